@@ -0,0 +1,143 @@
+// Measures how fast the scanners split identifiers from keywords.
+// The input is 20000 identifiers, 30% of them keywords and the rest near misses like "whiles" or "do_1" that start
+// like a keyword. It is scanned 50 times. The time includes the rest of the scanner, like interning the identifiers.
+//
+// Build from the repository root with one of the front ends:
+//   gcc -O2 -Isrc  -o KeywordLookup  benchmark/KeywordLookup.c src/Scanner.c src/String.c src/StringView.c src/Symbol.c src/Number.c src/Thread.c src/IntArray.c -lpthread
+//   gcc -O2 -Isrc2 -DSRC2 -o KeywordLookup2 benchmark/KeywordLookup.c src2/Scanner.c src2/String.c src2/StringView.c src2/Symbol.c src2/Number.c src2/Thread.c src2/FileInfo.c src2/Token.c -lpthread
+
+#include "Scanner.h"
+#include "String.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#define IDENTIFIER_COUNT 20000
+#define REPEAT_COUNT 50
+#define KEYWORD_PERCENT 30
+
+#ifdef SRC2
+// The keywords of src2/Scanner.c in TokenType order, checked against the scanner in checkKeywords.
+static const char* keywords[] = {
+	"auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else", "enum", "extern",
+	"float", "for", "goto", "if", "int", "long", "register", "return", "short", "signed", "sizeof", "static",
+	"struct", "switch", "typedef", "union", "unsigned", "void", "volatile", "while",
+};
+#else
+static const char* keywords[] = {
+	"break", "char", "continue", "do", "double", "else", "float", "for", "if", "int", "long", "putchar", "return",
+	"short", "signed", "unsigned", "while",
+};
+#endif
+
+#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+
+static const char* suffixes[] = { "s", "x", "_1", "ed" };
+
+static uint32_t randomState = 12345;
+
+// Same numbers on every platform, unlike rand.
+static uint32_t nextRandom(void)
+{
+	randomState = randomState * 1103515245 + 12345;
+	return randomState >> 16;
+}
+
+static String generateInput(void)
+{
+	String input = StringCopy("");
+	for (int i = 0; i < IDENTIFIER_COUNT; i++)
+	{
+		const char* keyword = keywords[nextRandom() % KEYWORD_COUNT];
+		if ((int)(nextRandom() % 100) < KEYWORD_PERCENT)
+			StringAppendFormat(&input, "%s ", keyword);
+		else
+			StringAppendFormat(&input, "%s%s ", keyword, suffixes[nextRandom() % (sizeof(suffixes) / sizeof(suffixes[0]))]);
+	}
+	return input;
+}
+
+#ifdef SRC2
+// Makes sure the input covers every keyword the src2 scanner knows about.
+static void checkKeywords(void)
+{
+	if (KEYWORD_COUNT != (size_t)(TOKEN_WHILE - TOKEN_AUTO + 1))
+	{
+		fprintf(stderr, "keyword list has %zu keywords, the scanner has %d\n", KEYWORD_COUNT, TOKEN_WHILE - TOKEN_AUTO + 1);
+		exit(1);
+	}
+
+	for (size_t i = 0; i < KEYWORD_COUNT; i++)
+	{
+		FileInfo fileInfo;
+		FileInfoInit(&fileInfo);
+		Scanner scanner;
+		ScannerInit(&scanner);
+		TokenArray tokens = ScannerScan(&scanner, StringViewInit(keywords[i], strlen(keywords[i])), "benchmark", &fileInfo);
+		TokenType type = TokenArrayGetType(&tokens, 0);
+		TokenArrayFree(&tokens);
+		ScannerFree(&scanner);
+		FileInfoFree(&fileInfo);
+
+		if (type != (TokenType)(TOKEN_AUTO + i))
+		{
+			fprintf(stderr, "'%s' is not scanned as the keyword at index %zu\n", keywords[i], i);
+			exit(1);
+		}
+	}
+}
+#endif
+
+static double secondsSince(const struct timespec* start)
+{
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (double)(end.tv_sec - start->tv_sec) + (double)(end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+int main(void)
+{
+#ifdef SRC2
+	checkKeywords();
+#endif
+	String input = generateInput();
+	size_t identifierCount = 0;
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < REPEAT_COUNT; i++)
+	{
+#ifdef SRC2
+		FileInfo fileInfo;
+		FileInfoInit(&fileInfo);
+		Scanner scanner;
+		ScannerInit(&scanner);
+		TokenArray tokens = ScannerScan(&scanner, StringViewInit(input.chars, input.length), "benchmark", &fileInfo);
+		// The last token is TOKEN_EOF.
+		identifierCount += tokens.size - 1;
+		TokenArrayFree(&tokens);
+		ScannerFree(&scanner);
+		FileInfoFree(&fileInfo);
+#else
+		FileInfo fileInfo;
+		FileInfoInit(&fileInfo);
+		fileInfo.filename = "benchmark";
+		fileInfo.source = StringViewInit(input.chars, input.length);
+		Scanner scanner;
+		ScannerInit(&scanner);
+		ScannerReset(&scanner, &fileInfo);
+		while (ScannerNextToken(&scanner).type != TOKEN_EOF)
+			identifierCount++;
+		ScannerFree(&scanner);
+		FileInfoFree(&fileInfo);
+#endif
+	}
+	double seconds = secondsSince(&start);
+
+	printf("%zu identifiers in %.3f s, %.1f M identifiers/s\n", identifierCount, seconds, (double)identifierCount / seconds / 1e6);
+	StringFree(&input);
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "Arena.h"
+#include "Alignment.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The data starts after the header.
+#define BLOCK_HEADER_SIZE ALIGN_UP_TO(ARENA_ALIGNMENT, sizeof(ArenaBlock))
+
+static ArenaBlock* allocateBlock(size_t size)
+{
+	ArenaBlock* block = malloc(BLOCK_HEADER_SIZE + size);
+	if (block == NULL)
+	{
+		fputs("Failed to allocate arena block", stderr);
+		exit(1);
+	}
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+void ArenaInit(Arena* arena)
+{
+	arena->current = NULL;
+}
+
+void ArenaFree(Arena* arena)
+{
+	ArenaBlock* block = arena->current;
+	while (block != NULL)
+	{
+		ArenaBlock* previous = block->previous;
+		free(block);
+		block = previous;
+	}
+	arena->current = NULL;
+}
+
+void* ArenaAllocate(Arena* arena, size_t size)
+{
+	size = ALIGN_UP_TO(ARENA_ALIGNMENT, size);
+
+	// Allocations that don't fit in a block get their own so the space left in the current block isn't wasted.
+	if (size > ARENA_BLOCK_SIZE)
+	{
+		ArenaBlock* block = allocateBlock(size);
+		block->used = size;
+		if (arena->current == NULL)
+		{
+			block->previous = NULL;
+			arena->current = block;
+		}
+		else
+		{
+			block->previous = arena->current->previous;
+			arena->current->previous = block;
+		}
+		return (char*)block + BLOCK_HEADER_SIZE;
+	}
+
+	ArenaBlock* block = arena->current;
+	if ((block == NULL) || ((block->used + size) > block->size))
+	{
+		block = allocateBlock(ARENA_BLOCK_SIZE);
+		block->previous = arena->current;
+		arena->current = block;
+	}
+
+	void* data = (char*)block + BLOCK_HEADER_SIZE + block->used;
+	block->used += size;
+	return data;
+}
+
+void* ArenaGrow(Arena* arena, void* data, size_t oldSize, size_t newSize)
+{
+	if (data == NULL)
+		return ArenaAllocate(arena, newSize);
+
+	oldSize = ALIGN_UP_TO(ARENA_ALIGNMENT, oldSize);
+	newSize = ALIGN_UP_TO(ARENA_ALIGNMENT, newSize);
+
+	ArenaBlock* block = arena->current;
+	char* top = (char*)block + BLOCK_HEADER_SIZE + block->used;
+	if ((((char*)data + oldSize) == top) && ((block->used - oldSize + newSize) <= block->size))
+	{
+		block->used = block->used - oldSize + newSize;
+		return data;
+	}
+
+	void* newData = ArenaAllocate(arena, newSize);
+	memcpy(newData, data, oldSize);
+	return newData;
+}
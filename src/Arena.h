@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+
+// Bump pointer allocator. The memory is allocated in blocks and everything is freed at once.
+typedef struct ArenaBlock
+{
+	struct ArenaBlock* previous;
+	size_t size;
+	size_t used;
+} ArenaBlock;
+
+typedef struct
+{
+	ArenaBlock* current;
+} Arena;
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+// Enough for any type.
+#define ARENA_ALIGNMENT 16
+
+void ArenaInit(Arena* arena);
+void ArenaFree(Arena* arena);
+void* ArenaAllocate(Arena* arena, size_t size);
+// Grows an allocation made with ArenaAllocate or ArenaGrow and returns its new address. The last allocation
+// of the current block is extended in place if it fits, anything else is copied and the old memory stays unused
+// until the arena is freed.
+void* ArenaGrow(Arena* arena, void* data, size_t oldSize, size_t newSize);
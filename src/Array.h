@@ -1,11 +1,12 @@
 #pragma once
 
+#include "Arena.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Could replace the grow capacity function with just one function for all types
-
+// The capacity used on the first append. Arrays don't allocate anything until then.
 #define ARRAY_INITIAL_CAPACITY 4
 
 #define ARRAY_TEMPLATE_DECLARATION(arrayTypeName, itemType) \
@@ -18,22 +19,92 @@ typedef struct \
 void arrayTypeName##Init(arrayTypeName* array); \
 void arrayTypeName##Free(arrayTypeName* array); \
 void arrayTypeName##Append(arrayTypeName* array, itemType item); \
+void arrayTypeName##AppendMany(arrayTypeName* array, const itemType* items, size_t count); \
+/* Makes sure capacity items fit without growing the array. */ \
+void arrayTypeName##Reserve(arrayTypeName* array, size_t capacity); \
+void arrayTypeName##ShrinkToFit(arrayTypeName* array); \
 void arrayTypeName##Clear(arrayTypeName* array);
 
 // void copyItemType(itemType* destination, itemType* source)
 // void freeItemType(itemType* ptr)
+// When the array grows the items are copied to the new buffer one by one and the old ones are freed.
 #define ARRAY_TEMPLATE_DEFINITION(arrayTypeName, itemType, copyItemType, freeItemType) \
 \
-static int grow##arrayTypeName##Capacity(size_t capacity) \
+static void reallocate##arrayTypeName(arrayTypeName* array, size_t capacity) \
+{ \
+	itemType* newData = malloc(capacity * sizeof(itemType)); \
+	if (newData == NULL) \
+	{ \
+		fputs("Failed to reallocate array\n", stderr); \
+		exit(1); \
+	} \
+	for (size_t i = 0; i < array->size; i++) \
+	{ \
+		copyItemType(&newData[i], &array->data[i]); \
+		freeItemType(&array->data[i]); \
+	} \
+	free(array->data); \
+	array->data = newData; \
+	array->capacity = capacity; \
+} \
+\
+static void copy##arrayTypeName##Items(itemType* destination, const itemType* items, size_t count) \
 { \
-	return capacity * 2; \
+	for (size_t i = 0; i < count; i++) \
+		copyItemType(&destination[i], (itemType*)&items[i]); \
+} \
+\
+ARRAY_TEMPLATE_COMMON_DEFINITION(arrayTypeName, itemType, copyItemType, freeItemType)
+
+// For items that can be copied with memcpy and don't own anything. Growing uses realloc so the items are
+// moved in bulk, and often not at all.
+#define ARRAY_TEMPLATE_TRIVIAL_DEFINITION(arrayTypeName, itemType) \
+\
+static void reallocate##arrayTypeName(arrayTypeName* array, size_t capacity) \
+{ \
+	itemType* newData = realloc(array->data, capacity * sizeof(itemType)); \
+	if (newData == NULL) \
+	{ \
+		fputs("Failed to reallocate array\n", stderr); \
+		exit(1); \
+	} \
+	array->data = newData; \
+	array->capacity = capacity; \
+} \
+\
+static void copy##arrayTypeName##Items(itemType* destination, const itemType* items, size_t count) \
+{ \
+	memcpy(destination, items, count * sizeof(itemType)); \
+} \
+\
+static void copy##arrayTypeName##Item(itemType* destination, itemType* item) \
+{ \
+	*destination = *item; \
+} \
+\
+static void free##arrayTypeName##Item(itemType* item) \
+{ \
+	(void)item; \
+} \
+\
+ARRAY_TEMPLATE_COMMON_DEFINITION(arrayTypeName, itemType, copy##arrayTypeName##Item, free##arrayTypeName##Item)
+
+// Used by both definitions. Requires reallocate##arrayTypeName and copy##arrayTypeName##Items.
+#define ARRAY_TEMPLATE_COMMON_DEFINITION(arrayTypeName, itemType, copyItemType, freeItemType) \
+\
+static void grow##arrayTypeName(arrayTypeName* array, size_t requiredCapacity) \
+{ \
+	size_t capacity = (array->capacity == 0) ? ARRAY_INITIAL_CAPACITY : array->capacity * 2; \
+	while (capacity < requiredCapacity) \
+		capacity *= 2; \
+	reallocate##arrayTypeName(array, capacity); \
 } \
 \
 void arrayTypeName##Init(arrayTypeName* array) \
 { \
 	array->size = 0; \
-	array->capacity = ARRAY_INITIAL_CAPACITY;\
-	array->data = malloc(array->capacity * sizeof(itemType)); \
+	array->capacity = 0; \
+	array->data = NULL; \
 } \
 \
 void arrayTypeName##Free(arrayTypeName* array) \
@@ -44,25 +115,41 @@ void arrayTypeName##Free(arrayTypeName* array) \
 void arrayTypeName##Append(arrayTypeName* array, itemType item) \
 { \
 	if ((array->size + 1) > array->capacity) \
+		grow##arrayTypeName(array, array->size + 1); \
+	copyItemType(&array->data[array->size], &item); \
+	array->size++; \
+} \
+\
+void arrayTypeName##AppendMany(arrayTypeName* array, const itemType* items, size_t count) \
+{ \
+	if (count == 0) \
+		return; \
+	if ((array->size + count) > array->capacity) \
+		grow##arrayTypeName(array, array->size + count); \
+	copy##arrayTypeName##Items(&array->data[array->size], items, count); \
+	array->size += count; \
+} \
+\
+void arrayTypeName##Reserve(arrayTypeName* array, size_t capacity) \
+{ \
+	if (capacity > array->capacity) \
+		reallocate##arrayTypeName(array, capacity); \
+} \
+\
+void arrayTypeName##ShrinkToFit(arrayTypeName* array) \
+{ \
+	if (array->size == array->capacity) \
+		return; \
+	if (array->size == 0) \
 	{ \
-		array->capacity = grow##arrayTypeName##Capacity(array->capacity); \
-		itemType* newData = malloc(array->capacity * sizeof(itemType)); \
-		if (newData == NULL) \
-		{ \
-			fputs("Failed to reallocate array\n", stderr); \
-			exit(1); \
-		} \
-		for (size_t i = 0; i < array->size; i++) \
-		{ \
-			copyItemType(&newData[i], &array->data[i]); \
-			freeItemType(&array->data[i]); \
-		} \
 		free(array->data); \
-		array->data = newData; \
+		array->data = NULL; \
+		array->capacity = 0; \
+		return; \
 	} \
-	copyItemType(&array->data[array->size], &item); \
-	array->size++; \
+	reallocate##arrayTypeName(array, array->size); \
 } \
+\
 void arrayTypeName##Clear(arrayTypeName* array) \
 { \
 	for (size_t i = 0; i < array->size; i++) \
@@ -70,4 +157,85 @@ void arrayTypeName##Clear(arrayTypeName* array) \
 		freeItemType(&array->data[i]); \
 	} \
 	array->size = 0; \
-}
\ No newline at end of file
+}
+
+// Arrays whose buffers are allocated from an arena, for data that is freed all at once. The arena isn't stored in
+// the array, so it is passed to the functions that allocate. There is no free function, freeing the arena frees the
+// buffers. A buffer with capacity 0 isn't owned by the arena, like one pointing into a mapped file, and is copied
+// on the first append.
+#define ARENA_ARRAY_TEMPLATE_DECLARATION(arrayTypeName, itemType) \
+typedef struct \
+{ \
+	size_t size; \
+	size_t capacity; \
+	itemType* data; \
+} arrayTypeName; \
+void arrayTypeName##Init(arrayTypeName* array); \
+void arrayTypeName##Append(arrayTypeName* array, Arena* arena, itemType item); \
+void arrayTypeName##AppendMany(arrayTypeName* array, Arena* arena, const itemType* items, size_t count); \
+/* Makes sure capacity items fit without growing the array. */ \
+void arrayTypeName##Reserve(arrayTypeName* array, Arena* arena, size_t capacity); \
+void arrayTypeName##Clear(arrayTypeName* array);
+
+// The items have to be trivially copyable.
+#define ARENA_ARRAY_TEMPLATE_DEFINITION(arrayTypeName, itemType) \
+\
+static void reallocate##arrayTypeName(arrayTypeName* array, Arena* arena, size_t capacity) \
+{ \
+	if (array->capacity == 0) \
+	{ \
+		itemType* newData = ArenaAllocate(arena, capacity * sizeof(itemType)); \
+		if (array->size != 0) \
+			memcpy(newData, array->data, array->size * sizeof(itemType)); \
+		array->data = newData; \
+	} \
+	else \
+	{ \
+		array->data = ArenaGrow(arena, array->data, array->capacity * sizeof(itemType), capacity * sizeof(itemType)); \
+	} \
+	array->capacity = capacity; \
+} \
+\
+static void grow##arrayTypeName(arrayTypeName* array, Arena* arena, size_t requiredCapacity) \
+{ \
+	size_t capacity = (array->capacity == 0) ? ARRAY_INITIAL_CAPACITY : array->capacity * 2; \
+	while (capacity < requiredCapacity) \
+		capacity *= 2; \
+	reallocate##arrayTypeName(array, arena, capacity); \
+} \
+\
+void arrayTypeName##Init(arrayTypeName* array) \
+{ \
+	array->size = 0; \
+	array->capacity = 0; \
+	array->data = NULL; \
+} \
+\
+void arrayTypeName##Append(arrayTypeName* array, Arena* arena, itemType item) \
+{ \
+	if ((array->size + 1) > array->capacity) \
+		grow##arrayTypeName(array, arena, array->size + 1); \
+	array->data[array->size] = item; \
+	array->size++; \
+} \
+\
+void arrayTypeName##AppendMany(arrayTypeName* array, Arena* arena, const itemType* items, size_t count) \
+{ \
+	if (count == 0) \
+		return; \
+	if ((array->size + count) > array->capacity) \
+		grow##arrayTypeName(array, arena, array->size + count); \
+	memcpy(&array->data[array->size], items, count * sizeof(itemType)); \
+	array->size += count; \
+} \
+\
+void arrayTypeName##Reserve(arrayTypeName* array, Arena* arena, size_t capacity) \
+{ \
+	if (capacity > array->capacity) \
+		reallocate##arrayTypeName(array, arena, capacity); \
+} \
+\
+void arrayTypeName##Clear(arrayTypeName* array) \
+{ \
+	array->size = 0; \
+}
@@ -0,0 +1,131 @@
+#include "Assembly.h"
+#include "Assert.h"
+
+static void renderOperand(const AsmOperand* operand, String* output);
+
+AsmOperand AsmRegisterGp(RegisterGp reg, size_t size)
+{
+	AsmOperand operand = { .type = ASM_OPERAND_REGISTER_GP, .size = size, .as.gpRegister = reg };
+	return operand;
+}
+
+AsmOperand AsmRegisterSimd(RegisterSimd reg)
+{
+	AsmOperand operand = { .type = ASM_OPERAND_REGISTER_SIMD, .size = 0, .as.simdRegister = reg };
+	return operand;
+}
+
+AsmOperand AsmStack(size_t baseOffset, size_t size)
+{
+	AsmOperand operand = { .type = ASM_OPERAND_STACK, .size = size, .as.baseOffset = baseOffset };
+	return operand;
+}
+
+AsmOperand AsmData(int labelIndex)
+{
+	AsmOperand operand = { .type = ASM_OPERAND_DATA, .size = 0, .as.labelIndex = labelIndex };
+	return operand;
+}
+
+AsmOperand AsmImmediate(uint64_t value, size_t size)
+{
+	AsmOperand operand = { .type = ASM_OPERAND_IMMEDIATE, .size = size };
+	switch (size)
+	{
+		case SIZE_BYTE:  operand.as.immediate = (int8_t)value; break;
+		case SIZE_WORD:  operand.as.immediate = (int16_t)value; break;
+		case SIZE_DWORD: operand.as.immediate = (int32_t)value; break;
+		default:         operand.as.immediate = (int64_t)value; break;
+	}
+	return operand;
+}
+
+AsmOperand AsmLabel(int labelIndex)
+{
+	AsmOperand operand = { .type = ASM_OPERAND_LABEL, .size = 0, .as.labelIndex = labelIndex };
+	return operand;
+}
+
+bool AsmOperandEquals(const AsmOperand* a, const AsmOperand* b)
+{
+	if ((a->type != b->type) || (a->size != b->size))
+		return false;
+
+	switch (a->type)
+	{
+		case ASM_OPERAND_NONE:          return true;
+		case ASM_OPERAND_REGISTER_GP:   return a->as.gpRegister == b->as.gpRegister;
+		case ASM_OPERAND_REGISTER_SIMD: return a->as.simdRegister == b->as.simdRegister;
+		case ASM_OPERAND_STACK:         return a->as.baseOffset == b->as.baseOffset;
+		case ASM_OPERAND_DATA:          return a->as.labelIndex == b->as.labelIndex;
+		case ASM_OPERAND_IMMEDIATE:     return a->as.immediate == b->as.immediate;
+		case ASM_OPERAND_LABEL:         return a->as.labelIndex == b->as.labelIndex;
+
+		default:
+			ASSERT_NOT_REACHED();
+			return false;
+	}
+}
+
+bool AsmIsJump(const AsmInstruction* instruction)
+{
+	return (instruction->isLabel == false) && (instruction->opcode[0] == 'j');
+}
+
+static void renderOperand(const AsmOperand* operand, String* output)
+{
+	switch (operand->type)
+	{
+		case ASM_OPERAND_REGISTER_GP:
+			StringAppend(output, RegisterGpToString(operand->as.gpRegister, operand->size));
+			break;
+
+		case ASM_OPERAND_REGISTER_SIMD:
+			StringAppend(output, RegisterSimdToString(operand->as.simdRegister));
+			break;
+
+		case ASM_OPERAND_STACK:
+			if (operand->size == 0)
+				StringAppendFormat(output, "[rbp-%zu]", operand->as.baseOffset);
+			else
+				StringAppendFormat(output, "%s [rbp-%zu]", dataSizeToString(operand->size), operand->as.baseOffset);
+			break;
+
+		case ASM_OPERAND_DATA:
+			StringAppendFormat(output, "[.L%d]", operand->as.labelIndex);
+			break;
+
+		case ASM_OPERAND_IMMEDIATE:
+			StringAppendFormat(output, "%lld", (long long)operand->as.immediate);
+			break;
+
+		case ASM_OPERAND_LABEL:
+			StringAppendFormat(output, ".L%d", operand->as.labelIndex);
+			break;
+
+		default:
+			ASSERT_NOT_REACHED();
+	}
+}
+
+void AsmRender(const AsmInstructionArray* instructions, String* output)
+{
+	for (size_t i = 0; i < instructions->size; i++)
+	{
+		const AsmInstruction* instruction = &instructions->data[i];
+		if (instruction->isLabel)
+		{
+			StringAppendFormat(output, "\n.L%d:", instruction->labelIndex);
+			continue;
+		}
+
+		StringAppendFormat(output, "\n\t%s", instruction->opcode);
+		for (int j = 0; j < instruction->operandCount; j++)
+		{
+			StringAppend(output, (j == 0) ? " " : ", ");
+			renderOperand(&instruction->operands[j], output);
+		}
+	}
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(AsmInstructionArray, AsmInstruction)
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Array.h"
+#include "Registers.h"
+#include "String.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The code generator emits instructions as records instead of text, so passes like the peephole optimizer can look
+// at the operands without parsing them. The records are rendered to NASM text at the end.
+
+typedef enum
+{
+	ASM_OPERAND_NONE,
+	ASM_OPERAND_REGISTER_GP,
+	ASM_OPERAND_REGISTER_SIMD,
+	// [rbp-baseOffset]
+	ASM_OPERAND_STACK,
+	// [.L<labelIndex>], a constant in the data section.
+	ASM_OPERAND_DATA,
+	ASM_OPERAND_IMMEDIATE,
+	// .L<labelIndex>, the target of a jump.
+	ASM_OPERAND_LABEL,
+} AsmOperandType;
+
+typedef struct
+{
+	AsmOperandType type;
+	// The number of bytes the operand reads or writes. Memory operands with size 0 are written without the size
+	// prefix, like the operand of lea.
+	size_t size;
+
+	union
+	{
+		// Used if ASM_OPERAND_REGISTER_GP
+		RegisterGp gpRegister;
+		// Used if ASM_OPERAND_REGISTER_SIMD
+		RegisterSimd simdRegister;
+		// Used if ASM_OPERAND_STACK
+		size_t baseOffset;
+		// Used if ASM_OPERAND_DATA and ASM_OPERAND_LABEL
+		int labelIndex;
+		// Used if ASM_OPERAND_IMMEDIATE. Already sign extended from the size of the operand.
+		int64_t immediate;
+	} as;
+} AsmOperand;
+
+// Big enough for the longest mnemonic, cvttsd2si.
+#define ASM_OPCODE_SIZE 16
+
+typedef struct
+{
+	// Labels are records too, so the passes know where jumps can land. A label only uses labelIndex.
+	bool isLabel;
+	int labelIndex;
+
+	char opcode[ASM_OPCODE_SIZE];
+	int operandCount;
+	AsmOperand operands[2];
+} AsmInstruction;
+
+ARRAY_TEMPLATE_DECLARATION(AsmInstructionArray, AsmInstruction)
+
+AsmOperand AsmRegisterGp(RegisterGp reg, size_t size);
+AsmOperand AsmRegisterSimd(RegisterSimd reg);
+AsmOperand AsmStack(size_t baseOffset, size_t size);
+AsmOperand AsmData(int labelIndex);
+// The value is truncated to the size and written as a signed number so the assembler doesn't warn about it.
+AsmOperand AsmImmediate(uint64_t value, size_t size);
+AsmOperand AsmLabel(int labelIndex);
+bool AsmOperandEquals(const AsmOperand* a, const AsmOperand* b);
+
+bool AsmIsJump(const AsmInstruction* instruction);
+
+// Appends the instructions to the string as NASM, one per line.
+void AsmRender(const AsmInstructionArray* instructions, String* output);
@@ -1,152 +1,606 @@
 #include "Ast.h"
 #include "Assert.h"
-#include "Generic.h"
 
-Expr* ExprAllocate(size_t size, ExprType type)
+ARENA_ARRAY_TEMPLATE_DEFINITION(ExprBinaryArray, ExprBinary)
+ARENA_ARRAY_TEMPLATE_DEFINITION(ExprUnaryArray, ExprUnary)
+ARENA_ARRAY_TEMPLATE_DEFINITION(ExprNumberLiteralArray, ExprNumberLiteral)
+ARENA_ARRAY_TEMPLATE_DEFINITION(ExprGroupingArray, ExprGrouping)
+ARENA_ARRAY_TEMPLATE_DEFINITION(ExprIdentifierArray, ExprIdentifier)
+ARENA_ARRAY_TEMPLATE_DEFINITION(ExprAssignmentArray, ExprAssignment)
+
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtExpressionArray, StmtExpression)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtVariableDeclarationArray, StmtVariableDeclaration)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtReturnArray, StmtReturn)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtBlockArray, StmtBlock)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtIfArray, StmtIf)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtWhileLoopArray, StmtWhileLoop)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtBreakArray, StmtBreak)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtContinueArray, StmtContinue)
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtPutcharArray, StmtPutchar)
+
+ARENA_ARRAY_TEMPLATE_DEFINITION(StmtHandleArray, StmtHandle)
+
+static uint32_t makeHandle(int type, size_t index);
+static SymbolId mapSymbol(const SymbolId* symbolMap, SymbolId symbol);
+
+void AstInit(Ast* ast)
 {
-	Expr* expr = malloc(size);
-	if (expr == NULL)
+	ast->source = StringViewInit("", 0);
+	ArenaInit(&ast->arena);
+
+	ExprBinaryArrayInit(&ast->binaries);
+	ExprUnaryArrayInit(&ast->unaries);
+	ExprNumberLiteralArrayInit(&ast->numberLiterals);
+	ExprGroupingArrayInit(&ast->groupings);
+	ExprIdentifierArrayInit(&ast->identifiers);
+	ExprAssignmentArrayInit(&ast->assignments);
+
+	StmtExpressionArrayInit(&ast->expressionStmts);
+	StmtVariableDeclarationArrayInit(&ast->variableDeclarations);
+	StmtReturnArrayInit(&ast->returns);
+	StmtBlockArrayInit(&ast->blocks);
+	StmtIfArrayInit(&ast->ifs);
+	StmtWhileLoopArrayInit(&ast->whileLoops);
+	StmtBreakArrayInit(&ast->breaks);
+	StmtContinueArrayInit(&ast->continues);
+	StmtPutcharArrayInit(&ast->putchars);
+
+	StmtHandleArrayInit(&ast->blockStatements);
+	StmtHandleArrayInit(&ast->blockStack);
+
+	ast->root.start = 0;
+	ast->root.count = 0;
+}
+
+void AstFree(Ast* ast)
+{
+	ArenaFree(&ast->arena);
+}
+
+void AstClear(Ast* ast, StringView source)
+{
+	ast->source = source;
+
+	// The nodes don't own anything so there is nothing to free.
+	ast->binaries.size = 0;
+	ast->unaries.size = 0;
+	ast->numberLiterals.size = 0;
+	ast->groupings.size = 0;
+	ast->identifiers.size = 0;
+	ast->assignments.size = 0;
+
+	ast->expressionStmts.size = 0;
+	ast->variableDeclarations.size = 0;
+	ast->returns.size = 0;
+	ast->blocks.size = 0;
+	ast->ifs.size = 0;
+	ast->whileLoops.size = 0;
+	ast->breaks.size = 0;
+	ast->continues.size = 0;
+	ast->putchars.size = 0;
+
+	ast->blockStatements.size = 0;
+	ast->blockStack.size = 0;
+
+	ast->root.start = 0;
+	ast->root.count = 0;
+}
+
+static uint32_t makeHandle(int type, size_t index)
+{
+	if (index > AST_HANDLE_INDEX_MASK)
 	{
-		fputs("Failed to allocate Expr", stderr);
+		fputs("too many ast nodes\n", stderr);
 		exit(1);
 	}
-	expr->type = type;
-	return expr;
+	return ((uint32_t)type << AST_HANDLE_TYPE_SHIFT) | (uint32_t)index;
+}
+
+ExprHandle AstAddBinary(Ast* ast, TokenType operator, uint32_t offset, ExprHandle left, ExprHandle right)
+{
+	ExprBinary expr = { .operator = (uint8_t)operator, .offset = offset, .left = left, .right = right };
+	ExprBinaryArrayAppend(&ast->binaries, &ast->arena, expr);
+	return makeHandle(EXPR_BINARY, ast->binaries.size - 1);
+}
+
+ExprHandle AstAddUnary(Ast* ast, TokenType operator, uint32_t offset, ExprHandle operand)
+{
+	ExprUnary expr = { .operator = (uint8_t)operator, .offset = offset, .operand = operand };
+	ExprUnaryArrayAppend(&ast->unaries, &ast->arena, expr);
+	return makeHandle(EXPR_UNARY, ast->unaries.size - 1);
+}
+
+ExprHandle AstAddIntLiteral(Ast* ast, DataType dataType, uint32_t offset, uint64_t value)
+{
+	ExprNumberLiteral expr = { .value.intValue = value, .offset = offset, .dataType = dataType };
+	ExprNumberLiteralArrayAppend(&ast->numberLiterals, &ast->arena, expr);
+	return makeHandle(EXPR_NUMBER_LITERAL, ast->numberLiterals.size - 1);
+}
+
+ExprHandle AstAddFloatLiteral(Ast* ast, DataType dataType, uint32_t offset, double value)
+{
+	ExprNumberLiteral expr = { .value.floatValue = value, .offset = offset, .dataType = dataType };
+	ExprNumberLiteralArrayAppend(&ast->numberLiterals, &ast->arena, expr);
+	return makeHandle(EXPR_NUMBER_LITERAL, ast->numberLiterals.size - 1);
+}
+
+ExprHandle AstAddGrouping(Ast* ast, ExprHandle expression)
+{
+	ExprGrouping expr = { .expression = expression };
+	ExprGroupingArrayAppend(&ast->groupings, &ast->arena, expr);
+	return makeHandle(EXPR_GROUPING, ast->groupings.size - 1);
+}
+
+ExprHandle AstAddIdentifier(Ast* ast, SymbolId name, uint32_t offset, uint32_t length)
+{
+	ExprIdentifier expr = { .name = name, .offset = offset, .length = length };
+	ExprIdentifierArrayAppend(&ast->identifiers, &ast->arena, expr);
+	return makeHandle(EXPR_IDENTIFIER, ast->identifiers.size - 1);
+}
+
+ExprHandle AstAddAssignment(Ast* ast, TokenType operator, uint32_t offset, ExprHandle left, ExprHandle right)
+{
+	ExprAssignment expr = { .operator = (uint8_t)operator, .offset = offset, .left = left, .right = right };
+	ExprAssignmentArrayAppend(&ast->assignments, &ast->arena, expr);
+	return makeHandle(EXPR_ASSIGNMENT, ast->assignments.size - 1);
+}
+
+StmtHandle AstAddExpressionStmt(Ast* ast, ExprHandle expression)
+{
+	StmtExpression stmt = { .expresssion = expression };
+	StmtExpressionArrayAppend(&ast->expressionStmts, &ast->arena, stmt);
+	return makeHandle(STMT_EXPRESSION, ast->expressionStmts.size - 1);
+}
+
+StmtHandle AstAddVariableDeclaration(Ast* ast, DataType dataType, SymbolId name, uint32_t nameOffset, uint32_t nameLength, ExprHandle initializer)
+{
+	StmtVariableDeclaration stmt = {
+		.name = name,
+		.nameOffset = nameOffset,
+		.nameLength = nameLength,
+		.initializer = initializer,
+		.dataType = dataType
+	};
+	StmtVariableDeclarationArrayAppend(&ast->variableDeclarations, &ast->arena, stmt);
+	return makeHandle(STMT_VARIABLE_DECLARATION, ast->variableDeclarations.size - 1);
+}
+
+StmtHandle AstAddReturn(Ast* ast, uint32_t offset, ExprHandle returnValue)
+{
+	StmtReturn stmt = { .offset = offset, .returnValue = returnValue };
+	StmtReturnArrayAppend(&ast->returns, &ast->arena, stmt);
+	return makeHandle(STMT_RETURN, ast->returns.size - 1);
+}
+
+StmtHandle AstAddIf(Ast* ast, ExprHandle condition, StmtHandle thenBlock, StmtHandle elseBlock)
+{
+	StmtIf stmt = { .condition = condition, .thenBlock = thenBlock, .elseBlock = elseBlock };
+	StmtIfArrayAppend(&ast->ifs, &ast->arena, stmt);
+	return makeHandle(STMT_IF, ast->ifs.size - 1);
+}
+
+StmtHandle AstAddWhileLoop(Ast* ast, ExprHandle condition, StmtHandle body)
+{
+	StmtWhileLoop stmt = { .condition = condition, .body = body };
+	StmtWhileLoopArrayAppend(&ast->whileLoops, &ast->arena, stmt);
+	return makeHandle(STMT_WHILE_LOOP, ast->whileLoops.size - 1);
 }
 
-void ExprFree(Expr* expression)
+StmtHandle AstAddBreak(Ast* ast, uint32_t offset)
 {
-	switch (expression->type)
+	StmtBreak stmt = { .offset = offset };
+	StmtBreakArrayAppend(&ast->breaks, &ast->arena, stmt);
+	return makeHandle(STMT_BREAK, ast->breaks.size - 1);
+}
+
+StmtHandle AstAddContinue(Ast* ast, uint32_t offset)
+{
+	StmtContinue stmt = { .offset = offset };
+	StmtContinueArrayAppend(&ast->continues, &ast->arena, stmt);
+	return makeHandle(STMT_CONTINUE, ast->continues.size - 1);
+}
+
+StmtHandle AstAddPutchar(Ast* ast, ExprHandle expression)
+{
+	StmtPutchar stmt = { .expresssion = expression };
+	StmtPutcharArrayAppend(&ast->putchars, &ast->arena, stmt);
+	return makeHandle(STMT_PUTCHAR, ast->putchars.size - 1);
+}
+
+size_t AstBeginBlock(Ast* ast)
+{
+	return ast->blockStack.size;
+}
+
+void AstAddToBlock(Ast* ast, StmtHandle stmt)
+{
+	StmtHandleArrayAppend(&ast->blockStack, &ast->arena, stmt);
+}
+
+StmtBlock AstEndBlock(Ast* ast, size_t blockStart)
+{
+	ASSERT(blockStart <= ast->blockStack.size);
+
+	StmtBlock block;
+	block.start = (uint32_t)ast->blockStatements.size;
+	block.count = (uint32_t)(ast->blockStack.size - blockStart);
+	StmtHandleArrayAppendMany(&ast->blockStatements, &ast->arena, &ast->blockStack.data[blockStart], block.count);
+	ast->blockStack.size = blockStart;
+
+	return block;
+}
+
+StmtHandle AstAddBlock(Ast* ast, StmtBlock block)
+{
+	StmtBlockArrayAppend(&ast->blocks, &ast->arena, block);
+	return makeHandle(STMT_BLOCK, ast->blocks.size - 1);
+}
+
+static SymbolId mapSymbol(const SymbolId* symbolMap, SymbolId symbol)
+{
+	return (symbolMap == NULL) ? symbol : symbolMap[symbol];
+}
+
+// The children are copied before the parents, the same order the parser adds them in.
+ExprHandle AstCopyExpr(Ast* ast, const Ast* from, ExprHandle expr, const SymbolId* symbolMap)
+{
+	if (expr == AST_HANDLE_NULL)
+		return AST_HANDLE_NULL;
+
+	switch (AstGetExprType(expr))
 	{
 		case EXPR_BINARY:
 		{
-			ExprBinary* expr = (ExprBinary*)expression;
-			ExprFree(expr->left);
-			ExprFree(expr->right);
-			break;
+			ExprBinary node = *AstGetBinary(from, expr);
+			node.left = AstCopyExpr(ast, from, node.left, symbolMap);
+			node.right = AstCopyExpr(ast, from, node.right, symbolMap);
+			ExprBinaryArrayAppend(&ast->binaries, &ast->arena, node);
+			return makeHandle(EXPR_BINARY, ast->binaries.size - 1);
 		}
-			
+
 		case EXPR_UNARY:
 		{
-			ExprUnary* expr = (ExprUnary*)expression;
-			ExprFree(expr->operand);
-			break;
+			ExprUnary node = *AstGetUnary(from, expr);
+			node.operand = AstCopyExpr(ast, from, node.operand, symbolMap);
+			ExprUnaryArrayAppend(&ast->unaries, &ast->arena, node);
+			return makeHandle(EXPR_UNARY, ast->unaries.size - 1);
 		}
 
+		case EXPR_NUMBER_LITERAL:
+			ExprNumberLiteralArrayAppend(&ast->numberLiterals, &ast->arena, *AstGetNumberLiteral(from, expr));
+			return makeHandle(EXPR_NUMBER_LITERAL, ast->numberLiterals.size - 1);
+
 		case EXPR_GROUPING:
-			ExprFree(((ExprGrouping*)expression)->expression);
-			break;
+			return AstAddGrouping(ast, AstCopyExpr(ast, from, AstGetGrouping(from, expr)->expression, symbolMap));
 
-		case EXPR_NUMBER_LITERAL:
-			break;
-			
 		case EXPR_IDENTIFIER:
-			break;
+		{
+			ExprIdentifier node = *AstGetIdentifier(from, expr);
+			node.name = mapSymbol(symbolMap, node.name);
+			ExprIdentifierArrayAppend(&ast->identifiers, &ast->arena, node);
+			return makeHandle(EXPR_IDENTIFIER, ast->identifiers.size - 1);
+		}
 
 		case EXPR_ASSIGNMENT:
 		{
-			ExprAssignment* expr = (ExprAssignment*)expression;
-			ExprFree(expr->left);
-			ExprFree(expr->right);
-			break;
+			ExprAssignment node = *AstGetAssignment(from, expr);
+			node.left = AstCopyExpr(ast, from, node.left, symbolMap);
+			node.right = AstCopyExpr(ast, from, node.right, symbolMap);
+			ExprAssignmentArrayAppend(&ast->assignments, &ast->arena, node);
+			return makeHandle(EXPR_ASSIGNMENT, ast->assignments.size - 1);
+		}
+	}
+
+	ASSERT_NOT_REACHED();
+	return AST_HANDLE_NULL;
+}
+
+StmtHandle AstCopyStmt(Ast* ast, const Ast* from, StmtHandle stmt, const SymbolId* symbolMap)
+{
+	if (stmt == AST_HANDLE_NULL)
+		return AST_HANDLE_NULL;
+
+	switch (AstGetStmtType(stmt))
+	{
+		case STMT_EXPRESSION:
+			return AstAddExpressionStmt(ast, AstCopyExpr(ast, from, AstGetExpressionStmt(from, stmt)->expresssion, symbolMap));
+
+		case STMT_VARIABLE_DECLARATION:
+		{
+			StmtVariableDeclaration node = *AstGetVariableDeclaration(from, stmt);
+			node.name = mapSymbol(symbolMap, node.name);
+			node.initializer = AstCopyExpr(ast, from, node.initializer, symbolMap);
+			StmtVariableDeclarationArrayAppend(&ast->variableDeclarations, &ast->arena, node);
+			return makeHandle(STMT_VARIABLE_DECLARATION, ast->variableDeclarations.size - 1);
+		}
+
+		case STMT_RETURN:
+		{
+			const StmtReturn* node = AstGetReturn(from, stmt);
+			return AstAddReturn(ast, node->offset, AstCopyExpr(ast, from, node->returnValue, symbolMap));
+		}
+
+		case STMT_BLOCK:
+		{
+			const StmtBlock* block = AstGetBlock(from, stmt);
+			const StmtHandle* statements = AstGetBlockStatements(from, block);
+			size_t blockStart = AstBeginBlock(ast);
+			for (uint32_t i = 0; i < block->count; i++)
+			{
+				AstAddToBlock(ast, AstCopyStmt(ast, from, statements[i], symbolMap));
+			}
+			return AstAddBlock(ast, AstEndBlock(ast, blockStart));
+		}
+
+		case STMT_IF:
+		{
+			const StmtIf* node = AstGetIf(from, stmt);
+			ExprHandle condition = AstCopyExpr(ast, from, node->condition, symbolMap);
+			StmtHandle thenBlock = AstCopyStmt(ast, from, node->thenBlock, symbolMap);
+			StmtHandle elseBlock = AstCopyStmt(ast, from, node->elseBlock, symbolMap);
+			return AstAddIf(ast, condition, thenBlock, elseBlock);
 		}
 
+		case STMT_WHILE_LOOP:
+		{
+			const StmtWhileLoop* node = AstGetWhileLoop(from, stmt);
+			ExprHandle condition = AstCopyExpr(ast, from, node->condition, symbolMap);
+			StmtHandle body = AstCopyStmt(ast, from, node->body, symbolMap);
+			return AstAddWhileLoop(ast, condition, body);
+		}
+
+		case STMT_BREAK:
+			return AstAddBreak(ast, AstGetBreak(from, stmt)->offset);
+
+		case STMT_CONTINUE:
+			return AstAddContinue(ast, AstGetContinue(from, stmt)->offset);
+
+		case STMT_PUTCHAR:
+			return AstAddPutchar(ast, AstCopyExpr(ast, from, AstGetPutchar(from, stmt)->expresssion, symbolMap));
+
 		default:
-			ASSERT_NOT_REACHED();
 			break;
 	}
-	free(expression);
-}
 
-static void copyStmt(Stmt** dst, Stmt** src)
-{
-	*dst = *src;
+	ASSERT_NOT_REACHED();
+	return AST_HANDLE_NULL;
 }
 
-ARRAY_TEMPLATE_DEFINITION(StmtArray, Stmt*, copyStmt, NO_OP_FUNCTION)
-
-Stmt* StmtAllocate(size_t size, StmtType type)
+void AstShiftExprOffsets(Ast* ast, ExprHandle expr, int32_t offsetDelta)
 {
-	Stmt* stmt = malloc(size);
-	if (stmt == NULL)
+	if (expr == AST_HANDLE_NULL)
+		return;
+
+	uint32_t index = AST_HANDLE_INDEX(expr);
+	switch (AstGetExprType(expr))
 	{
-		fputs("Failed to allocate Stmt", stderr);
-		exit(1);
+		case EXPR_BINARY:
+		{
+			ExprBinary* node = &ast->binaries.data[index];
+			node->offset += offsetDelta;
+			AstShiftExprOffsets(ast, node->left, offsetDelta);
+			AstShiftExprOffsets(ast, node->right, offsetDelta);
+			return;
+		}
+
+		case EXPR_UNARY:
+		{
+			ExprUnary* node = &ast->unaries.data[index];
+			node->offset += offsetDelta;
+			AstShiftExprOffsets(ast, node->operand, offsetDelta);
+			return;
+		}
+
+		case EXPR_NUMBER_LITERAL:
+			ast->numberLiterals.data[index].offset += offsetDelta;
+			return;
+
+		case EXPR_GROUPING:
+			AstShiftExprOffsets(ast, ast->groupings.data[index].expression, offsetDelta);
+			return;
+
+		case EXPR_IDENTIFIER:
+			ast->identifiers.data[index].offset += offsetDelta;
+			return;
+
+		case EXPR_ASSIGNMENT:
+		{
+			ExprAssignment* node = &ast->assignments.data[index];
+			node->offset += offsetDelta;
+			AstShiftExprOffsets(ast, node->left, offsetDelta);
+			AstShiftExprOffsets(ast, node->right, offsetDelta);
+			return;
+		}
 	}
-	stmt->type = type;
-	return stmt;
+
+	ASSERT_NOT_REACHED();
 }
 
-void StmtFree(Stmt* statement)
+void AstShiftStmtOffsets(Ast* ast, StmtHandle stmt, int32_t offsetDelta)
 {
-	switch (statement->type)
+	if (stmt == AST_HANDLE_NULL)
+		return;
+
+	uint32_t index = AST_HANDLE_INDEX(stmt);
+	switch (AstGetStmtType(stmt))
 	{
 		case STMT_EXPRESSION:
-		{
-			StmtExpression* stmt = (StmtExpression*)statement;
-			ExprFree(stmt->expresssion);
-			break;
-		}
+			AstShiftExprOffsets(ast, ast->expressionStmts.data[index].expresssion, offsetDelta);
+			return;
 
 		case STMT_VARIABLE_DECLARATION:
 		{
-			StmtVariableDeclaration* stmt = (StmtVariableDeclaration*)statement;
-			if (stmt->initializer != NULL)
-				ExprFree(stmt->initializer);
-			break;
+			StmtVariableDeclaration* node = &ast->variableDeclarations.data[index];
+			node->nameOffset += offsetDelta;
+			AstShiftExprOffsets(ast, node->initializer, offsetDelta);
+			return;
 		}
 
 		case STMT_RETURN:
 		{
-			StmtReturn* stmt = (StmtReturn*)statement;
-			ExprFree(stmt->returnValue);
-			break;
+			StmtReturn* node = &ast->returns.data[index];
+			node->offset += offsetDelta;
+			AstShiftExprOffsets(ast, node->returnValue, offsetDelta);
+			return;
 		}
 
 		case STMT_BLOCK:
 		{
-			StmtBlock* stmt = (StmtBlock*)statement;
-			for (size_t i = 0; i < stmt->satements.size; i++)
+			const StmtBlock* block = &ast->blocks.data[index];
+			for (uint32_t i = 0; i < block->count; i++)
 			{
-				StmtFree(stmt->satements.data[i]);
+				AstShiftStmtOffsets(ast, ast->blockStatements.data[block->start + i], offsetDelta);
 			}
-			break;
+			return;
 		}
 
 		case STMT_IF:
 		{
-			StmtIf* stmt = (StmtIf*)statement;
-			StmtFree(stmt->thenBlock);
-			if (stmt->elseBlock != NULL)
-				StmtFree(stmt->elseBlock);
-			ExprFree(stmt->condition);
-			break;
+			const StmtIf* node = &ast->ifs.data[index];
+			AstShiftExprOffsets(ast, node->condition, offsetDelta);
+			AstShiftStmtOffsets(ast, node->thenBlock, offsetDelta);
+			AstShiftStmtOffsets(ast, node->elseBlock, offsetDelta);
+			return;
 		}
 
 		case STMT_WHILE_LOOP:
 		{
-			StmtWhileLoop* stmt = (StmtWhileLoop*)statement;
-			ExprFree(stmt->condition);
-			StmtFree(stmt->body);
-			break;
+			const StmtWhileLoop* node = &ast->whileLoops.data[index];
+			AstShiftExprOffsets(ast, node->condition, offsetDelta);
+			AstShiftStmtOffsets(ast, node->body, offsetDelta);
+			return;
 		}
 
 		case STMT_BREAK:
-			break;
+			ast->breaks.data[index].offset += offsetDelta;
+			return;
 
 		case STMT_CONTINUE:
-			break;
+			ast->continues.data[index].offset += offsetDelta;
+			return;
 
 		case STMT_PUTCHAR:
-		{
-			StmtPutchar* stmt = (StmtPutchar*)statement;
-			ExprFree(stmt->expresssion);
-			break;
-		}
+			AstShiftExprOffsets(ast, ast->putchars.data[index].expresssion, offsetDelta);
+			return;
 
 		default:
-			ASSERT_NOT_REACHED();
+			break;
 	}
 
-	free(statement);
-}
\ No newline at end of file
+	ASSERT_NOT_REACHED();
+}
+
+size_t AstNodeCount(const Ast* ast)
+{
+	return ast->binaries.size + ast->unaries.size + ast->numberLiterals.size + ast->groupings.size
+		+ ast->identifiers.size + ast->assignments.size + ast->expressionStmts.size + ast->variableDeclarations.size
+		+ ast->returns.size + ast->blocks.size + ast->ifs.size + ast->whileLoops.size + ast->breaks.size
+		+ ast->continues.size + ast->putchars.size + ast->blockStatements.size;
+}
+
+ExprType AstGetExprType(ExprHandle expr)
+{
+	ASSERT(expr != AST_HANDLE_NULL);
+	return (ExprType)(expr >> AST_HANDLE_TYPE_SHIFT);
+}
+
+StmtType AstGetStmtType(StmtHandle stmt)
+{
+	ASSERT(stmt != AST_HANDLE_NULL);
+	return (StmtType)(stmt >> AST_HANDLE_TYPE_SHIFT);
+}
+
+const ExprBinary* AstGetBinary(const Ast* ast, ExprHandle expr)
+{
+	ASSERT(AstGetExprType(expr) == EXPR_BINARY);
+	return &ast->binaries.data[AST_HANDLE_INDEX(expr)];
+}
+
+const ExprUnary* AstGetUnary(const Ast* ast, ExprHandle expr)
+{
+	ASSERT(AstGetExprType(expr) == EXPR_UNARY);
+	return &ast->unaries.data[AST_HANDLE_INDEX(expr)];
+}
+
+const ExprNumberLiteral* AstGetNumberLiteral(const Ast* ast, ExprHandle expr)
+{
+	ASSERT(AstGetExprType(expr) == EXPR_NUMBER_LITERAL);
+	return &ast->numberLiterals.data[AST_HANDLE_INDEX(expr)];
+}
+
+const ExprGrouping* AstGetGrouping(const Ast* ast, ExprHandle expr)
+{
+	ASSERT(AstGetExprType(expr) == EXPR_GROUPING);
+	return &ast->groupings.data[AST_HANDLE_INDEX(expr)];
+}
+
+const ExprIdentifier* AstGetIdentifier(const Ast* ast, ExprHandle expr)
+{
+	ASSERT(AstGetExprType(expr) == EXPR_IDENTIFIER);
+	return &ast->identifiers.data[AST_HANDLE_INDEX(expr)];
+}
+
+const ExprAssignment* AstGetAssignment(const Ast* ast, ExprHandle expr)
+{
+	ASSERT(AstGetExprType(expr) == EXPR_ASSIGNMENT);
+	return &ast->assignments.data[AST_HANDLE_INDEX(expr)];
+}
+
+const StmtExpression* AstGetExpressionStmt(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_EXPRESSION);
+	return &ast->expressionStmts.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtVariableDeclaration* AstGetVariableDeclaration(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_VARIABLE_DECLARATION);
+	return &ast->variableDeclarations.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtReturn* AstGetReturn(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_RETURN);
+	return &ast->returns.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtBlock* AstGetBlock(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_BLOCK);
+	return &ast->blocks.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtIf* AstGetIf(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_IF);
+	return &ast->ifs.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtWhileLoop* AstGetWhileLoop(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_WHILE_LOOP);
+	return &ast->whileLoops.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtBreak* AstGetBreak(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_BREAK);
+	return &ast->breaks.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtContinue* AstGetContinue(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_CONTINUE);
+	return &ast->continues.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtPutchar* AstGetPutchar(const Ast* ast, StmtHandle stmt)
+{
+	ASSERT(AstGetStmtType(stmt) == STMT_PUTCHAR);
+	return &ast->putchars.data[AST_HANDLE_INDEX(stmt)];
+}
+
+const StmtHandle* AstGetBlockStatements(const Ast* ast, const StmtBlock* block)
+{
+	return &ast->blockStatements.data[block->start];
+}
@@ -3,14 +3,23 @@
 #include "Scanner.h"
 #include "Variable.h"
 
+#include <stdint.h>
+
 // Should make more things const
 
-// Could implement the visitor pattern with a cost of one virtual call
-// There would be a vtable in the Expr or Stmt class contaning a function for every visitor
-// for example Result acceptCompilerVisitor(Compiler* compiler, Stmt* stmt);
-// In this example the compiler would implement all the methods like CompilerAcceptExprBinary
-// That the vtable function would use.
-// Could automate generating of both using macros.
+// The nodes are stored in a pool for each node type and reference each other with 32 bit handles.
+// The type of the node is stored in the top bits of the handle and the index into the pool in the rest
+// so the type is known without loading the node. Nodes don't store tokens. Operators are stored as
+// a TokenType byte and locations as offsets into the source.
+// Children are added before their parents so a walk over a function mostly moves forward through the pools.
+
+typedef uint32_t ExprHandle;
+typedef uint32_t StmtHandle;
+
+#define AST_HANDLE_NULL UINT32_MAX
+#define AST_HANDLE_TYPE_SHIFT 28
+#define AST_HANDLE_INDEX_MASK ((1u << AST_HANDLE_TYPE_SHIFT) - 1)
+#define AST_HANDLE_INDEX(handle) ((handle) & AST_HANDLE_INDEX_MASK)
 
 typedef enum
 {
@@ -24,39 +33,29 @@ typedef enum
 
 typedef struct
 {
-	ExprType type;
-} Expr;
-
-Expr* ExprAllocate(size_t size, ExprType type);
-#define EXPR_ALLOCATE(dataType, exprType) ((dataType*)StmtAllocate(sizeof(dataType), exprType))
-void ExprFree(Expr* expression);
-
-typedef struct
-{
-	Expr expr;
-	// Maybe later change to token
-	Token operator;
-	Expr* left;
-	Expr* right;
+	uint8_t operator;
+	uint32_t offset;
+	ExprHandle left;
+	ExprHandle right;
 } ExprBinary;
 
 typedef struct
 {
-	Expr expr;
-	TokenType operator;
-	Expr* operand;
+	uint8_t operator;
+	uint32_t offset;
+	ExprHandle operand;
 } ExprUnary;
 
 typedef struct
 {
-	Expr expr;
-	Expr* expression;
+	ExprHandle expression;
 } ExprGrouping;
 
 typedef struct
 {
-	Expr expr;
-	Token name;
+	SymbolId name;
+	uint32_t offset;
+	uint32_t length;
 } ExprIdentifier;
 
 // Chars have type int
@@ -64,17 +63,22 @@ typedef struct
 // Maybe later add array literal and string
 typedef struct
 {
-	Expr expr;
-	Token literal;
+	// The decoded value. Char literals store the character.
+	union
+	{
+		uint64_t intValue;
+		double floatValue;
+	} value;
+	uint32_t offset;
 	DataType dataType;
 } ExprNumberLiteral;
 
 typedef struct
 {
-	Expr expr;
-	Expr* left;
-	Expr* right;
-	Token operator;
+	uint8_t operator;
+	uint32_t offset;
+	ExprHandle left;
+	ExprHandle right;
 } ExprAssignment;
 
 typedef enum
@@ -93,72 +97,175 @@ typedef enum
 
 typedef struct
 {
-	StmtType type;
-} Stmt;
-
-ARRAY_TEMPLATE_DECLARATION(StmtArray, Stmt*)
-
-Stmt* StmtAllocate(size_t size, StmtType type);
-#define STMT_ALLOCATE(dataType, stmtType) ((dataType*)StmtAllocate(sizeof(dataType), stmtType))
-void StmtFree(Stmt* statement);
-
-typedef struct
-{
-	Stmt stmt;
-	Expr* expresssion;
+	ExprHandle expresssion;
 } StmtExpression;
 
 typedef struct
 {
-	Stmt stmt;
-	Token name;
-	Expr* initializer; // Can be NULL
+	SymbolId name;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	ExprHandle initializer; // Can be AST_HANDLE_NULL
 	// Later also add thing like is struct maybe
 	DataType dataType;
 } StmtVariableDeclaration;
 
 typedef struct
 {
-	Stmt stmt;
-	Token location;
-	Expr* returnValue; // Can be NULL
+	uint32_t offset;
+	ExprHandle returnValue; // Can be AST_HANDLE_NULL
 } StmtReturn;
 
+// The statements of a block are stored next to each other in the block statements of the ast.
 typedef struct
 {
-	Stmt stmt;
-	StmtArray satements;
+	uint32_t start;
+	uint32_t count;
 } StmtBlock;
 
 typedef struct
 {
-	Stmt stmt;
-	Expr* condition;
-	Stmt* thenBlock;
-	Stmt* elseBlock;
+	ExprHandle condition;
+	StmtHandle thenBlock;
+	StmtHandle elseBlock; // Can be AST_HANDLE_NULL
 } StmtIf;
 
 typedef struct
 {
-	Stmt stmt;
-	Expr* condition;
-	Stmt* body;
+	ExprHandle condition;
+	StmtHandle body;
 } StmtWhileLoop;
 
 typedef struct
 {
-	Stmt stmt;
-	Token token;
+	uint32_t offset;
 } StmtBreak;
 
 typedef struct
 {
-	Stmt stmt;
-	Token token;
+	uint32_t offset;
 } StmtContinue;
 
 typedef struct
 {
-	Stmt stmt;
-	Expr* expresssion;
-} StmtPutchar;
\ No newline at end of file
+	ExprHandle expresssion;
+} StmtPutchar;
+
+ARENA_ARRAY_TEMPLATE_DECLARATION(ExprBinaryArray, ExprBinary)
+ARENA_ARRAY_TEMPLATE_DECLARATION(ExprUnaryArray, ExprUnary)
+ARENA_ARRAY_TEMPLATE_DECLARATION(ExprNumberLiteralArray, ExprNumberLiteral)
+ARENA_ARRAY_TEMPLATE_DECLARATION(ExprGroupingArray, ExprGrouping)
+ARENA_ARRAY_TEMPLATE_DECLARATION(ExprIdentifierArray, ExprIdentifier)
+ARENA_ARRAY_TEMPLATE_DECLARATION(ExprAssignmentArray, ExprAssignment)
+
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtExpressionArray, StmtExpression)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtVariableDeclarationArray, StmtVariableDeclaration)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtReturnArray, StmtReturn)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtBlockArray, StmtBlock)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtIfArray, StmtIf)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtWhileLoopArray, StmtWhileLoop)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtBreakArray, StmtBreak)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtContinueArray, StmtContinue)
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtPutcharArray, StmtPutchar)
+
+ARENA_ARRAY_TEMPLATE_DECLARATION(StmtHandleArray, StmtHandle)
+
+typedef struct
+{
+	// The source the offsets point into.
+	StringView source;
+
+	// The pools are allocated from the arena and freed together by AstFree.
+	Arena arena;
+
+	ExprBinaryArray binaries;
+	ExprUnaryArray unaries;
+	ExprNumberLiteralArray numberLiterals;
+	ExprGroupingArray groupings;
+	ExprIdentifierArray identifiers;
+	ExprAssignmentArray assignments;
+
+	StmtExpressionArray expressionStmts;
+	StmtVariableDeclarationArray variableDeclarations;
+	StmtReturnArray returns;
+	StmtBlockArray blocks;
+	StmtIfArray ifs;
+	StmtWhileLoopArray whileLoops;
+	StmtBreakArray breaks;
+	StmtContinueArray continues;
+	StmtPutcharArray putchars;
+
+	StmtHandleArray blockStatements;
+	// The statements of the blocks that are being built. Nested blocks are finished before the outer
+	// ones so the statements are collected here and copied to the block statements at the end.
+	StmtHandleArray blockStack;
+
+	// The top level statements.
+	StmtBlock root;
+} Ast;
+
+void AstInit(Ast* ast);
+void AstFree(Ast* ast);
+// Removes all the nodes but keeps the memory.
+void AstClear(Ast* ast, StringView source);
+
+// Builder
+ExprHandle AstAddBinary(Ast* ast, TokenType operator, uint32_t offset, ExprHandle left, ExprHandle right);
+ExprHandle AstAddUnary(Ast* ast, TokenType operator, uint32_t offset, ExprHandle operand);
+ExprHandle AstAddIntLiteral(Ast* ast, DataType dataType, uint32_t offset, uint64_t value);
+ExprHandle AstAddFloatLiteral(Ast* ast, DataType dataType, uint32_t offset, double value);
+ExprHandle AstAddGrouping(Ast* ast, ExprHandle expression);
+ExprHandle AstAddIdentifier(Ast* ast, SymbolId name, uint32_t offset, uint32_t length);
+ExprHandle AstAddAssignment(Ast* ast, TokenType operator, uint32_t offset, ExprHandle left, ExprHandle right);
+
+StmtHandle AstAddExpressionStmt(Ast* ast, ExprHandle expression);
+StmtHandle AstAddVariableDeclaration(Ast* ast, DataType dataType, SymbolId name, uint32_t nameOffset, uint32_t nameLength, ExprHandle initializer);
+StmtHandle AstAddReturn(Ast* ast, uint32_t offset, ExprHandle returnValue);
+StmtHandle AstAddIf(Ast* ast, ExprHandle condition, StmtHandle thenBlock, StmtHandle elseBlock);
+StmtHandle AstAddWhileLoop(Ast* ast, ExprHandle condition, StmtHandle body);
+StmtHandle AstAddBreak(Ast* ast, uint32_t offset);
+StmtHandle AstAddContinue(Ast* ast, uint32_t offset);
+StmtHandle AstAddPutchar(Ast* ast, ExprHandle expression);
+
+// Blocks are built by calling AstBeginBlock, adding the statements with AstAddToBlock and passing the
+// returned value to AstEndBlock. Blocks can be nested.
+size_t AstBeginBlock(Ast* ast);
+void AstAddToBlock(Ast* ast, StmtHandle stmt);
+StmtBlock AstEndBlock(Ast* ast, size_t blockStart);
+StmtHandle AstAddBlock(Ast* ast, StmtBlock block);
+
+// Copies a node and everything it references from another ast. If symbolMap isn't NULL the names are
+// replaced with symbolMap[name], which is needed when the other ast was parsed with a different symbol table.
+ExprHandle AstCopyExpr(Ast* ast, const Ast* from, ExprHandle expr, const SymbolId* symbolMap);
+StmtHandle AstCopyStmt(Ast* ast, const Ast* from, StmtHandle stmt, const SymbolId* symbolMap);
+// Adds offsetDelta to the source offsets of a node and everything it references. Used to move the nodes after an
+// edit of the source instead of parsing them again.
+void AstShiftExprOffsets(Ast* ast, ExprHandle expr, int32_t offsetDelta);
+void AstShiftStmtOffsets(Ast* ast, StmtHandle stmt, int32_t offsetDelta);
+// The number of nodes in all the pools, including the ones that aren't referenced anymore. The handles in the block
+// statements are counted as nodes too.
+size_t AstNodeCount(const Ast* ast);
+
+// Traversal
+ExprType AstGetExprType(ExprHandle expr);
+StmtType AstGetStmtType(StmtHandle stmt);
+
+const ExprBinary* AstGetBinary(const Ast* ast, ExprHandle expr);
+const ExprUnary* AstGetUnary(const Ast* ast, ExprHandle expr);
+const ExprNumberLiteral* AstGetNumberLiteral(const Ast* ast, ExprHandle expr);
+const ExprGrouping* AstGetGrouping(const Ast* ast, ExprHandle expr);
+const ExprIdentifier* AstGetIdentifier(const Ast* ast, ExprHandle expr);
+const ExprAssignment* AstGetAssignment(const Ast* ast, ExprHandle expr);
+
+const StmtExpression* AstGetExpressionStmt(const Ast* ast, StmtHandle stmt);
+const StmtVariableDeclaration* AstGetVariableDeclaration(const Ast* ast, StmtHandle stmt);
+const StmtReturn* AstGetReturn(const Ast* ast, StmtHandle stmt);
+const StmtBlock* AstGetBlock(const Ast* ast, StmtHandle stmt);
+const StmtIf* AstGetIf(const Ast* ast, StmtHandle stmt);
+const StmtWhileLoop* AstGetWhileLoop(const Ast* ast, StmtHandle stmt);
+const StmtBreak* AstGetBreak(const Ast* ast, StmtHandle stmt);
+const StmtContinue* AstGetContinue(const Ast* ast, StmtHandle stmt);
+const StmtPutchar* AstGetPutchar(const Ast* ast, StmtHandle stmt);
+
+// Returns block->count handles.
+const StmtHandle* AstGetBlockStatements(const Ast* ast, const StmtBlock* block);
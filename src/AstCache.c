@@ -0,0 +1,575 @@
+#include "AstCache.h"
+#include "Assert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t hashContents(StringView contents);
+static bool fileExists(const char* path);
+
+static void appendSection(String* buffer, const void* data, size_t size, uint64_t* offset);
+static void appendPool(String* buffer, const void* items, size_t size, size_t itemSize, AstCachePool* pool);
+static void* loadPool(const String* data, const AstCachePool* pool, size_t itemSize, bool* isValid);
+
+static bool isExprValid(const Ast* ast, ExprHandle expr, bool isOptional);
+static bool isStmtValid(const Ast* ast, StmtHandle stmt, bool isOptional);
+static bool isBinaryOperatorValid(uint8_t operator);
+static bool isDataTypeValid(const DataType* type);
+static bool areNodesValid(const Ast* ast);
+
+typedef enum
+{
+	NODE_UNVISITED,
+	// The children of the node are being checked, so reaching it again means there is a cycle.
+	NODE_VISITING,
+	NODE_VISITED,
+} NodeState;
+
+typedef struct
+{
+	const Ast* ast;
+	// Indexed by the index of the node plus the first index of its type.
+	uint8_t* states;
+	size_t exprFirstIndices[EXPR_ASSIGNMENT + 1];
+	size_t stmtFirstIndices[STMT_PUTCHAR + 1];
+} CycleChecker;
+
+static bool isExprAcyclic(CycleChecker* checker, ExprHandle expr);
+static bool isStmtAcyclic(CycleChecker* checker, StmtHandle stmt);
+// The handles have to be valid.
+static bool isAcyclic(const Ast* ast);
+
+String AstCacheGetPath(const char* directory, StringView source)
+{
+	String path = StringCopy(directory);
+	if ((path.length > 0) && (path.chars[path.length - 1] != '/') && (path.chars[path.length - 1] != '\\'))
+		StringAppend(&path, "/");
+	StringAppendFormat(&path, "%016llx.ast", (unsigned long long)hashContents(source));
+	return path;
+}
+
+bool AstCacheWrite(const Ast* ast, const char* cachePath)
+{
+	ASSERT(ast->blockStack.size == 0);
+
+	AstCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = AST_CACHE_MAGIC;
+	header.version = AST_CACHE_VERSION;
+	header.sourceLength = ast->source.length;
+	header.sourceHash = hashContents(ast->source);
+	header.root = ast->root;
+
+	String buffer = StringCopy("");
+	uint64_t headerOffset;
+	// The header is written again at the end when the offsets are known.
+	appendSection(&buffer, &header, sizeof(header), &headerOffset);
+
+	appendPool(&buffer, ast->binaries.data, ast->binaries.size, sizeof(ExprBinary), &header.binaries);
+	appendPool(&buffer, ast->unaries.data, ast->unaries.size, sizeof(ExprUnary), &header.unaries);
+	appendPool(&buffer, ast->numberLiterals.data, ast->numberLiterals.size, sizeof(ExprNumberLiteral), &header.numberLiterals);
+	appendPool(&buffer, ast->groupings.data, ast->groupings.size, sizeof(ExprGrouping), &header.groupings);
+	appendPool(&buffer, ast->identifiers.data, ast->identifiers.size, sizeof(ExprIdentifier), &header.identifiers);
+	appendPool(&buffer, ast->assignments.data, ast->assignments.size, sizeof(ExprAssignment), &header.assignments);
+
+	appendPool(&buffer, ast->expressionStmts.data, ast->expressionStmts.size, sizeof(StmtExpression), &header.expressionStmts);
+	appendPool(&buffer, ast->variableDeclarations.data, ast->variableDeclarations.size, sizeof(StmtVariableDeclaration), &header.variableDeclarations);
+	appendPool(&buffer, ast->returns.data, ast->returns.size, sizeof(StmtReturn), &header.returns);
+	appendPool(&buffer, ast->blocks.data, ast->blocks.size, sizeof(StmtBlock), &header.blocks);
+	appendPool(&buffer, ast->ifs.data, ast->ifs.size, sizeof(StmtIf), &header.ifs);
+	appendPool(&buffer, ast->whileLoops.data, ast->whileLoops.size, sizeof(StmtWhileLoop), &header.whileLoops);
+	appendPool(&buffer, ast->breaks.data, ast->breaks.size, sizeof(StmtBreak), &header.breaks);
+	appendPool(&buffer, ast->continues.data, ast->continues.size, sizeof(StmtContinue), &header.continues);
+	appendPool(&buffer, ast->putchars.data, ast->putchars.size, sizeof(StmtPutchar), &header.putchars);
+
+	appendPool(&buffer, ast->blockStatements.data, ast->blockStatements.size, sizeof(StmtHandle), &header.blockStatements);
+	memcpy(buffer.chars + headerOffset, &header, sizeof(header));
+
+	bool isValid;
+	FILE* file = fopen(cachePath, "wb");
+	if (file == NULL)
+	{
+		isValid = false;
+	}
+	else
+	{
+		isValid = fwrite(buffer.chars, 1, buffer.length, file) == buffer.length;
+		isValid &= fclose(file) == 0;
+		// Don't leave a truncated file.
+		if (isValid == false)
+			remove(cachePath);
+	}
+
+	StringFree(&buffer);
+	return isValid;
+}
+
+bool AstCacheLoad(CachedAst* cached, const char* cachePath, StringView source)
+{
+	if (fileExists(cachePath) == false)
+		return false;
+
+	String data = StringFromFileMapped(cachePath);
+	const AstCacheHeader* header = (const AstCacheHeader*)data.chars;
+
+	// The hash is checked last, it has to read the whole source.
+	if ((data.length < sizeof(AstCacheHeader))
+		|| (header->magic != AST_CACHE_MAGIC)
+		|| (header->version != AST_CACHE_VERSION)
+		|| (header->sourceLength != source.length)
+		|| (hashContents(source) != header->sourceHash))
+	{
+		StringFreeMapped(&data);
+		return false;
+	}
+
+	Ast* ast = &cached->ast;
+	AstInit(ast);
+	ast->source = source;
+	ast->root = header->root;
+
+	bool isValid = true;
+	ast->binaries.data = loadPool(&data, &header->binaries, sizeof(ExprBinary), &isValid);
+	ast->binaries.size = header->binaries.size;
+	ast->unaries.data = loadPool(&data, &header->unaries, sizeof(ExprUnary), &isValid);
+	ast->unaries.size = header->unaries.size;
+	ast->numberLiterals.data = loadPool(&data, &header->numberLiterals, sizeof(ExprNumberLiteral), &isValid);
+	ast->numberLiterals.size = header->numberLiterals.size;
+	ast->groupings.data = loadPool(&data, &header->groupings, sizeof(ExprGrouping), &isValid);
+	ast->groupings.size = header->groupings.size;
+	ast->identifiers.data = loadPool(&data, &header->identifiers, sizeof(ExprIdentifier), &isValid);
+	ast->identifiers.size = header->identifiers.size;
+	ast->assignments.data = loadPool(&data, &header->assignments, sizeof(ExprAssignment), &isValid);
+	ast->assignments.size = header->assignments.size;
+
+	ast->expressionStmts.data = loadPool(&data, &header->expressionStmts, sizeof(StmtExpression), &isValid);
+	ast->expressionStmts.size = header->expressionStmts.size;
+	ast->variableDeclarations.data = loadPool(&data, &header->variableDeclarations, sizeof(StmtVariableDeclaration), &isValid);
+	ast->variableDeclarations.size = header->variableDeclarations.size;
+	ast->returns.data = loadPool(&data, &header->returns, sizeof(StmtReturn), &isValid);
+	ast->returns.size = header->returns.size;
+	ast->blocks.data = loadPool(&data, &header->blocks, sizeof(StmtBlock), &isValid);
+	ast->blocks.size = header->blocks.size;
+	ast->ifs.data = loadPool(&data, &header->ifs, sizeof(StmtIf), &isValid);
+	ast->ifs.size = header->ifs.size;
+	ast->whileLoops.data = loadPool(&data, &header->whileLoops, sizeof(StmtWhileLoop), &isValid);
+	ast->whileLoops.size = header->whileLoops.size;
+	ast->breaks.data = loadPool(&data, &header->breaks, sizeof(StmtBreak), &isValid);
+	ast->breaks.size = header->breaks.size;
+	ast->continues.data = loadPool(&data, &header->continues, sizeof(StmtContinue), &isValid);
+	ast->continues.size = header->continues.size;
+	ast->putchars.data = loadPool(&data, &header->putchars, sizeof(StmtPutchar), &isValid);
+	ast->putchars.size = header->putchars.size;
+
+	ast->blockStatements.data = loadPool(&data, &header->blockStatements, sizeof(StmtHandle), &isValid);
+	ast->blockStatements.size = header->blockStatements.size;
+
+	// The nodes are checked so a bad file can't make the compiler read outside of the pools, recurse forever or
+	// hit an assert.
+	if ((isValid == false) || (areNodesValid(ast) == false) || (isAcyclic(ast) == false))
+	{
+		StringFreeMapped(&data);
+		return false;
+	}
+
+	cached->data = data;
+	return true;
+}
+
+void AstCacheFree(CachedAst* cached)
+{
+	StringFreeMapped(&cached->data);
+}
+
+// FNV-1a
+static uint64_t hashContents(StringView contents)
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (size_t i = 0; i < contents.length; i++)
+	{
+		hash ^= (uint8_t)contents.chars[i];
+		hash *= 0x100000001B3;
+	}
+	return hash;
+}
+
+static bool fileExists(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	fclose(file);
+	return true;
+}
+
+static void appendSection(String* buffer, const void* data, size_t size, uint64_t* offset)
+{
+	static const char padding[8] = { 0 };
+	StringAppendLen(buffer, padding, (8 - (buffer->length % 8)) % 8);
+	*offset = buffer->length;
+	// Empty pools don't have a buffer.
+	if (size != 0)
+		StringAppendLen(buffer, data, size);
+}
+
+static void appendPool(String* buffer, const void* items, size_t size, size_t itemSize, AstCachePool* pool)
+{
+	pool->size = (uint32_t)size;
+	pool->itemSize = (uint32_t)itemSize;
+	appendSection(buffer, items, size * itemSize, &pool->offset);
+}
+
+// Pools are aligned so the nodes can be read from the mapped file directly. Sets isValid to false if the pool
+// doesn't fit in the file.
+static void* loadPool(const String* data, const AstCachePool* pool, size_t itemSize, bool* isValid)
+{
+	if ((pool->itemSize != itemSize)
+		|| ((pool->offset % 8) != 0)
+		|| (pool->offset > data->length)
+		|| (((uint64_t)pool->size * itemSize) > (data->length - pool->offset)))
+	{
+		*isValid = false;
+		return NULL;
+	}
+	return data->chars + pool->offset;
+}
+
+static bool isExprValid(const Ast* ast, ExprHandle expr, bool isOptional)
+{
+	if (expr == AST_HANDLE_NULL)
+		return isOptional;
+
+	uint32_t index = AST_HANDLE_INDEX(expr);
+	switch (expr >> AST_HANDLE_TYPE_SHIFT)
+	{
+		case EXPR_BINARY: return index < ast->binaries.size;
+		case EXPR_UNARY: return index < ast->unaries.size;
+		case EXPR_NUMBER_LITERAL: return index < ast->numberLiterals.size;
+		case EXPR_GROUPING: return index < ast->groupings.size;
+		case EXPR_IDENTIFIER: return index < ast->identifiers.size;
+		case EXPR_ASSIGNMENT: return index < ast->assignments.size;
+	}
+	return false;
+}
+
+static bool isStmtValid(const Ast* ast, StmtHandle stmt, bool isOptional)
+{
+	if (stmt == AST_HANDLE_NULL)
+		return isOptional;
+
+	uint32_t index = AST_HANDLE_INDEX(stmt);
+	switch (stmt >> AST_HANDLE_TYPE_SHIFT)
+	{
+		case STMT_EXPRESSION: return index < ast->expressionStmts.size;
+		case STMT_VARIABLE_DECLARATION: return index < ast->variableDeclarations.size;
+		case STMT_RETURN: return index < ast->returns.size;
+		case STMT_BLOCK: return index < ast->blocks.size;
+		case STMT_IF: return index < ast->ifs.size;
+		case STMT_WHILE_LOOP: return index < ast->whileLoops.size;
+		case STMT_BREAK: return index < ast->breaks.size;
+		case STMT_CONTINUE: return index < ast->continues.size;
+		case STMT_PUTCHAR: return index < ast->putchars.size;
+	}
+	return false;
+}
+
+// The operators the compiler handles.
+static bool isBinaryOperatorValid(uint8_t operator)
+{
+	switch (operator)
+	{
+		case TOKEN_PLUS:
+		case TOKEN_MINUS:
+		case TOKEN_ASTERISK:
+		case TOKEN_SLASH:
+		case TOKEN_PERCENT:
+		case TOKEN_AMPERSAND:
+		case TOKEN_PIPE:
+		case TOKEN_CIRCUMFLEX:
+		case TOKEN_LESS_THAN:
+		case TOKEN_LESS_THAN_EQUALS:
+		case TOKEN_MORE_THAN:
+		case TOKEN_MORE_THAN_EQUALS:
+		case TOKEN_EQUALS_EQUALS:
+		case TOKEN_BANG_EQUALS:
+		case TOKEN_AMPERSAND_AMPERSAND:
+		case TOKEN_PIPE_PIPE:
+			return true;
+	}
+	return false;
+}
+
+static bool isDataTypeValid(const DataType* type)
+{
+	// Asts with errors aren't written, so DATA_TYPE_ERROR is invalid too.
+	if ((unsigned)type->type >= DATA_TYPE_ERROR)
+		return false;
+
+	// Read as a byte, a bool with a value other than 0 or 1 is undefined. isUnsigned isn't set for floats.
+	uint8_t isUnsigned;
+	memcpy(&isUnsigned, &type->isUnsigned, sizeof(isUnsigned));
+	return DataTypeIsFloat(type) || (isUnsigned <= 1);
+}
+
+// Checks that every handle and offset is in bounds and that the operators and types are ones the compiler
+// handles. This is one pass over the pools, which is a lot cheaper than parsing the source again.
+static bool areNodesValid(const Ast* ast)
+{
+	size_t sourceLength = ast->source.length;
+	size_t blockStatementCount = ast->blockStatements.size;
+
+	for (size_t i = 0; i < ast->binaries.size; i++)
+	{
+		const ExprBinary* node = &ast->binaries.data[i];
+		if ((node->offset >= sourceLength) || (isExprValid(ast, node->left, false) == false) || (isExprValid(ast, node->right, false) == false))
+			return false;
+		if (isBinaryOperatorValid(node->operator) == false)
+			return false;
+	}
+	for (size_t i = 0; i < ast->unaries.size; i++)
+	{
+		const ExprUnary* node = &ast->unaries.data[i];
+		if ((node->offset >= sourceLength) || (isExprValid(ast, node->operand, false) == false))
+			return false;
+		if ((node->operator != TOKEN_MINUS) && (node->operator != TOKEN_PLUS))
+			return false;
+	}
+	for (size_t i = 0; i < ast->numberLiterals.size; i++)
+	{
+		const ExprNumberLiteral* node = &ast->numberLiterals.data[i];
+		if ((node->offset >= sourceLength) || (isDataTypeValid(&node->dataType) == false))
+			return false;
+	}
+	for (size_t i = 0; i < ast->groupings.size; i++)
+	{
+		if (isExprValid(ast, ast->groupings.data[i].expression, false) == false)
+			return false;
+	}
+	for (size_t i = 0; i < ast->identifiers.size; i++)
+	{
+		const ExprIdentifier* node = &ast->identifiers.data[i];
+		if (((size_t)node->offset + node->length) > sourceLength)
+			return false;
+	}
+	for (size_t i = 0; i < ast->assignments.size; i++)
+	{
+		const ExprAssignment* node = &ast->assignments.data[i];
+		if ((node->offset >= sourceLength) || (isExprValid(ast, node->left, false) == false) || (isExprValid(ast, node->right, false) == false))
+			return false;
+		if (node->operator != TOKEN_EQUALS)
+			return false;
+	}
+
+	for (size_t i = 0; i < ast->expressionStmts.size; i++)
+	{
+		if (isExprValid(ast, ast->expressionStmts.data[i].expresssion, false) == false)
+			return false;
+	}
+	for (size_t i = 0; i < ast->variableDeclarations.size; i++)
+	{
+		const StmtVariableDeclaration* node = &ast->variableDeclarations.data[i];
+		if ((((size_t)node->nameOffset + node->nameLength) > sourceLength) || (isExprValid(ast, node->initializer, true) == false))
+			return false;
+		if (isDataTypeValid(&node->dataType) == false)
+			return false;
+	}
+	for (size_t i = 0; i < ast->returns.size; i++)
+	{
+		const StmtReturn* node = &ast->returns.data[i];
+		if ((node->offset >= sourceLength) || (isExprValid(ast, node->returnValue, true) == false))
+			return false;
+	}
+	for (size_t i = 0; i < ast->blocks.size; i++)
+	{
+		const StmtBlock* node = &ast->blocks.data[i];
+		if (((size_t)node->start + node->count) > blockStatementCount)
+			return false;
+	}
+	for (size_t i = 0; i < ast->ifs.size; i++)
+	{
+		const StmtIf* node = &ast->ifs.data[i];
+		if ((isExprValid(ast, node->condition, false) == false) || (isStmtValid(ast, node->thenBlock, false) == false) || (isStmtValid(ast, node->elseBlock, true) == false))
+			return false;
+	}
+	for (size_t i = 0; i < ast->whileLoops.size; i++)
+	{
+		const StmtWhileLoop* node = &ast->whileLoops.data[i];
+		if ((isExprValid(ast, node->condition, false) == false) || (isStmtValid(ast, node->body, false) == false))
+			return false;
+	}
+	for (size_t i = 0; i < ast->breaks.size; i++)
+	{
+		if (ast->breaks.data[i].offset >= sourceLength)
+			return false;
+	}
+	for (size_t i = 0; i < ast->continues.size; i++)
+	{
+		if (ast->continues.data[i].offset >= sourceLength)
+			return false;
+	}
+	for (size_t i = 0; i < ast->putchars.size; i++)
+	{
+		if (isExprValid(ast, ast->putchars.data[i].expresssion, false) == false)
+			return false;
+	}
+
+	for (size_t i = 0; i < blockStatementCount; i++)
+	{
+		if (isStmtValid(ast, ast->blockStatements.data[i], false) == false)
+			return false;
+	}
+	return ((size_t)ast->root.start + ast->root.count) <= blockStatementCount;
+}
+
+static bool isExprAcyclic(CycleChecker* checker, ExprHandle expr)
+{
+	if (expr == AST_HANDLE_NULL)
+		return true;
+
+	uint8_t* state = &checker->states[checker->exprFirstIndices[AstGetExprType(expr)] + AST_HANDLE_INDEX(expr)];
+	if (*state == NODE_VISITED)
+		return true;
+	if (*state == NODE_VISITING)
+		return false;
+	*state = NODE_VISITING;
+
+	const Ast* ast = checker->ast;
+	bool isValid = true;
+	switch (AstGetExprType(expr))
+	{
+		case EXPR_BINARY:
+		{
+			const ExprBinary* node = AstGetBinary(ast, expr);
+			isValid = isExprAcyclic(checker, node->left) && isExprAcyclic(checker, node->right);
+			break;
+		}
+		case EXPR_UNARY:
+			isValid = isExprAcyclic(checker, AstGetUnary(ast, expr)->operand);
+			break;
+		case EXPR_GROUPING:
+			isValid = isExprAcyclic(checker, AstGetGrouping(ast, expr)->expression);
+			break;
+		case EXPR_ASSIGNMENT:
+		{
+			const ExprAssignment* node = AstGetAssignment(ast, expr);
+			isValid = isExprAcyclic(checker, node->left) && isExprAcyclic(checker, node->right);
+			break;
+		}
+		case EXPR_NUMBER_LITERAL:
+		case EXPR_IDENTIFIER:
+			break;
+	}
+
+	*state = NODE_VISITED;
+	return isValid;
+}
+
+static bool isStmtAcyclic(CycleChecker* checker, StmtHandle stmt)
+{
+	if (stmt == AST_HANDLE_NULL)
+		return true;
+
+	uint8_t* state = &checker->states[checker->stmtFirstIndices[AstGetStmtType(stmt)] + AST_HANDLE_INDEX(stmt)];
+	if (*state == NODE_VISITED)
+		return true;
+	if (*state == NODE_VISITING)
+		return false;
+	*state = NODE_VISITING;
+
+	const Ast* ast = checker->ast;
+	bool isValid = true;
+	switch (AstGetStmtType(stmt))
+	{
+		case STMT_EXPRESSION:
+			isValid = isExprAcyclic(checker, AstGetExpressionStmt(ast, stmt)->expresssion);
+			break;
+		case STMT_VARIABLE_DECLARATION:
+			isValid = isExprAcyclic(checker, AstGetVariableDeclaration(ast, stmt)->initializer);
+			break;
+		case STMT_RETURN:
+			isValid = isExprAcyclic(checker, AstGetReturn(ast, stmt)->returnValue);
+			break;
+		case STMT_BLOCK:
+		{
+			const StmtBlock* node = AstGetBlock(ast, stmt);
+			for (uint32_t i = 0; (i < node->count) && isValid; i++)
+				isValid = isStmtAcyclic(checker, ast->blockStatements.data[node->start + i]);
+			break;
+		}
+		case STMT_IF:
+		{
+			const StmtIf* node = AstGetIf(ast, stmt);
+			isValid = isExprAcyclic(checker, node->condition)
+				&& isStmtAcyclic(checker, node->thenBlock)
+				&& isStmtAcyclic(checker, node->elseBlock);
+			break;
+		}
+		case STMT_WHILE_LOOP:
+		{
+			const StmtWhileLoop* node = AstGetWhileLoop(ast, stmt);
+			isValid = isExprAcyclic(checker, node->condition) && isStmtAcyclic(checker, node->body);
+			break;
+		}
+		case STMT_PUTCHAR:
+			isValid = isExprAcyclic(checker, AstGetPutchar(ast, stmt)->expresssion);
+			break;
+		default:
+			break;
+	}
+
+	*state = NODE_VISITED;
+	return isValid;
+}
+
+// Walks the ast from the root like the compiler does. Nodes reachable in more than one way are only checked once.
+static bool isAcyclic(const Ast* ast)
+{
+	CycleChecker checker;
+	checker.ast = ast;
+
+	size_t nodeCount = 0;
+	const size_t exprSizes[] = {
+		[EXPR_BINARY] = ast->binaries.size,
+		[EXPR_UNARY] = ast->unaries.size,
+		[EXPR_NUMBER_LITERAL] = ast->numberLiterals.size,
+		[EXPR_GROUPING] = ast->groupings.size,
+		[EXPR_IDENTIFIER] = ast->identifiers.size,
+		[EXPR_ASSIGNMENT] = ast->assignments.size,
+	};
+	for (int i = 0; i <= EXPR_ASSIGNMENT; i++)
+	{
+		checker.exprFirstIndices[i] = nodeCount;
+		nodeCount += exprSizes[i];
+	}
+
+	// Do while loops don't have a pool.
+	const size_t stmtSizes[] = {
+		[STMT_EXPRESSION] = ast->expressionStmts.size,
+		[STMT_VARIABLE_DECLARATION] = ast->variableDeclarations.size,
+		[STMT_RETURN] = ast->returns.size,
+		[STMT_BLOCK] = ast->blocks.size,
+		[STMT_IF] = ast->ifs.size,
+		[STMT_WHILE_LOOP] = ast->whileLoops.size,
+		[STMT_DO_WHILE_LOOP] = 0,
+		[STMT_BREAK] = ast->breaks.size,
+		[STMT_CONTINUE] = ast->continues.size,
+		[STMT_PUTCHAR] = ast->putchars.size,
+	};
+	for (int i = 0; i <= STMT_PUTCHAR; i++)
+	{
+		checker.stmtFirstIndices[i] = nodeCount;
+		nodeCount += stmtSizes[i];
+	}
+
+	checker.states = calloc(nodeCount + 1, sizeof(uint8_t));
+	if (checker.states == NULL)
+		return false;
+
+	bool isValid = true;
+	for (uint32_t i = 0; (i < ast->root.count) && isValid; i++)
+		isValid = isStmtAcyclic(&checker, ast->blockStatements.data[ast->root.start + i]);
+
+	free(checker.states);
+	return isValid;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Ast.h"
+#include "String.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A cached ast is the node pools of the ast written one after another, so a loaded ast points into the mapped file
+// and nothing has to be converted. Offsets are from the start of the file and every section is aligned to 8 bytes.
+// The files are named after the hash of the source, so a cache directory can hold the asts of many files.
+// The cached ast is the one after constant folding, because a loaded ast can't be changed.
+
+// "AST1"
+#define AST_CACHE_MAGIC 0x31545341
+#define AST_CACHE_VERSION 2
+
+typedef struct
+{
+	uint64_t offset;
+	uint32_t size;
+	// The nodes are stored like they are in memory, so the file can't be used if the size of a node changed.
+	uint32_t itemSize;
+} AstCachePool;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceLength;
+	uint64_t sourceHash;
+	StmtBlock root;
+
+	AstCachePool binaries;
+	AstCachePool unaries;
+	AstCachePool numberLiterals;
+	AstCachePool groupings;
+	AstCachePool identifiers;
+	AstCachePool assignments;
+
+	AstCachePool expressionStmts;
+	AstCachePool variableDeclarations;
+	AstCachePool returns;
+	AstCachePool blocks;
+	AstCachePool ifs;
+	AstCachePool whileLoops;
+	AstCachePool breaks;
+	AstCachePool continues;
+	AstCachePool putchars;
+
+	AstCachePool blockStatements;
+} AstCacheHeader;
+
+typedef struct
+{
+	// The arrays point into the mapped file. It is read only so nothing can be added and it mustn't be passed to
+	// AstFree. The SymbolIds aren't in any symbol table, the compiler only compares them with each other.
+	Ast ast;
+	String data;
+} CachedAst;
+
+// Returns the path of the cached ast of the source in the directory. The returned string has to be freed.
+String AstCacheGetPath(const char* directory, StringView source);
+// The ast has to be from a parse of the source without errors and already folded by the ConstantFolder. Returns
+// false if the file couldn't be written.
+bool AstCacheWrite(const Ast* ast, const char* cachePath);
+// Returns false if the file doesn't exist, is for a different source or is invalid.
+bool AstCacheLoad(CachedAst* cached, const char* cachePath, StringView source);
+void AstCacheFree(CachedAst* cached);
@@ -140,24 +140,24 @@ const char* ExprTypeToString(ExprType type)
 	return "";
 }
 
-void printExpr(Expr* expression, int depth)
+void printExpr(const Ast* ast, ExprHandle expression, int depth)
 {
-	switch (expression->type)
+	switch (AstGetExprType(expression))
 	{
 		case EXPR_BINARY:
 		{
-			ExprBinary* expr = (ExprBinary*)expression;
+			const ExprBinary* expr = AstGetBinary(ast, expression);
 			printf("(");
-			printExpr(expr->left, depth);
-			printTokenType(expr->operator.type);
-			printExpr(expr->right, depth);
+			printExpr(ast, expr->left, depth);
+			printTokenType(expr->operator);
+			printExpr(ast, expr->right, depth);
 			printf(")");
 			//printObjectStart(depth);
 			//printKey("left", depth + 1);
-			//printExpr(expr->left, depth + 1);
+			//printExpr(ast, expr->left, depth + 1);
 			//printMember(depth, "operator", TokenTypeToString(expr->operator));
 			//printKey("right", depth + 1);
-			//printExpr(expr->right, depth + 1);
+			//printExpr(ast, expr->right, depth + 1);
 			//printObjectEnd(depth);
 			break;
 		}
@@ -166,37 +166,45 @@ void printExpr(Expr* expression, int depth)
 
 		case EXPR_NUMBER_LITERAL:
 		{
-			ExprNumberLiteral* expr = (ExprNumberLiteral*)expression;
-			printf("%.*s", expr->literal.text.length, expr->literal.text.chars);
+			// Literals don't store their text. The for loop without a condition creates one that isn't in the source.
+			const ExprNumberLiteral* expr = AstGetNumberLiteral(ast, expression);
+			if (expr->dataType.type == DATA_TYPE_CHAR)
+				printf("'%c'", (char)expr->value.intValue);
+			else if (DataTypeIsFloat(&expr->dataType))
+				printf("%g", expr->value.floatValue);
+			else if (expr->dataType.isUnsigned)
+				printf("%llu", (unsigned long long)expr->value.intValue);
+			else
+				printf("%lld", (long long)expr->value.intValue);
 			//printMemberSeparator();
 			break;
 		}
 
 		case EXPR_UNARY:
 		{
-			ExprUnary* expr = (ExprUnary*)expression;
+			const ExprUnary* expr = AstGetUnary(ast, expression);
 			printTokenType(expr->operator);
-			printExpr(expr->operand, 0);
+			printExpr(ast, expr->operand, 0);
 			/*printObjectStart(depth);
 			printTokenType(expr->operator);
-			printExpr(expr->operand, depth + 1);
+			printExpr(ast, expr->operand, depth + 1);
 			printObjectEnd(depth);*/
 			break;
 		}
 
 		case EXPR_GROUPING:
 		{
-			ExprGrouping* expr = (ExprGrouping*)expression;
+			const ExprGrouping* expr = AstGetGrouping(ast, expression);
 			printf("(");
-			printExpr(expr->expression, depth + 1);
+			printExpr(ast, expr->expression, depth + 1);
 			printf(")");
 			break;
 		}
 
 		case EXPR_IDENTIFIER:
 		{
-			ExprIdentifier* expr = (ExprIdentifier*)expression;
-			printf("%.*s", expr->name.text.length, expr->name.text.chars);
+			const ExprIdentifier* expr = AstGetIdentifier(ast, expression);
+			printf("%.*s", (int)expr->length, ast->source.chars + expr->offset);
 			break;
 		}
 
@@ -206,15 +214,23 @@ void printExpr(Expr* expression, int depth)
 	}
 }
 
-void printStmt(Stmt* statement, int depth)
+void printStmt(const Ast* ast, StmtHandle statement, int depth)
 {
-	switch (statement->type)
+	switch (AstGetStmtType(statement))
 	{
 	case STMT_EXPRESSION:
+	{
+		const StmtExpression* stmt = AstGetExpressionStmt(ast, statement);
 		printObjectStart(depth);
 		printMember(depth, "type", "STMT_EXPRESSION");
+		printKey("expression", depth);
+		printExpr(ast, stmt->expresssion, depth);
+#ifdef PRETTY_PRINT
+		putchar('\n');
+#endif
 		printObjectEnd(depth);
 		break;
+	}
 
 	case STMT_VARIABLE_DECLARATION:
 		break;
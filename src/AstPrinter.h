@@ -7,5 +7,5 @@
 
 const char* TokenTypeToString(TokenType type);
 
-void printExpr(Expr* expr, int depth);
-void printStmt(Stmt* statement, int depth);
\ No newline at end of file
+void printExpr(const Ast* ast, ExprHandle expr, int depth);
+void printStmt(const Ast* ast, StmtHandle statement, int depth);
\ No newline at end of file
@@ -1,6 +1,38 @@
 #include "Cli.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void printUsageAndExit(const char* program);
+
 void runCli(int argCount, char* args[])
 {
 
-}
\ No newline at end of file
+}
+
+static void printUsageAndExit(const char* program)
+{
+	fprintf(stderr, "usage: %s [--ast-cache <directory>]\n", program);
+	exit(1);
+}
+
+CliOptions CliParseOptions(int argCount, char* args[])
+{
+	CliOptions options;
+	options.astCacheDirectory = NULL;
+
+	for (int i = 1; i < argCount; i++)
+	{
+		if ((strcmp(args[i], "--ast-cache") == 0) && ((i + 1) < argCount))
+		{
+			options.astCacheDirectory = args[++i];
+		}
+		else
+		{
+			fprintf(stderr, "unknown argument '%s'\n", args[i]);
+			printUsageAndExit(args[0]);
+		}
+	}
+	return options;
+}
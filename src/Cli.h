@@ -1,3 +1,11 @@
 #pragma once
 
-void runCli(int argCount, char* args[]);
\ No newline at end of file
+typedef struct
+{
+	// NULL if the asts aren't cached.
+	const char* astCacheDirectory;
+} CliOptions;
+
+void runCli(int argCount, char* args[]);
+// Prints the usage and exits if the arguments are invalid.
+CliOptions CliParseOptions(int argCount, char* args[]);
@@ -0,0 +1,960 @@
+#include "CodeGenerator.h"
+#include "Assert.h"
+#include "Alignment.h"
+#include "Generic.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+static void emitLabel(CodeGenerator* generator, int labelIndex);
+static void emitInstruction(CodeGenerator* generator, const char* opcode, int operandCount, AsmOperand destination, AsmOperand source);
+static void emitInstruction0(CodeGenerator* generator, const char* opcode);
+static void emitInstruction1(CodeGenerator* generator, const char* opcode, AsmOperand operand);
+static void emitInstruction2(CodeGenerator* generator, const char* opcode, AsmOperand destination, AsmOperand source);
+static void emitData(CodeGenerator* generator, const char* format, ...);
+static int getSignMaskLabel(CodeGenerator* generator, const DataType* type);
+static int getTwoToThe63Label(CodeGenerator* generator, const DataType* type);
+
+static size_t allocateSingleVariableOnStack(CodeGenerator* generator, size_t size);
+static void allocateLocations(CodeGenerator* generator);
+
+static size_t valueSize(CodeGenerator* generator, IrValue value);
+static bool isUsableAsImmediate(CodeGenerator* generator, IrValue value);
+// Returns the value as an instruction operand of the given size. Smaller sizes read the lower bytes.
+static AsmOperand getOperand(CodeGenerator* generator, IrValue value, size_t size);
+// Returns the value if it can be used as the second operand of an instruction, otherwise loads it into the register.
+static AsmOperand getSourceOperand(CodeGenerator* generator, IrValue value, RegisterGp reg);
+
+// Return the register the value is allocated to or reg if it isn't in one.
+static RegisterGp getRegisterGp(CodeGenerator* generator, IrValue value, RegisterGp reg);
+static RegisterSimd getRegisterSimd(CodeGenerator* generator, IrValue value, RegisterSimd reg);
+// Load the value into reg if it isn't already in a register and return the register it is in.
+static RegisterGp loadRegisterGp(CodeGenerator* generator, IrValue value, RegisterGp reg);
+static RegisterSimd loadRegisterSimd(CodeGenerator* generator, IrValue value, RegisterSimd reg);
+
+// The movs are left out if the value is already in the register.
+static void emitMovToRegisterGp(CodeGenerator* generator, RegisterGp reg, IrValue value);
+static void emitMovFromRegisterGp(CodeGenerator* generator, IrValue value, RegisterGp reg);
+static void emitMovToRegisterSimd(CodeGenerator* generator, RegisterSimd reg, IrValue value);
+static void emitMovFromRegisterSimd(CodeGenerator* generator, IrValue value, RegisterSimd reg);
+static void emitExtendToQword(CodeGenerator* generator, RegisterGp reg, const DataType* type);
+static const char* simdTypeName(const DataType* type);
+static const char* conditionToSuffix(IrCondition condition, bool isUnsigned);
+static void emitConditionalJump(CodeGenerator* generator, const char* suffix, const char* invertedSuffix, const IrInstruction* branch);
+
+static void generateBlock(CodeGenerator* generator, IrBlockIndex blockIndex);
+static void generateInstruction(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateCopy(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateIntBinary(CodeGenerator* generator, const char* op, const IrInstruction* instruction);
+static void generateIntMultiplication(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateIntDivision(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateFloatBinary(CodeGenerator* generator, const char* op, const IrInstruction* instruction);
+static void generateNegate(CodeGenerator* generator, const IrInstruction* instruction);
+// Emits the comparison and returns the suffix of the condition for set and jump instructions.
+// Returns the condition the flags have to be tested for.
+static IrCondition generateComparison(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateCompare(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateConvert(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateUnsignedQwordToFloat(CodeGenerator* generator, RegisterSimd result, const DataType* to);
+static void generateFloatToUnsignedQword(CodeGenerator* generator, RegisterGp result, RegisterSimd source, const DataType* from);
+static void generatePutchar(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateJump(CodeGenerator* generator, const IrInstruction* instruction);
+static void generateBranch(CodeGenerator* generator, const IrInstruction* instruction, const IrInstruction* comparison);
+static void generateReturn(CodeGenerator* generator, const IrInstruction* instruction);
+
+void CodeGeneratorInit(CodeGenerator* generator)
+{
+	LocationArrayInit(&generator->locations);
+	IntArrayInit(&generator->useCounts);
+	RegisterAllocatorInit(&generator->registerAllocator);
+	AsmInstructionArrayInit(&generator->instructions);
+	PeepholeOptimizerInit(&generator->peephole);
+}
+
+void CodeGeneratorFree(CodeGenerator* generator)
+{
+	LocationArrayFree(&generator->locations);
+	IntArrayFree(&generator->useCounts);
+	RegisterAllocatorFree(&generator->registerAllocator);
+	AsmInstructionArrayFree(&generator->instructions);
+}
+
+static void emitLabel(CodeGenerator* generator, int labelIndex)
+{
+	AsmInstruction label = { .isLabel = true, .labelIndex = labelIndex };
+	AsmInstructionArrayAppend(&generator->instructions, label);
+}
+
+static void emitInstruction(CodeGenerator* generator, const char* opcode, int operandCount, AsmOperand destination, AsmOperand source)
+{
+	AsmInstruction instruction = { .isLabel = false, .operandCount = operandCount, .operands = { destination, source } };
+	ASSERT(strlen(opcode) < ASM_OPCODE_SIZE);
+	strcpy(instruction.opcode, opcode);
+	AsmInstructionArrayAppend(&generator->instructions, instruction);
+}
+
+static void emitInstruction0(CodeGenerator* generator, const char* opcode)
+{
+	AsmOperand none = { .type = ASM_OPERAND_NONE };
+	emitInstruction(generator, opcode, 0, none, none);
+}
+
+static void emitInstruction1(CodeGenerator* generator, const char* opcode, AsmOperand operand)
+{
+	AsmOperand none = { .type = ASM_OPERAND_NONE };
+	emitInstruction(generator, opcode, 1, operand, none);
+}
+
+static void emitInstruction2(CodeGenerator* generator, const char* opcode, AsmOperand destination, AsmOperand source)
+{
+	emitInstruction(generator, opcode, 2, destination, source);
+}
+
+static void emitData(CodeGenerator* generator, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	StringAppendVaFormat(&generator->dataSection, format, args);
+	va_end(args);
+}
+
+// xorps and xorpd read 16 aligned bytes.
+static int getSignMaskLabel(CodeGenerator* generator, const DataType* type)
+{
+	int* label = (type->type == DATA_TYPE_FLOAT) ? &generator->floatSignMaskLabel : &generator->doubleSignMaskLabel;
+	if (*label != -1)
+		return *label;
+
+	*label = generator->labelCount++;
+	if (type->type == DATA_TYPE_FLOAT)
+		emitData(generator, "align 16\n.L%d:\n\tdd 0x80000000, 0, 0, 0\n", *label);
+	else
+		emitData(generator, "align 16\n.L%d:\n\tdq 0x8000000000000000, 0\n", *label);
+	return *label;
+}
+
+static int getTwoToThe63Label(CodeGenerator* generator, const DataType* type)
+{
+	int* label = (type->type == DATA_TYPE_FLOAT) ? &generator->floatTwoToThe63Label : &generator->doubleTwoToThe63Label;
+	if (*label != -1)
+		return *label;
+
+	*label = generator->labelCount++;
+	if (type->type == DATA_TYPE_FLOAT)
+		emitData(generator, ".L%d:\n\tdd 0x5F000000\n", *label);
+	else
+		emitData(generator, ".L%d:\n\tdq 0x43E0000000000000\n", *label);
+	return *label;
+}
+
+static size_t allocateSingleVariableOnStack(CodeGenerator* generator, size_t size)
+{
+	// On x86 data in memory should be aligned to the size of the data.
+	generator->stackAllocationSize = ALIGN_UP_TO(size, generator->stackAllocationSize) + size;
+	return generator->stackAllocationSize;
+}
+
+static void allocateLocations(CodeGenerator* generator)
+{
+	const IrFunction* function = generator->function;
+	size_t valueCount = function->valueTypes.size;
+
+	LocationArrayClear(&generator->locations);
+	LocationArrayReserve(&generator->locations, valueCount);
+	IntArrayClear(&generator->useCounts);
+	IntArrayReserve(&generator->useCounts, valueCount);
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		Location location = { .type = LOCATION_STACK, .as.baseOffset = 0 };
+		LocationArrayAppend(&generator->locations, location);
+		IntArrayAppend(&generator->useCounts, 0);
+	}
+
+	for (size_t i = 0; i < function->instructions.size; i++)
+	{
+		const IrInstruction* instruction = &function->instructions.data[i];
+		for (int j = 0; j < 2; j++)
+		{
+			if (instruction->operands[j] != IR_VALUE_NULL)
+				generator->useCounts.data[instruction->operands[j]]++;
+		}
+
+		if (instruction->opcode != IR_OP_CONSTANT)
+			continue;
+
+		// Constants are used directly by the instructions, so they don't need any code or space on the stack.
+		Location* location = &generator->locations.data[instruction->result];
+		if (DataTypeIsInt(&instruction->type))
+		{
+			location->type = LOCATION_INT_CONSTANT;
+			location->as.intConstant = instruction->as.intConstant;
+		}
+		// The bits are emitted directly so the value doesn't get rounded by formatting it as text.
+		else if (instruction->type.type == DATA_TYPE_FLOAT)
+		{
+			float value = (float)instruction->as.floatConstant;
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			location->type = LOCATION_LABEL;
+			location->as.labelIndex = generator->labelCount++;
+			emitData(generator, ".L%d:\n\tdd 0x%08X\n", location->as.labelIndex, bits);
+		}
+		else if (instruction->type.type == DATA_TYPE_DOUBLE)
+		{
+			uint64_t bits;
+			memcpy(&bits, &instruction->as.floatConstant, sizeof(bits));
+			location->type = LOCATION_LABEL;
+			location->as.labelIndex = generator->labelCount++;
+			emitData(generator, ".L%d:\n\tdq 0x%016llX\n", location->as.labelIndex, (unsigned long long)bits);
+		}
+		else
+		{
+			ASSERT_NOT_REACHED();
+		}
+	}
+
+	// Values that aren't used in reachable code aren't allocated and code is never generated for them.
+	RegisterAllocatorAllocate(&generator->registerAllocator, function);
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		Location* location = &generator->locations.data[i];
+		const Allocation* allocation = &generator->registerAllocator.allocations.data[i];
+		switch (allocation->type)
+		{
+			case ALLOCATION_REGISTER_GP:
+				location->type = LOCATION_REGISTER_GP;
+				location->as.gpRegister = allocation->as.gpRegister;
+				break;
+
+			case ALLOCATION_REGISTER_SIMD:
+				location->type = LOCATION_REGISTER_SIMD;
+				location->as.simdRegister = allocation->as.simdRegister;
+				break;
+
+			case ALLOCATION_SPILLED:
+				location->as.baseOffset = allocateSingleVariableOnStack(generator, DataTypeSize(&function->valueTypes.data[i]));
+				break;
+
+			case ALLOCATION_NONE:
+				break;
+		}
+	}
+	generator->putcharBaseOffset = allocateSingleVariableOnStack(generator, SIZE_BYTE);
+}
+
+static size_t valueSize(CodeGenerator* generator, IrValue value)
+{
+	return DataTypeSize(IrGetValueType(generator->function, value));
+}
+
+static bool isUsableAsImmediate(CodeGenerator* generator, IrValue value)
+{
+	const Location* location = &generator->locations.data[value];
+	if (location->type != LOCATION_INT_CONSTANT)
+		return false;
+	// Only mov takes 64 bit immediates, the other instructions sign extend 32 bit ones.
+	int64_t constant = (int64_t)location->as.intConstant;
+	return (valueSize(generator, value) < SIZE_QWORD) || ((constant >= INT32_MIN) && (constant <= INT32_MAX));
+}
+
+static AsmOperand getOperand(CodeGenerator* generator, IrValue value, size_t size)
+{
+	const Location* location = &generator->locations.data[value];
+	switch (location->type)
+	{
+		case LOCATION_STACK:         return AsmStack(location->as.baseOffset, size);
+		case LOCATION_REGISTER_GP:   return AsmRegisterGp(location->as.gpRegister, size);
+		case LOCATION_REGISTER_SIMD: return AsmRegisterSimd(location->as.simdRegister);
+		case LOCATION_LABEL:         return AsmData(location->as.labelIndex);
+		case LOCATION_INT_CONSTANT:  return AsmImmediate(location->as.intConstant, size);
+
+		default:
+		{
+			ASSERT_NOT_REACHED();
+			AsmOperand none = { .type = ASM_OPERAND_NONE };
+			return none;
+		}
+	}
+}
+
+static AsmOperand getSourceOperand(CodeGenerator* generator, IrValue value, RegisterGp reg)
+{
+	size_t size = valueSize(generator, value);
+	if ((generator->locations.data[value].type == LOCATION_INT_CONSTANT) && (isUsableAsImmediate(generator, value) == false))
+	{
+		emitMovToRegisterGp(generator, reg, value);
+		return AsmRegisterGp(reg, size);
+	}
+	return getOperand(generator, value, size);
+}
+
+static RegisterGp getRegisterGp(CodeGenerator* generator, IrValue value, RegisterGp reg)
+{
+	const Location* location = &generator->locations.data[value];
+	return (location->type == LOCATION_REGISTER_GP) ? location->as.gpRegister : reg;
+}
+
+static RegisterSimd getRegisterSimd(CodeGenerator* generator, IrValue value, RegisterSimd reg)
+{
+	const Location* location = &generator->locations.data[value];
+	return (location->type == LOCATION_REGISTER_SIMD) ? location->as.simdRegister : reg;
+}
+
+static RegisterGp loadRegisterGp(CodeGenerator* generator, IrValue value, RegisterGp reg)
+{
+	reg = getRegisterGp(generator, value, reg);
+	emitMovToRegisterGp(generator, reg, value);
+	return reg;
+}
+
+static RegisterSimd loadRegisterSimd(CodeGenerator* generator, IrValue value, RegisterSimd reg)
+{
+	reg = getRegisterSimd(generator, value, reg);
+	emitMovToRegisterSimd(generator, reg, value);
+	return reg;
+}
+
+static void emitMovToRegisterGp(CodeGenerator* generator, RegisterGp reg, IrValue value)
+{
+	const Location* location = &generator->locations.data[value];
+	if ((location->type == LOCATION_REGISTER_GP) && (location->as.gpRegister == reg))
+		return;
+
+	size_t size = valueSize(generator, value);
+	emitInstruction2(generator, "mov", AsmRegisterGp(reg, size), getOperand(generator, value, size));
+}
+
+static void emitMovFromRegisterGp(CodeGenerator* generator, IrValue value, RegisterGp reg)
+{
+	const Location* location = &generator->locations.data[value];
+	ASSERT((location->type == LOCATION_STACK) || (location->type == LOCATION_REGISTER_GP));
+	if ((location->type == LOCATION_REGISTER_GP) && (location->as.gpRegister == reg))
+		return;
+
+	size_t size = valueSize(generator, value);
+	emitInstruction2(generator, "mov", getOperand(generator, value, size), AsmRegisterGp(reg, size));
+}
+
+static void emitMovToRegisterSimd(CodeGenerator* generator, RegisterSimd reg, IrValue value)
+{
+	const Location* location = &generator->locations.data[value];
+	if ((location->type == LOCATION_REGISTER_SIMD) && (location->as.simdRegister == reg))
+		return;
+
+	char opcode[ASM_OPCODE_SIZE];
+	snprintf(opcode, sizeof(opcode), "mov%s", simdTypeName(IrGetValueType(generator->function, value)));
+	emitInstruction2(generator, opcode, AsmRegisterSimd(reg), getOperand(generator, value, valueSize(generator, value)));
+}
+
+static void emitMovFromRegisterSimd(CodeGenerator* generator, IrValue value, RegisterSimd reg)
+{
+	const Location* location = &generator->locations.data[value];
+	ASSERT((location->type == LOCATION_STACK) || (location->type == LOCATION_REGISTER_SIMD));
+	if ((location->type == LOCATION_REGISTER_SIMD) && (location->as.simdRegister == reg))
+		return;
+
+	char opcode[ASM_OPCODE_SIZE];
+	snprintf(opcode, sizeof(opcode), "mov%s", simdTypeName(IrGetValueType(generator->function, value)));
+	emitInstruction2(generator, opcode, getOperand(generator, value, valueSize(generator, value)), AsmRegisterSimd(reg));
+}
+
+// Extends the value of the type in the lower part of the register to the whole register.
+static void emitExtendToQword(CodeGenerator* generator, RegisterGp reg, const DataType* type)
+{
+	size_t size = DataTypeSize(type);
+	if (size == SIZE_QWORD)
+		return;
+
+	if (type->isUnsigned == false)
+	{
+		emitInstruction2(generator, "movsx", AsmRegisterGp(reg, SIZE_QWORD), AsmRegisterGp(reg, size));
+	}
+	// mov to 32 bit register zero extends the upper part.
+	else if (size == SIZE_DWORD)
+	{
+		emitInstruction2(generator, "mov", AsmRegisterGp(reg, SIZE_DWORD), AsmRegisterGp(reg, SIZE_DWORD));
+	}
+	else
+	{
+		emitInstruction2(generator, "movzx", AsmRegisterGp(reg, SIZE_QWORD), AsmRegisterGp(reg, size));
+	}
+}
+
+static const char* simdTypeName(const DataType* type)
+{
+	switch (type->type)
+	{
+		case DATA_TYPE_DOUBLE: return "sd";
+		case DATA_TYPE_FLOAT: return "ss";
+
+		default:
+			ASSERT_NOT_REACHED();
+			return "";
+	}
+}
+
+static const char* conditionToSuffix(IrCondition condition, bool isUnsigned)
+{
+	switch (condition)
+	{
+		case IR_CONDITION_EQUAL: return "e";
+		case IR_CONDITION_NOT_EQUAL: return "ne";
+		case IR_CONDITION_LESS: return isUnsigned ? "b" : "l";
+		case IR_CONDITION_LESS_EQUAL: return isUnsigned ? "be" : "le";
+		case IR_CONDITION_GREATER: return isUnsigned ? "a" : "g";
+		case IR_CONDITION_GREATER_EQUAL: return isUnsigned ? "ae" : "ge";
+
+		default:
+			ASSERT_NOT_REACHED();
+			return "";
+	}
+}
+
+// Jumps to the then target if the condition is true. The peephole optimizer removes the jmp to the else target if
+// it is placed next.
+static void emitConditionalJump(CodeGenerator* generator, const char* suffix, const char* invertedSuffix, const IrInstruction* branch)
+{
+	IrBlockIndex thenTarget = branch->as.targets[0];
+	IrBlockIndex elseTarget = branch->as.targets[1];
+	char opcode[ASM_OPCODE_SIZE];
+
+	if (thenTarget == generator->nextBlock)
+	{
+		snprintf(opcode, sizeof(opcode), "j%s", invertedSuffix);
+		emitInstruction1(generator, opcode, AsmLabel(elseTarget));
+	}
+	else
+	{
+		snprintf(opcode, sizeof(opcode), "j%s", suffix);
+		emitInstruction1(generator, opcode, AsmLabel(thenTarget));
+		emitInstruction1(generator, "jmp", AsmLabel(elseTarget));
+	}
+}
+
+static void generateBlock(CodeGenerator* generator, IrBlockIndex blockIndex)
+{
+	const IrFunction* function = generator->function;
+	const IrBlock* block = &function->blocks.data[blockIndex];
+	if (blockIndex != IR_ENTRY_BLOCK)
+		emitLabel(generator, blockIndex);
+
+	const IrInstruction* instructions = &function->instructions.data[block->firstInstruction];
+	for (uint32_t i = 0; i < block->instructionCount; i++)
+	{
+		const IrInstruction* instruction = &instructions[i];
+
+		// A comparison only used by the branch after it sets the flags for the jump instead of making a value.
+		if ((instruction->opcode == IR_OP_COMPARE)
+		 && (i + 1 < block->instructionCount)
+		 && (instructions[i + 1].opcode == IR_OP_BRANCH)
+		 && (instructions[i + 1].operands[0] == instruction->result)
+		 && (generator->useCounts.data[instruction->result] == 1))
+		{
+			generateBranch(generator, &instructions[i + 1], instruction);
+			i++;
+			continue;
+		}
+
+		generateInstruction(generator, instruction);
+	}
+}
+
+static void generateInstruction(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	bool isFloat = DataTypeIsFloat(&instruction->type);
+
+	switch (instruction->opcode)
+	{
+		case IR_OP_CONSTANT:
+			break;
+
+		case IR_OP_COPY:
+			generateCopy(generator, instruction);
+			break;
+
+		case IR_OP_ADD:
+			if (isFloat)
+				generateFloatBinary(generator, "add", instruction);
+			else
+				generateIntBinary(generator, "add", instruction);
+			break;
+
+		case IR_OP_SUBTRACT:
+			if (isFloat)
+				generateFloatBinary(generator, "sub", instruction);
+			else
+				generateIntBinary(generator, "sub", instruction);
+			break;
+
+		case IR_OP_MULTIPLY:
+			if (isFloat)
+				generateFloatBinary(generator, "mul", instruction);
+			else
+				generateIntMultiplication(generator, instruction);
+			break;
+
+		case IR_OP_DIVIDE:
+			if (isFloat)
+				generateFloatBinary(generator, "div", instruction);
+			else
+				generateIntDivision(generator, instruction);
+			break;
+
+		case IR_OP_MODULO:
+			generateIntDivision(generator, instruction);
+			break;
+
+		case IR_OP_AND: generateIntBinary(generator, "and", instruction); break;
+		case IR_OP_OR:  generateIntBinary(generator, "or", instruction); break;
+		case IR_OP_XOR: generateIntBinary(generator, "xor", instruction); break;
+
+		case IR_OP_NEGATE:  generateNegate(generator, instruction); break;
+		case IR_OP_COMPARE: generateCompare(generator, instruction); break;
+		case IR_OP_CONVERT: generateConvert(generator, instruction); break;
+		case IR_OP_PUTCHAR: generatePutchar(generator, instruction); break;
+		case IR_OP_JUMP:    generateJump(generator, instruction); break;
+		case IR_OP_BRANCH:  generateBranch(generator, instruction, NULL); break;
+		case IR_OP_RETURN:  generateReturn(generator, instruction); break;
+
+		default:
+			ASSERT_NOT_REACHED();
+	}
+}
+
+static void generateCopy(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	IrValue source = instruction->operands[0];
+	const Location* sourceLocation = &generator->locations.data[source];
+	const Location* destinationLocation = &generator->locations.data[instruction->result];
+
+	if (destinationLocation->type == LOCATION_REGISTER_SIMD)
+	{
+		emitMovToRegisterSimd(generator, destinationLocation->as.simdRegister, source);
+		return;
+	}
+	if (sourceLocation->type == LOCATION_REGISTER_SIMD)
+	{
+		emitMovFromRegisterSimd(generator, instruction->result, sourceLocation->as.simdRegister);
+		return;
+	}
+
+	// mov can't have two memory operands, every other combination is a single instruction.
+	if (isUsableAsImmediate(generator, source) || (destinationLocation->type == LOCATION_REGISTER_GP))
+	{
+		size_t size = valueSize(generator, instruction->result);
+		emitInstruction2(generator, "mov", getOperand(generator, instruction->result, size), getOperand(generator, source, size));
+		return;
+	}
+
+	// Floats in memory are copied through a general purpose register too, the type doesn't matter for a copy.
+	emitMovFromRegisterGp(generator, instruction->result, loadRegisterGp(generator, source, REGISTER_RAX));
+}
+
+// Operations that correspond to instructions with encoding op reg, reg/mem/imm.
+static void generateIntBinary(CodeGenerator* generator, const char* op, const IrInstruction* instruction)
+{
+	// The result never shares a register with the operands, so it can be computed in its own register.
+	size_t size = DataTypeSize(&instruction->type);
+	RegisterGp result = getRegisterGp(generator, instruction->result, REGISTER_RAX);
+	emitMovToRegisterGp(generator, result, instruction->operands[0]);
+	AsmOperand rhs = getSourceOperand(generator, instruction->operands[1], REGISTER_RBX);
+	emitInstruction2(generator, op, AsmRegisterGp(result, size), rhs);
+	emitMovFromRegisterGp(generator, instruction->result, result);
+}
+
+static void generateIntMultiplication(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	// The lower half of the product is the same for signed and unsigned numbers, so imul is used for both.
+	// There is no two operand imul for bytes but the lower byte of the 32 bit product is the same.
+	size_t size = DataTypeSize(&instruction->type);
+	size_t multiplicationSize = (size == SIZE_BYTE) ? SIZE_DWORD : size;
+	RegisterGp result = getRegisterGp(generator, instruction->result, REGISTER_RAX);
+	emitMovToRegisterGp(generator, result, instruction->operands[0]);
+	RegisterGp rhs = loadRegisterGp(generator, instruction->operands[1], REGISTER_RBX);
+	emitInstruction2(generator, "imul", AsmRegisterGp(result, multiplicationSize), AsmRegisterGp(rhs, multiplicationSize));
+	emitMovFromRegisterGp(generator, instruction->result, result);
+}
+
+static void generateIntDivision(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	size_t size = DataTypeSize(&instruction->type);
+	bool isUnsigned = instruction->type.isUnsigned;
+	// rax and rdx are never allocated so the divisor can stay in its register.
+	emitMovToRegisterGp(generator, REGISTER_RAX, instruction->operands[0]);
+	RegisterGp divisor = loadRegisterGp(generator, instruction->operands[1], REGISTER_RBX);
+
+	// The dividend is twice the size of the divisor. For bytes it is ax, for the other sizes the upper half is
+	// in rdx, so it has to be zero or sign extended there.
+	if (size == SIZE_BYTE)
+	{
+		emitInstruction2(generator, isUnsigned ? "movzx" : "movsx", AsmRegisterGp(REGISTER_RAX, SIZE_WORD), AsmRegisterGp(REGISTER_RAX, SIZE_BYTE));
+	}
+	else if (isUnsigned)
+	{
+		emitInstruction2(generator, "xor", AsmRegisterGp(REGISTER_RDX, SIZE_DWORD), AsmRegisterGp(REGISTER_RDX, SIZE_DWORD));
+	}
+	else
+	{
+		switch (size)
+		{
+			case SIZE_WORD:  emitInstruction0(generator, "cwd"); break;
+			case SIZE_DWORD: emitInstruction0(generator, "cdq"); break;
+			case SIZE_QWORD: emitInstruction0(generator, "cqo"); break;
+		}
+	}
+
+	emitInstruction1(generator, isUnsigned ? "div" : "idiv", AsmRegisterGp(divisor, size));
+
+	if (instruction->opcode == IR_OP_DIVIDE)
+	{
+		emitMovFromRegisterGp(generator, instruction->result, REGISTER_RAX);
+	}
+	// The remainder of byte division is in ah. ah can't be used in instructions with the registers added in x86-64,
+	// so it is shifted down to al.
+	else if (size == SIZE_BYTE)
+	{
+		emitInstruction2(generator, "shr", AsmRegisterGp(REGISTER_RAX, SIZE_WORD), AsmImmediate(8, SIZE_BYTE));
+		emitMovFromRegisterGp(generator, instruction->result, REGISTER_RAX);
+	}
+	else
+	{
+		emitMovFromRegisterGp(generator, instruction->result, REGISTER_RDX);
+	}
+}
+
+static void generateFloatBinary(CodeGenerator* generator, const char* op, const IrInstruction* instruction)
+{
+	RegisterSimd result = getRegisterSimd(generator, instruction->result, REGISTER_XMM1);
+	char opcode[ASM_OPCODE_SIZE];
+	snprintf(opcode, sizeof(opcode), "%s%s", op, simdTypeName(&instruction->type));
+	emitMovToRegisterSimd(generator, result, instruction->operands[0]);
+	emitInstruction2(generator, opcode, AsmRegisterSimd(result), getOperand(generator, instruction->operands[1], DataTypeSize(&instruction->type)));
+	emitMovFromRegisterSimd(generator, instruction->result, result);
+}
+
+static void generateNegate(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	if (DataTypeIsFloat(&instruction->type))
+	{
+		// Flipping the sign bit instead of computing 0 - x keeps the sign of zero, -0.0 is 0.0 and not -0.0.
+		RegisterSimd result = getRegisterSimd(generator, instruction->result, REGISTER_XMM0);
+		emitMovToRegisterSimd(generator, result, instruction->operands[0]);
+		const char* opcode = (instruction->type.type == DATA_TYPE_FLOAT) ? "xorps" : "xorpd";
+		emitInstruction2(generator, opcode, AsmRegisterSimd(result), AsmData(getSignMaskLabel(generator, &instruction->type)));
+		emitMovFromRegisterSimd(generator, instruction->result, result);
+		return;
+	}
+
+	RegisterGp result = getRegisterGp(generator, instruction->result, REGISTER_RAX);
+	emitMovToRegisterGp(generator, result, instruction->operands[0]);
+	emitInstruction1(generator, "neg", AsmRegisterGp(result, DataTypeSize(&instruction->type)));
+	emitMovFromRegisterGp(generator, instruction->result, result);
+}
+
+static IrCondition generateComparison(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	IrCondition condition = instruction->as.condition;
+
+	if (DataTypeIsFloat(&instruction->type))
+	{
+		// https://stackoverflow.com/questions/8627331/what-does-ordered-unordered-comparison-mean
+		// comis sets the flags like an unsigned comparison. If an operand is NaN it sets the zero, parity and carry
+		// flags, so a < b is compared as b > a to make it false. == and != have to test the parity flag too.
+		IrValue lhsValue = instruction->operands[0];
+		IrValue rhsValue = instruction->operands[1];
+		if ((condition == IR_CONDITION_LESS) || (condition == IR_CONDITION_LESS_EQUAL))
+		{
+			lhsValue = instruction->operands[1];
+			rhsValue = instruction->operands[0];
+			condition = (condition == IR_CONDITION_LESS) ? IR_CONDITION_GREATER : IR_CONDITION_GREATER_EQUAL;
+		}
+
+		RegisterSimd lhs = loadRegisterSimd(generator, lhsValue, REGISTER_XMM1);
+		char opcode[ASM_OPCODE_SIZE];
+		snprintf(opcode, sizeof(opcode), "comi%s", simdTypeName(&instruction->type));
+		emitInstruction2(generator, opcode, AsmRegisterSimd(lhs), getOperand(generator, rhsValue, DataTypeSize(&instruction->type)));
+		return condition;
+	}
+
+	RegisterGp lhs = loadRegisterGp(generator, instruction->operands[0], REGISTER_RAX);
+	AsmOperand rhs = getSourceOperand(generator, instruction->operands[1], REGISTER_RBX);
+	emitInstruction2(generator, "cmp", AsmRegisterGp(lhs, DataTypeSize(&instruction->type)), rhs);
+	return condition;
+}
+
+static void generateCompare(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	IrCondition condition = generateComparison(generator, instruction);
+	bool isFloat = DataTypeIsFloat(&instruction->type);
+	RegisterGp result = getRegisterGp(generator, instruction->result, REGISTER_RAX);
+	char opcode[ASM_OPCODE_SIZE];
+	snprintf(opcode, sizeof(opcode), "set%s", conditionToSuffix(condition, isFloat || instruction->type.isUnsigned));
+	emitInstruction1(generator, opcode, AsmRegisterGp(result, SIZE_BYTE));
+	// The parity flag is set if an operand is NaN.
+	if (isFloat && (condition == IR_CONDITION_EQUAL))
+	{
+		emitInstruction1(generator, "setnp", AsmRegisterGp(REGISTER_RDX, SIZE_BYTE));
+		emitInstruction2(generator, "and", AsmRegisterGp(result, SIZE_BYTE), AsmRegisterGp(REGISTER_RDX, SIZE_BYTE));
+	}
+	else if (isFloat && (condition == IR_CONDITION_NOT_EQUAL))
+	{
+		emitInstruction1(generator, "setp", AsmRegisterGp(REGISTER_RDX, SIZE_BYTE));
+		emitInstruction2(generator, "or", AsmRegisterGp(result, SIZE_BYTE), AsmRegisterGp(REGISTER_RDX, SIZE_BYTE));
+	}
+	emitInstruction2(generator, "movzx", AsmRegisterGp(result, SIZE_DWORD), AsmRegisterGp(result, SIZE_BYTE));
+	emitMovFromRegisterGp(generator, instruction->result, result);
+}
+
+static void generateConvert(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	IrValue operand = instruction->operands[0];
+	const DataType* from = IrGetValueType(generator->function, operand);
+	const DataType* to = &instruction->type;
+	size_t fromSize = DataTypeSize(from);
+	size_t toSize = DataTypeSize(to);
+
+	if (DataTypeIsInt(from) && DataTypeIsInt(to))
+	{
+		RegisterGp result = getRegisterGp(generator, instruction->result, REGISTER_RAX);
+		// If the resulting type is smaller or equal just take the lower bytes.
+		if (fromSize >= toSize)
+		{
+			emitInstruction2(generator, "mov", AsmRegisterGp(result, toSize), getOperand(generator, operand, toSize));
+		}
+		else
+		{
+			emitMovToRegisterGp(generator, result, operand);
+			emitExtendToQword(generator, result, from);
+		}
+		emitMovFromRegisterGp(generator, instruction->result, result);
+	}
+	else if (DataTypeIsInt(from) && DataTypeIsFloat(to))
+	{
+		// cvt instructions require the operand to be 32 or 64 bits
+		RegisterSimd result = getRegisterSimd(generator, instruction->result, REGISTER_XMM1);
+		emitMovToRegisterGp(generator, REGISTER_RAX, operand);
+		if (from->isUnsigned && (fromSize == SIZE_QWORD))
+		{
+			generateUnsignedQwordToFloat(generator, result, to);
+			emitMovFromRegisterSimd(generator, instruction->result, result);
+			return;
+		}
+		emitExtendToQword(generator, REGISTER_RAX, from);
+		char opcode[ASM_OPCODE_SIZE];
+		snprintf(opcode, sizeof(opcode), "cvtsi2%s", simdTypeName(to));
+		emitInstruction2(generator, opcode, AsmRegisterSimd(result), AsmRegisterGp(REGISTER_RAX, SIZE_QWORD));
+		emitMovFromRegisterSimd(generator, instruction->result, result);
+	}
+	else if (DataTypeIsFloat(from) && DataTypeIsInt(to))
+	{
+		// C conversions round towards zero so the truncating version is used.
+		RegisterGp result = getRegisterGp(generator, instruction->result, REGISTER_RAX);
+		RegisterSimd source = loadRegisterSimd(generator, operand, REGISTER_XMM1);
+		if (to->isUnsigned && (toSize == SIZE_QWORD))
+		{
+			generateFloatToUnsignedQword(generator, result, source, from);
+			emitMovFromRegisterGp(generator, instruction->result, result);
+			return;
+		}
+		char opcode[ASM_OPCODE_SIZE];
+		snprintf(opcode, sizeof(opcode), "cvtt%s2si", simdTypeName(from));
+		emitInstruction2(generator, opcode, AsmRegisterGp(result, SIZE_QWORD), AsmRegisterSimd(source));
+		emitMovFromRegisterGp(generator, instruction->result, result);
+	}
+	else if (from->type == to->type)
+	{
+		RegisterSimd result = getRegisterSimd(generator, instruction->result, REGISTER_XMM1);
+		emitMovToRegisterSimd(generator, result, operand);
+		emitMovFromRegisterSimd(generator, instruction->result, result);
+	}
+	else
+	{
+		RegisterSimd result = getRegisterSimd(generator, instruction->result, REGISTER_XMM1);
+		RegisterSimd source = loadRegisterSimd(generator, operand, REGISTER_XMM2);
+		char opcode[ASM_OPCODE_SIZE];
+		snprintf(opcode, sizeof(opcode), "cvt%s2%s", simdTypeName(from), simdTypeName(to));
+		emitInstruction2(generator, opcode, AsmRegisterSimd(result), AsmRegisterSimd(source));
+		emitMovFromRegisterSimd(generator, instruction->result, result);
+	}
+}
+
+// cvtsi2 only converts signed numbers. Values with the top bit set are halved before the conversion and doubled
+// after it. The lowest bit is kept in the halved value so it still rounds the same way. The value is in rax.
+static void generateUnsignedQwordToFloat(CodeGenerator* generator, RegisterSimd result, const DataType* to)
+{
+	int largeLabel = generator->labelCount++;
+	int endLabel = generator->labelCount++;
+	char convert[ASM_OPCODE_SIZE];
+	snprintf(convert, sizeof(convert), "cvtsi2%s", simdTypeName(to));
+	char add[ASM_OPCODE_SIZE];
+	snprintf(add, sizeof(add), "add%s", simdTypeName(to));
+
+	emitInstruction2(generator, "test", AsmRegisterGp(REGISTER_RAX, SIZE_QWORD), AsmRegisterGp(REGISTER_RAX, SIZE_QWORD));
+	emitInstruction1(generator, "js", AsmLabel(largeLabel));
+	emitInstruction2(generator, convert, AsmRegisterSimd(result), AsmRegisterGp(REGISTER_RAX, SIZE_QWORD));
+	emitInstruction1(generator, "jmp", AsmLabel(endLabel));
+
+	emitLabel(generator, largeLabel);
+	emitInstruction2(generator, "mov", AsmRegisterGp(REGISTER_RDX, SIZE_QWORD), AsmRegisterGp(REGISTER_RAX, SIZE_QWORD));
+	emitInstruction2(generator, "shr", AsmRegisterGp(REGISTER_RDX, SIZE_QWORD), AsmImmediate(1, SIZE_BYTE));
+	emitInstruction2(generator, "and", AsmRegisterGp(REGISTER_RAX, SIZE_DWORD), AsmImmediate(1, SIZE_DWORD));
+	emitInstruction2(generator, "or", AsmRegisterGp(REGISTER_RDX, SIZE_QWORD), AsmRegisterGp(REGISTER_RAX, SIZE_QWORD));
+	emitInstruction2(generator, convert, AsmRegisterSimd(result), AsmRegisterGp(REGISTER_RDX, SIZE_QWORD));
+	emitInstruction2(generator, add, AsmRegisterSimd(result), AsmRegisterSimd(result));
+	emitLabel(generator, endLabel);
+}
+
+// cvtt2si only converts to signed numbers. Values of at least 2^63 have 2^63 subtracted before the conversion and
+// the top bit set after it.
+static void generateFloatToUnsignedQword(CodeGenerator* generator, RegisterGp result, RegisterSimd source, const DataType* from)
+{
+	int largeLabel = generator->labelCount++;
+	int endLabel = generator->labelCount++;
+	AsmOperand twoToThe63 = AsmData(getTwoToThe63Label(generator, from));
+	char opcode[ASM_OPCODE_SIZE];
+
+	snprintf(opcode, sizeof(opcode), "comi%s", simdTypeName(from));
+	emitInstruction2(generator, opcode, AsmRegisterSimd(source), twoToThe63);
+	emitInstruction1(generator, "jae", AsmLabel(largeLabel));
+	snprintf(opcode, sizeof(opcode), "cvtt%s2si", simdTypeName(from));
+	emitInstruction2(generator, opcode, AsmRegisterGp(result, SIZE_QWORD), AsmRegisterSimd(source));
+	emitInstruction1(generator, "jmp", AsmLabel(endLabel));
+
+	emitLabel(generator, largeLabel);
+	snprintf(opcode, sizeof(opcode), "mov%s", simdTypeName(from));
+	emitInstruction2(generator, opcode, AsmRegisterSimd(REGISTER_XMM0), AsmRegisterSimd(source));
+	snprintf(opcode, sizeof(opcode), "sub%s", simdTypeName(from));
+	emitInstruction2(generator, opcode, AsmRegisterSimd(REGISTER_XMM0), twoToThe63);
+	snprintf(opcode, sizeof(opcode), "cvtt%s2si", simdTypeName(from));
+	emitInstruction2(generator, opcode, AsmRegisterGp(result, SIZE_QWORD), AsmRegisterSimd(REGISTER_XMM0));
+	emitInstruction2(generator, "btc", AsmRegisterGp(result, SIZE_QWORD), AsmImmediate(63, SIZE_BYTE));
+	emitLabel(generator, endLabel);
+}
+
+static void generatePutchar(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	IrValue operand = instruction->operands[0];
+	ASSERT(valueSize(generator, operand) == SIZE_BYTE);
+
+	// The write syscall takes a pointer to the char.
+	size_t baseOffset;
+	const Location* location = &generator->locations.data[operand];
+	if (location->type == LOCATION_STACK)
+	{
+		baseOffset = location->as.baseOffset;
+	}
+	else
+	{
+		baseOffset = generator->putcharBaseOffset;
+		emitInstruction2(generator, "mov", AsmStack(baseOffset, SIZE_BYTE), getOperand(generator, operand, SIZE_BYTE));
+	}
+
+	emitInstruction2(generator, "mov", AsmRegisterGp(REGISTER_RAX, SIZE_QWORD), AsmImmediate(1, SIZE_QWORD));
+	emitInstruction2(generator, "mov", AsmRegisterGp(REGISTER_RDI, SIZE_QWORD), AsmImmediate(1, SIZE_QWORD));
+	emitInstruction2(generator, "lea", AsmRegisterGp(REGISTER_RSI, SIZE_QWORD), AsmStack(baseOffset, 0));
+	emitInstruction2(generator, "mov", AsmRegisterGp(REGISTER_RDX, SIZE_QWORD), AsmImmediate(1, SIZE_QWORD));
+	emitInstruction0(generator, "syscall");
+}
+
+static void generateJump(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	emitInstruction1(generator, "jmp", AsmLabel(instruction->as.targets[0]));
+}
+
+// If comparison isn't NULL it is the instruction that made the condition and it is generated here.
+static void generateBranch(CodeGenerator* generator, const IrInstruction* instruction, const IrInstruction* comparison)
+{
+	if (comparison != NULL)
+	{
+		// The inverted suffix comes from the same flags so the comparison is only emitted once.
+		IrCondition condition = generateComparison(generator, comparison);
+		bool isFloat = DataTypeIsFloat(&comparison->type);
+		bool isUnsigned = isFloat || comparison->type.isUnsigned;
+		// If an operand is NaN, == is false and != is true. Otherwise the parity flag is clear and the zero flag
+		// decides. The other float conditions are already false for NaN.
+		if (isFloat && ((condition == IR_CONDITION_EQUAL) || (condition == IR_CONDITION_NOT_EQUAL)))
+		{
+			IrBlockIndex unorderedTarget = instruction->as.targets[(condition == IR_CONDITION_EQUAL) ? 1 : 0];
+			emitInstruction1(generator, "jp", AsmLabel(unorderedTarget));
+		}
+		const char* suffix = conditionToSuffix(condition, isUnsigned);
+		const char* invertedSuffix = conditionToSuffix(IrInvertCondition(condition), isUnsigned);
+		emitConditionalJump(generator, suffix, invertedSuffix, instruction);
+		return;
+	}
+
+	IrValue condition = instruction->operands[0];
+	const Location* location = &generator->locations.data[condition];
+	if (location->type == LOCATION_INT_CONSTANT)
+	{
+		emitInstruction1(generator, "jmp", AsmLabel(instruction->as.targets[(location->as.intConstant != 0) ? 0 : 1]));
+		return;
+	}
+
+	size_t size = valueSize(generator, condition);
+	emitInstruction2(generator, "cmp", getOperand(generator, condition, size), AsmImmediate(0, size));
+	emitConditionalJump(generator, "ne", "e", instruction);
+}
+
+static void generateReturn(CodeGenerator* generator, const IrInstruction* instruction)
+{
+	if (instruction->operands[0] == IR_VALUE_NULL)
+	{
+		emitInstruction2(generator, "xor", AsmRegisterGp(REGISTER_RDI, SIZE_DWORD), AsmRegisterGp(REGISTER_RDI, SIZE_DWORD));
+	}
+	else
+	{
+		emitMovToRegisterGp(generator, REGISTER_RDI, instruction->operands[0]);
+	}
+	emitInstruction2(generator, "mov", AsmRegisterGp(REGISTER_RAX, SIZE_QWORD), AsmImmediate(60, SIZE_QWORD));
+	emitInstruction0(generator, "syscall");
+}
+
+String CodeGeneratorGenerate(CodeGenerator* generator, const IrFunction* function)
+{
+	generator->function = function;
+	generator->dataSection = StringCopy("\nsection .data\n");
+	generator->stackAllocationSize = 0;
+	generator->labelCount = (int)function->blocks.size;
+	generator->floatSignMaskLabel = -1;
+	generator->doubleSignMaskLabel = -1;
+	generator->floatTwoToThe63Label = -1;
+	generator->doubleTwoToThe63Label = -1;
+
+	AsmInstructionArrayClear(&generator->instructions);
+
+	allocateLocations(generator);
+	emitInstruction2(generator, "mov", AsmRegisterGp(REGISTER_RBP, SIZE_QWORD), AsmRegisterGp(REGISTER_RSP, SIZE_QWORD));
+	size_t stackSize = ALIGN_UP_TO(16, generator->stackAllocationSize);
+	emitInstruction2(generator, "sub", AsmRegisterGp(REGISTER_RSP, SIZE_QWORD), AsmImmediate(stackSize, SIZE_QWORD));
+
+	const IrBlockIndexArray* layout = &function->layout;
+	for (size_t i = 0; i < layout->size; i++)
+	{
+		if (function->blocks.data[layout->data[i]].isReachable == false)
+			continue;
+
+		generator->nextBlock = IR_BLOCK_NULL;
+		for (size_t j = i + 1; j < layout->size; j++)
+		{
+			if (function->blocks.data[layout->data[j]].isReachable)
+			{
+				generator->nextBlock = layout->data[j];
+				break;
+			}
+		}
+
+		generateBlock(generator, layout->data[i]);
+	}
+
+	PeepholeOptimizerOptimize(&generator->peephole, &generator->instructions);
+	generator->textSection = StringCopy("section .text\nglobal _start\n_start:");
+	AsmRender(&generator->instructions, &generator->textSection);
+
+	StringAppendLen(&generator->textSection, generator->dataSection.chars, generator->dataSection.length);
+	StringFree(&generator->dataSection);
+
+	return generator->textSection;
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(LocationArray, Location)
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Ir.h"
+#include "IntArray.h"
+#include "String.h"
+#include "Registers.h"
+#include "RegisterAllocator.h"
+#include "Assembly.h"
+#include "Peephole.h"
+
+#include <stdint.h>
+
+// Generates x86-64 NASM from the IR. The values are kept in the registers the register allocator assigns to them
+// and the ones it spills get their own slot on the stack. Instructions that can't work on the locations directly
+// use rax, rbx, rdx and xmm0 to xmm2 as scratch registers.
+
+typedef enum
+{
+	LOCATION_STACK,
+	LOCATION_REGISTER_GP,
+	LOCATION_REGISTER_SIMD,
+	LOCATION_INT_CONSTANT,
+	// Float constants are put in the data section.
+	LOCATION_LABEL,
+} LocationType;
+
+typedef struct
+{
+	LocationType type;
+
+	union
+	{
+		// Used if LOCATION_STACK. Real position is [rbp-baseOffset]
+		size_t baseOffset;
+
+		// Used if LOCATION_REGISTER_GP
+		RegisterGp gpRegister;
+		// Used if LOCATION_REGISTER_SIMD
+		RegisterSimd simdRegister;
+
+		// Used if LOCATION_INT_CONSTANT
+		uint64_t intConstant;
+
+		// Used if LOCATION_LABEL
+		int labelIndex;
+	} as;
+} Location;
+
+ARRAY_TEMPLATE_DECLARATION(LocationArray, Location)
+
+typedef struct
+{
+	String textSection;
+	String dataSection;
+	// The text section is rendered from these after the peephole optimizer runs on them.
+	AsmInstructionArray instructions;
+	PeepholeOptimizer peephole;
+
+	const IrFunction* function;
+	RegisterAllocator registerAllocator;
+
+	// Indexed by IrValue.
+	LocationArray locations;
+	IntArray useCounts;
+
+	size_t stackAllocationSize;
+	// The byte putchar writes from when the char isn't already on the stack.
+	size_t putcharBaseOffset;
+
+	// The labels of the blocks are their indices, the labels of the constants and the jumps inside an instruction
+	// come after them.
+	int labelCount;
+	// The labels of the constants that flip the sign of a float and a double, -1 if they aren't emitted yet.
+	int floatSignMaskLabel;
+	int doubleSignMaskLabel;
+	// The same for 2^63, which is used to convert to unsigned 64 bit integers.
+	int floatTwoToThe63Label;
+	int doubleTwoToThe63Label;
+	// The block placed after the one code is generated for. Conditional jumps are inverted to fall through to it.
+	IrBlockIndex nextBlock;
+} CodeGenerator;
+
+void CodeGeneratorInit(CodeGenerator* generator);
+void CodeGeneratorFree(CodeGenerator* generator);
+// Returns a program that runs the function and exits with the value it returns. IrComputeCfg has to be called
+// before. The returned string has to be freed.
+String CodeGeneratorGenerate(CodeGenerator* generator, const IrFunction* function);
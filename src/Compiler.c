@@ -1,66 +1,38 @@
 #include "..\src2\Compiling.h"
 #include "Compiler.h"
 #include "Assert.h"
-#include "Alignment.h"
 #include "Generic.h"
 #include "TerminalColors.h"
 
 #include <stdarg.h>
+#include <string.h>
 
-static void errorAt(Compiler* compiler, Token token, const char* message, ...);
-
-static void emitCode(Compiler* compiler, const char* format, ...);
-static void emitInstruction(Compiler* compiler, const char* format, ...);
-static void emitData(Compiler* compiler, const char* format, ...);
-
-// Maybe later add emit jump 
-static void emitResult(Compiler* compiler, const Result* result);
-static void emitIntConstant(Compiler* compiler, const Result* result);
-static void emitMovToRegisterGp(Compiler* compiler, RegisterGp reg, const Result* result);
-static void emitMovFromRegisterGp(Compiler* compiler, const Result* result, RegisterGp reg);
-static void emitMovToRegisterSimd(Compiler* compiler, RegisterSimd reg, const Result* result);
-static void emitMovFromRegisterSimd(Compiler* compiler, const Result* result, RegisterSimd reg);
-static void emitSimdTypeName(Compiler* compiler, const DataType* type);
+static void errorAt(Compiler* compiler, uint32_t offset, size_t length, const char* message, ...);
 
 static void beginScope(Compiler* compiler);
 static void endScope(Compiler* compiler);
-static int allocateLabel(Compiler* compiler);
-static size_t allocateSingleVariableOnStack(Compiler* compiler, size_t size);
-static Result allocateTemp(Compiler* compiler, const DataType* dataType);
-static void freeTemp(Compiler* compiler, const Result* temp);
-static void freeIfIsTemp(Compiler* compiler, const Result* value);
 // Returns false if the variable was already defined.
-static bool declareLocalVariable(Compiler* compiler, StringView name, const DataType* type, Result* result);
-static bool resolveLocalVariable(Compiler* compiler, StringView name, Result* result);
-
-static const char* tokenTypeToCondition(TokenType token, bool isUnsigned);
-
-static int getIntegerConversionRank(const DataType* dataType);
-static DataType binaryExpressionGetResultingType(const DataType* a, const DataType* b);
-
-static bool isResultLvalue(const Result* result);
-
-static Result convertToType(Compiler* compiler, const Result* value, const DataType* type);
-
-static Result compileExpr(Compiler* compiler, const Expr* expr);
-static Result compileExprNumberLiteral(Compiler* compiler, const ExprNumberLiteral* expr);
-// Maybe use this later for asignment operators like +=
-static Result compileExprBinary(Compiler* compiler, const ExprBinary* expr);
-static Result compileSimpleIntExprBinary(Compiler* compiler, const char* op, const Result* lhs, const Result* rhs);
-static Result compileIntDivisionOrMultiplcation(Compiler* compiler, TokenType operator, const char* op, const Result* lhs, const Result* rhs);
-static Result compileFloatExprBinary(Compiler* compiler, const char* op, const Result* lhs, const Result* rhs);
-static Result compileComparasion(Compiler* compiler, Token op, const Result* lhs, const Result* rhs);
-static Result compileAnd(Compiler* compiler, const Expr* lhs, const Expr* rhs);
-static Result compileOr(Compiler* compiler, const Expr* lhs, const Expr* rhs);
-static Result compileExprGrouping(Compiler* compiler, const ExprGrouping* expr);
-static Result compileExprUnary(Compiler* compiler, const ExprUnary* expr);
-static Result compileNegation(Compiler* compiler, const Result* operand);
-static Result compileFloatNegation(Compiler* compiler, const Result* operand);
-static Result compileExprIdentifier(Compiler* compiler, const ExprIdentifier* expr);
-static Result compileExprAssignment(Compiler* compiler, const ExprAssignment* expr);
-static void moveBetweenMemory(Compiler* compiler, const Result* lhs, const Result* rhs);
-
-static void compileStmt(Compiler* compiler, const Stmt* stmt);
+static bool declareLocalVariable(Compiler* compiler, SymbolId name, const DataType* type, IrValue* value);
+static bool resolveLocalVariable(Compiler* compiler, SymbolId name, IrValue* value);
+
+static IrCondition tokenTypeToCondition(TokenType token);
+
+static IrValue convertToType(Compiler* compiler, IrValue value, const DataType* type);
+// Starts a new block for the code after a jump. It can only be reached if the jump is skipped over.
+static void startBlockAfterJump(Compiler* compiler);
+
+static IrValue compileExpr(Compiler* compiler, ExprHandle expr);
+static IrValue compileExprNumberLiteral(Compiler* compiler, const ExprNumberLiteral* expr);
+static IrValue compileExprBinary(Compiler* compiler, const ExprBinary* expr);
+static IrValue compileAndOr(Compiler* compiler, TokenType operator, ExprHandle lhs, ExprHandle rhs);
+// Returns an integer that is nonzero if the expression is true, which can be used by a branch.
+static IrValue compileCondition(Compiler* compiler, ExprHandle expr);
+static IrValue compileExprGrouping(Compiler* compiler, const ExprGrouping* expr);
+static IrValue compileExprUnary(Compiler* compiler, const ExprUnary* expr);
+static IrValue compileExprIdentifier(Compiler* compiler, const ExprIdentifier* expr);
+static IrValue compileExprAssignment(Compiler* compiler, const ExprAssignment* expr);
+
+static void compileStmt(Compiler* compiler, StmtHandle stmt);
 static void compileStmtExpression(Compiler* compiler, const StmtExpression* stmt);
 static void compileStmtReturn(Compiler* compiler, const StmtReturn* stmt);
 static void compileVariableDeclaration(Compiler* compiler, const StmtVariableDeclaration* stmt);
@@ -73,28 +45,35 @@ static void compileStmtPutchar(Compiler* compiler, const StmtPutchar* stmt);
 
 void CompilerInit(Compiler* compiler)
 {
-	//LocalVariableTableInit(&compiler->localVariables);
-	TempArrayInit(&compiler->temps);
+	IrFunctionInit(&compiler->function);
+	CodeGeneratorInit(&compiler->codeGenerator);
+	LocalVariableTableInit(&compiler->localVariables);
+	ScopeEntryArrayInit(&compiler->scopeEntries);
+	ScopeArrayInit(&compiler->scopes);
 }
 
 void CompilerFree(Compiler* compiler)
 {
-	//LocalVariableTableFree(&compiler->localVariables);
-	TempArrayFree(&compiler->temps);
+	IrFunctionFree(&compiler->function);
+	CodeGeneratorFree(&compiler->codeGenerator);
+	LocalVariableTableFree(&compiler->localVariables);
+	ScopeEntryArrayFree(&compiler->scopeEntries);
+	ScopeArrayFree(&compiler->scopes);
 }
 
-void errorAt(Compiler* compiler, Token token, const char* message, ...)
+void errorAt(Compiler* compiler, uint32_t offset, size_t length, const char* message, ...)
 {
 	compiler->hadError = true;
 
-	const FileInfo* fileInfo = compiler->fileInfo;
-	size_t lineOffset = token.text.chars - (fileInfo->source.chars + fileInfo->lineStartOffsets.data[token.line]);
-	StringView line = FileInfoGetLine(fileInfo, token.line);
+	FileInfo* fileInfo = compiler->fileInfo;
+	size_t lineNumber = FileInfoGetLineNumber(fileInfo, offset);
+	StringView line = FileInfoGetLine(fileInfo, lineNumber);
+	size_t lineOffset = (fileInfo->source.chars + offset) - line.chars;
 
 	fprintf(
 		stderr,
-		"%s:%d:%d: " TERM_COL_RED "error: " TERM_COL_RESET,
-		fileInfo->filename, token.line, lineOffset
+		"%s:%zu:%zu: " TERM_COL_RED "error: " TERM_COL_RESET,
+		fileInfo->filename, lineNumber, lineOffset
 	);
 
 	va_list args;
@@ -105,675 +84,186 @@ void errorAt(Compiler* compiler, Token token, const char* message, ...)
 	fprintf(stderr,
 		"\n%.*s\n"
 		"%*s" TERM_COL_GREEN "^",
-		line.length, line.chars,
-		lineOffset, " "
+		(int)line.length, line.chars,
+		(int)lineOffset, " "
 	);
 
-	for (size_t i = 0; i < token.text.length - 1; i++)
+	for (size_t i = 0; i < length - 1; i++)
 		fputc('~', stderr);
 
 	fprintf(stderr, TERM_COL_RESET "\n");
 }
 
-static void emitCode(Compiler* compiler, const char* format, ...)
-{
-	va_list args;
-	va_start(args, format);
-	StringAppendVaFormat(&compiler->textSection, format, args);
-	va_end(args);
-}
-
-static void emitInstruction(Compiler* compiler, const char* format, ...)
-{
-	emitCode(compiler, "\n\t");
-	va_list args;
-	va_start(args, format);
-	StringAppendVaFormat(&compiler->textSection, format, args);
-	va_end(args);
-}
-
-void emitData(Compiler* compiler, const char* format, ...)
-{
-	va_list args;
-	va_start(args, format);
-	StringAppendVaFormat(&compiler->dataSection, format, args);
-	va_end(args);
-}
-
-static void emitResult(Compiler* compiler, const Result* result)
-{
-	switch (result->locationType)
-	{
-		case RESULT_LOCATION_INT_CONSTANT:
-			emitIntConstant(compiler, result);
-			break;
-
-		case RESULT_LOCATION_BASE_OFFSET:
-			emitCode(
-				compiler, "%s [rbp-%zu]",
-				dataSizeToString(DataTypeSize(&result->dataType)), result->location.baseOffset
-			);
-			break;
-
-		case RESULT_LOCATION_LABEL:
-		case RESULT_LOCATION_LABEL_COSTANT:
-			emitCode(compiler, "[.L%d]", result->location.labelIndex);
-			break;
-
-		case RESULT_LOCATION_TEMP:
-			emitCode(
-				compiler, "%s [rbp-%zu]",
-				dataSizeToString(DataTypeSize(&result->dataType)), 
-				compiler->temps.data[result->location.tempIndex].baseOffset
-			);
-			break;
-
-		default:
-			ASSERT_NOT_REACHED();
-	}
-}
-
-void emitIntConstant(Compiler* compiler, const Result* result)
-{
-	// Don't know if there is a difference between signed and unsigned here.
-	switch (result->dataType.type)
-	{
-		case DATA_TYPE_CHAR:
-			emitCode(compiler, "%d", result->location.charConstant);
-			break;
-		case DATA_TYPE_SHORT:
-			emitCode(compiler, "%d", result->location.shortConstant);
-			break;
-		case DATA_TYPE_INT:
-			emitCode(compiler, "%d", result->location.intConstant);
-			break;
-		case DATA_TYPE_LONG:
-			emitCode(compiler, "%d", result->location.intConstant);
-			break;
-		case DATA_TYPE_LONG_LONG:
-			emitCode(compiler, "%lld", result->location.longLongConstant);
-			break;
-
-		default:
-			ASSERT_NOT_REACHED();
-	}
-}
-
-static void emitMovToRegisterGp(Compiler* compiler, RegisterGp reg, const Result* result)
-{
-	emitInstruction(compiler, "mov %s, ", RegisterGpToString(reg, DataTypeSize(&result->dataType)));
-	emitResult(compiler, result);
-}
-
-static void emitMovFromRegisterGp(Compiler* compiler, const Result* result, RegisterGp reg)
-{
-	emitInstruction(compiler, "mov ");
-	emitResult(compiler, result);
-	emitCode(compiler, ", %s", RegisterGpToString(reg, DataTypeSize(&result->dataType)));
-}
-
-static void emitMovToRegisterSimd(Compiler* compiler, RegisterSimd reg, const Result* result)
-{
-	switch (DataTypeSize(&result->dataType))
-	{
-		case SIZE_DWORD: emitInstruction(compiler, "movss %s, ", RegisterSimdToString(reg)); break;
-		case SIZE_QWORD: emitInstruction(compiler, "movsd %s, ", RegisterSimdToString(reg)); break;
-		default:
-			ASSERT_NOT_REACHED();
-	}
-	emitResult(compiler, result);
-}
-
-static void emitMovFromRegisterSimd(Compiler* compiler, const Result* result, RegisterSimd reg)
-{
-	switch (DataTypeSize(&result->dataType))
-	{
-		case SIZE_DWORD: emitInstruction(compiler, "movss "); break;
-		case SIZE_QWORD: emitInstruction(compiler, "movsd "); break;
-		default:
-			ASSERT_NOT_REACHED();
-	}
-	emitResult(compiler, result);
-	emitCode(compiler, ", %s", RegisterSimdToString(reg));
-}
-
-void emitSimdTypeName(Compiler* compiler, const DataType* type)
-{
-	switch (type->type)
-	{
-		case DATA_TYPE_DOUBLE:
-			emitCode(compiler, "sd");
-			break;
-		case DATA_TYPE_FLOAT:
-			emitCode(compiler, "ss");
-			break;
-		// This is bad
-		default:
-			emitCode(compiler, "si");
-			break;
-	}
-}
-
 void beginScope(Compiler* compiler)
 {
-	Scope scope;
-	LocalVariableTableInit(&scope.localVariables);
-	if (compiler->currentScope == NULL)
-	{
-		scope.enclosing = NULL;
-		compiler->currentScope = &scope;
-	}
-	else
-	{
-		scope.enclosing = compiler->currentScope;
-		compiler->currentScope = &scope;
-	}
+	Scope scope = { .firstEntry = compiler->scopeEntries.size };
+	ScopeArrayAppend(&compiler->scopes, scope);
 }
 
 void endScope(Compiler* compiler)
 {
-	LocalVariableTableFree(&compiler->currentScope->localVariables);
-	compiler->currentScope = compiler->currentScope->enclosing;
-}
-
-static int allocateLabel(Compiler* compiler)
-{
-	return compiler->labelCount++;
-}
+	ASSERT(compiler->scopes.size > 0);
+	size_t firstEntry = compiler->scopes.data[compiler->scopes.size - 1].firstEntry;
+	compiler->scopes.size--;
 
-static size_t allocateSingleVariableOnStack(Compiler* compiler, size_t size)
-{
-	// On x86 data in memory should be aligned to the size of the data.
-	// If memory is not aligned the cpu might need to perform 2 loads
-	// or with some instructions the program might crash.
-	compiler->stackAllocationSize = ALIGN_UP_TO(size, compiler->stackAllocationSize) + size;
-	return compiler->stackAllocationSize;
-}
-
-Result allocateTemp(Compiler* compiler, const DataType* dataType)
-{
-	Result result;
-	result.locationType = RESULT_LOCATION_TEMP;
-	result.dataType = *dataType;
-
-	size_t tempSize = DataTypeSize(dataType);
-	for (size_t i = 0; i < compiler->temps.size; i++)
+	// Undo the declarations in reverse order so a variable declared twice in nested scopes gets the right one back.
+	while (compiler->scopeEntries.size > firstEntry)
 	{
-		if ((compiler->temps.data[i].isAllocated == false)
-		 && (compiler->temps.data[i].size >= tempSize))
+		compiler->scopeEntries.size--;
+		ScopeEntry* entry = &compiler->scopeEntries.data[compiler->scopeEntries.size];
+		if (entry->isShadowing)
+		{
+			LocalVariableTableSet(&compiler->localVariables, &entry->name, entry->shadowed);
+		}
+		else
 		{
-			compiler->temps.data[i].isAllocated = true;
-			result.location.tempIndex = i;
-			return result;
+			LocalVariableTableRemove(&compiler->localVariables, &entry->name);
 		}
 	}
-
-	Temp newTemp = {
-		.baseOffset = allocateSingleVariableOnStack(compiler, tempSize),
-		.size = tempSize,
-		.isAllocated = true
-	};
-	result.location.tempIndex = compiler->temps.size;
-	TempArrayAppend(&compiler->temps, newTemp);
-
-	return result;
 }
 
-static void freeTemp(Compiler* compiler, const Result* temp)
+static bool declareLocalVariable(Compiler* compiler, SymbolId name, const DataType* type, IrValue* value)
 {
-	compiler->temps.data[temp->location.tempIndex].isAllocated = false;
-}
+	ASSERT(compiler->scopes.size > 0);
 
-static void freeIfIsTemp(Compiler* compiler, const Result* value)
-{
-	if (value->locationType == RESULT_LOCATION_TEMP)
+	ScopeEntry entry;
+	entry.name = name;
+	entry.isShadowing = LocalVariableTableGet(&compiler->localVariables, &name, &entry.shadowed);
+	if (entry.isShadowing && (entry.shadowed.scopeDepth == compiler->scopes.size))
 	{
-		freeTemp(compiler, value);
+		return false;
 	}
-}
-
-static bool declareLocalVariable(Compiler* compiler, StringView name, const DataType* type, Result* result)
-{
-	//if (compiler->currentScope == NULL)
-	//{
-	//	GlobalVariable;
-	//}
-	ASSERT(compiler->currentScope != NULL);
+	ScopeEntryArrayAppend(&compiler->scopeEntries, entry);
 
+	// Every declaration gets its own value, even if it shadows a variable with the same name.
 	LocalVariable variable;
-	if (LocalVariableTableGet(&compiler->currentScope->localVariables, &name, &variable))
-	{
-		return false;
-	}
-	else
-	{
-		// If is not array
-		variable.dataType = *type;
-		variable.baseOffset = allocateSingleVariableOnStack(compiler, DataTypeSize(type));
-		result->dataType = *type;
-		result->locationType = RESULT_LOCATION_BASE_OFFSET;
-		result->location.baseOffset = variable.baseOffset;
-		// LocalVariable could just store a result
-		LocalVariableTableSet(&compiler->currentScope->localVariables, &name, variable);
-		return true;
-	}
+	variable.dataType = *type;
+	variable.value = IrAddValue(&compiler->function, type);
+	variable.scopeDepth = compiler->scopes.size;
+	LocalVariableTableSet(&compiler->localVariables, &name, variable);
+	*value = variable.value;
+	return true;
 }
 
-bool resolveLocalVariable(Compiler* compiler, StringView name, Result* result)
+bool resolveLocalVariable(Compiler* compiler, SymbolId name, IrValue* value)
 {
 	LocalVariable local;
-
-	Scope* scope = compiler->currentScope;
-	while (scope != NULL)
+	if (LocalVariableTableGet(&compiler->localVariables, &name, &local) == false)
 	{
-		if (LocalVariableTableGet(&scope->localVariables, &name, &local))
-		{
-			result->dataType = local.dataType;
-			result->locationType = RESULT_LOCATION_BASE_OFFSET;
-			result->location.baseOffset = local.baseOffset;
-			return true;
-		}
-
-		scope = scope->enclosing;
+		return false;
 	}
 
-	return false;
+	*value = local.value;
+	return true;
 }
 
-const char* tokenTypeToCondition(TokenType token, bool isUnsigned)
+static IrCondition tokenTypeToCondition(TokenType token)
 {
 	switch (token)
 	{
-		case TOKEN_EQUALS_EQUALS: return "e";
-		case TOKEN_BANG_EQUALS: return "ne";
-		case TOKEN_LESS_THAN: return isUnsigned ? "b" : "l";
-		case TOKEN_LESS_THAN_EQUALS: return isUnsigned ? "be" : "le";
-		case TOKEN_MORE_THAN: return isUnsigned ? "a" : "g";
-		case TOKEN_MORE_THAN_EQUALS: return isUnsigned ? "ae" : "ge";
+		case TOKEN_EQUALS_EQUALS: return IR_CONDITION_EQUAL;
+		case TOKEN_BANG_EQUALS: return IR_CONDITION_NOT_EQUAL;
+		case TOKEN_LESS_THAN: return IR_CONDITION_LESS;
+		case TOKEN_LESS_THAN_EQUALS: return IR_CONDITION_LESS_EQUAL;
+		case TOKEN_MORE_THAN: return IR_CONDITION_GREATER;
+		case TOKEN_MORE_THAN_EQUALS: return IR_CONDITION_GREATER_EQUAL;
 
 		default:
 			ASSERT_NOT_REACHED();
-			return "";
-	}
-}
-
-static int getIntegerConversionRank(const DataType* dataType)
-{
-	switch (dataType->type)
-	{
-		case DATA_TYPE_CHAR:	   return 1;
-		case DATA_TYPE_SHORT:	   return 2;
-		case DATA_TYPE_INT:		   return 3;
-		case DATA_TYPE_LONG:	   return 4;
-		case DATA_TYPE_LONG_LONG:  return 5;
-
-		default:
-			return -1;
-	}
-}
-
-static DataType binaryExpressionGetResultingType(const DataType* a, const DataType* b)
-{
-	DataType result;
-
-	if ((a->type == DATA_TYPE_LONG_DOUBLE) || (b->type == DATA_TYPE_LONG_DOUBLE))
-	{
-		result.type = DATA_TYPE_LONG_DOUBLE;
-		return result;
-	}
-
-	if ((a->type == DATA_TYPE_DOUBLE) || (b->type == DATA_TYPE_DOUBLE))
-	{
-		result.type = DATA_TYPE_DOUBLE;
-		return result;
+			return IR_CONDITION_EQUAL;
 	}
-
-	if ((a->type == DATA_TYPE_FLOAT) || (b->type == DATA_TYPE_FLOAT))
-	{
-		result.type = DATA_TYPE_FLOAT;
-		return result;
-	}
-
-	int aConversionRank = getIntegerConversionRank(a);
-	int bConversionRank = getIntegerConversionRank(b);
-	if ((aConversionRank == -1) || (bConversionRank == -1))
-	{
-		result.type = DATA_TYPE_ERROR;
-		return result;
-	}
-
-	if (a->isUnsigned == b->isUnsigned)
-	{
-		result.type = (aConversionRank > bConversionRank) ? a->type : b->type;
-		result.isUnsigned = a->isUnsigned;
-		return result;
-	}
-	else
-	{
-		if ((a->isUnsigned) && (aConversionRank >= bConversionRank))
-		{
-			result.type = a->type;
-			result.isUnsigned = true;
-			return result;
-		}
-		else if ((b->isUnsigned) && (bConversionRank >= aConversionRank))
-		{
-			result.type = b->type;
-			result.isUnsigned = true;
-			return result;
-		}
-		// Simplify this later if the signed type has higher conversion rank
-		else if ((b->isUnsigned))
-		{
-			result.type = a->type;
-			result.isUnsigned = false;
-			return result;
-		}
-		else if ((a->isUnsigned))
-		{
-			result.type = b->type;
-			result.isUnsigned = false;
-			return result;
-		}
-	}
-
-	// Should have returned at integerConversionRank == -1
-	ASSERT_NOT_REACHED();
-		
-	result.type = DATA_TYPE_ERROR;
-	return result;
 }
 
-bool isResultLvalue(const Result* result)
+static IrValue convertToType(Compiler* compiler, IrValue value, const DataType* type)
 {
-	return (result->locationType == RESULT_LOCATION_BASE_OFFSET)
-		|| (result->locationType == RESULT_LOCATION_LABEL);
+	if (DataTypeEquals(IrGetValueType(&compiler->function, value), type))
+		return value;
+	return IrEmitConvert(&compiler->function, type, value);
 }
 
-Result convertToType(Compiler* compiler, const Result* value, const DataType* type)
+static void startBlockAfterJump(Compiler* compiler)
 {
-	if (value->locationType == RESULT_LOCATION_INT_CONSTANT)
-	{
-		// evaluateConstantConversion(compiler, value, type);
-	}
-
-	Result result;
-	result = *value;
-	result.dataType = *type;
-
-	size_t valueTypeSize = DataTypeSize(&value->dataType);
-	size_t resultTypeSize = DataTypeSize(type);
-
-	if (DataTypeIsInt(type) && DataTypeIsInt(&value->dataType))
-	{
-		// If the resulting type is smaller or equal just take the lower bytes.
-		if (valueTypeSize >= resultTypeSize)
-		{
-			return result;
-		}
-		// Conversion from unsigned to signed and unsigned to unsigned types.
-		else if (value->dataType.isUnsigned)
-		{
-			// mov to 32 bit register zero extends the upper part.
-			if ((valueTypeSize == SIZE_DWORD) && (resultTypeSize == SIZE_QWORD))
-			{
-				emitMovToRegisterGp(compiler, REGISTER_RAX, value);
-				freeIfIsTemp(compiler, value);
-				result = allocateTemp(compiler, type);
-				emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-				return result;
-			}
-			else
-			{
-				//emitInstruction(compiler, "movzx %s, ", RegisterGpToString(REGISTER_RAX, resultTypeSize));
-				//emitResult(compiler, value);
-				emitMovToRegisterGp(compiler, REGISTER_RAX, value);
-				emitInstruction(
-					compiler, "movzx rax, %s",
-					RegisterGpToString(REGISTER_RAX, valueTypeSize)
-				);
-
-				freeIfIsTemp(compiler, value);
-				result = allocateTemp(compiler, type);
-				emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-				return result;
-			}
-		}
-		else if (value->dataType.isUnsigned == false)
-		{
-			// movsx and movzx don't take immediate operands
-			//emitInstruction(compiler, "movsx %s, ", RegisterGpToString(REGISTER_RAX, resultTypeSize));
-			//emitResult(compiler, value);
-
-			emitMovToRegisterGp(compiler, REGISTER_RAX, value);
-			emitInstruction(
-				compiler, "movsx rax, %s",
-				RegisterGpToString(REGISTER_RAX, valueTypeSize)
-			);
-
-			freeIfIsTemp(compiler, value);
-			result = allocateTemp(compiler, type);
-			emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-			return result;
-		}
-	}
-	if (DataTypeIsFloat(type) || DataTypeIsFloat(&value->dataType))
-	{
-		if (value->dataType.type == type->type)
-			return result;
-
-		if (DataTypeIsFloat(&value->dataType) && DataTypeIsFloat(type))
-		{
-			emitMovToRegisterSimd(compiler, REGISTER_XMM2, value);
-			
-			emitInstruction(compiler, "cvt");
-			emitSimdTypeName(compiler, &value->dataType);
-			emitCode(compiler, "2");
-			emitSimdTypeName(compiler, type);
-			emitCode(compiler, " xmm1, xmm2");
-
-			freeIfIsTemp(compiler, value);
-			result = allocateTemp(compiler, type);
-			emitMovFromRegisterSimd(compiler, &result, REGISTER_XMM1);
-			return result;
-		}
-		else if (DataTypeIsInt(&value->dataType) && DataTypeIsFloat(type))
-		{
-			// Move because you can't movsx immediate operands
-			emitMovToRegisterGp(compiler, REGISTER_RAX, value);
-			// cvt instructions require the operand to be 32 or 64 bits
-			// could do a check for dword and qword here to avoid mov but it probably doesn't matter
-			emitInstruction(
-				compiler, "movsx rax, %s",
-				RegisterGpToString(REGISTER_RAX, valueTypeSize)
-			);
-
-			emitInstruction(compiler, "cvt");
-			emitSimdTypeName(compiler, &value->dataType);
-			emitCode(compiler, "2");
-			emitSimdTypeName(compiler, type);
-			emitCode(compiler, " xmm1, rax");
-
-			freeIfIsTemp(compiler, value);
-			result = allocateTemp(compiler, type);
-			emitMovFromRegisterSimd(compiler, &result, REGISTER_XMM1);
-			return result;
-		}
-		else if (DataTypeIsFloat(&value->dataType) && DataTypeIsInt(type))
-		{
-			emitMovToRegisterSimd(compiler, REGISTER_XMM1, value);
-
-			emitInstruction(compiler, "cvt");
-			emitSimdTypeName(compiler, &value->dataType);
-			emitCode(compiler, "2");
-			emitSimdTypeName(compiler, type);
-			emitCode(compiler, " rax, xmm1");
-
-			freeIfIsTemp(compiler, value);
-			result = allocateTemp(compiler, type);
-			emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-			return result;
-		}
-	}
-
-	// Maybe just throw an error here later
-	ASSERT_NOT_REACHED();
-
-	return result;
+	IrStartBlock(&compiler->function, IrAddBlock(&compiler->function));
 }
 
-static Result compileExpr(Compiler* compiler, const Expr* expr)
+static IrValue compileExpr(Compiler* compiler, ExprHandle expr)
 {
-	switch (expr->type)
+	const Ast* ast = compiler->ast;
+	switch (AstGetExprType(expr))
 	{
 		case EXPR_NUMBER_LITERAL:
-			return compileExprNumberLiteral(compiler, (ExprNumberLiteral*)expr);
+			return compileExprNumberLiteral(compiler, AstGetNumberLiteral(ast, expr));
 		case EXPR_BINARY:
-			return compileExprBinary(compiler, (ExprBinary*)expr);
+			return compileExprBinary(compiler, AstGetBinary(ast, expr));
 		case EXPR_GROUPING:
-			return compileExprGrouping(compiler, (ExprGrouping*)expr);
+			return compileExprGrouping(compiler, AstGetGrouping(ast, expr));
 		case EXPR_UNARY:
-			return compileExprUnary(compiler, (ExprUnary*)expr);
+			return compileExprUnary(compiler, AstGetUnary(ast, expr));
 		case EXPR_IDENTIFIER:
-			return compileExprIdentifier(compiler, (ExprIdentifier*)expr);
+			return compileExprIdentifier(compiler, AstGetIdentifier(ast, expr));
 		case EXPR_ASSIGNMENT:
-			return compileExprAssignment(compiler, (ExprAssignment*)expr);
+			return compileExprAssignment(compiler, AstGetAssignment(ast, expr));
 
 	default:
 		ASSERT_NOT_REACHED();
+		return IR_VALUE_NULL;
 	}
 }
 
-static Result compileExprNumberLiteral(Compiler* compiler, const ExprNumberLiteral* expr)
+static IrValue compileExprNumberLiteral(Compiler* compiler, const ExprNumberLiteral* expr)
 {
-	Result result;
-	result.dataType = expr->dataType;
-
-	switch (expr->dataType.type)
+	DataType type = expr->dataType;
+	if (DataTypeIsFloat(&type))
 	{
-		case DATA_TYPE_CHAR:
-			result.locationType = RESULT_LOCATION_INT_CONSTANT;
-			result.location.constant = expr->literal.text.chars[1];
-			break;
-
-		case DATA_TYPE_INT:
-		case DATA_TYPE_LONG:
-		case DATA_TYPE_LONG_LONG:
-			result.locationType = RESULT_LOCATION_INT_CONSTANT;
-			result.location.constant = strtoll(expr->literal.text.chars, NULL, 0);
-			break;
-
-		case DATA_TYPE_FLOAT:
-			result.locationType = RESULT_LOCATION_LABEL_COSTANT;
-			result.location.labelIndex = allocateLabel(compiler);
-			emitData(
-				compiler, ".L%d:\n\tdd %f\n",
-				result.location.labelIndex, 
-				strtof(expr->literal.text.chars, NULL)
-			);
-			break;
-
-		case DATA_TYPE_DOUBLE:
-			result.locationType = RESULT_LOCATION_LABEL_COSTANT;
-			result.location.labelIndex = allocateLabel(compiler);
-			emitData(
-				compiler, ".L%d:\n\tdq %f\n",
-				result.location.labelIndex,
-				strtof(expr->literal.text.chars, NULL)
-			);
-			break;
-
-		case DATA_TYPE_LONG_DOUBLE:
-			break;
-			
-		default:
-			ASSERT_NOT_REACHED();
+		type.isUnsigned = false;
+		return IrEmitFloatConstant(&compiler->function, &type, expr->value.floatValue);
 	}
-
-	return result;
+	return IrEmitIntConstant(&compiler->function, &type, expr->value.intValue);
 }
 
-static Result compileExprBinary(Compiler* compiler, const ExprBinary* expr)
+static IrValue compileExprBinary(Compiler* compiler, const ExprBinary* expr)
 {
-	if (expr->operator.type == TOKEN_AMPERSAND_AMPERSAND)
-	{
-		return compileAnd(compiler, expr->left, expr->right);
-	}
-	else if (expr->operator.type == TOKEN_PIPE_PIPE)
+	if ((expr->operator == TOKEN_AMPERSAND_AMPERSAND) || (expr->operator == TOKEN_PIPE_PIPE))
 	{
-		return compileOr(compiler, expr->left, expr->right);
+		return compileAndOr(compiler, expr->operator, expr->left, expr->right);
 	}
 
-	Result lhs = compileExpr(compiler, expr->left);
-	Result rhs = compileExpr(compiler, expr->right);
+	IrValue lhs = compileExpr(compiler, expr->left);
+	IrValue rhs = compileExpr(compiler, expr->right);
+	// Copied because the types are in an array that grows when values are added.
+	DataType lhsType = *IrGetValueType(&compiler->function, lhs);
+	DataType rhsType = *IrGetValueType(&compiler->function, rhs);
 	// Could check if the types are fundemental types
-	DataType resultType = binaryExpressionGetResultingType(&lhs.dataType, &rhs.dataType);
-	if (resultType.type == DATA_TYPE_ERROR)
-	{
-		//errorAt()
-		//return;
-	}
+	DataType resultType = DataTypeGetBinaryResultType(&lhsType, &rhsType);
 
-	lhs = convertToType(compiler, &lhs, &resultType);
-	rhs = convertToType(compiler, &rhs, &resultType);
-	
-	if ((lhs.locationType == RESULT_LOCATION_INT_CONSTANT) && (rhs.locationType == RESULT_LOCATION_INT_CONSTANT))
+	bool isIntOnly = (expr->operator == TOKEN_PERCENT)
+		|| (expr->operator == TOKEN_AMPERSAND)
+		|| (expr->operator == TOKEN_PIPE)
+		|| (expr->operator == TOKEN_CIRCUMFLEX);
+	if (isIntOnly && DataTypeIsFloat(&resultType))
 	{
-		// return evaluateConstantBinaryExpression(compiler, &lhs, &rhs);
+		errorAt(
+			compiler, expr->offset, 1,
+			"invalid operands to binary '%c', the operands have to be integers", compiler->fileInfo->source.chars[expr->offset]
+		);
+		// The float instructions don't have these operations, so the lhs is used as the value to continue.
+		return lhs;
 	}
 
-	switch (expr->operator.type)
-	{
-		case TOKEN_PLUS:       
-		{
-			if (DataTypeIsInt(&resultType))
-				return compileSimpleIntExprBinary(compiler, "add", &lhs, &rhs);
-			else if (DataTypeIsFloat(&resultType))
-				return compileFloatExprBinary(compiler, "add", &lhs, &rhs);
-		}
-		case TOKEN_MINUS:     
-		{
-			if (DataTypeIsInt(&resultType))
-				return compileSimpleIntExprBinary(compiler, "sub", &lhs, &rhs);
-			else if (DataTypeIsFloat(&resultType))
-				return compileFloatExprBinary(compiler, "sub", &lhs, &rhs);
-		}
-		case TOKEN_AMPERSAND:  return compileSimpleIntExprBinary(compiler, "and", &lhs, &rhs);
-		case TOKEN_PIPE:	   return compileSimpleIntExprBinary(compiler, "or", &lhs, &rhs);
-		case TOKEN_CIRCUMFLEX: return compileSimpleIntExprBinary(compiler, "xor", &lhs, &rhs);
-
-		case TOKEN_PERCENT:
-		case TOKEN_SLASH:
-		{
-			if (DataTypeIsInt(&resultType))
-			{
-				if (resultType.isUnsigned)
-					return compileIntDivisionOrMultiplcation(compiler, expr->operator.type, "div", &lhs, &rhs);
-				else
-					return compileIntDivisionOrMultiplcation(compiler, expr->operator.type, "idiv", &lhs, &rhs);
-			}
-			else if (DataTypeIsFloat(&resultType))
-			{
-				return compileFloatExprBinary(compiler, "div", &lhs, &rhs);
-			}
-			break;
-		}
+	lhs = convertToType(compiler, lhs, &resultType);
+	rhs = convertToType(compiler, rhs, &resultType);
 
-		case TOKEN_ASTERISK:
-		{
-			if (DataTypeIsInt(&resultType))
-			{
-				if (resultType.isUnsigned)
-					return compileIntDivisionOrMultiplcation(compiler, expr->operator.type, "mul", &lhs, &rhs);
-				else
-					return compileIntDivisionOrMultiplcation(compiler, expr->operator.type, "imul", &lhs, &rhs);
-			}
-			else if (DataTypeIsFloat(&resultType))
-			{
-				return compileFloatExprBinary(compiler, "mul", &lhs, &rhs);
-			}
-			break;
-		}
+	IrFunction* function = &compiler->function;
+	switch (expr->operator)
+	{
+		case TOKEN_PLUS:       return IrEmitBinary(function, IR_OP_ADD, lhs, rhs);
+		case TOKEN_MINUS:      return IrEmitBinary(function, IR_OP_SUBTRACT, lhs, rhs);
+		case TOKEN_ASTERISK:   return IrEmitBinary(function, IR_OP_MULTIPLY, lhs, rhs);
+		case TOKEN_SLASH:      return IrEmitBinary(function, IR_OP_DIVIDE, lhs, rhs);
+		case TOKEN_PERCENT:    return IrEmitBinary(function, IR_OP_MODULO, lhs, rhs);
+		case TOKEN_AMPERSAND:  return IrEmitBinary(function, IR_OP_AND, lhs, rhs);
+		case TOKEN_PIPE:	   return IrEmitBinary(function, IR_OP_OR, lhs, rhs);
+		case TOKEN_CIRCUMFLEX: return IrEmitBinary(function, IR_OP_XOR, lhs, rhs);
 
 		case TOKEN_LESS_THAN:
 		case TOKEN_LESS_THAN_EQUALS:
@@ -781,354 +271,157 @@ static Result compileExprBinary(Compiler* compiler, const ExprBinary* expr)
 		case TOKEN_MORE_THAN_EQUALS:
 		case TOKEN_EQUALS_EQUALS:
 		case TOKEN_BANG_EQUALS:
-		{
-			return compileComparasion(compiler, expr->operator, &lhs, &rhs);
-			break;
-		}
+			return IrEmitCompare(function, tokenTypeToCondition(expr->operator), lhs, rhs);
 	}
 
 	ASSERT_NOT_REACHED();
+	return IR_VALUE_NULL;
 }
 
-// Compiles operations that correspond to instructions with encoding op reg, reg.
-// Requires lhs.dataType == rhs.dataType
-static Result compileSimpleIntExprBinary(Compiler* compiler, const char* op, const Result* lhs, const Result* rhs)
-{
-	emitMovToRegisterGp(compiler, REGISTER_RAX, lhs);
-	emitMovToRegisterGp(compiler, REGISTER_RBX, rhs);
-
-	size_t resultSize = DataTypeSize(&lhs->dataType);
-
-	emitInstruction(
-		compiler, "%s %s, %s", op,
-		RegisterGpToString(REGISTER_RAX, resultSize),
-		RegisterGpToString(REGISTER_RBX, resultSize)
-	);
-
-	freeIfIsTemp(compiler, lhs);
-	freeIfIsTemp(compiler, rhs);
-
-	Result result = allocateTemp(compiler, &lhs->dataType);
-	emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-	return result;
-}
-
-static Result compileIntDivisionOrMultiplcation(Compiler* compiler, TokenType operator, const char* op, const Result* lhs, const Result* rhs)
-{
-	// Write a not about divison here
-	emitInstruction(compiler, "xor rdx, rdx");
-
-	emitMovToRegisterGp(compiler, REGISTER_RAX, lhs);
-	emitMovToRegisterGp(compiler, REGISTER_RBX, rhs);
-
-	size_t resultSize = DataTypeSize(&lhs->dataType);
-
-	emitInstruction(compiler, "%s %s", op, RegisterGpToString(REGISTER_RBX, resultSize));
-
-	freeIfIsTemp(compiler, lhs);
-	freeIfIsTemp(compiler, rhs);
-
-	Result result = allocateTemp(compiler, &lhs->dataType);
-
-	switch (operator)
-	{
-		case TOKEN_SLASH:
-		case TOKEN_ASTERISK:
-			emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-			break;
-
-		case TOKEN_PERCENT:
-		{
-			if (DataTypeSize(&lhs->dataType) == SIZE_BYTE)
-			{
-				emitInstruction(compiler, "mov ");
-				emitResult(compiler, &result);
-				emitCode(compiler, ", ");
-				emitCode(compiler, "ah");
-			}
-			else
-			{
-				emitMovFromRegisterGp(compiler, &result, REGISTER_RDX);
-			}
-			break;
-		}
-
-		default:
-			ASSERT_NOT_REACHED();
-			break;
-	}
-
-	return result;
-}
-
-Result compileFloatExprBinary(Compiler* compiler, const char* op, const Result* lhs, const Result* rhs)
-{
-	emitMovToRegisterSimd(compiler, REGISTER_XMM1, lhs);
-	emitMovToRegisterSimd(compiler, REGISTER_XMM2, rhs);
-
-	size_t resultSize = DataTypeSize(&lhs->dataType);
-
-	emitInstruction(compiler, "%s", op);
-	switch (resultSize)
-	{
-		case SIZE_DWORD: emitCode(compiler, "ss"); break;
-		case SIZE_QWORD: emitCode(compiler, "sd"); break;
-
-		default:
-			ASSERT_NOT_REACHED();
-	}
-	emitCode(compiler, " xmm1, xmm2");
-
-	freeIfIsTemp(compiler, lhs);
-	freeIfIsTemp(compiler, rhs);
-
-	Result result = allocateTemp(compiler, &lhs->dataType);
-	emitMovFromRegisterSimd(compiler, &result, REGISTER_XMM1);
-	return result;
-}
-
-Result compileComparasion(Compiler* compiler, Token op, const Result* lhs, const Result* rhs)
+// The result is set to the value the expression has if the right side is skipped and the right side is only
+// evaluated if it can change it.
+static IrValue compileAndOr(Compiler* compiler, TokenType operator, ExprHandle left, ExprHandle right)
 {
-	if (DataTypeIsFloat(&lhs->dataType))
-	{
-		// https://stackoverflow.com/questions/8627331/what-does-ordered-unordered-comparison-mean
-		emitMovToRegisterSimd(compiler, REGISTER_XMM1, lhs);
-		emitMovToRegisterSimd(compiler, REGISTER_XMM2, rhs);
-
-		size_t resultSize = DataTypeSize(&lhs->dataType);
-
-		emitInstruction(compiler, "comi");
-		emitSimdTypeName(compiler, &lhs->dataType),
-
-		emitCode(
-			compiler, " %s, %s",
-			RegisterSimdToString(REGISTER_XMM1),
-			RegisterSimdToString(REGISTER_XMM2)
-		);
-		emitInstruction(compiler, "set%s al", tokenTypeToCondition(op.type, true));
-	}
-	else if (DataTypeIsInt(&lhs->dataType))
-	{
-		emitMovToRegisterGp(compiler, REGISTER_RAX, lhs);
-		emitMovToRegisterGp(compiler, REGISTER_RBX, rhs);
-
-		size_t resultSize = DataTypeSize(&lhs->dataType);
+	IrFunction* function = &compiler->function;
+	bool isAnd = (operator == TOKEN_AMPERSAND_AMPERSAND);
+	DataType integer;
+	integer.type = DATA_TYPE_INT;
+	integer.isUnsigned = false;
 
-		emitInstruction(
-			compiler, "cmp %s, %s",
-			RegisterGpToString(REGISTER_RAX, resultSize),
-			RegisterGpToString(REGISTER_RBX, resultSize)
-		);
-		emitInstruction(compiler, "set%s al", tokenTypeToCondition(op.type, lhs->dataType.isUnsigned));
-	}
+	IrValue lhs = compileCondition(compiler, left);
+	IrValue result = IrAddValue(function, &integer);
+	IrEmitCopy(function, result, IrEmitIntConstant(function, &integer, isAnd ? 0 : 1));
+	IrBlockIndex rhsBlock = IrAddBlock(function);
+	IrBlockIndex endBlock = IrAddBlock(function);
+	if (isAnd)
+		IrEmitBranch(function, lhs, rhsBlock, endBlock);
+	else
+		IrEmitBranch(function, lhs, endBlock, rhsBlock);
 
-	freeIfIsTemp(compiler, lhs);
-	freeIfIsTemp(compiler, rhs);
+	IrStartBlock(function, rhsBlock);
+	IrValue rhs = compileCondition(compiler, right);
+	rhs = IrEmitCompare(function, IR_CONDITION_NOT_EQUAL, rhs, IrEmitIntConstant(function, IrGetValueType(function, rhs), 0));
+	IrEmitCopy(function, result, rhs);
+	IrEmitJump(function, endBlock);
 
-	// Don't know what should the return type be.
-	DataType integer;
-	integer.isUnsigned = false;
-	integer.type = DATA_TYPE_INT;
-	Result result = allocateTemp(compiler, &integer);
-	emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
+	IrStartBlock(function, endBlock);
 	return result;
 }
 
-Result compileAnd(Compiler* compiler, const Expr* left, const Expr* right)
+static IrValue compileCondition(Compiler* compiler, ExprHandle expr)
 {
-	// Should probably use movzx here so smaller operands also work
-	Result lhs = compileExpr(compiler, left);
-	emitMovToRegisterGp(compiler, REGISTER_RAX, &lhs);
-	emitInstruction(compiler, "cmp rax, 0");
-	int endLabel = allocateLabel(compiler);
-	emitInstruction(compiler, "je .L%d", endLabel);
-	freeIfIsTemp(compiler, &lhs);
-	Result rhs = compileExpr(compiler, right);
-	emitMovToRegisterGp(compiler, REGISTER_RAX, &rhs);
-	emitInstruction(compiler, "cmp rax, 0");
-	emitCode(compiler, "\n.L%d:", endLabel);
-	emitInstruction(compiler, "setne al");
-	freeIfIsTemp(compiler, &rhs);
-	// This is probably incorrect
-	Result result = allocateTemp(compiler, &rhs.dataType);
-	emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-	return result;
-}
+	IrFunction* function = &compiler->function;
+	IrValue value = compileExpr(compiler, expr);
+	DataType type = *IrGetValueType(function, value);
+	if (DataTypeIsInt(&type))
+		return value;
 
-Result compileOr(Compiler* compiler, const Expr* left, const Expr* right)
-{
-	// Should probably use movzx here so smaller operands also work
-	Result lhs = compileExpr(compiler, left);
-	emitMovToRegisterGp(compiler, REGISTER_RAX, &lhs);
-	emitInstruction(compiler, "cmp rax, 0");
-	int endLabel = allocateLabel(compiler);
-	emitInstruction(compiler, "jne .L%d", endLabel);
-	freeIfIsTemp(compiler, &lhs);
-	Result rhs = compileExpr(compiler, right);
-	emitMovToRegisterGp(compiler, REGISTER_RAX, &rhs);
-	emitInstruction(compiler, "cmp rax, 0");
-	emitCode(compiler, "\n.L%d:", endLabel);
-	emitInstruction(compiler, "setne al");
-	freeIfIsTemp(compiler, &rhs);
-	// This is probably incorrect
-	Result result = allocateTemp(compiler, &rhs.dataType);
-	emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-	return result;
+	return IrEmitCompare(function, IR_CONDITION_NOT_EQUAL, value, IrEmitFloatConstant(function, &type, 0.0));
 }
 
-static Result compileExprGrouping(Compiler* compiler, const ExprGrouping* expr)
+static IrValue compileExprGrouping(Compiler* compiler, const ExprGrouping* expr)
 {
 	return compileExpr(compiler, expr->expression);
 }
 
-Result compileExprUnary(Compiler* compiler, const ExprUnary* expr)
+static IrValue compileExprUnary(Compiler* compiler, const ExprUnary* expr)
 {
-	Result operand = compileExpr(compiler, expr->operand);
+	IrValue operand = compileExpr(compiler, expr->operand);
 
 	switch (expr->operator)
 	{
 		case TOKEN_MINUS:
-		{
-			if (DataTypeIsInt(&operand.dataType))
-				return compileNegation(compiler, &operand);
-			else if (DataTypeIsFloat(&operand.dataType))
-				return compileFloatNegation(compiler, &operand);
-		}
+			return IrEmitNegate(&compiler->function, operand);
 
 		case TOKEN_PLUS:
-			break;
+			return operand;
 
 		default:
 			ASSERT_NOT_REACHED();
-			break;
-	}
-}
-
-static Result compileNegation(Compiler* compiler, const Result* operand)
-{
-	emitMovToRegisterGp(compiler, REGISTER_RAX, operand);
-	emitInstruction(compiler, "neg rax");
-
-	if (operand->locationType == RESULT_LOCATION_TEMP)
-		freeTemp(compiler, operand);
-
-	Result result = allocateTemp(compiler, &operand->dataType);
-	emitMovFromRegisterGp(compiler, &result, REGISTER_RAX);
-	return result;
-}
-
-Result compileFloatNegation(Compiler* compiler, const Result* operand)
-{
-	// This could be done faster with xorps and a bitmask
-	emitMovToRegisterSimd(compiler, REGISTER_XMM1, operand);
-	emitInstruction(compiler, "pxor xmm0, xmm0");
-	if (operand->dataType.type == DATA_TYPE_FLOAT)
-	{
-		emitInstruction(compiler, "subss xmm0, xmm1");
-	}
-	else if (operand->dataType.type == DATA_TYPE_DOUBLE)
-	{
-		emitInstruction(compiler, "subsd xmm0, xmm1");
-	}
-	else
-	{
-		ASSERT_NOT_REACHED();
+			return operand;
 	}
-	Result result = allocateTemp(compiler, &operand->dataType);
-	emitMovFromRegisterSimd(compiler, &result, REGISTER_XMM0);
-	freeIfIsTemp(compiler, operand);
-	return result;
 }
 
-Result compileExprIdentifier(Compiler* compiler, const ExprIdentifier* expr)
+static IrValue compileExprIdentifier(Compiler* compiler, const ExprIdentifier* expr)
 {
-	Result result;
-	if (resolveLocalVariable(compiler, expr->name.text, &result) == false)
+	IrValue value;
+	if (resolveLocalVariable(compiler, expr->name, &value) == false)
 	{
 		errorAt(
-			compiler, expr->name,
-			"undeclared variable '%.*s' used", expr->name.text.length, expr->name.text.chars
+			compiler, expr->offset, expr->length,
+			"undeclared variable '%.*s' used", expr->length, compiler->fileInfo->source.chars + expr->offset
 		);
+		// Give the expression a value so the compilation can continue and find more errors.
+		DataType integer;
+		integer.type = DATA_TYPE_INT;
+		integer.isUnsigned = false;
+		return IrAddValue(&compiler->function, &integer);
 	}
 
-	return result;
+	return value;
 }
 
-Result compileExprAssignment(Compiler* compiler, const ExprAssignment* expr)
+static IrValue compileExprAssignment(Compiler* compiler, const ExprAssignment* expr)
 {
-	Result lhs = compileExpr(compiler, expr->left);
-	if (isResultLvalue(&lhs) == false)
+	// Only variables can be assigned for now.
+	ExprHandle target = expr->left;
+	while (AstGetExprType(target) == EXPR_GROUPING)
+		target = AstGetGrouping(compiler->ast, target)->expression;
+
+	IrValue lhs = compileExpr(compiler, expr->left);
+	if (AstGetExprType(target) != EXPR_IDENTIFIER)
 	{
-		errorAt(compiler, expr->operator, "cannot asign to a non lvalue");
-		//return;
+		errorAt(compiler, expr->offset, 1, "cannot asign to a non lvalue");
+		return compileExpr(compiler, expr->right);
 	}
-	
-	Result rhs = compileExpr(compiler, expr->right);
-	rhs = convertToType(compiler, &rhs, &lhs.dataType);
-	moveBetweenMemory(compiler, &lhs, &rhs);
 
-	Result result = allocateTemp(compiler, &lhs.dataType);
-	moveBetweenMemory(compiler, &result, &rhs);
+	DataType type = *IrGetValueType(&compiler->function, lhs);
+	IrValue rhs = compileExpr(compiler, expr->right);
+	rhs = convertToType(compiler, rhs, &type);
+	IrEmitCopy(&compiler->function, lhs, rhs);
 	// https://en.cppreference.com/w/c/language/operator_assignment
-
-	freeIfIsTemp(compiler, &lhs);
-	freeIfIsTemp(compiler, &rhs);
-	return result;
-}
-
-// Requiers type to be the same maybe later add assert
-static void moveBetweenMemory(Compiler* compiler, const Result* lhs, const Result* rhs)
-{
-	//if (DataTypeIsFloat(&lhs->dataType))
-	//{
-	//	emitMovFromRegisterSimd(compiler, REGISTER_XMM0, lhs);
-	//	emitMovFromRegisterSimd(compiler, rhs, REGISTER_XMM0);
-	//}
-
-	// Type shouldn't matter in this case
-	emitMovToRegisterGp(compiler, REGISTER_RAX, rhs);
-	emitMovFromRegisterGp(compiler, lhs, REGISTER_RAX);
-	
+	return rhs;
 }
 
-static void compileStmt(Compiler* compiler, const Stmt* stmt)
+static void compileStmt(Compiler* compiler, StmtHandle stmt)
 {
-	switch (stmt->type)
+	const Ast* ast = compiler->ast;
+	switch (AstGetStmtType(stmt))
 	{
 	case STMT_EXPRESSION:
-		compileStmtExpression(compiler, (StmtExpression*)stmt);
+		compileStmtExpression(compiler, AstGetExpressionStmt(ast, stmt));
 		break;
 
 	case STMT_RETURN:
-		compileStmtReturn(compiler, (StmtReturn*)stmt);
+		compileStmtReturn(compiler, AstGetReturn(ast, stmt));
 		break;
 
 	case STMT_VARIABLE_DECLARATION:
-		compileVariableDeclaration(compiler, (StmtVariableDeclaration*)stmt);
+		compileVariableDeclaration(compiler, AstGetVariableDeclaration(ast, stmt));
 		break;
 
 	case STMT_BLOCK:
-		compileStmtBlock(compiler, (StmtBlock*)stmt);
+		compileStmtBlock(compiler, AstGetBlock(ast, stmt));
 		break;
 
 	case STMT_IF:
-		compileStmtIf(compiler, (StmtIf*)stmt);
+		compileStmtIf(compiler, AstGetIf(ast, stmt));
 		break;
 
 	case STMT_WHILE_LOOP:
-		compileStmtWhileLoop(compiler, (StmtWhileLoop*)stmt);
+		compileStmtWhileLoop(compiler, AstGetWhileLoop(ast, stmt));
 		break;
 
 	case STMT_BREAK:
-		compileStmtBreak(compiler, (StmtBreak*)stmt);
+		compileStmtBreak(compiler, AstGetBreak(ast, stmt));
 		break;
 
 	case STMT_CONTINUE:
-		compileStmtContinue(compiler, (StmtContinue*)stmt);
+		compileStmtContinue(compiler, AstGetContinue(ast, stmt));
 		break;
 
 	case STMT_PUTCHAR:
-		compileStmtPutchar(compiler, (StmtPutchar*)stmt);
+		compileStmtPutchar(compiler, AstGetPutchar(ast, stmt));
 		break;
 
 	default:
@@ -1141,113 +434,100 @@ static void compileStmtExpression(Compiler* compiler, const StmtExpression* stmt
 	compileExpr(compiler, stmt->expresssion);
 }
 
+// The program is the body of main so returning exits.
 static void compileStmtReturn(Compiler* compiler, const StmtReturn* stmt)
 {
-	if (stmt->returnValue != NULL)
+	IrValue returnValue = IR_VALUE_NULL;
+	if (stmt->returnValue != AST_HANDLE_NULL)
 	{
-		Result returnValue = compileExpr(compiler, stmt->returnValue);
-		if (DataTypeIsInt(&returnValue.dataType))
-		{
-			emitMovToRegisterGp(compiler, REGISTER_RAX, &returnValue);
-		}
-		else if (DataTypeIsFloat(&returnValue.dataType))
-		{
-			emitMovToRegisterSimd(compiler, REGISTER_XMM0, &returnValue);
-		}
+		DataType integer;
+		integer.type = DATA_TYPE_INT;
+		integer.isUnsigned = false;
+		returnValue = convertToType(compiler, compileExpr(compiler, stmt->returnValue), &integer);
 	}
-	//emitInstruction(compiler, "ret");
+	IrEmitReturn(&compiler->function, returnValue);
+	startBlockAfterJump(compiler);
 }
 
 void compileVariableDeclaration(Compiler* compiler, const StmtVariableDeclaration* stmt)
 {
-	Result variable;
-	if (declareLocalVariable(compiler, stmt->name.text, &stmt->dataType, &variable) == false)
+	IrValue variable;
+	if (declareLocalVariable(compiler, stmt->name, &stmt->dataType, &variable) == false)
 	{
 		errorAt(
-			compiler, stmt->name,
-			"redeclaration of variable '%.*s'", stmt->name.text.length, stmt->name.text.chars
+			compiler, stmt->nameOffset, stmt->nameLength,
+			"redeclaration of variable '%.*s'", stmt->nameLength, compiler->fileInfo->source.chars + stmt->nameOffset
 		);
 		return;
 	}
 
 	// https://en.cppreference.com/w/c/language/declarations
 
-	if (stmt->initializer != NULL)
+	if (stmt->initializer != AST_HANDLE_NULL)
 	{
-		Result initializer = compileExpr(compiler, stmt->initializer);
-		initializer = convertToType(compiler, &initializer, &stmt->dataType);
-		moveBetweenMemory(compiler, &variable, &initializer);
+		IrValue initializer = compileExpr(compiler, stmt->initializer);
+		initializer = convertToType(compiler, initializer, &stmt->dataType);
+		IrEmitCopy(&compiler->function, variable, initializer);
 	}
 }
 
 void compileStmtBlock(Compiler* compiler, const StmtBlock* stmt)
 {
-	//beginScope(compiler);
-	Scope scope;
-	LocalVariableTableInit(&scope.localVariables);
-	if (compiler->currentScope == NULL)
-	{
-		scope.enclosing = NULL;
-		compiler->currentScope = &scope;
-	}
-	else
-	{
-		scope.enclosing = compiler->currentScope;
-		compiler->currentScope = &scope;
-	}
+	beginScope(compiler);
 
-	for (size_t i = 0; i < stmt->satements.size; i++)
+	const StmtHandle* statements = AstGetBlockStatements(compiler->ast, stmt);
+	for (uint32_t i = 0; i < stmt->count; i++)
 	{
-		compileStmt(compiler, stmt->satements.data[i]);
+		compileStmt(compiler, statements[i]);
 	}
 
-	//endScope(compiler);
-	LocalVariableTableFree(&compiler->currentScope->localVariables);
-	compiler->currentScope = compiler->currentScope->enclosing;
+	endScope(compiler);
 }
 
 static void compileStmtIf(Compiler* compiler, const StmtIf* stmt)
 {
-	Result condition = compileExpr(compiler, stmt->condition);
-	emitMovToRegisterGp(compiler, REGISTER_RAX, &condition);
-	freeIfIsTemp(compiler, &condition);
-	int elseLabel = allocateLabel(compiler);
-	int endLabel = allocateLabel(compiler);
-	emitInstruction(compiler, "cmp rax, 0");
-	emitInstruction(compiler, "je .L%d", elseLabel);
+	IrFunction* function = &compiler->function;
+	IrValue condition = compileCondition(compiler, stmt->condition);
+	IrBlockIndex thenBlock = IrAddBlock(function);
+	IrBlockIndex elseBlock = (stmt->elseBlock != AST_HANDLE_NULL) ? IrAddBlock(function) : IR_BLOCK_NULL;
+	IrBlockIndex endBlock = IrAddBlock(function);
+	IrEmitBranch(function, condition, thenBlock, (elseBlock != IR_BLOCK_NULL) ? elseBlock : endBlock);
+
+	IrStartBlock(function, thenBlock);
 	compileStmt(compiler, stmt->thenBlock);
-	emitInstruction(compiler, "jmp .L%d", endLabel);
-	emitCode(compiler, "\n.L%d:", elseLabel);
-	if (stmt->elseBlock != NULL)
+	IrEmitJump(function, endBlock);
+
+	if (elseBlock != IR_BLOCK_NULL)
 	{
+		IrStartBlock(function, elseBlock);
 		compileStmt(compiler, stmt->elseBlock);
+		IrEmitJump(function, endBlock);
 	}
-	emitCode(compiler, "\n.L%d:", endLabel);
+
+	IrStartBlock(function, endBlock);
 }
 
 void compileStmtWhileLoop(Compiler* compiler, const StmtWhileLoop* stmt)
 {
+	IrFunction* function = &compiler->function;
+
 	Loop loop;
-	if (compiler->currentLoop == NULL)
-		loop.enclosing = NULL;
-	else
-		loop.enclosing = compiler->currentLoop;
+	loop.enclosing = compiler->currentLoop;
+	loop.loopStart = IrAddBlock(function);
+	loop.loopEnd = IrAddBlock(function);
+	IrBlockIndex body = IrAddBlock(function);
 	compiler->currentLoop = &loop;
 
+	IrEmitJump(function, loop.loopStart);
+	IrStartBlock(function, loop.loopStart);
+	IrValue condition = compileCondition(compiler, stmt->condition);
+	IrEmitBranch(function, condition, body, loop.loopEnd);
 
-	int endLabel = allocateLabel(compiler);
-	int startLabel = allocateLabel(compiler);
-	loop.loopEnd = endLabel;
-	loop.loopStart = startLabel;
-	emitCode(compiler, "\n.L%d:", startLabel);
-	Result condition = compileExpr(compiler, stmt->condition);
-	emitMovToRegisterGp(compiler, REGISTER_RAX, &condition);
-	emitInstruction(compiler, "cmp rax, 0");
-	emitInstruction(compiler, "je .L%d", endLabel);
+	IrStartBlock(function, body);
 	compileStmt(compiler, stmt->body);
-	emitInstruction(compiler, "jmp .L%d", startLabel);
+	IrEmitJump(function, loop.loopStart);
 
-	emitCode(compiler, "\n.L%d:", endLabel);
+	IrStartBlock(function, loop.loopEnd);
 
 	compiler->currentLoop = compiler->currentLoop->enclosing;
 }
@@ -1256,70 +536,61 @@ void compileStmtBreak(Compiler* compiler, const StmtBreak* stmt)
 {
 	if (compiler->currentLoop == NULL)
 	{
-		errorAt(compiler, stmt->token, "break statments only allowed inside loops");
+		errorAt(compiler, stmt->offset, sizeof("break") - 1, "break statments only allowed inside loops");
 		return;
 	}
-	emitInstruction(compiler, "jmp .L%d", compiler->currentLoop->loopEnd);
+	IrEmitJump(&compiler->function, compiler->currentLoop->loopEnd);
+	startBlockAfterJump(compiler);
 }
 
 void compileStmtContinue(Compiler* compiler, const StmtContinue* stmt)
 {
 	if (compiler->currentLoop == NULL)
 	{
-		errorAt(compiler, stmt->token, "continue statments only allowed inside loops");
+		errorAt(compiler, stmt->offset, sizeof("continue") - 1, "continue statments only allowed inside loops");
 		return;
 	}
-	emitInstruction(compiler, "jmp .L%d", compiler->currentLoop->loopStart);
+	IrEmitJump(&compiler->function, compiler->currentLoop->loopStart);
+	startBlockAfterJump(compiler);
 }
 
 void compileStmtPutchar(Compiler* compiler, const StmtPutchar* stmt)
 {
-	Result argument = compileExpr(compiler, stmt->expresssion);
+	IrValue argument = compileExpr(compiler, stmt->expresssion);
 	DataType charType;
 	charType.type = DATA_TYPE_CHAR;
 	charType.isUnsigned = true;
-	argument = convertToType(compiler, &argument, &charType);
-	Result arg = allocateTemp(compiler, &charType);
-	freeIfIsTemp(compiler, &argument);
-	moveBetweenMemory(compiler, &arg, &argument);
-	emitInstruction(compiler, "mov rax, 1"); 
-	emitInstruction(compiler, "mov rdi, 1"); 
-	emitInstruction(compiler, "lea rsi, [rbp-%d]", compiler->temps.data[arg.location.tempIndex].baseOffset);
-	emitInstruction(compiler, "mov rdx, 1"); 
-	emitInstruction(compiler, "syscall"); 
+	argument = convertToType(compiler, argument, &charType);
+	IrEmitPutchar(&compiler->function, argument);
 }
 
-String CompilerCompile(Compiler* compiler, const FileInfo* fileInfo, const StmtArray* ast)
+String CompilerCompile(Compiler* compiler, FileInfo* fileInfo, const Ast* ast)
 {
 	compiler->fileInfo = fileInfo;
-	compiler->textSection = StringCopy("section .text\nglobal _start\n_start:\n\tmov rbp, rsp");
-	compiler->dataSection = StringCopy("\nsection .data\n");
-	compiler->stackAllocationSize = 0;
-	compiler->labelCount = 0;
+	compiler->ast = ast;
 	compiler->hadError = false;
-	compiler->currentScope = NULL;
 	compiler->currentLoop = NULL;
+	IrFunctionClear(&compiler->function);
 
-
-	TempArrayClear(&compiler->temps);
-	for (size_t i = 0; i < ast->size; i++)
+	// The top level statements are the body of main.
+	beginScope(compiler);
+	const StmtHandle* statements = AstGetBlockStatements(ast, &ast->root);
+	for (uint32_t i = 0; i < ast->root.count; i++)
 	{
-		compileStmt(compiler, ast->data[i]);
+		compileStmt(compiler, statements[i]);
 	}
+	endScope(compiler);
+	IrEmitReturn(&compiler->function, IR_VALUE_NULL);
 
-	emitInstruction(compiler, "mov rdi, rax");
-	emitInstruction(compiler, "mov rax, 60");
-	emitInstruction(compiler, "syscall");
-
-	StringAppendLen(&compiler->textSection, compiler->dataSection.chars, compiler->dataSection.length);
-	StringFree(&compiler->dataSection);
-
-	return compiler->textSection;
-}
+	if (compiler->hadError)
+	{
+		String empty = { .chars = NULL, .length = 0, .capacity = 0 };
+		return empty;
+	}
 
-static void copyTemp(Temp* dst, const Temp* src)
-{
-	*dst = *src;
+	IrComputeCfg(&compiler->function);
+	return CodeGeneratorGenerate(&compiler->codeGenerator, &compiler->function);
 }
 
-ARRAY_TEMPLATE_DEFINITION(TempArray, Temp, copyTemp, NO_OP_FUNCTION)
\ No newline at end of file
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(ScopeEntryArray, ScopeEntry)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(ScopeArray, Scope)
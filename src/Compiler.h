@@ -4,7 +4,8 @@
 #include "String.h"
 #include "Variable.h"
 #include "Parser.h"
-#include "Registers.h"
+#include "Ir.h"
+#include "CodeGenerator.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -17,96 +18,55 @@
 // https://en.wikipedia.org/wiki/C11_(C_standard_revision)
 // Maybe use _Generic instead of align macro
 
+// All the local variables of a function are in a single table. Declaring a variable that is already visible
+// replaces it in the table and the old one is saved in the scope entries. At the end of a scope its entries
+// are popped and the shadowed variables are put back.
 typedef struct
 {
-	size_t baseOffset;
-	size_t size;
-	bool isAllocated;
-} Temp;
+	SymbolId name;
+	bool isShadowing;
+	// Used if isShadowing.
+	LocalVariable shadowed;
+} ScopeEntry;
 
-ARRAY_TEMPLATE_DECLARATION(TempArray, Temp)
-
-typedef enum
-{
-	RESULT_LOCATION_BASE_OFFSET,
-	RESULT_LOCATION_TEMP,
-	RESULT_LOCATION_LABEL_COSTANT,
-	RESULT_LOCATION_LABEL,
-	RESULT_LOCATION_INT_CONSTANT,
-} ResultLocationType;
-
-typedef uint8_t byte;
-typedef uint16_t word;
-typedef uint32_t dword;
-typedef uint64_t qword;
-
-typedef uint8_t ubyte;
-typedef uint16_t uword;
-typedef uint32_t udword;
-typedef uint64_t uqword;
-
-// Later add system for allocating and freeing temps
-// Maybe store the location in an array of temp objects
-// It would store the size and location of temp
 typedef struct
 {
-	ResultLocationType locationType;
-	DataType dataType;
-
-	union
-	{
-		// Used if RESULT_LOCATION_BASE_OFFSET
-		uintptr_t baseOffset;
-
-		// Used if RESUL_LOCATION_TEMP
-		int tempIndex;
-
-		// Used if RESULT_LOCATION_LABEL and RESULT_LOCATION_LABEL_COSTANT
-		size_t labelIndex;
-
-		// Used if RESULT_LOCATION_CONSTANT
-		uint64_t constant;
-		byte charConstant;
-		word shortConstant;
-		dword intConstant;
-		qword longLongConstant;
-	} location;
-} Result;
-
-typedef struct Scope
-{
-	LocalVariableTable localVariables;
-	struct Scope* enclosing;
+	// Index of the first entry of the scope.
+	size_t firstEntry;
 } Scope;
 
+ARRAY_TEMPLATE_DECLARATION(ScopeEntryArray, ScopeEntry)
+ARRAY_TEMPLATE_DECLARATION(ScopeArray, Scope)
+
 typedef struct Loop
 {
-	// Labels
 	struct Loop* enclosing;
-	int loopStart;
-	int loopEnd;
+	// The block continue jumps to, which checks the condition.
+	IrBlockIndex loopStart;
+	// The block break jumps to.
+	IrBlockIndex loopEnd;
 } Loop;
 
+// The compiler lowers the ast to the IR, reporting the errors the parser can't find, and then passes the IR to the
+// code generator.
 typedef struct
 {
-	String textSection;
-	String dataSection;
-
 	bool hadError;
 
-	// For line information
-	const FileInfo* fileInfo;
+	// For line information. Not const because the line start offsets are computed on the first error.
+	FileInfo* fileInfo;
+	const Ast* ast;
 
-	size_t stackAllocationSize;
-	TempArray temps;
+	IrFunction function;
+	CodeGenerator codeGenerator;
 
-	Scope* currentScope;
+	LocalVariableTable localVariables;
+	ScopeEntryArray scopeEntries;
+	ScopeArray scopes;
 	Loop* currentLoop;
-
-	int labelCount;
-
 } Compiler;
 
 void CompilerInit(Compiler* compiler);
 void CompilerFree(Compiler* compiler);
-String CompilerCompile(Compiler* compiler, const FileInfo* fileInfo, const StmtArray* ast);
\ No newline at end of file
+// The returned string has to be freed.
+String CompilerCompile(Compiler* compiler, FileInfo* fileInfo, const Ast* ast);
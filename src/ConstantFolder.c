@@ -0,0 +1,723 @@
+#include "ConstantFolder.h"
+#include "Assert.h"
+#include "Generic.h"
+#include "Registers.h"
+
+#include <math.h>
+
+static void beginScope(ConstantFolder* folder);
+static void endScope(ConstantFolder* folder);
+static void declareVariable(ConstantFolder* folder, SymbolId name, const DataType* type);
+static DataType getVariableType(const ConstantFolder* folder, SymbolId name);
+
+// Long doubles and the types of invalid expressions aren't evaluated.
+static bool isFoldableType(const DataType* type);
+// Ints are stored sign extended if the type is signed and zero extended if it is unsigned.
+static uint64_t wrapToType(uint64_t value, const DataType* type);
+static double getFloatValue(const ExprNumberLiteral* literal);
+static bool isLiteralTrue(const ExprNumberLiteral* literal);
+static bool isLiteralEqualTo(const Ast* ast, ExprHandle expr, int value);
+// Returns false if the conversion isn't defined, then it is left for runtime.
+static bool convertLiteral(const ExprNumberLiteral* literal, const DataType* type, ExprNumberLiteral* result);
+// The operands have to have the same type. Returns false if the result isn't defined or the operation would trap.
+static bool evaluateBinary(TokenType operator, const ExprNumberLiteral* lhs, const ExprNumberLiteral* rhs, ExprNumberLiteral* result);
+static bool evaluateComparison(TokenType operator, const ExprNumberLiteral* lhs, const ExprNumberLiteral* rhs);
+static void evaluateNegation(const ExprNumberLiteral* operand, ExprNumberLiteral* result);
+// Returns true if evaluating the expression doesn't change anything, so it can be removed.
+static bool isPure(const Ast* ast, ExprHandle expr);
+static bool isSameVariable(const Ast* ast, ExprHandle a, ExprHandle b);
+static bool isComparison(TokenType operator);
+
+static ExprHandle addLiteral(ConstantFolder* folder, const ExprNumberLiteral* literal);
+static ExprHandle addIntLiteral(ConstantFolder* folder, DataType type, uint32_t offset, uint64_t value);
+static ExprHandle convertIfLiteral(ConstantFolder* folder, ExprHandle expr, const DataType* type);
+static ExprHandle compareWithZero(ConstantFolder* folder, ExprHandle expr, uint32_t offset);
+
+// The folded expressions return the handle of the expression that replaces them and the type of it.
+static ExprHandle foldExpr(ConstantFolder* folder, ExprHandle expr, DataType* type);
+static ExprHandle foldBinary(ConstantFolder* folder, ExprHandle expr, DataType* type);
+// Returns AST_HANDLE_NULL if the expression can't be simplified.
+static ExprHandle simplifyBinary(ConstantFolder* folder, const ExprBinary* binary, const DataType* lhsType, const DataType* rhsType, const DataType* resultType);
+static ExprHandle foldAndOr(ConstantFolder* folder, ExprHandle expr, DataType* type);
+static ExprHandle foldUnary(ConstantFolder* folder, ExprHandle expr, DataType* type);
+static ExprHandle foldAssignment(ConstantFolder* folder, ExprHandle expr, DataType* type);
+
+static void foldStmt(ConstantFolder* folder, StmtHandle stmt);
+static void foldBlock(ConstantFolder* folder, const StmtBlock* block);
+
+void ConstantFolderInit(ConstantFolder* folder)
+{
+	DataTypeArrayInit(&folder->variableTypes);
+	ShadowedVariableArrayInit(&folder->shadowed);
+	IntArrayInit(&folder->scopes);
+}
+
+void ConstantFolderFree(ConstantFolder* folder)
+{
+	DataTypeArrayFree(&folder->variableTypes);
+	ShadowedVariableArrayFree(&folder->shadowed);
+	IntArrayFree(&folder->scopes);
+}
+
+static void beginScope(ConstantFolder* folder)
+{
+	IntArrayAppend(&folder->scopes, (int)folder->shadowed.size);
+}
+
+static void endScope(ConstantFolder* folder)
+{
+	ASSERT(folder->scopes.size > 0);
+	size_t firstShadowed = (size_t)folder->scopes.data[--folder->scopes.size];
+
+	// Restored in reverse order like in the compiler.
+	while (folder->shadowed.size > firstShadowed)
+	{
+		const ShadowedVariable* variable = &folder->shadowed.data[--folder->shadowed.size];
+		folder->variableTypes.data[variable->name] = variable->shadowed;
+	}
+}
+
+static void declareVariable(ConstantFolder* folder, SymbolId name, const DataType* type)
+{
+	DataType none = { .type = DATA_TYPE_ERROR, .isUnsigned = false };
+	while (folder->variableTypes.size <= name)
+		DataTypeArrayAppend(&folder->variableTypes, none);
+
+	ShadowedVariable shadowed = { .name = name, .shadowed = folder->variableTypes.data[name] };
+	ShadowedVariableArrayAppend(&folder->shadowed, shadowed);
+	folder->variableTypes.data[name] = *type;
+}
+
+static DataType getVariableType(const ConstantFolder* folder, SymbolId name)
+{
+	if (name < folder->variableTypes.size)
+		return folder->variableTypes.data[name];
+
+	DataType none = { .type = DATA_TYPE_ERROR, .isUnsigned = false };
+	return none;
+}
+
+static bool isFoldableType(const DataType* type)
+{
+	return DataTypeIsInt(type) || (type->type == DATA_TYPE_FLOAT) || (type->type == DATA_TYPE_DOUBLE);
+}
+
+static uint64_t wrapToType(uint64_t value, const DataType* type)
+{
+	switch (DataTypeSize(type))
+	{
+		case SIZE_BYTE:  return type->isUnsigned ? (uint8_t)value : (uint64_t)(int64_t)(int8_t)value;
+		case SIZE_WORD:  return type->isUnsigned ? (uint16_t)value : (uint64_t)(int64_t)(int16_t)value;
+		case SIZE_DWORD: return type->isUnsigned ? (uint32_t)value : (uint64_t)(int64_t)(int32_t)value;
+		default:         return value;
+	}
+}
+
+// Float literals are stored as double so they have to be rounded first.
+static double getFloatValue(const ExprNumberLiteral* literal)
+{
+	if (literal->dataType.type == DATA_TYPE_FLOAT)
+		return (float)literal->value.floatValue;
+	return literal->value.floatValue;
+}
+
+static bool isLiteralTrue(const ExprNumberLiteral* literal)
+{
+	if (DataTypeIsFloat(&literal->dataType))
+		return getFloatValue(literal) != 0.0;
+	return wrapToType(literal->value.intValue, &literal->dataType) != 0;
+}
+
+static bool isLiteralEqualTo(const Ast* ast, ExprHandle expr, int value)
+{
+	if (AstGetExprType(expr) != EXPR_NUMBER_LITERAL)
+		return false;
+
+	const ExprNumberLiteral* literal = AstGetNumberLiteral(ast, expr);
+	// -0.0 isn't 0 here, x - -0.0 is x + 0.0, which is 0.0 and not x if x is -0.0.
+	if (DataTypeIsFloat(&literal->dataType))
+		return (getFloatValue(literal) == (double)value) && (signbit(getFloatValue(literal)) == false);
+	return wrapToType(literal->value.intValue, &literal->dataType) == wrapToType((uint64_t)(int64_t)value, &literal->dataType);
+}
+
+static bool convertLiteral(const ExprNumberLiteral* literal, const DataType* type, ExprNumberLiteral* result)
+{
+	const DataType* from = &literal->dataType;
+	result->offset = literal->offset;
+	result->dataType = *type;
+	if (DataTypeIsFloat(type))
+		result->dataType.isUnsigned = false;
+
+	if (DataTypeIsInt(from) && DataTypeIsInt(type))
+	{
+		// Conversions to signed types wrap around like the generated code does.
+		result->value.intValue = wrapToType(wrapToType(literal->value.intValue, from), type);
+		return true;
+	}
+
+	if (DataTypeIsInt(from))
+	{
+		// Converted directly instead of through double so the value is only rounded once.
+		uint64_t value = wrapToType(literal->value.intValue, from);
+		if (type->type == DATA_TYPE_FLOAT)
+			result->value.floatValue = from->isUnsigned ? (float)value : (float)(int64_t)value;
+		else
+			result->value.floatValue = from->isUnsigned ? (double)value : (double)(int64_t)value;
+		return true;
+	}
+
+	double value = getFloatValue(literal);
+	if (DataTypeIsInt(type))
+	{
+		// Converting a value that doesn't fit is undefined.
+		double truncated = trunc(value);
+		int bits = (int)DataTypeSize(type) * 8;
+		double minimum = type->isUnsigned ? 0.0 : -ldexp(1.0, bits - 1);
+		double maximum = type->isUnsigned ? ldexp(1.0, bits) : ldexp(1.0, bits - 1);
+		if ((truncated >= minimum) && (truncated < maximum))
+		{
+			result->value.intValue = type->isUnsigned
+				? (uint64_t)truncated
+				: wrapToType((uint64_t)(int64_t)truncated, type);
+			return true;
+		}
+		return false;
+	}
+
+	result->value.floatValue = (type->type == DATA_TYPE_FLOAT) ? (float)value : value;
+	return true;
+}
+
+static bool evaluateBinary(TokenType operator, const ExprNumberLiteral* lhs, const ExprNumberLiteral* rhs, ExprNumberLiteral* result)
+{
+	const DataType* type = &lhs->dataType;
+	result->dataType = *type;
+
+	if (type->type == DATA_TYPE_FLOAT)
+	{
+		// Computed in float so the result is rounded like the float instructions round it.
+		float a = (float)getFloatValue(lhs);
+		float b = (float)getFloatValue(rhs);
+		float value;
+		switch (operator)
+		{
+			case TOKEN_PLUS:     value = a + b; break;
+			case TOKEN_MINUS:    value = a - b; break;
+			case TOKEN_ASTERISK: value = a * b; break;
+			case TOKEN_SLASH:    value = a / b; break;
+			default:
+				return false;
+		}
+		result->value.floatValue = value;
+		return true;
+	}
+
+	if (type->type == DATA_TYPE_DOUBLE)
+	{
+		double a = getFloatValue(lhs);
+		double b = getFloatValue(rhs);
+		double value;
+		switch (operator)
+		{
+			case TOKEN_PLUS:     value = a + b; break;
+			case TOKEN_MINUS:    value = a - b; break;
+			case TOKEN_ASTERISK: value = a * b; break;
+			case TOKEN_SLASH:    value = a / b; break;
+			default:
+				return false;
+		}
+		result->value.floatValue = value;
+		return true;
+	}
+
+	// Unsigned arithmetic on the 64 bit values has the same lower bits, so wrapping the result gives the value in the
+	// type. Signed overflow is undefined but the generated code wraps around, so it is folded the same way.
+	uint64_t a = wrapToType(lhs->value.intValue, type);
+	uint64_t b = wrapToType(rhs->value.intValue, type);
+	uint64_t value;
+	switch (operator)
+	{
+		case TOKEN_PLUS:       value = a + b; break;
+		case TOKEN_MINUS:      value = a - b; break;
+		case TOKEN_ASTERISK:   value = a * b; break;
+		case TOKEN_AMPERSAND:  value = a & b; break;
+		case TOKEN_PIPE:       value = a | b; break;
+		case TOKEN_CIRCUMFLEX: value = a ^ b; break;
+
+		case TOKEN_SLASH:
+		case TOKEN_PERCENT:
+		{
+			// Dividing by zero and dividing the smallest value by -1 trap, so they are left for runtime.
+			if (b == 0)
+				return false;
+
+			if (type->isUnsigned)
+			{
+				value = (operator == TOKEN_SLASH) ? (a / b) : (a % b);
+				break;
+			}
+
+			int64_t minimum = (int64_t)wrapToType((uint64_t)1 << (DataTypeSize(type) * 8 - 1), type);
+			if (((int64_t)a == minimum) && ((int64_t)b == -1))
+				return false;
+			value = (operator == TOKEN_SLASH) ? (uint64_t)((int64_t)a / (int64_t)b) : (uint64_t)((int64_t)a % (int64_t)b);
+			break;
+		}
+
+		default:
+			return false;
+	}
+	result->value.intValue = wrapToType(value, type);
+	return true;
+}
+
+static bool evaluateComparison(TokenType operator, const ExprNumberLiteral* lhs, const ExprNumberLiteral* rhs)
+{
+	const DataType* type = &lhs->dataType;
+	int order;
+	if (DataTypeIsFloat(type))
+	{
+		double a = getFloatValue(lhs);
+		double b = getFloatValue(rhs);
+		// Every comparison with NaN is false except !=.
+		if (isnan(a) || isnan(b))
+			return operator == TOKEN_BANG_EQUALS;
+		order = (a < b) ? -1 : ((a > b) ? 1 : 0);
+	}
+	else if (type->isUnsigned)
+	{
+		uint64_t a = wrapToType(lhs->value.intValue, type);
+		uint64_t b = wrapToType(rhs->value.intValue, type);
+		order = (a < b) ? -1 : ((a > b) ? 1 : 0);
+	}
+	else
+	{
+		int64_t a = (int64_t)wrapToType(lhs->value.intValue, type);
+		int64_t b = (int64_t)wrapToType(rhs->value.intValue, type);
+		order = (a < b) ? -1 : ((a > b) ? 1 : 0);
+	}
+
+	switch (operator)
+	{
+		case TOKEN_EQUALS_EQUALS:     return order == 0;
+		case TOKEN_BANG_EQUALS:       return order != 0;
+		case TOKEN_LESS_THAN:         return order < 0;
+		case TOKEN_LESS_THAN_EQUALS:  return order <= 0;
+		case TOKEN_MORE_THAN:         return order > 0;
+		case TOKEN_MORE_THAN_EQUALS:  return order >= 0;
+
+		default:
+			ASSERT_NOT_REACHED();
+			return false;
+	}
+}
+
+static void evaluateNegation(const ExprNumberLiteral* operand, ExprNumberLiteral* result)
+{
+	result->dataType = operand->dataType;
+	if (operand->dataType.type == DATA_TYPE_FLOAT)
+		result->value.floatValue = -(float)getFloatValue(operand);
+	else if (operand->dataType.type == DATA_TYPE_DOUBLE)
+		result->value.floatValue = -getFloatValue(operand);
+	else
+		result->value.intValue = wrapToType(0 - operand->value.intValue, &operand->dataType);
+}
+
+static bool isPure(const Ast* ast, ExprHandle expr)
+{
+	switch (AstGetExprType(expr))
+	{
+		case EXPR_NUMBER_LITERAL:
+		case EXPR_IDENTIFIER:
+			return true;
+
+		case EXPR_GROUPING:
+			return isPure(ast, AstGetGrouping(ast, expr)->expression);
+
+		case EXPR_UNARY:
+			return isPure(ast, AstGetUnary(ast, expr)->operand);
+
+		case EXPR_BINARY:
+		{
+			const ExprBinary* binary = AstGetBinary(ast, expr);
+			return isPure(ast, binary->left) && isPure(ast, binary->right);
+		}
+
+		case EXPR_ASSIGNMENT:
+			return false;
+
+		default:
+			ASSERT_NOT_REACHED();
+			return false;
+	}
+}
+
+static bool isSameVariable(const Ast* ast, ExprHandle a, ExprHandle b)
+{
+	return (AstGetExprType(a) == EXPR_IDENTIFIER)
+		&& (AstGetExprType(b) == EXPR_IDENTIFIER)
+		&& (AstGetIdentifier(ast, a)->name == AstGetIdentifier(ast, b)->name);
+}
+
+static bool isComparison(TokenType operator)
+{
+	return (operator == TOKEN_EQUALS_EQUALS)
+		|| (operator == TOKEN_BANG_EQUALS)
+		|| (operator == TOKEN_LESS_THAN)
+		|| (operator == TOKEN_LESS_THAN_EQUALS)
+		|| (operator == TOKEN_MORE_THAN)
+		|| (operator == TOKEN_MORE_THAN_EQUALS);
+}
+
+static ExprHandle addLiteral(ConstantFolder* folder, const ExprNumberLiteral* literal)
+{
+	if (DataTypeIsFloat(&literal->dataType))
+		return AstAddFloatLiteral(folder->ast, literal->dataType, literal->offset, literal->value.floatValue);
+	return AstAddIntLiteral(folder->ast, literal->dataType, literal->offset, literal->value.intValue);
+}
+
+static ExprHandle addIntLiteral(ConstantFolder* folder, DataType type, uint32_t offset, uint64_t value)
+{
+	return AstAddIntLiteral(folder->ast, type, offset, wrapToType(value, &type));
+}
+
+static ExprHandle convertIfLiteral(ConstantFolder* folder, ExprHandle expr, const DataType* type)
+{
+	if (AstGetExprType(expr) != EXPR_NUMBER_LITERAL)
+		return expr;
+
+	ExprNumberLiteral literal = *AstGetNumberLiteral(folder->ast, expr);
+	if ((isFoldableType(&literal.dataType) == false) || DataTypeEquals(&literal.dataType, type))
+		return expr;
+
+	ExprNumberLiteral converted;
+	if (convertLiteral(&literal, type, &converted) == false)
+		return expr;
+	return addLiteral(folder, &converted);
+}
+
+// Makes expr != 0, which is what the logical operators do with their operands.
+static ExprHandle compareWithZero(ConstantFolder* folder, ExprHandle expr, uint32_t offset)
+{
+	DataType integer = { .type = DATA_TYPE_INT, .isUnsigned = false };
+	return AstAddBinary(folder->ast, TOKEN_BANG_EQUALS, offset, expr, addIntLiteral(folder, integer, offset, 0));
+}
+
+static ExprHandle foldExpr(ConstantFolder* folder, ExprHandle expr, DataType* type)
+{
+	const Ast* ast = folder->ast;
+	switch (AstGetExprType(expr))
+	{
+		case EXPR_NUMBER_LITERAL:
+			*type = AstGetNumberLiteral(ast, expr)->dataType;
+			return expr;
+
+		case EXPR_IDENTIFIER:
+			*type = getVariableType(folder, AstGetIdentifier(ast, expr)->name);
+			return expr;
+
+		// The tree already has the order of the operations so the grouping isn't needed anymore.
+		case EXPR_GROUPING:
+			return foldExpr(folder, AstGetGrouping(ast, expr)->expression, type);
+
+		case EXPR_BINARY:
+			return foldBinary(folder, expr, type);
+
+		case EXPR_UNARY:
+			return foldUnary(folder, expr, type);
+
+		case EXPR_ASSIGNMENT:
+			return foldAssignment(folder, expr, type);
+
+		default:
+			ASSERT_NOT_REACHED();
+			return expr;
+	}
+}
+
+static ExprHandle foldBinary(ConstantFolder* folder, ExprHandle expr, DataType* type)
+{
+	// Copied because adding nodes moves the pools.
+	ExprBinary binary = *AstGetBinary(folder->ast, expr);
+	if ((binary.operator == TOKEN_AMPERSAND_AMPERSAND) || (binary.operator == TOKEN_PIPE_PIPE))
+		return foldAndOr(folder, expr, type);
+
+	DataType lhsType;
+	DataType rhsType;
+	binary.left = foldExpr(folder, binary.left, &lhsType);
+	binary.right = foldExpr(folder, binary.right, &rhsType);
+
+	DataType operandType = DataTypeGetBinaryResultType(&lhsType, &rhsType);
+	if (isComparison(binary.operator))
+	{
+		type->type = DATA_TYPE_INT;
+		type->isUnsigned = false;
+	}
+	else
+	{
+		*type = operandType;
+	}
+
+	if (isFoldableType(&lhsType) && isFoldableType(&rhsType))
+	{
+		// The conversions of the operands are done at compile time for literals.
+		binary.left = convertIfLiteral(folder, binary.left, &operandType);
+		binary.right = convertIfLiteral(folder, binary.right, &operandType);
+
+		if ((AstGetExprType(binary.left) == EXPR_NUMBER_LITERAL) && (AstGetExprType(binary.right) == EXPR_NUMBER_LITERAL))
+		{
+			ExprNumberLiteral lhs = *AstGetNumberLiteral(folder->ast, binary.left);
+			ExprNumberLiteral rhs = *AstGetNumberLiteral(folder->ast, binary.right);
+			if (isComparison(binary.operator))
+				return addIntLiteral(folder, *type, binary.offset, evaluateComparison(binary.operator, &lhs, &rhs));
+
+			ExprNumberLiteral result;
+			result.offset = binary.offset;
+			if (evaluateBinary(binary.operator, &lhs, &rhs, &result))
+				return addLiteral(folder, &result);
+		}
+		else if (isComparison(binary.operator) == false)
+		{
+			ExprHandle simplified = simplifyBinary(folder, &binary, &lhsType, &rhsType, &operandType);
+			if (simplified != AST_HANDLE_NULL)
+				return simplified;
+		}
+	}
+
+	folder->ast->binaries.data[AST_HANDLE_INDEX(expr)] = binary;
+	return expr;
+}
+
+static ExprHandle simplifyBinary(ConstantFolder* folder, const ExprBinary* binary, const DataType* lhsType, const DataType* rhsType, const DataType* resultType)
+{
+	const Ast* ast = folder->ast;
+	bool isInt = DataTypeIsInt(resultType);
+	// An operand can only replace the expression if it doesn't have to be converted.
+	bool canUseLhs = DataTypeEquals(lhsType, resultType);
+	bool canUseRhs = DataTypeEquals(rhsType, resultType);
+
+	switch (binary->operator)
+	{
+		// x + 0 isn't x for floats if x is -0.
+		case TOKEN_PLUS:
+			if (isInt && canUseLhs && isLiteralEqualTo(ast, binary->right, 0))
+				return binary->left;
+			if (isInt && canUseRhs && isLiteralEqualTo(ast, binary->left, 0))
+				return binary->right;
+			break;
+
+		// x - x isn't 0 for floats if x is infinity or NaN.
+		case TOKEN_MINUS:
+			if (canUseLhs && isLiteralEqualTo(ast, binary->right, 0))
+				return binary->left;
+			if (isInt && isSameVariable(ast, binary->left, binary->right))
+				return addIntLiteral(folder, *resultType, binary->offset, 0);
+			break;
+
+		// x * 0 isn't 0 for floats if x is negative, infinity or NaN.
+		case TOKEN_ASTERISK:
+			if (canUseLhs && isLiteralEqualTo(ast, binary->right, 1))
+				return binary->left;
+			if (canUseRhs && isLiteralEqualTo(ast, binary->left, 1))
+				return binary->right;
+			if (isInt && isLiteralEqualTo(ast, binary->right, 0) && isPure(ast, binary->left))
+				return addIntLiteral(folder, *resultType, binary->offset, 0);
+			if (isInt && isLiteralEqualTo(ast, binary->left, 0) && isPure(ast, binary->right))
+				return addIntLiteral(folder, *resultType, binary->offset, 0);
+			break;
+
+		case TOKEN_SLASH:
+			if (canUseLhs && isLiteralEqualTo(ast, binary->right, 1))
+				return binary->left;
+			break;
+	}
+
+	return AST_HANDLE_NULL;
+}
+
+// The result of && and || is an int that is 0 or 1. An operand that decides the result makes the whole expression
+// a literal and an operand that doesn't leaves only the comparison of the other one with zero.
+static ExprHandle foldAndOr(ConstantFolder* folder, ExprHandle expr, DataType* type)
+{
+	ExprBinary binary = *AstGetBinary(folder->ast, expr);
+	bool isAnd = (binary.operator == TOKEN_AMPERSAND_AMPERSAND);
+	type->type = DATA_TYPE_INT;
+	type->isUnsigned = false;
+
+	DataType lhsType;
+	DataType rhsType;
+	binary.left = foldExpr(folder, binary.left, &lhsType);
+	binary.right = foldExpr(folder, binary.right, &rhsType);
+
+	if (AstGetExprType(binary.left) == EXPR_NUMBER_LITERAL)
+	{
+		bool lhs = isLiteralTrue(AstGetNumberLiteral(folder->ast, binary.left));
+		// The right side isn't evaluated.
+		if (lhs != isAnd)
+			return addIntLiteral(folder, *type, binary.offset, lhs);
+
+		if (AstGetExprType(binary.right) == EXPR_NUMBER_LITERAL)
+			return addIntLiteral(folder, *type, binary.offset, isLiteralTrue(AstGetNumberLiteral(folder->ast, binary.right)));
+		return compareWithZero(folder, binary.right, binary.offset);
+	}
+
+	if (AstGetExprType(binary.right) == EXPR_NUMBER_LITERAL)
+	{
+		bool rhs = isLiteralTrue(AstGetNumberLiteral(folder->ast, binary.right));
+		if (rhs == isAnd)
+			return compareWithZero(folder, binary.left, binary.offset);
+		// The left side still has to be evaluated if it has side effects.
+		if (isPure(folder->ast, binary.left))
+			return addIntLiteral(folder, *type, binary.offset, rhs);
+	}
+
+	folder->ast->binaries.data[AST_HANDLE_INDEX(expr)] = binary;
+	return expr;
+}
+
+static ExprHandle foldUnary(ConstantFolder* folder, ExprHandle expr, DataType* type)
+{
+	ExprUnary unary = *AstGetUnary(folder->ast, expr);
+	unary.operand = foldExpr(folder, unary.operand, type);
+
+	if (unary.operator == TOKEN_PLUS)
+		return unary.operand;
+
+	if ((AstGetExprType(unary.operand) == EXPR_NUMBER_LITERAL) && isFoldableType(type))
+	{
+		ExprNumberLiteral result;
+		evaluateNegation(AstGetNumberLiteral(folder->ast, unary.operand), &result);
+		result.offset = unary.offset;
+		return addLiteral(folder, &result);
+	}
+
+	// -(-x) is x
+	if ((AstGetExprType(unary.operand) == EXPR_UNARY) && (AstGetUnary(folder->ast, unary.operand)->operator == TOKEN_MINUS))
+		return AstGetUnary(folder->ast, unary.operand)->operand;
+
+	folder->ast->unaries.data[AST_HANDLE_INDEX(expr)] = unary;
+	return expr;
+}
+
+static ExprHandle foldAssignment(ConstantFolder* folder, ExprHandle expr, DataType* type)
+{
+	ExprAssignment assignment = *AstGetAssignment(folder->ast, expr);
+	DataType rhsType;
+	assignment.left = foldExpr(folder, assignment.left, type);
+	assignment.right = foldExpr(folder, assignment.right, &rhsType);
+	if (isFoldableType(type))
+		assignment.right = convertIfLiteral(folder, assignment.right, type);
+
+	folder->ast->assignments.data[AST_HANDLE_INDEX(expr)] = assignment;
+	return expr;
+}
+
+static void foldStmt(ConstantFolder* folder, StmtHandle stmt)
+{
+	Ast* ast = folder->ast;
+	uint32_t index = AST_HANDLE_INDEX(stmt);
+	DataType type;
+
+	switch (AstGetStmtType(stmt))
+	{
+		case STMT_EXPRESSION:
+		{
+			ExprHandle expression = foldExpr(folder, ast->expressionStmts.data[index].expresssion, &type);
+			ast->expressionStmts.data[index].expresssion = expression;
+			break;
+		}
+
+		// The variable is visible in its initializer like in the compiler.
+		case STMT_VARIABLE_DECLARATION:
+		{
+			StmtVariableDeclaration declaration = ast->variableDeclarations.data[index];
+			declareVariable(folder, declaration.name, &declaration.dataType);
+			if (declaration.initializer == AST_HANDLE_NULL)
+				break;
+
+			ExprHandle initializer = foldExpr(folder, declaration.initializer, &type);
+			if (isFoldableType(&declaration.dataType))
+				initializer = convertIfLiteral(folder, initializer, &declaration.dataType);
+			ast->variableDeclarations.data[index].initializer = initializer;
+			break;
+		}
+
+		case STMT_RETURN:
+		{
+			ExprHandle returnValue = ast->returns.data[index].returnValue;
+			if (returnValue == AST_HANDLE_NULL)
+				break;
+
+			DataType integer = { .type = DATA_TYPE_INT, .isUnsigned = false };
+			returnValue = convertIfLiteral(folder, foldExpr(folder, returnValue, &type), &integer);
+			ast->returns.data[index].returnValue = returnValue;
+			break;
+		}
+
+		case STMT_BLOCK:
+		{
+			StmtBlock block = ast->blocks.data[index];
+			beginScope(folder);
+			foldBlock(folder, &block);
+			endScope(folder);
+			break;
+		}
+
+		case STMT_IF:
+		{
+			StmtIf ifStmt = ast->ifs.data[index];
+			ast->ifs.data[index].condition = foldExpr(folder, ifStmt.condition, &type);
+			foldStmt(folder, ifStmt.thenBlock);
+			if (ifStmt.elseBlock != AST_HANDLE_NULL)
+				foldStmt(folder, ifStmt.elseBlock);
+			break;
+		}
+
+		case STMT_WHILE_LOOP:
+		{
+			StmtWhileLoop loop = ast->whileLoops.data[index];
+			ast->whileLoops.data[index].condition = foldExpr(folder, loop.condition, &type);
+			foldStmt(folder, loop.body);
+			break;
+		}
+
+		case STMT_PUTCHAR:
+		{
+			DataType charType = { .type = DATA_TYPE_CHAR, .isUnsigned = true };
+			ExprHandle expression = foldExpr(folder, ast->putchars.data[index].expresssion, &type);
+			ast->putchars.data[index].expresssion = convertIfLiteral(folder, expression, &charType);
+			break;
+		}
+
+		case STMT_BREAK:
+		case STMT_CONTINUE:
+			break;
+
+		default:
+			ASSERT_NOT_REACHED();
+	}
+}
+
+static void foldBlock(ConstantFolder* folder, const StmtBlock* block)
+{
+	for (uint32_t i = 0; i < block->count; i++)
+	{
+		foldStmt(folder, folder->ast->blockStatements.data[block->start + i]);
+	}
+}
+
+void ConstantFolderFold(ConstantFolder* folder, Ast* ast)
+{
+	folder->ast = ast;
+	DataTypeArrayClear(&folder->variableTypes);
+	ShadowedVariableArrayClear(&folder->shadowed);
+	IntArrayClear(&folder->scopes);
+
+	// The top level statements are in a scope in the compiler too.
+	beginScope(folder);
+	StmtBlock root = ast->root;
+	foldBlock(folder, &root);
+	endScope(folder);
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(ShadowedVariableArray, ShadowedVariable)
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Ast.h"
+#include "IntArray.h"
+
+// Evaluates the expressions that only use constants and simplifies identities like x * 1 before compiling, so
+// constant arithmetic doesn't run every time the program is executed. The operations are evaluated in the
+// types the compiler would do them in, so the result is the same as the one the generated code computes.
+// The ast has no casts, so an expression is only replaced by one of its operands if the type stays the same.
+
+typedef struct
+{
+	SymbolId name;
+	DataType shadowed;
+} ShadowedVariable;
+
+ARRAY_TEMPLATE_DECLARATION(ShadowedVariableArray, ShadowedVariable)
+
+typedef struct
+{
+	Ast* ast;
+
+	// The types of the visible variables indexed by SymbolId. The type is DATA_TYPE_ERROR if there is no variable.
+	DataTypeArray variableTypes;
+	// The types that were replaced by declarations and the index of the first one of each scope.
+	ShadowedVariableArray shadowed;
+	IntArray scopes;
+} ConstantFolder;
+
+void ConstantFolderInit(ConstantFolder* folder);
+void ConstantFolderFree(ConstantFolder* folder);
+// Changes the nodes in place and adds the new literals to the ast, so it can't be the ast of a CachedAst.
+void ConstantFolderFold(ConstantFolder* folder, Ast* ast);
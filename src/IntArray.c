@@ -1,9 +1,4 @@
 #include "IntArray.h"
 #include "Generic.h"
 
-static void copyInt(int* destination, int* source)
-{
-	*destination = *source;
-}
-
-ARRAY_TEMPLATE_DEFINITION(IntArray, int, copyInt, NO_OP_FUNCTION)
\ No newline at end of file
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(IntArray, int)
\ No newline at end of file
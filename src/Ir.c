@@ -0,0 +1,459 @@
+#include "Ir.h"
+#include "Assert.h"
+#include "Generic.h"
+
+static IrInstruction* addInstruction(IrFunction* function, IrOpcode opcode, const DataType* type, IrValue result);
+
+static const char* opcodeToString(IrOpcode opcode);
+static const char* conditionToString(IrCondition condition);
+static void printType(const DataType* type);
+static void printValue(IrValue value);
+
+void IrFunctionInit(IrFunction* function)
+{
+	IrInstructionArrayInit(&function->instructions);
+	IrBlockArrayInit(&function->blocks);
+	IrBlockIndexArrayInit(&function->layout);
+	IrBlockIndexArrayInit(&function->predecessors);
+	DataTypeArrayInit(&function->valueTypes);
+	function->currentBlock = IR_BLOCK_NULL;
+}
+
+void IrFunctionFree(IrFunction* function)
+{
+	IrInstructionArrayFree(&function->instructions);
+	IrBlockArrayFree(&function->blocks);
+	IrBlockIndexArrayFree(&function->layout);
+	IrBlockIndexArrayFree(&function->predecessors);
+	DataTypeArrayFree(&function->valueTypes);
+}
+
+void IrFunctionClear(IrFunction* function)
+{
+	IrInstructionArrayClear(&function->instructions);
+	IrBlockArrayClear(&function->blocks);
+	IrBlockIndexArrayClear(&function->layout);
+	IrBlockIndexArrayClear(&function->predecessors);
+	DataTypeArrayClear(&function->valueTypes);
+	function->currentBlock = IR_BLOCK_NULL;
+
+	IrBlockIndex entry = IrAddBlock(function);
+	ASSERT(entry == IR_ENTRY_BLOCK);
+	IrStartBlock(function, entry);
+}
+
+IrValue IrAddValue(IrFunction* function, const DataType* type)
+{
+	DataTypeArrayAppend(&function->valueTypes, *type);
+	return (IrValue)(function->valueTypes.size - 1);
+}
+
+IrBlockIndex IrAddBlock(IrFunction* function)
+{
+	IrBlock block;
+	block.firstInstruction = 0;
+	block.instructionCount = 0;
+	block.successorCount = 0;
+	block.firstPredecessor = 0;
+	block.predecessorCount = 0;
+	block.isReachable = false;
+	block.isStarted = false;
+	IrBlockArrayAppend(&function->blocks, block);
+	return (IrBlockIndex)(function->blocks.size - 1);
+}
+
+void IrStartBlock(IrFunction* function, IrBlockIndex blockIndex)
+{
+	ASSERT((function->currentBlock == IR_BLOCK_NULL) || IrIsCurrentBlockTerminated(function));
+	IrBlock* block = &function->blocks.data[blockIndex];
+	ASSERT(block->isStarted == false);
+	block->isStarted = true;
+	block->firstInstruction = (uint32_t)function->instructions.size;
+	IrBlockIndexArrayAppend(&function->layout, blockIndex);
+	function->currentBlock = blockIndex;
+}
+
+bool IrIsCurrentBlockTerminated(const IrFunction* function)
+{
+	const IrBlock* block = &function->blocks.data[function->currentBlock];
+	if (block->instructionCount == 0)
+		return false;
+	return IrIsTerminator(function->instructions.data[block->firstInstruction + block->instructionCount - 1].opcode);
+}
+
+static IrInstruction* addInstruction(IrFunction* function, IrOpcode opcode, const DataType* type, IrValue result)
+{
+	ASSERT(IrIsCurrentBlockTerminated(function) == false);
+
+	IrInstruction instruction;
+	instruction.opcode = opcode;
+	instruction.type = *type;
+	instruction.result = result;
+	instruction.operands[0] = IR_VALUE_NULL;
+	instruction.operands[1] = IR_VALUE_NULL;
+	instruction.as.intConstant = 0;
+	IrInstructionArrayAppend(&function->instructions, instruction);
+	function->blocks.data[function->currentBlock].instructionCount++;
+	return &function->instructions.data[function->instructions.size - 1];
+}
+
+IrValue IrEmitIntConstant(IrFunction* function, const DataType* type, uint64_t value)
+{
+	ASSERT(DataTypeIsInt(type));
+	// Copied because the type can point into the value types, which move when a value is added.
+	DataType valueType = *type;
+	IrInstruction* instruction = addInstruction(function, IR_OP_CONSTANT, &valueType, IrAddValue(function, &valueType));
+	instruction->as.intConstant = value;
+	return instruction->result;
+}
+
+IrValue IrEmitFloatConstant(IrFunction* function, const DataType* type, double value)
+{
+	ASSERT(DataTypeIsFloat(type));
+	DataType valueType = *type;
+	IrInstruction* instruction = addInstruction(function, IR_OP_CONSTANT, &valueType, IrAddValue(function, &valueType));
+	instruction->as.floatConstant = value;
+	return instruction->result;
+}
+
+void IrEmitCopy(IrFunction* function, IrValue destination, IrValue source)
+{
+	const DataType* type = IrGetValueType(function, destination);
+	ASSERT(type->type == IrGetValueType(function, source)->type);
+	IrInstruction* instruction = addInstruction(function, IR_OP_COPY, type, destination);
+	instruction->operands[0] = source;
+}
+
+IrValue IrEmitBinary(IrFunction* function, IrOpcode opcode, IrValue lhs, IrValue rhs)
+{
+	ASSERT((opcode >= IR_OP_ADD) && (opcode <= IR_OP_XOR));
+	DataType type = *IrGetValueType(function, lhs);
+	ASSERT(type.type == IrGetValueType(function, rhs)->type);
+	IrInstruction* instruction = addInstruction(function, opcode, &type, IrAddValue(function, &type));
+	instruction->operands[0] = lhs;
+	instruction->operands[1] = rhs;
+	return instruction->result;
+}
+
+IrValue IrEmitNegate(IrFunction* function, IrValue operand)
+{
+	DataType type = *IrGetValueType(function, operand);
+	IrInstruction* instruction = addInstruction(function, IR_OP_NEGATE, &type, IrAddValue(function, &type));
+	instruction->operands[0] = operand;
+	return instruction->result;
+}
+
+IrValue IrEmitCompare(IrFunction* function, IrCondition condition, IrValue lhs, IrValue rhs)
+{
+	DataType type = *IrGetValueType(function, lhs);
+	ASSERT(type.type == IrGetValueType(function, rhs)->type);
+	DataType integer;
+	integer.type = DATA_TYPE_INT;
+	integer.isUnsigned = false;
+	IrInstruction* instruction = addInstruction(function, IR_OP_COMPARE, &type, IrAddValue(function, &integer));
+	instruction->operands[0] = lhs;
+	instruction->operands[1] = rhs;
+	instruction->as.condition = condition;
+	return instruction->result;
+}
+
+IrValue IrEmitConvert(IrFunction* function, const DataType* type, IrValue operand)
+{
+	DataType valueType = *type;
+	IrInstruction* instruction = addInstruction(function, IR_OP_CONVERT, &valueType, IrAddValue(function, &valueType));
+	instruction->operands[0] = operand;
+	return instruction->result;
+}
+
+void IrEmitPutchar(IrFunction* function, IrValue operand)
+{
+	IrInstruction* instruction = addInstruction(function, IR_OP_PUTCHAR, IrGetValueType(function, operand), IR_VALUE_NULL);
+	instruction->operands[0] = operand;
+}
+
+void IrEmitJump(IrFunction* function, IrBlockIndex target)
+{
+	DataType none = { .type = DATA_TYPE_ERROR };
+	IrInstruction* instruction = addInstruction(function, IR_OP_JUMP, &none, IR_VALUE_NULL);
+	instruction->as.targets[0] = target;
+	instruction->as.targets[1] = IR_BLOCK_NULL;
+}
+
+void IrEmitBranch(IrFunction* function, IrValue condition, IrBlockIndex thenTarget, IrBlockIndex elseTarget)
+{
+	ASSERT(DataTypeIsInt(IrGetValueType(function, condition)));
+	IrInstruction* instruction = addInstruction(function, IR_OP_BRANCH, IrGetValueType(function, condition), IR_VALUE_NULL);
+	instruction->operands[0] = condition;
+	instruction->as.targets[0] = thenTarget;
+	instruction->as.targets[1] = elseTarget;
+}
+
+void IrEmitReturn(IrFunction* function, IrValue operand)
+{
+	DataType integer;
+	integer.type = DATA_TYPE_INT;
+	integer.isUnsigned = false;
+	IrInstruction* instruction = addInstruction(function, IR_OP_RETURN, &integer, IR_VALUE_NULL);
+	instruction->operands[0] = operand;
+}
+
+void IrComputeCfg(IrFunction* function)
+{
+	IrBlock* blocks = function->blocks.data;
+	size_t blockCount = function->blocks.size;
+
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		IrBlock* block = &blocks[i];
+		ASSERT(block->isStarted && (block->instructionCount > 0));
+		const IrInstruction* terminator = &function->instructions.data[block->firstInstruction + block->instructionCount - 1];
+		ASSERT(IrIsTerminator(terminator->opcode));
+
+		block->successorCount = 0;
+		block->predecessorCount = 0;
+		block->isReachable = false;
+		if (terminator->opcode == IR_OP_JUMP)
+		{
+			block->successors[block->successorCount++] = terminator->as.targets[0];
+		}
+		else if (terminator->opcode == IR_OP_BRANCH)
+		{
+			block->successors[block->successorCount++] = terminator->as.targets[0];
+			if (terminator->as.targets[1] != terminator->as.targets[0])
+				block->successors[block->successorCount++] = terminator->as.targets[1];
+		}
+	}
+
+	// Mark the reachable blocks using the predecessors array as the stack.
+	IrBlockIndexArray* stack = &function->predecessors;
+	IrBlockIndexArrayClear(stack);
+	IrBlockIndexArrayAppend(stack, IR_ENTRY_BLOCK);
+	blocks[IR_ENTRY_BLOCK].isReachable = true;
+	while (stack->size > 0)
+	{
+		IrBlock* block = &blocks[stack->data[--stack->size]];
+		for (uint32_t i = 0; i < block->successorCount; i++)
+		{
+			IrBlock* successor = &blocks[block->successors[i]];
+			if (successor->isReachable == false)
+			{
+				successor->isReachable = true;
+				IrBlockIndexArrayAppend(stack, block->successors[i]);
+			}
+		}
+	}
+
+	// Unreachable blocks aren't counted as predecessors. The predecessor counts are used as the write position
+	// while filling the array so they are counted again.
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		if (blocks[i].isReachable == false)
+			continue;
+		for (uint32_t j = 0; j < blocks[i].successorCount; j++)
+			blocks[blocks[i].successors[j]].predecessorCount++;
+	}
+
+	uint32_t predecessorCount = 0;
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		blocks[i].firstPredecessor = predecessorCount;
+		predecessorCount += blocks[i].predecessorCount;
+		blocks[i].predecessorCount = 0;
+	}
+
+	IrBlockIndexArrayClear(&function->predecessors);
+	IrBlockIndexArrayReserve(&function->predecessors, predecessorCount);
+	function->predecessors.size = predecessorCount;
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		if (blocks[i].isReachable == false)
+			continue;
+		for (uint32_t j = 0; j < blocks[i].successorCount; j++)
+		{
+			IrBlock* successor = &blocks[blocks[i].successors[j]];
+			function->predecessors.data[successor->firstPredecessor + successor->predecessorCount] = (IrBlockIndex)i;
+			successor->predecessorCount++;
+		}
+	}
+}
+
+const DataType* IrGetValueType(const IrFunction* function, IrValue value)
+{
+	ASSERT(value < function->valueTypes.size);
+	return &function->valueTypes.data[value];
+}
+
+bool IrIsTerminator(IrOpcode opcode)
+{
+	return (opcode == IR_OP_JUMP) || (opcode == IR_OP_BRANCH) || (opcode == IR_OP_RETURN);
+}
+
+IrCondition IrInvertCondition(IrCondition condition)
+{
+	switch (condition)
+	{
+		case IR_CONDITION_EQUAL:         return IR_CONDITION_NOT_EQUAL;
+		case IR_CONDITION_NOT_EQUAL:     return IR_CONDITION_EQUAL;
+		case IR_CONDITION_LESS:          return IR_CONDITION_GREATER_EQUAL;
+		case IR_CONDITION_LESS_EQUAL:    return IR_CONDITION_GREATER;
+		case IR_CONDITION_GREATER:       return IR_CONDITION_LESS_EQUAL;
+		case IR_CONDITION_GREATER_EQUAL: return IR_CONDITION_LESS;
+
+		default:
+			ASSERT_NOT_REACHED();
+			return condition;
+	}
+}
+
+static const char* opcodeToString(IrOpcode opcode)
+{
+	switch (opcode)
+	{
+		case IR_OP_CONSTANT: return "constant";
+		case IR_OP_COPY:     return "copy";
+		case IR_OP_ADD:      return "add";
+		case IR_OP_SUBTRACT: return "subtract";
+		case IR_OP_MULTIPLY: return "multiply";
+		case IR_OP_DIVIDE:   return "divide";
+		case IR_OP_MODULO:   return "modulo";
+		case IR_OP_AND:      return "and";
+		case IR_OP_OR:       return "or";
+		case IR_OP_XOR:      return "xor";
+		case IR_OP_NEGATE:   return "negate";
+		case IR_OP_COMPARE:  return "compare";
+		case IR_OP_CONVERT:  return "convert";
+		case IR_OP_PUTCHAR:  return "putchar";
+		case IR_OP_JUMP:     return "jump";
+		case IR_OP_BRANCH:   return "branch";
+		case IR_OP_RETURN:   return "return";
+
+		default:
+			ASSERT_NOT_REACHED();
+			return "";
+	}
+}
+
+static const char* conditionToString(IrCondition condition)
+{
+	switch (condition)
+	{
+		case IR_CONDITION_EQUAL:         return "==";
+		case IR_CONDITION_NOT_EQUAL:     return "!=";
+		case IR_CONDITION_LESS:          return "<";
+		case IR_CONDITION_LESS_EQUAL:    return "<=";
+		case IR_CONDITION_GREATER:       return ">";
+		case IR_CONDITION_GREATER_EQUAL: return ">=";
+
+		default:
+			ASSERT_NOT_REACHED();
+			return "";
+	}
+}
+
+static void printType(const DataType* type)
+{
+	if (type->isUnsigned && DataTypeIsInt(type))
+		printf("unsigned ");
+
+	switch (type->type)
+	{
+		case DATA_TYPE_CHAR:        printf("char"); break;
+		case DATA_TYPE_SHORT:       printf("short"); break;
+		case DATA_TYPE_INT:         printf("int"); break;
+		case DATA_TYPE_LONG:        printf("long"); break;
+		case DATA_TYPE_LONG_LONG:   printf("long long"); break;
+		case DATA_TYPE_LONG_DOUBLE: printf("long double"); break;
+		case DATA_TYPE_DOUBLE:      printf("double"); break;
+		case DATA_TYPE_FLOAT:       printf("float"); break;
+
+		default:
+			printf("?");
+			break;
+	}
+}
+
+static void printValue(IrValue value)
+{
+	printf("v%u", value);
+}
+
+// Prints the blocks in the layout order like
+// block1: (predecessors: block0 block2)
+//     v3 = add int v1, v2
+//     branch v3, block2, block3
+void IrPrint(const IrFunction* function)
+{
+	for (size_t i = 0; i < function->layout.size; i++)
+	{
+		IrBlockIndex blockIndex = function->layout.data[i];
+		const IrBlock* block = &function->blocks.data[blockIndex];
+
+		printf("block%u:", blockIndex);
+		if (block->predecessorCount > 0)
+		{
+			printf(" (predecessors:");
+			for (uint32_t j = 0; j < block->predecessorCount; j++)
+				printf(" block%u", function->predecessors.data[block->firstPredecessor + j]);
+			printf(")");
+		}
+		if (block->isReachable == false)
+			printf(" (unreachable)");
+		putchar('\n');
+
+		for (uint32_t j = 0; j < block->instructionCount; j++)
+		{
+			const IrInstruction* instruction = &function->instructions.data[block->firstInstruction + j];
+			printf("\t");
+			if (instruction->result != IR_VALUE_NULL)
+			{
+				printValue(instruction->result);
+				printf(" = ");
+			}
+			printf("%s", opcodeToString(instruction->opcode));
+
+			switch (instruction->opcode)
+			{
+				case IR_OP_CONSTANT:
+					putchar(' ');
+					printType(&instruction->type);
+					if (DataTypeIsFloat(&instruction->type))
+						printf(" %g", instruction->as.floatConstant);
+					else
+						printf(" %llu", (unsigned long long)instruction->as.intConstant);
+					break;
+
+				case IR_OP_JUMP:
+					printf(" block%u", instruction->as.targets[0]);
+					break;
+
+				case IR_OP_BRANCH:
+					putchar(' ');
+					printValue(instruction->operands[0]);
+					printf(", block%u, block%u", instruction->as.targets[0], instruction->as.targets[1]);
+					break;
+
+				default:
+					if (instruction->opcode == IR_OP_COMPARE)
+						printf(" %s", conditionToString(instruction->as.condition));
+					if (instruction->opcode != IR_OP_RETURN)
+					{
+						putchar(' ');
+						printType(&instruction->type);
+					}
+					for (int k = 0; k < 2; k++)
+					{
+						if (instruction->operands[k] == IR_VALUE_NULL)
+							break;
+						printf((k == 0) ? " " : ", ");
+						printValue(instruction->operands[k]);
+					}
+					break;
+			}
+			putchar('\n');
+		}
+	}
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(IrInstructionArray, IrInstruction)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(IrBlockArray, IrBlock)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(IrBlockIndexArray, IrBlockIndex)
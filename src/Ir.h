@@ -0,0 +1,163 @@
+#pragma once
+
+#include "Array.h"
+#include "Variable.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The intermediate representation the compiler lowers the ast to before generating code. It is three-address code
+// split into basic blocks. Every instruction produces at most one value and values are numbered, so the passes
+// and the backend can keep information about them in arrays indexed by the value.
+// Temporaries are only assigned once. Each local variable is a single value that is assigned with IR_OP_COPY,
+// so variables can be assigned more than once and the IR isn't in strict SSA form.
+
+typedef uint32_t IrValue;
+typedef uint32_t IrBlockIndex;
+
+#define IR_VALUE_NULL UINT32_MAX
+#define IR_BLOCK_NULL UINT32_MAX
+// The block the function starts in.
+#define IR_ENTRY_BLOCK 0
+
+typedef enum
+{
+	// result = constant
+	IR_OP_CONSTANT,
+	// result = operands[0]. Used for assigning variables, both have the same type.
+	IR_OP_COPY,
+
+	// result = operands[0] op operands[1]. The operands and the result have the type of the instruction.
+	IR_OP_ADD,
+	IR_OP_SUBTRACT,
+	IR_OP_MULTIPLY,
+	IR_OP_DIVIDE,
+	IR_OP_MODULO,
+	IR_OP_AND,
+	IR_OP_OR,
+	IR_OP_XOR,
+
+	// result = -operands[0]
+	IR_OP_NEGATE,
+	// result = operands[0] condition operands[1]. The type of the instruction is the type of the operands,
+	// the result is an int that is 0 or 1.
+	IR_OP_COMPARE,
+	// result = (type)operands[0]
+	IR_OP_CONVERT,
+	// Writes the unsigned char operands[0] to stdout.
+	IR_OP_PUTCHAR,
+
+	// Terminators. Every block ends with exactly one of them and they only appear at the end of a block.
+
+	// goto targets[0]
+	IR_OP_JUMP,
+	// if (operands[0] != 0) goto targets[0] else goto targets[1]. The operand is an integer.
+	IR_OP_BRANCH,
+	// Exits the program with the int operands[0]. If there is no operand the exit code is 0.
+	IR_OP_RETURN,
+} IrOpcode;
+
+typedef enum
+{
+	IR_CONDITION_EQUAL,
+	IR_CONDITION_NOT_EQUAL,
+	IR_CONDITION_LESS,
+	IR_CONDITION_LESS_EQUAL,
+	IR_CONDITION_GREATER,
+	IR_CONDITION_GREATER_EQUAL,
+} IrCondition;
+
+typedef struct
+{
+	IrOpcode opcode;
+	DataType type;
+	// IR_VALUE_NULL if the instruction doesn't produce a value.
+	IrValue result;
+	// Unused operands are IR_VALUE_NULL.
+	IrValue operands[2];
+
+	union
+	{
+		// Used if IR_OP_CONSTANT. Float constants are stored as double and rounded when the type is float.
+		uint64_t intConstant;
+		double floatConstant;
+
+		// Used if IR_OP_COMPARE
+		IrCondition condition;
+
+		// Used if IR_OP_JUMP and IR_OP_BRANCH
+		IrBlockIndex targets[2];
+	} as;
+} IrInstruction;
+
+typedef struct
+{
+	// The instructions of a block are next to each other in the instructions of the function.
+	uint32_t firstInstruction;
+	uint32_t instructionCount;
+
+	// The fields below are set by IrComputeCfg.
+
+	IrBlockIndex successors[2];
+	uint32_t successorCount;
+	// The predecessors are next to each other in the predecessors of the function.
+	uint32_t firstPredecessor;
+	uint32_t predecessorCount;
+	// Blocks after a break, continue or return can't be reached and no code is generated for them.
+	bool isReachable;
+
+	bool isStarted;
+} IrBlock;
+
+ARRAY_TEMPLATE_DECLARATION(IrInstructionArray, IrInstruction)
+ARRAY_TEMPLATE_DECLARATION(IrBlockArray, IrBlock)
+ARRAY_TEMPLATE_DECLARATION(IrBlockIndexArray, IrBlockIndex)
+
+typedef struct
+{
+	IrInstructionArray instructions;
+	IrBlockArray blocks;
+	// The order the blocks are placed in the generated code, which is the order they were started in.
+	IrBlockIndexArray layout;
+	IrBlockIndexArray predecessors;
+	// Indexed by IrValue.
+	DataTypeArray valueTypes;
+
+	// The block the builder adds instructions to.
+	IrBlockIndex currentBlock;
+} IrFunction;
+
+void IrFunctionInit(IrFunction* function);
+void IrFunctionFree(IrFunction* function);
+// Removes everything but keeps the memory. The entry block is created and started.
+void IrFunctionClear(IrFunction* function);
+
+// Builder
+IrValue IrAddValue(IrFunction* function, const DataType* type);
+IrBlockIndex IrAddBlock(IrFunction* function);
+// Instructions are added to the block until another one is started. A block can only be started once and the
+// previous one has to end with a terminator.
+void IrStartBlock(IrFunction* function, IrBlockIndex block);
+bool IrIsCurrentBlockTerminated(const IrFunction* function);
+
+IrValue IrEmitIntConstant(IrFunction* function, const DataType* type, uint64_t value);
+IrValue IrEmitFloatConstant(IrFunction* function, const DataType* type, double value);
+void IrEmitCopy(IrFunction* function, IrValue destination, IrValue source);
+IrValue IrEmitBinary(IrFunction* function, IrOpcode opcode, IrValue lhs, IrValue rhs);
+IrValue IrEmitNegate(IrFunction* function, IrValue operand);
+IrValue IrEmitCompare(IrFunction* function, IrCondition condition, IrValue lhs, IrValue rhs);
+IrValue IrEmitConvert(IrFunction* function, const DataType* type, IrValue operand);
+void IrEmitPutchar(IrFunction* function, IrValue operand);
+void IrEmitJump(IrFunction* function, IrBlockIndex target);
+void IrEmitBranch(IrFunction* function, IrValue condition, IrBlockIndex thenTarget, IrBlockIndex elseTarget);
+// operand can be IR_VALUE_NULL
+void IrEmitReturn(IrFunction* function, IrValue operand);
+
+// Fills in the successors, predecessors and reachability of the blocks. Every block has to be terminated.
+void IrComputeCfg(IrFunction* function);
+
+const DataType* IrGetValueType(const IrFunction* function, IrValue value);
+bool IrIsTerminator(IrOpcode opcode);
+IrCondition IrInvertCondition(IrCondition condition);
+
+void IrPrint(const IrFunction* function);
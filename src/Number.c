@@ -0,0 +1,210 @@
+#include "Number.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Converts 8 decimal digits using 3 multiplications instead of 8.
+// Assumes little endian, which is true for all the targets.
+static uint32_t parseEightDigits(const char* chars)
+{
+	uint64_t value;
+	memcpy(&value, chars, sizeof(value));
+	value -= 0x3030303030303030;
+	// Pairs of digits.
+	value = (value * 10) + (value >> 8);
+	// Pairs of pairs, the result ends up in the upper 32 bits.
+	value = (((value & 0x000000FF000000FF) * (100 + (1000000ull << 32)))
+		+ (((value >> 16) & 0x000000FF000000FF) * (1 + (10000ull << 32)))) >> 32;
+	return (uint32_t)value;
+}
+
+static int digitValue(char chr)
+{
+	if ((chr >= '0') && (chr <= '9'))
+		return chr - '0';
+	if ((chr >= 'a') && (chr <= 'f'))
+		return chr - 'a' + 10;
+	return chr - 'A' + 10;
+}
+
+bool NumberParseInteger(const char* digits, size_t length, int base, uint64_t* value)
+{
+	const char* chr = digits;
+	const char* end = digits + length;
+
+	while ((chr < end) && (*chr == '0'))
+		chr++;
+
+	uint64_t result = 0;
+
+	if (base == 10)
+	{
+		// 19 decimal digits always fit in 64 bits so only the digits after them need to be checked.
+		const char* uncheckedEnd = ((end - chr) > 19) ? chr + 19 : end;
+		for (; (uncheckedEnd - chr) >= 8; chr += 8)
+			result = (result * 100000000) + parseEightDigits(chr);
+		for (; chr < uncheckedEnd; chr++)
+			result = (result * 10) + (*chr - '0');
+	}
+
+	for (; chr < end; chr++)
+	{
+		uint64_t digit = digitValue(*chr);
+		if (result > ((UINT64_MAX - digit) / base))
+			return false;
+		result = (result * base) + digit;
+	}
+
+	*value = result;
+	return true;
+}
+
+// Splits the text into a decimal significand and exponent. Returns false if the significand doesn't fit in 64 bits.
+static bool decomposeDecimal(const char* text, size_t length, uint64_t* significandOut, int* exponentOut)
+{
+	const char* chr = text;
+	const char* end = text + length;
+
+	uint64_t significand = 0;
+	int significantDigitCount = 0;
+	int exponent = 0;
+
+	for (; (chr < end) && (*chr >= '0') && (*chr <= '9'); chr++)
+	{
+		if ((significand == 0) && (*chr == '0'))
+			continue;
+		significand = (significand * 10) + (*chr - '0');
+		significantDigitCount++;
+	}
+
+	if ((chr < end) && (*chr == '.'))
+	{
+		chr++;
+		for (; (chr < end) && (*chr >= '0') && (*chr <= '9'); chr++)
+		{
+			exponent--;
+			if ((significand == 0) && (*chr == '0'))
+				continue;
+			significand = (significand * 10) + (*chr - '0');
+			significantDigitCount++;
+		}
+	}
+
+	// Could have overflowed.
+	if (significantDigitCount > 19)
+		return false;
+
+	if ((chr < end) && ((*chr == 'e') || (*chr == 'E')))
+	{
+		chr++;
+		bool isNegative = false;
+		if ((chr < end) && ((*chr == '-') || (*chr == '+')))
+		{
+			isNegative = *chr == '-';
+			chr++;
+		}
+
+		int explicitExponent = 0;
+		for (; (chr < end) && (*chr >= '0') && (*chr <= '9'); chr++)
+		{
+			// Anything this large is outside the fast path range anyway.
+			if (explicitExponent > 10000)
+				return false;
+			explicitExponent = (explicitExponent * 10) + (*chr - '0');
+		}
+		exponent += isNegative ? -explicitExponent : explicitExponent;
+	}
+
+	*significandOut = significand;
+	*exponentOut = exponent;
+	return true;
+}
+
+// Powers of ten that are exactly representable as a double. The first 11 are also exact as a float.
+static const double exactPowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Clinger's fast path. If the significand and the power of ten are both exact the result of a single
+// multiplication or division is correctly rounded.
+#define MAX_EXACT_DOUBLE_POWER_OF_TEN 22
+#define MAX_EXACT_DOUBLE_INTEGER (1ull << 53)
+#define MAX_EXACT_FLOAT_POWER_OF_TEN 10
+#define MAX_EXACT_FLOAT_INTEGER (1ull << 24)
+
+// The slow path. Long digit sequences and large exponents are rare in source code so the text is just copied
+// so it can be null terminated.
+static char* copyNullTerminated(const char* text, size_t length, char* buffer, size_t bufferSize)
+{
+	char* copy = buffer;
+	if (length >= bufferSize)
+	{
+		copy = malloc(length + 1);
+		if (copy == NULL)
+		{
+			fputs("Failed to allocate number literal\n", stderr);
+			exit(1);
+		}
+	}
+	memcpy(copy, text, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+double NumberParseDouble(const char* text, size_t length)
+{
+	uint64_t significand;
+	int exponent;
+	if (decomposeDecimal(text, length, &significand, &exponent))
+	{
+		if (significand == 0)
+			return 0.0;
+
+		if ((significand <= MAX_EXACT_DOUBLE_INTEGER)
+			&& (exponent >= -MAX_EXACT_DOUBLE_POWER_OF_TEN)
+			&& (exponent <= MAX_EXACT_DOUBLE_POWER_OF_TEN))
+		{
+			return (exponent < 0)
+				? (double)significand / exactPowersOfTen[-exponent]
+				: (double)significand * exactPowersOfTen[exponent];
+		}
+	}
+
+	char buffer[64];
+	char* copy = copyNullTerminated(text, length, buffer, sizeof(buffer));
+	double value = strtod(copy, NULL);
+	if (copy != buffer)
+		free(copy);
+	return value;
+}
+
+// Computing the double first and then rounding to float could round twice so the fast path is done in float.
+float NumberParseFloat(const char* text, size_t length)
+{
+	uint64_t significand;
+	int exponent;
+	if (decomposeDecimal(text, length, &significand, &exponent))
+	{
+		if (significand == 0)
+			return 0.0f;
+
+		if ((significand <= MAX_EXACT_FLOAT_INTEGER)
+			&& (exponent >= -MAX_EXACT_FLOAT_POWER_OF_TEN)
+			&& (exponent <= MAX_EXACT_FLOAT_POWER_OF_TEN))
+		{
+			float powerOfTen = (float)exactPowersOfTen[(exponent < 0) ? -exponent : exponent];
+			return (exponent < 0)
+				? (float)significand / powerOfTen
+				: (float)significand * powerOfTen;
+		}
+	}
+
+	char buffer[64];
+	char* copy = copyNullTerminated(text, length, buffer, sizeof(buffer));
+	float value = strtof(copy, NULL);
+	if (copy != buffer)
+		free(copy);
+	return value;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number literals are decoded once by the scanner so later stages don't have to parse the text again.
+
+// Parses digits in base 8, 10 or 16 without a prefix or suffix. Returns false if the value doesn't fit in 64 bits.
+bool NumberParseInteger(const char* digits, size_t length, int base, uint64_t* value);
+// The text is a decimal floating point constant without the suffix. Both return the correctly rounded value.
+double NumberParseDouble(const char* text, size_t length);
+float NumberParseFloat(const char* text, size_t length);
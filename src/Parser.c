@@ -2,6 +2,10 @@
 #include "TerminalColors.h" 
 #include "Variable.h"
 #include "Assert.h"
+#include "Simd.h"
+#include "Thread.h"
+
+#include <string.h>
 
 static void advance(Parser* parser);
 static bool isAtEnd(Parser* parser);
@@ -13,29 +17,117 @@ static bool match(Parser* parser, TokenType type);
 // Rename consume to expect
 static void consume(Parser* parser, TokenType type, const char* errorMessage);
 
-static Stmt* expressionStatement(Parser* parser);
-static Stmt* variableDeclaration(Parser* parser);
-static Stmt* returnStatement(Parser* parser);
+static uint32_t tokenOffset(Parser* parser, const Token* token);
+
+static StmtHandle expressionStatement(Parser* parser);
+static StmtHandle variableDeclaration(Parser* parser);
+static StmtHandle returnStatement(Parser* parser);
 
 bool isDataTypeStart(Parser* parser);
-static Stmt* statement(Parser* parser);
+static StmtHandle statement(Parser* parser);
 
 static DataType dataType(Parser* parser);
-static Expr* literal(Parser* parser);
-static Expr* grouping(Parser* parser);
-static Expr* unary(Parser* parser);
-static Expr* term(Parser* parser);
-static Expr* factor(Parser* parser);
-static Expr* expression(Parser* parser);
+static ExprHandle literal(Parser* parser);
+static ExprHandle grouping(Parser* parser);
+static ExprHandle unary(Parser* parser);
+static ExprHandle expression(Parser* parser);
+
+// From lowest to highest. && has lower precedence than || here unlike in C.
+typedef enum
+{
+	PRECEDENCE_NONE,
+	PRECEDENCE_AND,
+	PRECEDENCE_OR,
+	PRECEDENCE_EQUALITY,
+	PRECEDENCE_COMPARISON,
+	PRECEDENCE_FACTOR,
+	PRECEDENCE_TERM,
+} Precedence;
+
+// Top level blocks found by the pre-pass.
+typedef struct
+{
+	// Offsets of the '{' and one past the matching '}'.
+	uint32_t start;
+	uint32_t end;
+	size_t workerIndex;
+	// In the ast of the worker. AST_HANDLE_NULL if the worker failed to parse the block.
+	StmtHandle stmt;
+} TopLevelBlock;
+
+ARRAY_TEMPLATE_DECLARATION(TopLevelBlockArray, TopLevelBlock)
+
+typedef struct
+{
+	Parser parser;
+	FileInfo* fileInfo;
+	TopLevelBlock* blocks;
+	size_t blockCount;
+	// Indexed by the SymbolIds of the worker. Filled out after the worker is joined.
+	SymbolId* symbolMap;
+} ParseWorker;
+
+struct ParallelParse
+{
+	TopLevelBlockArray blocks;
+	// The first block that wasn't taken or skipped yet.
+	size_t nextBlock;
+	ParseWorker* workers;
+	size_t workerCount;
+};
+
+static void findTopLevelBlocks(StringView source, TopLevelBlockArray* blocks);
+static void parseTopLevelBlocks(void* workerPointer);
+static ParseWorker* parseBlocksParallel(Parser* parser, FileInfo* fileInfo, TopLevelBlockArray* blocks, size_t* workerCount);
+static StmtHandle takeParsedBlock(Parser* parser);
+
+static void addTopLevelStatement(Parser* parser, uint32_t start, StmtHandle stmt);
+static void reuseTopLevelStatement(Parser* parser, StmtHandle stmt, SourceSpan span, int32_t offsetDelta);
+
+static Precedence binaryPrecedence(TokenType type);
+static ExprHandle binary(Parser* parser, Precedence minPrecedence);
+
+static const Precedence binaryPrecedences[] = {
+	[TOKEN_AMPERSAND_AMPERSAND] = PRECEDENCE_AND,
+	[TOKEN_PIPE_PIPE] = PRECEDENCE_OR,
+	[TOKEN_EQUALS_EQUALS] = PRECEDENCE_EQUALITY,
+	[TOKEN_BANG_EQUALS] = PRECEDENCE_EQUALITY,
+	[TOKEN_LESS_THAN] = PRECEDENCE_COMPARISON,
+	[TOKEN_LESS_THAN_EQUALS] = PRECEDENCE_COMPARISON,
+	[TOKEN_MORE_THAN] = PRECEDENCE_COMPARISON,
+	[TOKEN_MORE_THAN_EQUALS] = PRECEDENCE_COMPARISON,
+	[TOKEN_PLUS] = PRECEDENCE_FACTOR,
+	[TOKEN_MINUS] = PRECEDENCE_FACTOR,
+	[TOKEN_ASTERISK] = PRECEDENCE_TERM,
+	[TOKEN_SLASH] = PRECEDENCE_TERM,
+	[TOKEN_PERCENT] = PRECEDENCE_TERM,
+};
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(SourceSpanArray, SourceSpan)
 
 void ParserInit(Parser* parser)
 {
 	ScannerInit(&parser->scanner);
+	AstInit(&parser->ast);
+	SourceSpanArrayInit(&parser->spans);
+	SourceSpanArrayInit(&parser->previousSpans);
+	parser->fullParseNodeCount = 0;
+	parser->hadError = false;
+	parser->isSpeculative = false;
+	parser->parallelParse = NULL;
 }
 
 void ParserFree(Parser* parser)
 {
 	ScannerFree(&parser->scanner);
+	AstFree(&parser->ast);
+	SourceSpanArrayFree(&parser->spans);
+	SourceSpanArrayFree(&parser->previousSpans);
+}
+
+static uint32_t tokenOffset(Parser* parser, const Token* token)
+{
+	return (uint32_t)(token->text.chars - parser->scanner.fileInfo->source.chars);
 }
 
 static void synchornize(Parser* parser)
@@ -59,10 +151,17 @@ static void errorAt(Parser* parser, Token* token, const char* message)
 		return;
 	parser->hadError = true;
 	parser->isSynchronizing = true;
+	if (parser->isSpeculative)
+	{
+		// The block is parsed again on the main thread so there is no point in continuing. All the loops stop at EOF.
+		parser->current.type = TOKEN_EOF;
+		return;
+	}
 
+	FileInfo* fileInfo = parser->scanner.fileInfo;
 	fprintf(
-		stderr, "%s:%d: " TERM_COL_RED "error: " TERM_COL_RESET "%s\n",
-		parser->scanner.fileInfo->filename, token->line, message
+		stderr, "%s:%zu: " TERM_COL_RED "error: " TERM_COL_RESET "%s\n",
+		fileInfo->filename, FileInfoGetLineNumber(fileInfo, token->text.chars - fileInfo->source.chars), message
 	);
 }
 
@@ -199,7 +298,7 @@ static DataType dataType(Parser* parser)
 	return type;
 }
 
-static Expr* expression(Parser* parser);
+static ExprHandle expression(Parser* parser);
 
 // Finding the data type in parsing is kindof pointless because the compiler has to switch between the types anyway.
 // It does simplify things like char literals though.
@@ -253,331 +352,244 @@ static DataType tokenNumberLiteralToDataType(TokenType token)
 	return type;
 }
 
-static Expr* literal(Parser* parser)
+static ExprHandle literal(Parser* parser)
 {
 	DataType dataType = tokenNumberLiteralToDataType(peek(parser).type);
 	if (dataType.type != DATA_TYPE_ERROR)
 	{
 		advance(parser);
-		ExprNumberLiteral* expr = EXPR_ALLOCATE(ExprNumberLiteral, EXPR_NUMBER_LITERAL);
-		expr->dataType = dataType;
-		expr->literal = parser->previous;
-		return (Expr*)expr;
+		Token* token = &parser->previous;
+		uint32_t offset = tokenOffset(parser, token);
+		if (token->type == TOKEN_CHAR_LITERAL)
+			return AstAddIntLiteral(&parser->ast, dataType, offset, (uint64_t)token->text.chars[1]);
+		else if (DataTypeIsFloat(&dataType))
+			return AstAddFloatLiteral(&parser->ast, dataType, offset, token->value.floatValue);
+		else
+			return AstAddIntLiteral(&parser->ast, dataType, offset, token->value.intValue);
 	}
 	else if (match(parser, TOKEN_IDENTIFIER))
 	{
-		ExprIdentifier* expr = (ExprIdentifier*)ExprAllocate(sizeof(ExprIdentifier), EXPR_IDENTIFIER);
-		expr->name = parser->previous;
-		return (Expr*)expr;
+		Token* name = &parser->previous;
+		return AstAddIdentifier(&parser->ast, name->symbol, tokenOffset(parser, name), (uint32_t)name->text.length);
 	}
 
 	// Don't know if this is a good message
 	error(parser, "Expected literal");
-	return NULL;
+	return AST_HANDLE_NULL;
 }
 
-static Expr* grouping(Parser* parser)
+static ExprHandle grouping(Parser* parser)
 {
 	if (match(parser, TOKEN_LEFT_PAREN))
 	{
-		ExprGrouping* expr = (ExprGrouping*)ExprAllocate(sizeof(ExprGrouping), EXPR_GROUPING);
-		expr->expression = expression(parser);
+		ExprHandle expr = expression(parser);
 		consume(parser, TOKEN_RIGHT_PAREN, "expected ')' after expression");
-		return (Expr*)expr;
+		return AstAddGrouping(&parser->ast, expr);
 	}
 
 	return literal(parser);
 }
 
-static Expr* unary(Parser* parser)
+static ExprHandle unary(Parser* parser)
 {
 	if ((match(parser, TOKEN_PLUS)) || (match(parser, TOKEN_MINUS)))
 	{
-		ExprUnary* expr = (ExprUnary*)ExprAllocate(sizeof(ExprUnary), EXPR_UNARY);
-		expr->operator = parser->previous.type;
-		expr->operand = expression(parser);
-		return (Expr*)expr;
+		TokenType operator = parser->previous.type;
+		uint32_t offset = tokenOffset(parser, &parser->previous);
+		ExprHandle operand = expression(parser);
+		return AstAddUnary(&parser->ast, operator, offset, operand);
 	}
 
 	return grouping(parser);
 }
 
-// https://www.khanacademy.org/math/cc-sixth-grade-math/cc-6th-expressions-and-variables/cc-6th-evaluating-expressions/e/identifying-parts-of-expressions
-static Expr* term(Parser* parser)
+static Precedence binaryPrecedence(TokenType type)
 {
-	Expr* expr = unary(parser);
-
-	while ((match(parser, TOKEN_SLASH)) || (match(parser, TOKEN_ASTERISK)) || (match(parser, TOKEN_PERCENT)))
-	{
-		ExprBinary* temp = (ExprBinary*)ExprAllocate(sizeof(ExprBinary), EXPR_BINARY);
-		temp->left = expr;
-		temp->operator = parser->previous;
-		temp->right = unary(parser);
-		expr = (Expr*)temp;
-	}
-
-	return expr;
+	// Tokens that aren't in the table are zero initialized to PRECEDENCE_NONE.
+	if (type >= (sizeof(binaryPrecedences) / sizeof(binaryPrecedences[0])))
+		return PRECEDENCE_NONE;
+	return binaryPrecedences[type];
 }
 
-static Expr* factor(Parser* parser)
+// Binary operators are parsed by precedence climbing. A binary operator only calls binary once for its right
+// operand instead of going through a function for every precedence level.
+static ExprHandle binary(Parser* parser, Precedence minPrecedence)
 {
-	Expr* expr = term(parser);
+	ExprHandle expr = unary(parser);
 
-	while ((match(parser, TOKEN_PLUS)) || (match(parser, TOKEN_MINUS)))
+	for (;;)
 	{
-		ExprBinary* temp = (ExprBinary*)ExprAllocate(sizeof(ExprBinary), EXPR_BINARY);
-		temp->left = expr;
-		temp->operator = parser->previous;
-		temp->right = term(parser);
-		expr = (Expr*)temp;
-	}
-	
-	return (Expr*)expr;
-}
-
-static Expr* comparison(Parser* parser)
-{
-	Expr* expr = factor(parser);
-
-	while ((match(parser, TOKEN_LESS_THAN)) || (match(parser, TOKEN_LESS_THAN_EQUALS))
-		|| (match(parser, TOKEN_MORE_THAN)) || (match(parser, TOKEN_MORE_THAN_EQUALS)))
-	{
-		ExprBinary* temp = (ExprBinary*)ExprAllocate(sizeof(ExprBinary), EXPR_BINARY);
-		temp->left = expr;
-		temp->operator = parser->previous;
-		temp->right = factor(parser);
-		expr = (Expr*)temp;
-	}
-
-	return (Expr*)expr;
-}
-
-static Expr* equality(Parser* parser)
-{
-	Expr* expr = comparison(parser);
-
-	while ((match(parser, TOKEN_BANG_EQUALS)) || (match(parser, TOKEN_EQUALS_EQUALS)))
-	{
-		ExprBinary* temp = (ExprBinary*)ExprAllocate(sizeof(ExprBinary), EXPR_BINARY);
-		temp->left = expr;
-		temp->operator = parser->previous;
-		temp->right = comparison(parser);
-		expr = (Expr*)temp;
-	}
-
-	return (Expr*)expr;
-}
-
-static Expr* or(Parser* parser)
-{
-	Expr* expr = equality(parser);
-
-	while ((match(parser, TOKEN_PIPE_PIPE)))
-	{
-		ExprBinary* temp = (ExprBinary*)ExprAllocate(sizeof(ExprBinary), EXPR_BINARY);
-		temp->left = expr;
-		temp->operator = parser->previous;
-		temp->right = equality(parser);
-		expr = (Expr*)temp;
-	}
-
-	return (Expr*)expr;
-}
-
-static Expr* and(Parser* parser)
-{
-	Expr* expr = or(parser);
+		Precedence precedence = binaryPrecedence(peek(parser).type);
+		if (precedence < minPrecedence)
+			break;
 
-	while (match(parser, TOKEN_AMPERSAND_AMPERSAND))
-	{
-		ExprBinary* temp = (ExprBinary*)ExprAllocate(sizeof(ExprBinary), EXPR_BINARY);
-		temp->left = expr;
-		temp->operator = parser->previous;
-		temp->right = or(parser);
-		expr = (Expr*)temp;
+		advance(parser);
+		TokenType operator = parser->previous.type;
+		uint32_t offset = tokenOffset(parser, &parser->previous);
+		// All the binary operators are left associative.
+		ExprHandle right = binary(parser, precedence + 1);
+		expr = AstAddBinary(&parser->ast, operator, offset, expr, right);
 	}
 
-	return (Expr*)expr;
+	return expr;
 }
 
-static Expr* assignment(Parser* parser)
+static ExprHandle assignment(Parser* parser)
 {
-	Expr* expr = and(parser);
+	ExprHandle expr = binary(parser, PRECEDENCE_AND);
 		
 	if (match(parser, TOKEN_EQUALS))
 	{
-		ExprAssignment* temp = EXPR_ALLOCATE(ExprAssignment, EXPR_ASSIGNMENT);
-		temp->left = expr;
-		temp->operator = parser->previous;
+		TokenType operator = parser->previous.type;
+		uint32_t offset = tokenOffset(parser, &parser->previous);
 		// Shouldn't this be assignment ?
-		temp->right = and(parser);
-		expr = (Expr*)temp;
+		ExprHandle right = binary(parser, PRECEDENCE_AND);
+		expr = AstAddAssignment(&parser->ast, operator, offset, expr, right);
 	}
 
 	return expr;
 }
 
-static Expr* expression(Parser* parser)
+static ExprHandle expression(Parser* parser)
 {
 	return assignment(parser);
 }
 
-static Stmt* expressionStatement(Parser* parser)
+static StmtHandle expressionStatement(Parser* parser)
 {
-	StmtExpression* expressionStmt = (StmtExpression*)StmtAllocate(sizeof(StmtExpression), STMT_EXPRESSION);
-	expressionStmt->expresssion = expression(parser);
-	//printExpr(expressionStmt->expresssion, 0);
+	ExprHandle expr = expression(parser);
 	consume(parser, TOKEN_SEMICOLON, "expected ';'");
-	return (Stmt*)expressionStmt;
+	return AstAddExpressionStmt(&parser->ast, expr);
 }
 
 // Later add support for multiple variables
 // Don't know if it possible to compile that into multiple statment or just put all in one
-static Stmt* variableDeclaration(Parser* parser)
+static StmtHandle variableDeclaration(Parser* parser)
 {
-	StmtVariableDeclaration* variableDeclaration = (StmtVariableDeclaration*)StmtAllocate(sizeof(StmtVariableDeclaration), STMT_VARIABLE_DECLARATION);
-	variableDeclaration->dataType = dataType(parser);
+	DataType type = dataType(parser);
 	consume(parser, TOKEN_IDENTIFIER, "Expected variable name");
-	variableDeclaration->name = parser->previous;
+	Token name = parser->previous;
+	ExprHandle initializer = AST_HANDLE_NULL;
 	if (match(parser, TOKEN_EQUALS))
 	{
-		variableDeclaration->initializer = expression(parser);
-	}
-	else
-	{
-		variableDeclaration->initializer = NULL;
+		initializer = expression(parser);
 	}
 
 	consume(parser, TOKEN_SEMICOLON, "expected ';'");
 
-	return (Stmt*)variableDeclaration;
+	return AstAddVariableDeclaration(
+		&parser->ast, type, name.symbol, tokenOffset(parser, &name), (uint32_t)name.text.length, initializer
+	);
 }
 
-static Stmt* returnStatement(Parser* parser)
+static StmtHandle returnStatement(Parser* parser)
 {
-	StmtReturn* stmt = (StmtReturn*)StmtAllocate(sizeof(StmtReturn), STMT_RETURN);
+	uint32_t offset = tokenOffset(parser, &parser->previous);
+	ExprHandle returnValue = AST_HANDLE_NULL;
 
-	if (check(parser, TOKEN_SEMICOLON))
-		stmt->returnValue = NULL;
-	else
-		stmt->returnValue = expression(parser);
+	if (check(parser, TOKEN_SEMICOLON) == false)
+		returnValue = expression(parser);
 
 	consume(parser, TOKEN_SEMICOLON, "Expected ';'");
 
-	return (Stmt*)stmt;
+	return AstAddReturn(&parser->ast, offset, returnValue);
 }
 
-static Stmt* block(Parser* parser)
+static StmtHandle block(Parser* parser)
 {
-	StmtBlock* stmt = STMT_ALLOCATE(StmtBlock, STMT_BLOCK);
-	StmtArrayInit(&stmt->satements);
+	size_t blockStart = AstBeginBlock(&parser->ast);
 	while ((isAtEnd(parser) == false) && (check(parser, TOKEN_RIGHT_BRACE) == false))
 	{
-		StmtArrayAppend(&stmt->satements, statement(parser));
+		AstAddToBlock(&parser->ast, statement(parser));
 	}
 	consume(parser, TOKEN_RIGHT_BRACE, "Expected '}'");
 
-	return (Stmt*)stmt;
+	return AstAddBlock(&parser->ast, AstEndBlock(&parser->ast, blockStart));
 }
 
-static Stmt* ifStmt(Parser* parser)
+static StmtHandle ifStmt(Parser* parser)
 {
-	StmtIf* stmt = STMT_ALLOCATE(StmtIf, STMT_IF);
 	consume(parser, TOKEN_LEFT_PAREN, "exptected '('");
-	stmt->condition = expression(parser);
+	ExprHandle condition = expression(parser);
 	consume(parser, TOKEN_RIGHT_PAREN, "exptected ')'");
-	stmt->thenBlock = statement(parser);
+	StmtHandle thenBlock = statement(parser);
+	StmtHandle elseBlock = AST_HANDLE_NULL;
 	if (match(parser, TOKEN_ELSE))
 	{
-		stmt->elseBlock = statement(parser);
-	}
-	else
-	{
-		stmt->elseBlock = NULL;
+		elseBlock = statement(parser);
 	}
-	return (Stmt*)stmt;
+	return AstAddIf(&parser->ast, condition, thenBlock, elseBlock);
 }
 
-static Stmt* whileStmt(Parser* parser)
+static StmtHandle whileStmt(Parser* parser)
 {
-	StmtWhileLoop* stmt = STMT_ALLOCATE(StmtWhileLoop, STMT_WHILE_LOOP);
 	consume(parser, TOKEN_LEFT_PAREN, "exptected '('");
-	stmt->condition = expression(parser);
+	ExprHandle condition = expression(parser);
 	consume(parser, TOKEN_RIGHT_PAREN, "exptected ')'");
-	stmt->body = statement(parser);
-	return (Stmt*)stmt;
+	StmtHandle body = statement(parser);
+	return AstAddWhileLoop(&parser->ast, condition, body);
 }
 
-static Stmt* forStmt(Parser* parser)
+static StmtHandle forStmt(Parser* parser)
 {
-	StmtBlock* scope = STMT_ALLOCATE(StmtBlock, STMT_BLOCK);
-	StmtArrayInit(&scope->satements);
+	size_t scopeStart = AstBeginBlock(&parser->ast);
 
 	consume(parser, TOKEN_LEFT_PAREN, "exptected '('");
 
 	if (match(parser, TOKEN_SEMICOLON) == false)
 	{
-		StmtArrayAppend(&scope->satements, statement(parser));
+		AstAddToBlock(&parser->ast, statement(parser));
 	}
 
-	StmtWhileLoop* loop = STMT_ALLOCATE(StmtWhileLoop, STMT_WHILE_LOOP);
-
+	ExprHandle condition;
 	if (match(parser, TOKEN_SEMICOLON))
 	{
-		ExprNumberLiteral* expr = EXPR_ALLOCATE(ExprNumberLiteral, EXPR_NUMBER_LITERAL);
-		expr->dataType.type = DATA_TYPE_INT;
-		expr->literal.line = parser->current.line;
-		expr->literal.type = TOKEN_INT_LITERAL;
-		expr->literal.text = StringViewInit("1", 1);
-		loop->condition = (Expr*)expr;
+		DataType intType;
+		intType.type = DATA_TYPE_INT;
+		intType.isUnsigned = false;
+		condition = AstAddIntLiteral(&parser->ast, intType, tokenOffset(parser, &parser->previous), 1);
 	}
 	else
 	{
-		loop->condition = expression(parser);
+		condition = expression(parser);
 		consume(parser, TOKEN_SEMICOLON, "expected ';'");
 	}
 
-	Expr* iterationExpression = expression(parser);
-	StmtExpression* expression = STMT_ALLOCATE(StmtExpression, STMT_EXPRESSION);
-	expression->expresssion = iterationExpression;
+	ExprHandle iterationExpression = expression(parser);
 
 	consume(parser, TOKEN_RIGHT_PAREN, "exptected ')'");
 
-	StmtBlock* block = STMT_ALLOCATE(StmtBlock, STMT_BLOCK);
-	StmtArrayInit(&block->satements);
-	StmtArrayAppend(&block->satements, statement(parser));
-	StmtArrayAppend(&block->satements, (Stmt*)expression);
-	loop->body = (Stmt*)block;
+	size_t bodyStart = AstBeginBlock(&parser->ast);
+	AstAddToBlock(&parser->ast, statement(parser));
+	AstAddToBlock(&parser->ast, AstAddExpressionStmt(&parser->ast, iterationExpression));
+	StmtHandle body = AstAddBlock(&parser->ast, AstEndBlock(&parser->ast, bodyStart));
 
-	StmtArrayAppend(&scope->satements, (Stmt*)loop);
+	AstAddToBlock(&parser->ast, AstAddWhileLoop(&parser->ast, condition, body));
 
-	return (Stmt*)scope;
+	return AstAddBlock(&parser->ast, AstEndBlock(&parser->ast, scopeStart));
 }
 
-static Stmt* breakStmt(Parser* parser)
+static StmtHandle breakStmt(Parser* parser)
 {
-	StmtBreak* stmt = STMT_ALLOCATE(StmtBreak, STMT_BREAK);
-	stmt->token = parser->previous;
+	uint32_t offset = tokenOffset(parser, &parser->previous);
 	consume(parser, TOKEN_SEMICOLON, "Expected ';'");
-	return (Stmt*)stmt;
+	return AstAddBreak(&parser->ast, offset);
 }
 
-static Stmt* continueStmt(Parser* parser)
+static StmtHandle continueStmt(Parser* parser)
 {
-	StmtContinue* stmt = STMT_ALLOCATE(StmtContinue, STMT_CONTINUE);
-	stmt->token = parser->previous;
+	uint32_t offset = tokenOffset(parser, &parser->previous);
 	consume(parser, TOKEN_SEMICOLON, "Expected ';'");
-	return (Stmt*)stmt;
+	return AstAddContinue(&parser->ast, offset);
 }
 
-static Stmt* putcharStmt(Parser* parser)
+static StmtHandle putcharStmt(Parser* parser)
 {
-	StmtPutchar* stmt = STMT_ALLOCATE(StmtPutchar, STMT_PUTCHAR);
 	consume(parser, TOKEN_LEFT_PAREN, "Expected '('");
-	stmt->expresssion = expression(parser);
+	ExprHandle expr = expression(parser);
 	consume(parser, TOKEN_RIGHT_PAREN, "Expected ')'");
 	consume(parser, TOKEN_SEMICOLON, "Expected ';'");
-	return (Stmt*)stmt;
+	return AstAddPutchar(&parser->ast, expr);
 }
 
 bool isDataTypeStart(Parser* parser)
@@ -592,8 +604,16 @@ bool isDataTypeStart(Parser* parser)
 		|| check(parser, TOKEN_DOUBLE);
 }
 
-static Stmt* statement(Parser* parser)
+static StmtHandle statement(Parser* parser)
 {
+	// This also takes the blocks that are the bodies of top level statements like while.
+	if ((parser->parallelParse != NULL) && check(parser, TOKEN_LEFT_BRACE))
+	{
+		StmtHandle stmt = takeParsedBlock(parser);
+		if (stmt != AST_HANDLE_NULL)
+			return stmt;
+	}
+
 	if (isDataTypeStart(parser))
 		return variableDeclaration(parser);
 	else if (match(parser, TOKEN_RETURN))
@@ -616,12 +636,229 @@ static Stmt* statement(Parser* parser)
 		return expressionStatement(parser);
 }
 
-static Stmt* declaration(Parser* parser)
+static StmtHandle declaration(Parser* parser)
+{
+
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(TopLevelBlockArray, TopLevelBlock)
+
+// Finds the blocks without scanning the tokens. Only comments and char literals can contain braces that aren't
+// tokens. If this gets a block wrong it is just parsed again on the main thread.
+static void findTopLevelBlocks(StringView source, TopLevelBlockArray* blocks)
+{
+	const char* dataStart = source.chars;
+	const char* dataEnd = source.chars + source.length;
+	const char* chr = dataStart;
+	const char* blockStart = NULL;
+	size_t depth = 0;
+
+	while (chr < dataEnd)
+	{
+#ifdef SIMD_WIDTH
+		if ((dataEnd - chr) >= SIMD_WIDTH)
+		{
+			uint32_t mask = SimdMatchMask(chr, '{') | SimdMatchMask(chr, '}')
+				| SimdMatchMask(chr, '/') | SimdMatchMask(chr, '\'');
+			if (mask == 0)
+			{
+				chr += SIMD_WIDTH;
+				continue;
+			}
+			chr += SimdCountTrailingZeros(mask);
+		}
+#endif
+
+		switch (*chr)
+		{
+			case '/':
+				if (((chr + 1) < dataEnd) && (chr[1] == '/'))
+				{
+					const char* newline = memchr(chr, '\n', dataEnd - chr);
+					chr = (newline == NULL) ? dataEnd : newline;
+					continue;
+				}
+				break;
+
+			case '\'':
+			{
+				const char* closing = memchr(chr + 1, '\'', dataEnd - (chr + 1));
+				chr = (closing == NULL) ? dataEnd : closing + 1;
+				continue;
+			}
+
+			case '{':
+				if (depth == 0)
+					blockStart = chr;
+				depth++;
+				break;
+
+			case '}':
+				// Unmatched braces are left for the parser to report.
+				if (depth == 0)
+					break;
+				depth--;
+				if (depth == 0)
+				{
+					TopLevelBlock block;
+					block.start = (uint32_t)(blockStart - dataStart);
+					block.end = (uint32_t)(chr + 1 - dataStart);
+					block.workerIndex = 0;
+					block.stmt = AST_HANDLE_NULL;
+					TopLevelBlockArrayAppend(blocks, block);
+				}
+				break;
+		}
+		chr++;
+	}
+}
+
+static void parseTopLevelBlocks(void* workerPointer)
 {
+	ParseWorker* worker = workerPointer;
+	Parser* parser = &worker->parser;
+	AstClear(&parser->ast, worker->fileInfo->source);
+
+	for (size_t i = 0; i < worker->blockCount; i++)
+	{
+		TopLevelBlock* block = &worker->blocks[i];
+		ScannerResetRange(&parser->scanner, worker->fileInfo, block->start, block->end);
+		parser->hadError = false;
+		parser->isSynchronizing = false;
+		parser->current = ScannerNextToken(&parser->scanner);
+
+		StmtHandle stmt = AST_HANDLE_NULL;
+		if (check(parser, TOKEN_LEFT_BRACE))
+			stmt = statement(parser);
+
+		// If the block doesn't end at the end of the range the pre-pass got it wrong.
+		block->stmt = ((parser->hadError == false) && isAtEnd(parser)) ? stmt : AST_HANDLE_NULL;
+	}
+}
+
+// Each worker gets a run of consecutive blocks with about the same number of bytes.
+static ParseWorker* parseBlocksParallel(Parser* parser, FileInfo* fileInfo, TopLevelBlockArray* blocks, size_t* workerCount)
+{
+	size_t threadCount = ThreadHardwareConcurrency();
+	if (threadCount > blocks->size)
+		threadCount = blocks->size;
+
+	ParseWorker* workers = malloc(sizeof(ParseWorker) * threadCount);
+	Thread* threads = malloc(sizeof(Thread) * threadCount);
+	if ((workers == NULL) || (threads == NULL))
+	{
+		fputs("Failed to allocate parse workers\n", stderr);
+		exit(1);
+	}
+
+	size_t totalSize = 0;
+	for (size_t i = 0; i < blocks->size; i++)
+		totalSize += blocks->data[i].end - blocks->data[i].start;
+
+	size_t assignedSize = 0;
+	for (size_t i = 0; i < blocks->size; i++)
+	{
+		blocks->data[i].workerIndex = (assignedSize * threadCount) / totalSize;
+		assignedSize += blocks->data[i].end - blocks->data[i].start;
+	}
 
+	size_t blockIndex = 0;
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		ParseWorker* worker = &workers[i];
+		ParserInit(&worker->parser);
+		worker->parser.isSpeculative = true;
+		worker->parser.scanner.isSpeculative = true;
+		worker->fileInfo = fileInfo;
+		worker->symbolMap = NULL;
+		worker->blocks = &blocks->data[blockIndex];
+		worker->blockCount = 0;
+		while ((blockIndex < blocks->size) && (blocks->data[blockIndex].workerIndex == i))
+		{
+			worker->blockCount++;
+			blockIndex++;
+		}
+	}
+
+	for (size_t i = 1; i < threadCount; i++)
+		ThreadStart(&threads[i], parseTopLevelBlocks, &workers[i]);
+	parseTopLevelBlocks(&workers[0]);
+	for (size_t i = 1; i < threadCount; i++)
+		ThreadJoin(&threads[i]);
+	free(threads);
+
+	// The workers interned the names into their own tables.
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		const StringViewArray* names = &workers[i].parser.scanner.symbols.names;
+		workers[i].symbolMap = malloc(sizeof(SymbolId) * (names->size + 1));
+		if (workers[i].symbolMap == NULL)
+		{
+			fputs("Failed to allocate symbol map\n", stderr);
+			exit(1);
+		}
+		for (size_t j = 0; j < names->size; j++)
+			workers[i].symbolMap[j] = SymbolTableIntern(&parser->scanner.symbols, names->data[j]);
+	}
+
+	*workerCount = threadCount;
+	return workers;
+}
+
+// If the current token starts a block that was parsed by a worker, copies it into the ast and skips past it.
+static StmtHandle takeParsedBlock(Parser* parser)
+{
+	ParallelParse* parallelParse = parser->parallelParse;
+	const TopLevelBlockArray* blocks = &parallelParse->blocks;
+	uint32_t offset = tokenOffset(parser, &parser->current);
+	// Blocks that the main thread parsed again, because the worker failed to parse them, are skipped.
+	while ((parallelParse->nextBlock < blocks->size) && (blocks->data[parallelParse->nextBlock].start < offset))
+		parallelParse->nextBlock++;
+	if (parallelParse->nextBlock == blocks->size)
+		return AST_HANDLE_NULL;
+
+	const TopLevelBlock* block = &blocks->data[parallelParse->nextBlock];
+	if ((block->start != offset) || (block->stmt == AST_HANDLE_NULL))
+		return AST_HANDLE_NULL;
+	parallelParse->nextBlock++;
+
+	const ParseWorker* worker = &parallelParse->workers[block->workerIndex];
+	StmtHandle stmt = AstCopyStmt(&parser->ast, &worker->parser.ast, block->stmt, worker->symbolMap);
+
+	FileInfo* fileInfo = parser->scanner.fileInfo;
+	ScannerResetRange(&parser->scanner, fileInfo, block->end, fileInfo->source.length);
+	// The closing brace, so the span of the statement ends in the right place.
+	parser->previous.type = TOKEN_RIGHT_BRACE;
+	parser->previous.text.chars = fileInfo->source.chars + block->end - 1;
+	parser->previous.text.length = 1;
+	parser->current = ScannerNextToken(&parser->scanner);
+	return stmt;
 }
 
-StmtArray ParserParse(Parser* parser, const char* filename, StringView source, FileInfo* fileInfoToFillOut)
+static void addTopLevelStatement(Parser* parser, uint32_t start, StmtHandle stmt)
+{
+	AstAddToBlock(&parser->ast, stmt);
+	SourceSpan span;
+	span.start = start;
+	span.end = tokenOffset(parser, &parser->previous) + (uint32_t)parser->previous.text.length;
+	SourceSpanArrayAppend(&parser->spans, span);
+
+	if (parser->isSynchronizing)
+		synchornize(parser);
+}
+
+// Adds a statement of the last parse to the new root. The nodes stay where they are.
+static void reuseTopLevelStatement(Parser* parser, StmtHandle stmt, SourceSpan span, int32_t offsetDelta)
+{
+	if (offsetDelta != 0)
+		AstShiftStmtOffsets(&parser->ast, stmt, offsetDelta);
+	AstAddToBlock(&parser->ast, stmt);
+	span.start += offsetDelta;
+	span.end += offsetDelta;
+	SourceSpanArrayAppend(&parser->spans, span);
+}
+
+const Ast* ParserParse(Parser* parser, const char* filename, StringView source, FileInfo* fileInfoToFillOut)
 {
 	parser->hadError = false;
 	parser->isSynchronizing = false;
@@ -630,16 +867,119 @@ StmtArray ParserParse(Parser* parser, const char* filename, StringView source, F
 	fileInfoToFillOut->filename = filename;
 	ScannerReset(&parser->scanner, fileInfoToFillOut);
 	parser->current = ScannerNextToken(&parser->scanner);
+	parser->previous = parser->current;
+	AstClear(&parser->ast, source);
+	SourceSpanArrayClear(&parser->spans);
+
+	// The top level blocks, which are mostly the bodies of top level statements, are parsed on other threads
+	// first. The statements are then parsed in order and statement copies the blocks that the workers parsed
+	// into the ast instead of parsing them again.
+	ParallelParse parallelParse;
+	TopLevelBlockArrayInit(&parallelParse.blocks);
+	parallelParse.nextBlock = 0;
+	parallelParse.workers = NULL;
+	parallelParse.workerCount = 0;
+	if ((source.length >= PARALLEL_PARSE_MIN_SIZE) && (ThreadHardwareConcurrency() > 1))
+	{
+		findTopLevelBlocks(source, &parallelParse.blocks);
+		if (parallelParse.blocks.size > 1)
+		{
+			parallelParse.workers = parseBlocksParallel(parser, fileInfoToFillOut, &parallelParse.blocks, &parallelParse.workerCount);
+			parser->parallelParse = &parallelParse;
+		}
+	}
+
+	size_t rootStart = AstBeginBlock(&parser->ast);
+	while (isAtEnd(parser) == false)
+	{
+		uint32_t start = tokenOffset(parser, &parser->current);
+		addTopLevelStatement(parser, start, statement(parser));
+	}
+	parser->ast.root = AstEndBlock(&parser->ast, rootStart);
+	parser->fullParseNodeCount = AstNodeCount(&parser->ast);
+	parser->parallelParse = NULL;
+
+	for (size_t i = 0; i < parallelParse.workerCount; i++)
+	{
+		ParserFree(&parallelParse.workers[i].parser);
+		free(parallelParse.workers[i].symbolMap);
+	}
+	free(parallelParse.workers);
+	TopLevelBlockArrayFree(&parallelParse.blocks);
+
+	return &parser->ast;
+}
+
+const Ast* ParserReparse(Parser* parser, StringView source, FileInfo* fileInfo, const SourceEdit* edit)
+{
+	ASSERT((edit->start <= edit->oldEnd) && (edit->start <= edit->newEnd) && (edit->newEnd <= source.length));
+	if (parser->hadError || (AstNodeCount(&parser->ast) > (parser->fullParseNodeCount * 2)))
+		return ParserParse(parser, fileInfo->filename, source, fileInfo);
+
+	SourceSpanArray spans = parser->previousSpans;
+	parser->previousSpans = parser->spans;
+	parser->spans = spans;
+	SourceSpanArrayClear(&parser->spans);
+
+	const SourceSpan* oldSpans = parser->previousSpans.data;
+	size_t oldCount = parser->previousSpans.size;
+	StmtBlock oldRoot = parser->ast.root;
+	int32_t offsetDelta = (int32_t)edit->newEnd - (int32_t)edit->oldEnd;
+
+	// The first statement the edit touches. The one before it is parsed again too, because the edit can change
+	// the token after it, which decides if an if statement has an else.
+	size_t first = 0;
+	while ((first < oldCount) && (oldSpans[first].end < edit->start))
+		first++;
+	if (first > 0)
+		first--;
+
+	// The statements after the edit. A statement starting right at the end of the edit isn't reused, the edit
+	// could have changed its first token.
+	size_t next = first;
+	while ((next < oldCount) && (oldSpans[next].start <= edit->oldEnd))
+		next++;
+
+	parser->hadError = false;
+	parser->isSynchronizing = false;
+	fileInfo->source = source;
+	parser->ast.source = source;
+	ScannerReset(&parser->scanner, fileInfo);
+
+	// The new statements are added to the pools after the old ones. The handles of the old root are read by index
+	// because adding the new root can reallocate the block statements.
+	size_t rootStart = AstBeginBlock(&parser->ast);
+	for (size_t i = 0; i < first; i++)
+		reuseTopLevelStatement(parser, parser->ast.blockStatements.data[oldRoot.start + i], oldSpans[i], 0);
+
+	// If the edit is before the first statement it can be in a comment, so the scanning starts at the beginning.
+	uint32_t restart = (first > 0) ? oldSpans[first].start : 0;
+	ScannerResetRange(&parser->scanner, fileInfo, restart, source.length);
+	parser->current = ScannerNextToken(&parser->scanner);
+	parser->previous = parser->current;
 
-	StmtArray array;
-	StmtArrayInit(&array);
+	// Parses until the parser reaches the start of one of the statements after the edit. From there on the
+	// tokens are the same as before so the rest of the statements are the same too.
+	bool isInSync = false;
 	while (isAtEnd(parser) == false)
 	{
-		StmtArrayAppend(&array, statement(parser));
+		uint32_t start = tokenOffset(parser, &parser->current);
+		while ((next < oldCount) && (((int64_t)oldSpans[next].start + offsetDelta) < start))
+			next++;
+		if ((next < oldCount) && (((int64_t)oldSpans[next].start + offsetDelta) == start))
+		{
+			isInSync = true;
+			break;
+		}
+		addTopLevelStatement(parser, start, statement(parser));
+	}
 
-		if (parser->isSynchronizing)
-			synchornize(parser);
+	if (isInSync)
+	{
+		for (; next < oldCount; next++)
+			reuseTopLevelStatement(parser, parser->ast.blockStatements.data[oldRoot.start + next], oldSpans[next], offsetDelta);
 	}
+	parser->ast.root = AstEndBlock(&parser->ast, rootStart);
 
-	return array;
-}
\ No newline at end of file
+	return &parser->ast;
+}
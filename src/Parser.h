@@ -10,16 +10,57 @@
 // struct type could be used for declarations like
 // struct { int x, int y } a;
 
+// Files at least this big have their top level blocks parsed on multiple threads.
+#define PARALLEL_PARSE_MIN_SIZE (256 * 1024)
+
+// The source range of a top level statement. From the start of its first token to the end of its last token.
+typedef struct
+{
+	uint32_t start;
+	uint32_t end;
+} SourceSpan;
+
+ARRAY_TEMPLATE_DECLARATION(SourceSpanArray, SourceSpan)
+
+// The text in [start, oldEnd) of the old source was replaced with the text in [start, newEnd) of the new source.
+typedef struct
+{
+	uint32_t start;
+	uint32_t oldEnd;
+	uint32_t newEnd;
+} SourceEdit;
+
+// The blocks parsed on other threads during a parse of a large file.
+typedef struct ParallelParse ParallelParse;
+
 typedef struct
 {
 	Scanner scanner;
+	Ast ast;
+	// The spans of the statements in ast.root. Only valid if the parse didn't have errors.
+	SourceSpanArray spans;
+	// Used by ParserReparse to build the new spans.
+	SourceSpanArray previousSpans;
+	// Reparsing leaves the nodes of the replaced statements in the pools. Once there are too many of them
+	// the file is parsed again from the start.
+	size_t fullParseNodeCount;
 	Token current;
 	Token previous;
 
 	bool hadError;
 	bool isSynchronizing;
+	// Set for parsers running on other threads. Errors aren't reported, the part is parsed again on the main thread.
+	bool isSpeculative;
+	// NULL unless the top level blocks were parsed on other threads.
+	ParallelParse* parallelParse;
 } Parser;
 
 void ParserInit(Parser* parser);
 void ParserFree(Parser* parser);
-StmtArray ParserParse(Parser* parser, const char* filename, StringView source, FileInfo* fileInfoToFillOut);
\ No newline at end of file
+// The ast is valid until the next parse or until the parser is freed.
+const Ast* ParserParse(Parser* parser, const char* filename, StringView source, FileInfo* fileInfoToFillOut);
+// Parses the source after an edit. The top level statements of the last parse that the edit doesn't touch are
+// kept instead of being scanned and parsed again. fileInfo has to be the one the last parse used, it is updated
+// to the new source. If the last parse had errors the whole source is parsed. The interned names point into the
+// sources of the earlier parses so they have to stay valid.
+const Ast* ParserReparse(Parser* parser, StringView source, FileInfo* fileInfo, const SourceEdit* edit);
\ No newline at end of file
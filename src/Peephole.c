@@ -0,0 +1,209 @@
+#include "Peephole.h"
+#include "Assert.h"
+
+#include <string.h>
+
+// The window ends with the instruction that was just kept. Returns the index in the window of the instruction to
+// remove or -1 if the rule doesn't match. Rules can change the other instructions of the window.
+typedef int (*PeepholeRuleFunction)(AsmInstruction* window, int windowSize);
+
+typedef struct
+{
+	const char* name;
+	PeepholeRuleFunction function;
+} PeepholeRule;
+
+static int removeRedundantMove(AsmInstruction* window, int windowSize);
+static int removeCompareAfterSet(AsmInstruction* window, int windowSize);
+static int removeJumpToNextLabel(AsmInstruction* window, int windowSize);
+
+static bool isMove(const AsmInstruction* instruction);
+static bool isGpRegister(const AsmOperand* operand, RegisterGp reg, size_t size);
+// Returns the suffix of the condition that is true when the one given is false or NULL if it isn't known.
+static const char* invertConditionSuffix(const char* suffix);
+
+static const PeepholeRule rules[] = {
+	[PEEPHOLE_RULE_REDUNDANT_MOVE] = { "redundant mov", removeRedundantMove },
+	[PEEPHOLE_RULE_COMPARE_AFTER_SET] = { "cmp after set", removeCompareAfterSet },
+	[PEEPHOLE_RULE_JUMP_TO_NEXT_LABEL] = { "jump to next label", removeJumpToNextLabel },
+};
+
+void PeepholeOptimizerInit(PeepholeOptimizer* optimizer)
+{
+	for (int i = 0; i < PEEPHOLE_RULE_COUNT; i++)
+	{
+		optimizer->isRuleEnabled[i] = true;
+		optimizer->removedCounts[i] = 0;
+	}
+}
+
+static bool isMove(const AsmInstruction* instruction)
+{
+	return (instruction->isLabel == false)
+		&& ((strcmp(instruction->opcode, "mov") == 0)
+		 || (strcmp(instruction->opcode, "movss") == 0)
+		 || (strcmp(instruction->opcode, "movsd") == 0));
+}
+
+static bool isGpRegister(const AsmOperand* operand, RegisterGp reg, size_t size)
+{
+	return (operand->type == ASM_OPERAND_REGISTER_GP) && (operand->as.gpRegister == reg) && (operand->size == size);
+}
+
+static const char* invertConditionSuffix(const char* suffix)
+{
+	static const char* pairs[][2] = {
+		{ "e", "ne" }, { "l", "ge" }, { "le", "g" }, { "b", "ae" }, { "be", "a" },
+	};
+
+	for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+	{
+		if (strcmp(suffix, pairs[i][0]) == 0)
+			return pairs[i][1];
+		if (strcmp(suffix, pairs[i][1]) == 0)
+			return pairs[i][0];
+	}
+	return NULL;
+}
+
+// The second mov writes the value the destination already has. The upper bits of registers that the mov might
+// clear aren't used by the generated code, which always reads values with their own size.
+static int removeRedundantMove(AsmInstruction* window, int windowSize)
+{
+	if (windowSize < 2)
+		return -1;
+
+	const AsmInstruction* first = &window[windowSize - 2];
+	const AsmInstruction* second = &window[windowSize - 1];
+	if (isMove(first)
+	 && (strcmp(first->opcode, second->opcode) == 0)
+	 && AsmOperandEquals(&first->operands[0], &second->operands[1])
+	 && AsmOperandEquals(&first->operands[1], &second->operands[0]))
+	{
+		return windowSize - 1;
+	}
+	return -1;
+}
+
+// set and movzx don't change the flags and cmp r, 0 sets the zero flag to the inverse of the condition, so jne and
+// setne are the condition of the set and je and sete are its inverse. The code generator often puts a mov between
+// them, like the moves of a branch argument, which doesn't change the flags either if it doesn't write r.
+static int removeCompareAfterSet(AsmInstruction* window, int windowSize)
+{
+	if (windowSize < 4)
+		return -1;
+
+	AsmInstruction* user = &window[windowSize - 1];
+	const AsmInstruction* compare = &window[windowSize - 2];
+	if (compare->isLabel
+	 || (strcmp(compare->opcode, "cmp") != 0)
+	 || (compare->operands[0].type != ASM_OPERAND_REGISTER_GP)
+	 || (compare->operands[0].size != SIZE_DWORD)
+	 || (compare->operands[1].type != ASM_OPERAND_IMMEDIATE)
+	 || (compare->operands[1].as.immediate != 0))
+		return -1;
+
+	RegisterGp reg = compare->operands[0].as.gpRegister;
+	int extendIndex = windowSize - 3;
+	const AsmInstruction* between = &window[extendIndex];
+	if (isMove(between)
+	 && ((between->operands[0].type != ASM_OPERAND_REGISTER_GP) || (between->operands[0].as.gpRegister != reg)))
+		extendIndex--;
+	if (extendIndex < 1)
+		return -1;
+
+	const AsmInstruction* extend = &window[extendIndex];
+	const AsmInstruction* set = &window[extendIndex - 1];
+	if (extend->isLabel
+	 || (strcmp(extend->opcode, "movzx") != 0)
+	 || (isGpRegister(&extend->operands[0], reg, SIZE_DWORD) == false)
+	 || (isGpRegister(&extend->operands[1], reg, SIZE_BYTE) == false))
+		return -1;
+
+	if (set->isLabel || (strncmp(set->opcode, "set", 3) != 0) || (isGpRegister(&set->operands[0], reg, SIZE_BYTE) == false))
+		return -1;
+
+	// The flags are used by a jump or by another set, which comes from comparing the result with 0.
+	const char* userPrefix;
+	if (AsmIsJump(user))
+		userPrefix = "j";
+	else if ((user->isLabel == false) && (strncmp(user->opcode, "set", 3) == 0))
+		userPrefix = "set";
+	else
+		return -1;
+
+	const char* condition = set->opcode + strlen("set");
+	const char* userCondition = user->opcode + strlen(userPrefix);
+	const char* newCondition;
+	if (strcmp(userCondition, "ne") == 0)
+		newCondition = condition;
+	else if (strcmp(userCondition, "e") == 0)
+		newCondition = invertConditionSuffix(condition);
+	else
+		return -1;
+
+	if (newCondition == NULL)
+		return -1;
+
+	snprintf(user->opcode, ASM_OPCODE_SIZE, "%s%s", userPrefix, newCondition);
+	return windowSize - 2;
+}
+
+static int removeJumpToNextLabel(AsmInstruction* window, int windowSize)
+{
+	if (windowSize < 2)
+		return -1;
+
+	const AsmInstruction* jump = &window[windowSize - 2];
+	const AsmInstruction* label = &window[windowSize - 1];
+	if (AsmIsJump(jump)
+	 && label->isLabel
+	 && (jump->operands[0].type == ASM_OPERAND_LABEL)
+	 && (jump->operands[0].as.labelIndex == label->labelIndex))
+	{
+		return windowSize - 2;
+	}
+	return -1;
+}
+
+void PeepholeOptimizerOptimize(PeepholeOptimizer* optimizer, AsmInstructionArray* instructions)
+{
+	// The kept instructions are moved to the start of the array, so this doesn't allocate.
+	AsmInstruction* data = instructions->data;
+	size_t keptCount = 0;
+	for (size_t i = 0; i < instructions->size; i++)
+	{
+		data[keptCount++] = data[i];
+
+		int rule = 0;
+		while (rule < PEEPHOLE_RULE_COUNT)
+		{
+			int windowSize = (keptCount < PEEPHOLE_WINDOW_SIZE) ? (int)keptCount : PEEPHOLE_WINDOW_SIZE;
+			AsmInstruction* window = &data[keptCount - windowSize];
+			int removed = optimizer->isRuleEnabled[rule] ? rules[rule].function(window, windowSize) : -1;
+			if (removed == -1)
+			{
+				rule++;
+				continue;
+			}
+
+			ASSERT((removed >= 0) && (removed < windowSize));
+			memmove(&window[removed], &window[removed + 1], (windowSize - removed - 1) * sizeof(AsmInstruction));
+			keptCount--;
+			optimizer->removedCounts[rule]++;
+			rule = 0;
+		}
+	}
+	instructions->size = keptCount;
+}
+
+void PeepholeOptimizerPrintStatistics(const PeepholeOptimizer* optimizer, FILE* file)
+{
+	for (int i = 0; i < PEEPHOLE_RULE_COUNT; i++)
+	{
+		fprintf(
+			file, "%s: %zu removed%s\n",
+			rules[i].name, optimizer->removedCounts[i], optimizer->isRuleEnabled[i] ? "" : " (disabled)"
+		);
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Assembly.h"
+
+#include <stdio.h>
+
+// Removes instructions that don't do anything from the emitted code. Every instruction is appended to the kept
+// instructions and the rules are tried on the last few kept ones, which is the window. A rule removes at most one
+// instruction of the window. The rules are tried again after a removal, because it can make a new match.
+
+typedef enum
+{
+	// mov a, b followed by mov b, a. Mostly a store of a spilled value followed by loading it back.
+	PEEPHOLE_RULE_REDUNDANT_MOVE,
+	// set<cc> r; movzx r, r; cmp r, 0 followed by je, jne, sete or setne, maybe with a mov before the cmp. The jump
+	// or set can use the flags the first set used.
+	PEEPHOLE_RULE_COMPARE_AFTER_SET,
+	// A jump to the label right after it.
+	PEEPHOLE_RULE_JUMP_TO_NEXT_LABEL,
+	PEEPHOLE_RULE_COUNT,
+} PeepholeRuleType;
+
+// The number of instructions the rules can look at.
+#define PEEPHOLE_WINDOW_SIZE 5
+
+typedef struct
+{
+	bool isRuleEnabled[PEEPHOLE_RULE_COUNT];
+	// The number of instructions each rule removed since the optimizer was initialized.
+	size_t removedCounts[PEEPHOLE_RULE_COUNT];
+} PeepholeOptimizer;
+
+// Every rule is enabled.
+void PeepholeOptimizerInit(PeepholeOptimizer* optimizer);
+void PeepholeOptimizerOptimize(PeepholeOptimizer* optimizer, AsmInstructionArray* instructions);
+void PeepholeOptimizerPrintStatistics(const PeepholeOptimizer* optimizer, FILE* file);
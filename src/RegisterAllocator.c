@@ -0,0 +1,467 @@
+#include "RegisterAllocator.h"
+#include "Assert.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The code generator uses rax, rbx, rdx and xmm0 to xmm2 as scratch registers and rbp for the stack frame, so they
+// aren't allocated. The program exits instead of returning, so the callee saved registers don't have to be saved.
+// The registers at the start are clobbered by putchar. They are tried first for values that aren't live across one,
+// which leaves the others free for the values that are.
+static const RegisterGp allocatableGpRegisters[] = {
+	REGISTER_RCX, REGISTER_RSI, REGISTER_RDI, REGISTER_R11,
+	REGISTER_R8, REGISTER_R9, REGISTER_R10, REGISTER_R12, REGISTER_R13, REGISTER_R14, REGISTER_R15
+};
+#define ALLOCATABLE_GP_REGISTER_COUNT (sizeof(allocatableGpRegisters) / sizeof(allocatableGpRegisters[0]))
+#define SYSCALL_CLOBBERED_GP_REGISTER_COUNT 4
+
+static const RegisterSimd allocatableSimdRegisters[] = {
+	REGISTER_XMM3, REGISTER_XMM4, REGISTER_XMM5, REGISTER_XMM6, REGISTER_XMM7
+};
+#define ALLOCATABLE_SIMD_REGISTER_COUNT (sizeof(allocatableSimdRegisters) / sizeof(allocatableSimdRegisters[0]))
+
+// A use inside a loop counts this many times more than one outside of it.
+#define LOOP_WEIGHT 8.0f
+#define MAX_WEIGHTED_LOOP_DEPTH 5
+
+#define WORD_BITS 64
+
+static void fillIntArray(IntArray* array, size_t count, int value);
+static void fillBitsets(BitsetWordArray* array, size_t count);
+static uint64_t* getSet(BitsetWordArray* array, RegisterAllocator* allocator, IrBlockIndex block);
+static bool isInSet(const uint64_t* set, IrValue value);
+static void addToSet(uint64_t* set, IrValue value);
+
+static uint32_t numberInstructions(RegisterAllocator* allocator, const IrFunction* function);
+static void computeLoopDepths(RegisterAllocator* allocator, const IrFunction* function, uint32_t positionCount);
+static void computeLiveness(RegisterAllocator* allocator, const IrFunction* function);
+static void buildIntervals(RegisterAllocator* allocator, const IrFunction* function, uint32_t positionCount);
+static void extendInterval(LiveInterval* interval, uint32_t position);
+static int compareIntervalStarts(const void* a, const void* b);
+
+static void linearScan(RegisterAllocator* allocator, const IrFunction* function);
+static void expireIntervals(RegisterAllocator* allocator, uint32_t position, bool* gpInUse, bool* simdInUse);
+// Returns true if the allocation of the value can be used by the interval.
+static bool isRegisterUsable(const RegisterAllocator* allocator, const LiveInterval* interval, IrValue value);
+
+void RegisterAllocatorInit(RegisterAllocator* allocator)
+{
+	AllocationArrayInit(&allocator->allocations);
+	LiveIntervalArrayInit(&allocator->intervals);
+	LiveIntervalArrayInit(&allocator->sorted);
+	LiveIntervalArrayInit(&allocator->active);
+	BitsetWordArrayInit(&allocator->liveIn);
+	BitsetWordArrayInit(&allocator->liveOut);
+	BitsetWordArrayInit(&allocator->defined);
+	BitsetWordArrayInit(&allocator->used);
+	IntArrayInit(&allocator->blockStarts);
+	IntArrayInit(&allocator->loopDepths);
+	IntArrayInit(&allocator->syscallsBefore);
+}
+
+void RegisterAllocatorFree(RegisterAllocator* allocator)
+{
+	AllocationArrayFree(&allocator->allocations);
+	LiveIntervalArrayFree(&allocator->intervals);
+	LiveIntervalArrayFree(&allocator->sorted);
+	LiveIntervalArrayFree(&allocator->active);
+	BitsetWordArrayFree(&allocator->liveIn);
+	BitsetWordArrayFree(&allocator->liveOut);
+	BitsetWordArrayFree(&allocator->defined);
+	BitsetWordArrayFree(&allocator->used);
+	IntArrayFree(&allocator->blockStarts);
+	IntArrayFree(&allocator->loopDepths);
+	IntArrayFree(&allocator->syscallsBefore);
+}
+
+static void fillIntArray(IntArray* array, size_t count, int value)
+{
+	IntArrayClear(array);
+	IntArrayReserve(array, count);
+	for (size_t i = 0; i < count; i++)
+		IntArrayAppend(array, value);
+}
+
+static void fillBitsets(BitsetWordArray* array, size_t count)
+{
+	BitsetWordArrayClear(array);
+	BitsetWordArrayReserve(array, count);
+	for (size_t i = 0; i < count; i++)
+		BitsetWordArrayAppend(array, 0);
+}
+
+static uint64_t* getSet(BitsetWordArray* array, RegisterAllocator* allocator, IrBlockIndex block)
+{
+	return &array->data[block * allocator->wordsPerSet];
+}
+
+static bool isInSet(const uint64_t* set, IrValue value)
+{
+	return (set[value / WORD_BITS] >> (value % WORD_BITS)) & 1;
+}
+
+static void addToSet(uint64_t* set, IrValue value)
+{
+	set[value / WORD_BITS] |= (uint64_t)1 << (value % WORD_BITS);
+}
+
+// Gives the instructions of the reachable blocks positions in the order the blocks are placed in and returns the
+// number of positions.
+static uint32_t numberInstructions(RegisterAllocator* allocator, const IrFunction* function)
+{
+	fillIntArray(&allocator->blockStarts, function->blocks.size, -1);
+
+	uint32_t position = 0;
+	for (size_t i = 0; i < function->layout.size; i++)
+	{
+		IrBlockIndex blockIndex = function->layout.data[i];
+		const IrBlock* block = &function->blocks.data[blockIndex];
+		if (block->isReachable == false)
+			continue;
+
+		allocator->blockStarts.data[blockIndex] = (int)position;
+		position += block->instructionCount;
+	}
+	return position;
+}
+
+// The blocks are placed in the order of the source, so a jump backwards is the end of a loop and every block placed
+// between its target and it is inside the loop.
+static void computeLoopDepths(RegisterAllocator* allocator, const IrFunction* function, uint32_t positionCount)
+{
+	// Filled with the changes of the depth first and summed up after.
+	fillIntArray(&allocator->loopDepths, positionCount + 1, 0);
+	for (size_t i = 0; i < function->blocks.size; i++)
+	{
+		const IrBlock* block = &function->blocks.data[i];
+		int start = allocator->blockStarts.data[i];
+		if (start == -1)
+			continue;
+
+		for (uint32_t j = 0; j < block->successorCount; j++)
+		{
+			int successorStart = allocator->blockStarts.data[block->successors[j]];
+			if (successorStart > start)
+				continue;
+
+			allocator->loopDepths.data[successorStart]++;
+			allocator->loopDepths.data[start + block->instructionCount]--;
+		}
+	}
+
+	int depth = 0;
+	for (uint32_t i = 0; i < positionCount; i++)
+	{
+		depth += allocator->loopDepths.data[i];
+		allocator->loopDepths.data[i] = depth;
+	}
+}
+
+static void computeLiveness(RegisterAllocator* allocator, const IrFunction* function)
+{
+	size_t blockCount = function->blocks.size;
+	size_t wordsPerSet = (function->valueTypes.size + WORD_BITS - 1) / WORD_BITS;
+	allocator->wordsPerSet = wordsPerSet;
+	fillBitsets(&allocator->liveIn, blockCount * wordsPerSet);
+	fillBitsets(&allocator->liveOut, blockCount * wordsPerSet);
+	fillBitsets(&allocator->defined, blockCount * wordsPerSet);
+	fillBitsets(&allocator->used, blockCount * wordsPerSet);
+
+	for (size_t i = 0; i < blockCount; i++)
+	{
+		const IrBlock* block = &function->blocks.data[i];
+		if (block->isReachable == false)
+			continue;
+
+		uint64_t* defined = getSet(&allocator->defined, allocator, (IrBlockIndex)i);
+		uint64_t* used = getSet(&allocator->used, allocator, (IrBlockIndex)i);
+		for (uint32_t j = 0; j < block->instructionCount; j++)
+		{
+			const IrInstruction* instruction = &function->instructions.data[block->firstInstruction + j];
+			for (int k = 0; k < 2; k++)
+			{
+				IrValue operand = instruction->operands[k];
+				if ((operand != IR_VALUE_NULL) && (isInSet(defined, operand) == false))
+					addToSet(used, operand);
+			}
+			if (instruction->result != IR_VALUE_NULL)
+				addToSet(defined, instruction->result);
+		}
+	}
+
+	// liveOut is the union of liveIn of the successors and liveIn is used + (liveOut - defined). Going backwards
+	// through the layout propagates the sets of most blocks in one pass, only loops need more of them.
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t i = function->layout.size; i-- > 0;)
+		{
+			IrBlockIndex blockIndex = function->layout.data[i];
+			const IrBlock* block = &function->blocks.data[blockIndex];
+			if (block->isReachable == false)
+				continue;
+
+			uint64_t* liveOut = getSet(&allocator->liveOut, allocator, blockIndex);
+			uint64_t* liveIn = getSet(&allocator->liveIn, allocator, blockIndex);
+			const uint64_t* defined = getSet(&allocator->defined, allocator, blockIndex);
+			const uint64_t* used = getSet(&allocator->used, allocator, blockIndex);
+			for (size_t word = 0; word < wordsPerSet; word++)
+			{
+				uint64_t out = 0;
+				for (uint32_t j = 0; j < block->successorCount; j++)
+					out |= getSet(&allocator->liveIn, allocator, block->successors[j])[word];
+
+				uint64_t in = used[word] | (out & ~defined[word]);
+				if ((out != liveOut[word]) || (in != liveIn[word]))
+					changed = true;
+				liveOut[word] = out;
+				liveIn[word] = in;
+			}
+		}
+	}
+}
+
+static void extendInterval(LiveInterval* interval, uint32_t position)
+{
+	if (position < interval->start)
+		interval->start = position;
+	if (position > interval->end)
+		interval->end = position;
+}
+
+static void buildIntervals(RegisterAllocator* allocator, const IrFunction* function, uint32_t positionCount)
+{
+	size_t valueCount = function->valueTypes.size;
+	LiveIntervalArrayClear(&allocator->intervals);
+	LiveIntervalArrayReserve(&allocator->intervals, valueCount);
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		LiveInterval interval = { .value = (IrValue)i, .start = UINT32_MAX, .end = 0, .spillWeight = 0.0f, .isLiveAcrossSyscall = false };
+		LiveIntervalArrayAppend(&allocator->intervals, interval);
+	}
+	LiveInterval* intervals = allocator->intervals.data;
+
+	fillIntArray(&allocator->syscallsBefore, positionCount + 1, 0);
+	for (size_t i = 0; i < function->blocks.size; i++)
+	{
+		const IrBlock* block = &function->blocks.data[i];
+		int blockStart = allocator->blockStarts.data[i];
+		if (blockStart == -1)
+			continue;
+
+		// The interval only has to cover the block if the value is live at its start or its end, otherwise the
+		// definitions and uses inside it are enough.
+		uint32_t start = (uint32_t)blockStart;
+		uint32_t end = start + block->instructionCount - 1;
+		const uint64_t* liveIn = getSet(&allocator->liveIn, allocator, (IrBlockIndex)i);
+		const uint64_t* liveOut = getSet(&allocator->liveOut, allocator, (IrBlockIndex)i);
+		for (IrValue value = 0; value < valueCount; value++)
+		{
+			if (isInSet(liveIn, value))
+				extendInterval(&intervals[value], start);
+			if (isInSet(liveOut, value))
+				extendInterval(&intervals[value], end);
+		}
+
+		for (uint32_t j = 0; j < block->instructionCount; j++)
+		{
+			const IrInstruction* instruction = &function->instructions.data[block->firstInstruction + j];
+			uint32_t position = start + j;
+			float weight = 1.0f;
+			for (int k = 0; (k < allocator->loopDepths.data[position]) && (k < MAX_WEIGHTED_LOOP_DEPTH); k++)
+				weight *= LOOP_WEIGHT;
+
+			for (int k = 0; k < 2; k++)
+			{
+				IrValue operand = instruction->operands[k];
+				if (operand == IR_VALUE_NULL)
+					continue;
+				extendInterval(&intervals[operand], position);
+				intervals[operand].spillWeight += weight;
+			}
+			if (instruction->result != IR_VALUE_NULL)
+			{
+				extendInterval(&intervals[instruction->result], position);
+				intervals[instruction->result].spillWeight += weight;
+			}
+
+			if (instruction->opcode == IR_OP_PUTCHAR)
+				allocator->syscallsBefore.data[position + 1]++;
+		}
+	}
+
+	for (uint32_t i = 0; i < positionCount; i++)
+		allocator->syscallsBefore.data[i + 1] += allocator->syscallsBefore.data[i];
+
+	// Until now spillWeight was the weighted number of uses. Dividing it by the length makes long intervals that are
+	// rarely used get spilled before short ones, which frees the register for longer.
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		LiveInterval* interval = &intervals[i];
+		if (interval->start == UINT32_MAX)
+			continue;
+
+		interval->spillWeight /= (float)(interval->end - interval->start + 1);
+		// The operand of a putchar is written to memory before the syscall, so only the ones strictly inside count.
+		interval->isLiveAcrossSyscall =
+			allocator->syscallsBefore.data[interval->end] - allocator->syscallsBefore.data[interval->start + 1] > 0;
+	}
+}
+
+static int compareIntervalStarts(const void* a, const void* b)
+{
+	const LiveInterval* lhs = a;
+	const LiveInterval* rhs = b;
+	if (lhs->start != rhs->start)
+		return (lhs->start < rhs->start) ? -1 : 1;
+	// Sorted by value too, so the order doesn't depend on the qsort implementation.
+	return (lhs->value < rhs->value) ? -1 : ((lhs->value > rhs->value) ? 1 : 0);
+}
+
+static bool isRegisterUsable(const RegisterAllocator* allocator, const LiveInterval* interval, IrValue value)
+{
+	const Allocation* allocation = &allocator->allocations.data[value];
+	if ((allocation->type != ALLOCATION_REGISTER_GP) || (interval->isLiveAcrossSyscall == false))
+		return true;
+
+	for (int i = 0; i < SYSCALL_CLOBBERED_GP_REGISTER_COUNT; i++)
+	{
+		if (allocatableGpRegisters[i] == allocation->as.gpRegister)
+			return false;
+	}
+	return true;
+}
+
+static void expireIntervals(RegisterAllocator* allocator, uint32_t position, bool* gpInUse, bool* simdInUse)
+{
+	LiveIntervalArray* active = &allocator->active;
+	size_t kept = 0;
+	for (size_t i = 0; i < active->size; i++)
+	{
+		if (active->data[i].end >= position)
+		{
+			active->data[kept++] = active->data[i];
+			continue;
+		}
+
+		const Allocation* allocation = &allocator->allocations.data[active->data[i].value];
+		if (allocation->type == ALLOCATION_REGISTER_GP)
+			gpInUse[allocation->as.gpRegister] = false;
+		else
+			simdInUse[allocation->as.simdRegister] = false;
+	}
+	active->size = kept;
+}
+
+static void linearScan(RegisterAllocator* allocator, const IrFunction* function)
+{
+	bool gpInUse[REGISTER_GP_COUNT] = { false };
+	bool simdInUse[REGISTER_SIMD_COUNT] = { false };
+	LiveIntervalArrayClear(&allocator->active);
+
+	for (size_t i = 0; i < allocator->sorted.size; i++)
+	{
+		const LiveInterval* current = &allocator->sorted.data[i];
+		Allocation* allocation = &allocator->allocations.data[current->value];
+		bool isFloat = DataTypeIsFloat(IrGetValueType(function, current->value));
+		expireIntervals(allocator, current->start, gpInUse, simdInUse);
+
+		allocation->type = ALLOCATION_SPILLED;
+		if (isFloat)
+		{
+			for (size_t j = 0; j < ALLOCATABLE_SIMD_REGISTER_COUNT; j++)
+			{
+				if (simdInUse[allocatableSimdRegisters[j]] == false)
+				{
+					allocation->type = ALLOCATION_REGISTER_SIMD;
+					allocation->as.simdRegister = allocatableSimdRegisters[j];
+					simdInUse[allocatableSimdRegisters[j]] = true;
+					break;
+				}
+			}
+		}
+		else
+		{
+			size_t first = current->isLiveAcrossSyscall ? SYSCALL_CLOBBERED_GP_REGISTER_COUNT : 0;
+			for (size_t j = first; j < ALLOCATABLE_GP_REGISTER_COUNT; j++)
+			{
+				if (gpInUse[allocatableGpRegisters[j]] == false)
+				{
+					allocation->type = ALLOCATION_REGISTER_GP;
+					allocation->as.gpRegister = allocatableGpRegisters[j];
+					gpInUse[allocatableGpRegisters[j]] = true;
+					break;
+				}
+			}
+		}
+
+		if (allocation->type != ALLOCATION_SPILLED)
+		{
+			LiveIntervalArrayAppend(&allocator->active, *current);
+			continue;
+		}
+
+		// There is no free register, so the interval with the smallest weight is spilled. If it is an active one
+		// the current interval takes its register.
+		size_t spilled = SIZE_MAX;
+		float smallestWeight = current->spillWeight;
+		for (size_t j = 0; j < allocator->active.size; j++)
+		{
+			const LiveInterval* candidate = &allocator->active.data[j];
+			if ((DataTypeIsFloat(IrGetValueType(function, candidate->value)) == isFloat)
+			 && (candidate->spillWeight < smallestWeight)
+			 && isRegisterUsable(allocator, current, candidate->value))
+			{
+				spilled = j;
+				smallestWeight = candidate->spillWeight;
+			}
+		}
+
+		if (spilled == SIZE_MAX)
+			continue;
+
+		Allocation* spilledAllocation = &allocator->allocations.data[allocator->active.data[spilled].value];
+		*allocation = *spilledAllocation;
+		spilledAllocation->type = ALLOCATION_SPILLED;
+		allocator->active.data[spilled] = *current;
+	}
+}
+
+void RegisterAllocatorAllocate(RegisterAllocator* allocator, const IrFunction* function)
+{
+	size_t valueCount = function->valueTypes.size;
+	AllocationArrayClear(&allocator->allocations);
+	AllocationArrayReserve(&allocator->allocations, valueCount);
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		Allocation allocation = { .type = ALLOCATION_NONE };
+		AllocationArrayAppend(&allocator->allocations, allocation);
+	}
+
+	uint32_t positionCount = numberInstructions(allocator, function);
+	computeLoopDepths(allocator, function, positionCount);
+	computeLiveness(allocator, function);
+	buildIntervals(allocator, function, positionCount);
+
+	// Constants don't need a location and values that aren't used in reachable code don't have an interval.
+	LiveIntervalArrayClear(&allocator->sorted);
+	for (size_t i = 0; i < function->instructions.size; i++)
+	{
+		const IrInstruction* instruction = &function->instructions.data[i];
+		if (instruction->opcode == IR_OP_CONSTANT)
+			allocator->intervals.data[instruction->result].start = UINT32_MAX;
+	}
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		if (allocator->intervals.data[i].start != UINT32_MAX)
+			LiveIntervalArrayAppend(&allocator->sorted, allocator->intervals.data[i]);
+	}
+	qsort(allocator->sorted.data, allocator->sorted.size, sizeof(LiveInterval), compareIntervalStarts);
+
+	linearScan(allocator, function);
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(AllocationArray, Allocation)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(LiveIntervalArray, LiveInterval)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(BitsetWordArray, uint64_t)
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Ir.h"
+#include "Registers.h"
+#include "IntArray.h"
+
+#include <stdint.h>
+
+// Assigns registers to the values of an IrFunction with linear scan. The instructions of the reachable blocks are
+// numbered in the order they are placed in and every value gets one live interval from the first to the last
+// instruction it is live at, which is found with liveness analysis so values used in loops stay live in the whole
+// loop. The intervals are visited in the order they start and get a register that is free for the whole interval.
+// If there is none, the interval with the smallest spill weight is spilled to the stack.
+
+typedef enum
+{
+	// Constants aren't allocated because the code generator uses them as immediates.
+	ALLOCATION_NONE,
+	ALLOCATION_REGISTER_GP,
+	ALLOCATION_REGISTER_SIMD,
+	ALLOCATION_SPILLED,
+} AllocationType;
+
+typedef struct
+{
+	AllocationType type;
+
+	union
+	{
+		// Used if ALLOCATION_REGISTER_GP
+		RegisterGp gpRegister;
+		// Used if ALLOCATION_REGISTER_SIMD
+		RegisterSimd simdRegister;
+	} as;
+} Allocation;
+
+typedef struct
+{
+	IrValue value;
+	// Positions of the first and the last instruction the value is live at, both inclusive. An interval that ends
+	// at an instruction doesn't share a register with one that starts there, so an instruction can write its
+	// result before it is done reading the operands.
+	uint32_t start;
+	uint32_t end;
+	// How much spilling the value costs per instruction it is live for. Uses inside loops count more.
+	float spillWeight;
+	// If the value is live across a putchar, which clobbers some registers.
+	bool isLiveAcrossSyscall;
+} LiveInterval;
+
+ARRAY_TEMPLATE_DECLARATION(AllocationArray, Allocation)
+ARRAY_TEMPLATE_DECLARATION(LiveIntervalArray, LiveInterval)
+ARRAY_TEMPLATE_DECLARATION(BitsetWordArray, uint64_t)
+
+typedef struct
+{
+	// Indexed by IrValue.
+	AllocationArray allocations;
+
+	// Everything below is only used while allocating.
+
+	// Indexed by IrValue.
+	LiveIntervalArray intervals;
+	// The intervals sorted by start and the ones that currently have a register.
+	LiveIntervalArray sorted;
+	LiveIntervalArray active;
+
+	// The sets of values live at the start and the end of each block, each one is wordsPerSet words.
+	BitsetWordArray liveIn;
+	BitsetWordArray liveOut;
+	// The values the block defines and the ones it uses before defining them.
+	BitsetWordArray defined;
+	BitsetWordArray used;
+	size_t wordsPerSet;
+
+	// The position of the first instruction of each block or -1 if the block isn't reachable.
+	IntArray blockStarts;
+	// Indexed by position.
+	IntArray loopDepths;
+	// The number of putchars before each position and one past the last position.
+	IntArray syscallsBefore;
+} RegisterAllocator;
+
+void RegisterAllocatorInit(RegisterAllocator* allocator);
+void RegisterAllocatorFree(RegisterAllocator* allocator);
+// IrComputeCfg has to be called before. The registers the code generator uses as scratch registers are never
+// allocated.
+void RegisterAllocatorAllocate(RegisterAllocator* allocator, const IrFunction* function);
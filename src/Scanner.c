@@ -1,6 +1,8 @@
 #include "Scanner.h"
 #include "Assert.h"
 #include "TerminalColors.h"
+#include "Simd.h"
+#include "Number.h"
 
 #include <stdio.h>
 #include <stdbool.h>
@@ -10,19 +12,70 @@ void FileInfoInit(FileInfo* fileInfo)
 	IntArrayInit(&fileInfo->lineStartOffsets);
 }
 
+// The line start offsets are only needed for error messages so they are computed on the first use.
+static void computeLineStartOffsets(FileInfo* fileInfo)
+{
+	IntArray* lineStartOffsets = &fileInfo->lineStartOffsets;
+	const char* dataStart = fileInfo->source.chars;
+	const char* dataEnd = fileInfo->source.chars + fileInfo->source.length;
+	const char* chr = dataStart;
+
+	IntArrayAppend(lineStartOffsets, 0);
+
+#ifdef SIMD_WIDTH
+	for (; (dataEnd - chr) >= SIMD_WIDTH; chr += SIMD_WIDTH)
+	{
+		uint32_t newlineMask = SimdMatchMask(chr, '\n');
+		while (newlineMask != 0)
+		{
+			IntArrayAppend(lineStartOffsets, (int)(chr - dataStart) + SimdCountTrailingZeros(newlineMask) + 1);
+			newlineMask &= newlineMask - 1;
+		}
+	}
+#endif
+
+	for (; chr < dataEnd; chr++)
+	{
+		if (*chr == '\n')
+			IntArrayAppend(lineStartOffsets, (int)(chr - dataStart) + 1);
+	}
+}
+
+size_t FileInfoGetLineNumber(FileInfo* fileInfo, size_t offset)
+{
+	if (fileInfo->lineStartOffsets.size == 0)
+		computeLineStartOffsets(fileInfo);
+
+	// Find the last line that starts at or before the offset.
+	const IntArray* lineStartOffsets = &fileInfo->lineStartOffsets;
+	size_t low = 0;
+	size_t high = lineStartOffsets->size;
+	while ((high - low) > 1)
+	{
+		size_t middle = low + (high - low) / 2;
+		if ((size_t)lineStartOffsets->data[middle] <= offset)
+			low = middle;
+		else
+			high = middle;
+	}
+	return low;
+}
+
 // Don't know if it should remove the newline character
-StringView FileInfoGetLine(const FileInfo* fileInfo, size_t lineNumber)
+StringView FileInfoGetLine(FileInfo* fileInfo, size_t lineNumber)
 {
+	if (fileInfo->lineStartOffsets.size == 0)
+		computeLineStartOffsets(fileInfo);
+
 	ASSERT((lineNumber) < fileInfo->lineStartOffsets.size);
 
 	StringView line;
 	const IntArray* lineStartOffsets = &fileInfo->lineStartOffsets;
-	const char* sourceEnd = fileInfo->source.chars + fileInfo->source.length;
 	line.chars = fileInfo->source.chars + lineStartOffsets->data[lineNumber];
 
-	line.length = (lineNumber == lineStartOffsets->size)
-		? sourceEnd - (fileInfo->source.chars - lineStartOffsets->data[lineNumber])
-		: lineStartOffsets->data[lineNumber + 1] - lineStartOffsets->data[lineNumber];
+	line.length = ((lineNumber + 1) == lineStartOffsets->size)
+		? fileInfo->source.length - lineStartOffsets->data[lineNumber]
+		: (size_t)(lineStartOffsets->data[lineNumber + 1] - lineStartOffsets->data[lineNumber]);
 	
 	return line;
 }
@@ -34,12 +87,8 @@ void FileInfoFree(FileInfo* fileInfo)
 
 void ScannerReset(Scanner* scanner, FileInfo* fileInfo)
 {
-	scanner->line = 0;
-	scanner->charInLine = 0;
-
 	scanner->fileInfo = fileInfo;
 	IntArrayClear(&scanner->fileInfo->lineStartOffsets);
-	IntArrayAppend(&scanner->fileInfo->lineStartOffsets, 0);
 
 	scanner->dataStart = fileInfo->source.chars;
 	scanner->dataEnd = fileInfo->source.chars + fileInfo->source.length;
@@ -47,35 +96,55 @@ void ScannerReset(Scanner* scanner, FileInfo* fileInfo)
 	scanner->tokenStart = fileInfo->source.chars;
 }
 
-void ScannerInit(Scanner* scanner)
+void ScannerResetRange(Scanner* scanner, FileInfo* fileInfo, size_t start, size_t end)
 {
+	ASSERT((start <= end) && (end <= fileInfo->source.length));
+	scanner->fileInfo = fileInfo;
+
+	// Offsets are still computed from the start of the source.
+	scanner->dataStart = fileInfo->source.chars;
+	scanner->dataEnd = fileInfo->source.chars + end;
+	scanner->currentChar = fileInfo->source.chars + start;
+	scanner->tokenStart = fileInfo->source.chars + start;
+}
 
+void ScannerInit(Scanner* scanner)
+{
+	SymbolTableInit(&scanner->symbols);
+	scanner->isSpeculative = false;
 }
 
 void ScannerFree(Scanner* scanner)
 {
-
+	SymbolTableFree(&scanner->symbols);
 }
 
 static void error(Scanner* scanner, const char* message)
 {
+	if (scanner->isSpeculative)
+		return;
+
 	const char* chr = scanner->currentChar;
 	while ((chr < scanner->dataEnd) && (*chr != '\n'))
 		chr++;
 	int endOfLineDistance = chr - scanner->currentChar;
 
+	size_t line = FileInfoGetLineNumber(scanner->fileInfo, scanner->currentChar - scanner->dataStart);
+	const char* lineStart = &scanner->dataStart[scanner->fileInfo->lineStartOffsets.data[line]];
+	int charInLine = scanner->currentChar - lineStart;
+
 	// Make this code better
 	// Prints the location of the error and the message then the line the error was in
 	// and an arrow below the character the error occurred at
 	fprintf(
 		stderr,
-		"%s:%d:%d: " TERM_COL_RED "error: " TERM_COL_RESET "%s"
+		"%s:%zu:%d: " TERM_COL_RED "error: " TERM_COL_RESET "%s"
 		"\n%.*s\n"
 		"%*s" TERM_COL_GREEN "^" TERM_COL_RESET "\n",
-		scanner->fileInfo->filename, scanner->line, scanner->charInLine, message,
-		scanner->charInLine + endOfLineDistance,
-		&scanner->dataStart[scanner->fileInfo->lineStartOffsets.data[scanner->line]],
-		scanner->charInLine - 1, " "
+		scanner->fileInfo->filename, line, charInLine, message,
+		charInLine + endOfLineDistance,
+		lineStart,
+		charInLine - 1, " "
 	);
 }
 
@@ -85,31 +154,28 @@ static Token makeToken(Scanner* scanner, TokenType type)
 	token.text.chars = scanner->tokenStart;
 	token.text.length = scanner->currentChar - scanner->tokenStart;
 	token.type = type;
-	token.line = scanner->line;
+	token.symbol = SYMBOL_ID_NULL;
+	token.value.intValue = 0;
 	scanner->tokenStart = scanner->currentChar;
 	return token;
 }
 
-static Token errorToken()
+// The text points to where the error happened so it can be used for getting the location.
+static Token errorToken(Scanner* scanner)
 {
 	Token token;
-	token.text.chars = "";
+	token.text.chars = scanner->tokenStart;
 	token.text.length = 0;
 	token.type = TOKEN_ERROR;
+	token.symbol = SYMBOL_ID_NULL;
+	token.value.intValue = 0;
+	scanner->tokenStart = scanner->currentChar;
 	return token;
 }
 
 static void advance(Scanner* scanner)
 {
 	scanner->currentChar++;
-	scanner->charInLine++;
-}
-
-static void advanceLine(Scanner* scanner)
-{
-	scanner->charInLine = 0;
-	scanner->line++;
-	IntArrayAppend(&scanner->fileInfo->lineStartOffsets, scanner->currentChar - scanner->dataStart);
 }
 
 static bool isAtEnd(Scanner* scanner)
@@ -144,10 +210,46 @@ static char peekNext(Scanner* scanner)
 	return scanner->currentChar[1];
 }
 
+// Skips ' ', '\t', '\r' and '\n' SIMD_WIDTH bytes at a time. The remaining bytes are handled by skipWhitespace.
+static void skipBlanks(Scanner* scanner)
+{
+#ifdef SIMD_WIDTH
+	while ((scanner->dataEnd - scanner->currentChar) >= SIMD_WIDTH)
+	{
+		uint32_t blankMask = SimdBlankMask(scanner->currentChar);
+		if (blankMask != SIMD_FULL_MASK)
+		{
+			scanner->currentChar += SimdCountTrailingZeros(~blankMask);
+			return;
+		}
+		scanner->currentChar += SIMD_WIDTH;
+	}
+#endif
+}
+
+// Skips the body of a single line comment up to the newline SIMD_WIDTH bytes at a time.
+static void skipToNewline(Scanner* scanner)
+{
+#ifdef SIMD_WIDTH
+	while ((scanner->dataEnd - scanner->currentChar) >= SIMD_WIDTH)
+	{
+		uint32_t newlineMask = SimdMatchMask(scanner->currentChar, '\n');
+		if (newlineMask != 0)
+		{
+			scanner->currentChar += SimdCountTrailingZeros(newlineMask);
+			return;
+		}
+		scanner->currentChar += SIMD_WIDTH;
+	}
+#endif
+}
+
 static void skipWhitespace(Scanner* scanner)
 {
 	for (;;)
 	{
+		skipBlanks(scanner);
+
 		char chr = peek(scanner);
 
 		switch (chr)
@@ -160,7 +262,6 @@ static void skipWhitespace(Scanner* scanner)
 
 			case '\n':
 				advance(scanner);
-				advanceLine(scanner);
 				break;
 
 			case '/':
@@ -168,11 +269,11 @@ static void skipWhitespace(Scanner* scanner)
 				{
 					advance(scanner);
 					advance(scanner);
+					skipToNewline(scanner);
 					while (isAtEnd(scanner) == false)
 					{
 						if (peek(scanner) == '\n')
 						{
-							advanceLine(scanner);
 							break;
 						}
 						advance(scanner);
@@ -182,11 +283,7 @@ static void skipWhitespace(Scanner* scanner)
 				{
 					while (isAtEnd(scanner) == false)
 					{
-						if (match(scanner, '\n'))
-						{
-							advanceLine(scanner);
-						}
-						else if (match(scanner, '*'))
+						if (match(scanner, '*'))
 						{
 							if ((isAtEnd(scanner) == false) && (match(scanner, '/')))
 							{
@@ -224,7 +321,7 @@ static bool isDigit(char chr)
 
 static bool isHexDigit(char chr)
 {
-	return isDigit(chr) || ((chr >= 'a') && (chr <= 'z')) || ((chr >= 'A') && (chr <= 'Z'));
+	return isDigit(chr) || ((chr >= 'a') && (chr <= 'f')) || ((chr >= 'A') && (chr <= 'F'));
 }
 
 static bool isOctalDigit(char chr)
@@ -237,22 +334,52 @@ static bool isAlnum(char chr)
 	return isAlpha(chr) || isDigit(chr);
 }
 
-// Validating the number in scanner and then parsing it in the parser is kind of stupid
-// but storing the number in token would be cumbersome.
+static Token integerLiteral(Scanner* scanner, TokenType type, const char* digits, const char* digitsEnd, int base)
+{
+	uint64_t value;
+	if (NumberParseInteger(digits, digitsEnd - digits, base, &value) == false)
+	{
+		error(scanner, "integer constant is too large");
+		return errorToken(scanner);
+	}
+
+	Token token = makeToken(scanner, type);
+	token.value.intValue = value;
+	return token;
+}
+
+static Token floatLiteral(Scanner* scanner, TokenType type, const char* textEnd)
+{
+	const char* text = scanner->tokenStart;
+	double value = (type == TOKEN_FLOAT_LITERAL)
+		? NumberParseFloat(text, textEnd - text)
+		: NumberParseDouble(text, textEnd - text);
+
+	Token token = makeToken(scanner, type);
+	token.value.floatValue = value;
+	return token;
+}
+
+// The value is decoded here once so the compiler doesn't need to parse the text again.
 static Token number(Scanner* scanner)
 {
 	bool isHex = false;
+	int base = 10;
+	const char* digits = scanner->tokenStart;
 
 	if (match(scanner, '0'))
 	{
 		if ((isAtEnd(scanner) == false) && (match(scanner, 'x') || match(scanner, 'X')))
 		{
 			isHex = true;
+			base = 16;
+			digits = scanner->currentChar;
 			while ((isAtEnd(scanner) == false) && (isHexDigit(peek(scanner))))
 				advance(scanner);
 		}
 		else
 		{
+			base = 8;
 			while ((isAtEnd(scanner) == false) && (isOctalDigit(peek(scanner))))
 				advance(scanner);
 		}
@@ -263,6 +390,7 @@ static Token number(Scanner* scanner)
 			advance(scanner);
 	}
 
+	const char* digitsEnd = scanner->currentChar;
 	bool isFloat = false;
 
 	// Priror to c99 hexiadecimal constant were not allowed put they require special syntax.
@@ -274,7 +402,7 @@ static Token number(Scanner* scanner)
 		if (isHex)
 		{
 			error(scanner, "hexadecimal floating point constants are not allowed");
-			return errorToken();
+			return errorToken(scanner);
 		}
 
 		isFloat = true;
@@ -295,16 +423,18 @@ static Token number(Scanner* scanner)
 
 	if (isFloat && (isAtEnd(scanner) == false))
 	{
+		const char* textEnd = scanner->currentChar;
+
 		if (match(scanner, 'f') || match(scanner, 'F'))
 		{
-			return makeToken(scanner, TOKEN_FLOAT_LITERAL);
+			return floatLiteral(scanner, TOKEN_FLOAT_LITERAL, textEnd);
 		}
 		else if (match(scanner, 'l') || match(scanner, 'L'))
 		{
-			return makeToken(scanner, TOKEN_LONG_DOUBLE_LITERAL);
+			return floatLiteral(scanner, TOKEN_LONG_DOUBLE_LITERAL, textEnd);
 		}
 
-		return makeToken(scanner, TOKEN_DOUBLE_LITERAL);
+		return floatLiteral(scanner, TOKEN_DOUBLE_LITERAL, textEnd);
 	}
 	else
 	{
@@ -316,17 +446,21 @@ static Token number(Scanner* scanner)
 			if (peek(scanner) == peekPrevious(scanner))
 			{
 				advance(scanner);
-				return isUnsigned
-					? makeToken(scanner, TOKEN_UNSIGNED_LONG_LONG_LITERAL)
-					: makeToken(scanner, TOKEN_LONG_LONG_LITERAL);
+				return integerLiteral(
+					scanner,
+					isUnsigned ? TOKEN_UNSIGNED_LONG_LONG_LITERAL : TOKEN_LONG_LONG_LITERAL,
+					digits, digitsEnd, base
+				);
 			}
 
-			return isUnsigned
-				? makeToken(scanner, TOKEN_UNSIGNED_LONG_LITERAL)
-				: makeToken(scanner, TOKEN_LONG_LITERAL);
+			return integerLiteral(
+				scanner,
+				isUnsigned ? TOKEN_UNSIGNED_LONG_LITERAL : TOKEN_LONG_LITERAL,
+				digits, digitsEnd, base
+			);
 		}
 
-		return makeToken(scanner, TOKEN_INT_LITERAL);
+		return integerLiteral(scanner, TOKEN_INT_LITERAL, digits, digitsEnd, base);
 	}
 }
 
@@ -341,12 +475,51 @@ static Token charLiteral(Scanner* scanner)
 	if (token.text.length == 2)
 	{
 		error(scanner, "empty character literal not allowed");
-		return errorToken();
+		return errorToken(scanner);
 	}
 
 	return token;
 }
 
+typedef struct
+{
+	const char* text;
+	ptrdiff_t length;
+	TokenType type;
+} Keyword;
+
+// Perfect hash of the keywords. The multipliers were found by trying small values until every keyword
+// landed in a different slot, so adding a keyword requires checking for collisions again.
+#define KEYWORD_TABLE_SIZE 64
+#define KEYWORD_HASH(first, last, length) \
+	(((((size_t)(unsigned char)(first)) * 14) + ((((size_t)(unsigned char)(last)) + (size_t)(length)) * 5)) & (KEYWORD_TABLE_SIZE - 1))
+
+#define KEYWORD(first, last, keywordString, tokenType) \
+	[KEYWORD_HASH(first, last, sizeof(keywordString) - 1)] = { keywordString, sizeof(keywordString) - 1, tokenType }
+
+// Empty slots have length 0 so they never match.
+static const Keyword keywords[KEYWORD_TABLE_SIZE] = {
+	KEYWORD('b', 'k', "break", TOKEN_BREAK),
+	KEYWORD('c', 'r', "char", TOKEN_CHAR),
+	KEYWORD('c', 'e', "continue", TOKEN_CONTINUE),
+	KEYWORD('d', 'o', "do", TOKEN_DO),
+	KEYWORD('d', 'e', "double", TOKEN_DOUBLE),
+	KEYWORD('e', 'e', "else", TOKEN_ELSE),
+	KEYWORD('f', 't', "float", TOKEN_FLOAT),
+	KEYWORD('f', 'r', "for", TOKEN_FOR),
+	KEYWORD('i', 'f', "if", TOKEN_IF),
+	KEYWORD('i', 't', "int", TOKEN_INT),
+	KEYWORD('l', 'g', "long", TOKEN_LONG),
+	KEYWORD('p', 'r', "putchar", TOKEN_PUTCHAR),
+	KEYWORD('r', 'n', "return", TOKEN_RETURN),
+	KEYWORD('s', 't', "short", TOKEN_SHORT),
+	KEYWORD('s', 'd', "signed", TOKEN_SIGNED),
+	KEYWORD('u', 'd', "unsigned", TOKEN_UNSIGNED),
+	KEYWORD('w', 'e', "while", TOKEN_WHILE),
+};
+
+#undef KEYWORD
+
 static Token identifierOrKeyword(Scanner* scanner)
 {
 	while ((isAtEnd(scanner) == false) && (isAlnum(peek(scanner))))
@@ -354,87 +527,16 @@ static Token identifierOrKeyword(Scanner* scanner)
 		advance(scanner);
 	}
 
-	TokenType type = TOKEN_IDENTIFIER;
-
-	#define KEYWORD_GROUP(chr) \
-		case chr: 
-
-	#define KEYWORD_GROUP_END() \
-		break;
-
-	#define KEYWORD(keywordString, tokenType) \
-		{ \
-			ptrdiff_t keywordLength = sizeof(keywordString) - 1; \
-			if (((scanner->currentChar - scanner->tokenStart) == keywordLength) \
-			  && (memcmp(scanner->tokenStart, keywordString, keywordLength) == 0)) \
-			{ \
-				type = tokenType; \
-				break; \
-			} \
-		}
-
-	switch (scanner->tokenStart[0])
+	ptrdiff_t length = scanner->currentChar - scanner->tokenStart;
+	const Keyword* keyword = &keywords[KEYWORD_HASH(scanner->tokenStart[0], scanner->tokenStart[length - 1], length)];
+	if ((keyword->length == length) && (memcmp(scanner->tokenStart, keyword->text, length) == 0))
 	{
-		KEYWORD_GROUP('d')
-			KEYWORD("double", TOKEN_DOUBLE)
-			KEYWORD("do", TOKEN_DO)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('p')
-			KEYWORD("putchar", TOKEN_PUTCHAR)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('e')
-			KEYWORD("else", TOKEN_ELSE)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('w')
-			KEYWORD("while", TOKEN_WHILE)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('f')
-			KEYWORD("float", TOKEN_FLOAT)
-			KEYWORD("for", TOKEN_FOR)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('i')
-			KEYWORD("if", TOKEN_IF)
-			KEYWORD("int", TOKEN_INT)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('l')
-			KEYWORD("long", TOKEN_LONG)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('c')
-			KEYWORD("char", TOKEN_CHAR)
-			KEYWORD("continue", TOKEN_CONTINUE)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('b')
-			KEYWORD("break", TOKEN_BREAK)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('s')
-			KEYWORD("signed", TOKEN_SIGNED)
-			KEYWORD("short", TOKEN_SHORT)
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('u')
-			KEYWORD("unsigned", TOKEN_UNSIGNED);
-		KEYWORD_GROUP_END()
-
-		KEYWORD_GROUP('r')
-			KEYWORD("return", TOKEN_RETURN)
-		KEYWORD_GROUP_END()
-
+		return makeToken(scanner, keyword->type);
 	}
 
-	#undef KEYWORD
-	#undef KEYWORD_GROUP
-	#undef KEYWORD_GROUP_END
-
-	return makeToken(scanner, type);
+	Token token = makeToken(scanner, TOKEN_IDENTIFIER);
+	token.symbol = SymbolTableIntern(&scanner->symbols, token.text);
+	return token;
 }
 
 static Token scanToken(Scanner* scanner)
@@ -537,7 +639,7 @@ static Token scanToken(Scanner* scanner)
 
 		default:
 			error(scanner, "invalid char");
-			return errorToken();
+			return errorToken(scanner);
 	}
 }
 
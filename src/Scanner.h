@@ -1,9 +1,11 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdbool.h>
 
 #include "IntArray.h"
 #include "StringView.h"
+#include "Symbol.h"
 
 // Line numbers are counted from 0
 
@@ -82,37 +84,53 @@ typedef struct
 {
 	TokenType type;
 	StringView text;
-	size_t line;
+	// SYMBOL_ID_NULL if the token isn't an identifier.
+	SymbolId symbol;
+	// The decoded value of number literals. Float literals are stored as the double of the rounded float.
+	union
+	{
+		uint64_t intValue;
+		double floatValue;
+	} value;
 } Token;
 
 typedef struct
 {
 	const char* filename;
 	StringView source;
+	// Computed when a line is first needed. Empty until then.
 	IntArray lineStartOffsets;
 } FileInfo;
 
 void FileInfoInit(FileInfo* fileInfo);
+// Returns the line containing the character at offset.
+size_t FileInfoGetLineNumber(FileInfo* fileInfo, size_t offset);
 // If line doesn't exist should it return a NULL string view
 // or should I just assert
-StringView FileInfoGetLine(const FileInfo* fileInfo, size_t lineNumber);
+StringView FileInfoGetLine(FileInfo* fileInfo, size_t lineNumber);
 void FileInfoFree(FileInfo* fileInfo);
 
 typedef struct
 {
-	size_t line;
-	int charInLine;
-
 	FileInfo* fileInfo;
 
+	SymbolTable symbols;
+
 	const char* dataStart;
 	const char* dataEnd;
 
 	const char* tokenStart;
 	const char* currentChar;
+
+	// Set for scanners that scan parts of the file on other threads. Errors aren't reported, they would be
+	// out of order and computing the line start offsets of the shared file info isn't thread safe.
+	bool isSpeculative;
 } Scanner;
 
 void ScannerReset(Scanner* scanner, FileInfo* fileInfo);
+// Scans only the source in [start, end). Unlike ScannerReset it doesn't modify the file info so it can be
+// shared by many scanners.
+void ScannerResetRange(Scanner* scanner, FileInfo* fileInfo, size_t start, size_t end);
 void ScannerInit(Scanner* scanner);
 void ScannerFree(Scanner* scanner);
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+
+// SSE2 is part of x86-64 so it is always available when compiling for it.
+// AVX2 is only used if the compiler is allowed to generate it (/arch:AVX2 or -mavx2).
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Number of bytes classified at once. Bit i of a mask corresponds to data[i].
+#if defined(SIMD_AVX2)
+#define SIMD_WIDTH 32
+#define SIMD_FULL_MASK 0xFFFFFFFFu
+#elif defined(SIMD_SSE2)
+#define SIMD_WIDTH 16
+#define SIMD_FULL_MASK 0xFFFFu
+#endif
+
+// Undefined for 0.
+static inline uint32_t SimdCountTrailingZeros(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return index;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+#if defined(SIMD_AVX2)
+
+static inline uint32_t SimdMatchMask(const char* data, char chr)
+{
+	__m256i chunk = _mm256_loadu_si256((const __m256i*)data);
+	return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(chr)));
+}
+
+// Returns the mask of ' ', '\t', '\r' and '\n' characters.
+static inline uint32_t SimdBlankMask(const char* data)
+{
+	__m256i chunk = _mm256_loadu_si256((const __m256i*)data);
+	__m256i blanks = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+		_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')))
+	);
+	return (uint32_t)_mm256_movemask_epi8(blanks);
+}
+
+// Returns the mask of bytes with the high bit set.
+static inline uint32_t SimdHighBitMask(const char* data)
+{
+	return (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)data));
+}
+
+#elif defined(SIMD_SSE2)
+
+static inline uint32_t SimdMatchMask(const char* data, char chr)
+{
+	__m128i chunk = _mm_loadu_si128((const __m128i*)data);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(chr)));
+}
+
+// Returns the mask of ' ', '\t', '\r' and '\n' characters.
+static inline uint32_t SimdBlankMask(const char* data)
+{
+	__m128i chunk = _mm_loadu_si128((const __m128i*)data);
+	__m128i blanks = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+		_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')))
+	);
+	return (uint32_t)_mm_movemask_epi8(blanks);
+}
+
+// Returns the mask of bytes with the high bit set.
+static inline uint32_t SimdHighBitMask(const char* data)
+{
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)data));
+}
+
+#endif
\ No newline at end of file
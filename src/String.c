@@ -5,6 +5,16 @@
 #include <string.h>
 #include <stdarg.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 String StringCopy(const char* string)
 {
 	String str;
@@ -21,6 +31,8 @@ String StringCopy(const char* string)
 	return str;
 }
 
+static String readWholeFile(FILE* file);
+
 String StringFromFile(const char* filename)
 {
 	String string;
@@ -30,12 +42,22 @@ String StringFromFile(const char* filename)
 		fprintf(stderr, "Cannot open file '%s'", filename);
 		exit(1);
 	}
-	fseek(file, 0, SEEK_END);
 
-	// This might return -1
-	string.length = (size_t)ftell(file);
-	string.capacity = string.length;
-	fseek(file, 0, SEEK_SET);
+	// ftell returns -1 for non seekable inputs like pipes and on some platforms for files larger than LONG_MAX.
+	long fileSize = -1;
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		fileSize = ftell(file);
+	}
+	if ((fileSize < 0) || (fseek(file, 0, SEEK_SET) != 0))
+	{
+		string = readWholeFile(file);
+		fclose(file);
+		return string;
+	}
+
+	string.length = (size_t)fileSize;
+	string.capacity = string.length + 1;
 
 	char* buffer = malloc(string.length + 1);
 	if (buffer == NULL)
@@ -56,6 +78,156 @@ String StringFromFile(const char* filename)
 	return string;
 }
 
+// Used when the size of the file can't be known before reading it.
+static String readWholeFile(FILE* file)
+{
+	String string;
+	string.length = 0;
+	string.capacity = 4096;
+	string.chars = malloc(string.capacity);
+	if (string.chars == NULL)
+	{
+		fputs("Failed to allocate memory", stderr);
+		exit(1);
+	}
+
+	for (;;)
+	{
+		// Leave space for the null terminator.
+		size_t read = fread(string.chars + string.length, sizeof(char), string.capacity - string.length - 1, file);
+		string.length += read;
+		if (read == 0)
+		{
+			if (ferror(file))
+			{
+				fputs("Failed to read file", stderr);
+				exit(1);
+			}
+			break;
+		}
+
+		if ((string.length + 1) == string.capacity)
+		{
+			string.capacity *= 2;
+			char* newChars = realloc(string.chars, string.capacity);
+			if (newChars == NULL)
+			{
+				fputs("Failed to allocate memory", stderr);
+				exit(1);
+			}
+			string.chars = newChars;
+		}
+	}
+
+	string.chars[string.length] = '\0';
+	return string;
+}
+
+// The scanner requires the source to be null terminated. The part of the last page of a mapping that is past the end of the file
+// is filled with zeros so the terminator is already there unless the size of the file is a multiple of the page size.
+// In that case or if the file can't be mapped this falls back to reading the file.
+#ifdef _WIN32
+
+String StringFromFileMapped(const char* filename)
+{
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		fprintf(stderr, "Cannot open file '%s'", filename);
+		exit(1);
+	}
+
+	LARGE_INTEGER fileSize;
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	if ((GetFileSizeEx(file, &fileSize) == FALSE)
+	 || (fileSize.QuadPart == 0)
+	 || (((size_t)fileSize.QuadPart % systemInfo.dwPageSize) == 0))
+	{
+		CloseHandle(file);
+		return StringFromFile(filename);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+	{
+		return StringFromFile(filename);
+	}
+
+	// The view stays valid after closing the handles.
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (data == NULL)
+	{
+		return StringFromFile(filename);
+	}
+
+	String string;
+	string.chars = data;
+	string.length = (size_t)fileSize.QuadPart;
+	string.capacity = 0;
+	return string;
+}
+
+#else
+
+String StringFromFileMapped(const char* filename)
+{
+	int file = open(filename, O_RDONLY);
+	if (file == -1)
+	{
+		fprintf(stderr, "Cannot open file '%s'", filename);
+		exit(1);
+	}
+
+	struct stat fileStat;
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	if ((fstat(file, &fileStat) == -1)
+	 || (S_ISREG(fileStat.st_mode) == 0)
+	 || (fileStat.st_size == 0)
+	 || (((size_t)fileStat.st_size % pageSize) == 0))
+	{
+		close(file);
+		return StringFromFile(filename);
+	}
+
+	void* data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		return StringFromFile(filename);
+	}
+#ifdef MADV_SEQUENTIAL
+	// The source is read from start to end once.
+	madvise(data, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+#endif
+
+	String string;
+	string.chars = data;
+	string.length = (size_t)fileStat.st_size;
+	string.capacity = 0;
+	return string;
+}
+
+#endif
+
+void StringFreeMapped(String* string)
+{
+	// Mapped strings don't own a heap buffer so their capacity is 0.
+	if (string->capacity != 0)
+	{
+		StringFree(string);
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(string->chars);
+#else
+	munmap(string->chars, string->length);
+#endif
+}
+
 String StringNonOwning(char* str)
 {
 	String string;
@@ -112,7 +284,9 @@ void StringAppendVaFormat(String* string, const char* format, va_list arguments)
 		exit(1);
 	}
 
-	vsprintf(buffer, format, args);
+	va_end(args);
+	// The copy was used up by vsnprintf.
+	vsprintf(buffer, format, arguments);
 
 	StringAppendLen(string, buffer, length);
 	free(buffer);
@@ -0,0 +1,60 @@
+#include "Symbol.h"
+#include "Assert.h"
+#include "Generic.h"
+
+static void copyStringView(StringView* dst, const StringView* src)
+{
+	*dst = *src;
+}
+
+static bool compareStringView(const StringView* a, const StringView* b)
+{
+	return (a->length == b->length) && (memcmp(a->chars, b->chars, a->length) == 0);
+}
+
+static void copySymbolId(SymbolId* dst, const SymbolId* src)
+{
+	*dst = *src;
+}
+
+TABLE_TEMPLATE_DEFINITION(SymbolIdTable, StringView, SymbolId, StringViewHash, copyStringView, compareStringView, NO_OP_FUNCTION, copySymbolId, NO_OP_FUNCTION)
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(StringViewArray, StringView)
+
+void SymbolTableInit(SymbolTable* table)
+{
+	SymbolIdTableInit(&table->ids);
+	StringViewArrayInit(&table->names);
+}
+
+void SymbolTableFree(SymbolTable* table)
+{
+	SymbolIdTableFree(&table->ids);
+	StringViewArrayFree(&table->names);
+}
+
+SymbolId SymbolTableIntern(SymbolTable* table, StringView name)
+{
+	SymbolId id;
+	if (SymbolIdTableGet(&table->ids, &name, &id))
+		return id;
+
+	id = (SymbolId)table->names.size;
+	SymbolIdTableSet(&table->ids, &name, id);
+	StringViewArrayAppend(&table->names, name);
+	return id;
+}
+
+SymbolId SymbolTableFind(SymbolTable* table, StringView name)
+{
+	SymbolId id;
+	if (SymbolIdTableGet(&table->ids, &name, &id))
+		return id;
+	return SYMBOL_ID_NULL;
+}
+
+StringView SymbolTableGetName(const SymbolTable* table, SymbolId id)
+{
+	ASSERT(id < table->names.size);
+	return table->names.data[id];
+}
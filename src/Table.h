@@ -1,249 +1,268 @@
 #pragma once
 
 #include "String.h"
+#include "Simd.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
-// #ifdef moveItemType move #else copyItemType
-// hashKeyType, compareKeyType, copyKeyType, copyItemType, freeKeyType freeItemType
 // mark things const also in array
 
-#define TABLE_INITIAL_CAPACITY 16
-#define TABLE_MAX_LOAD 0.75
+// Open addressing table with the layout of a SwissTable. Every slot has a control byte, which is either empty,
+// deleted or the top 7 bits of the hash of the key in the slot. A lookup compares a whole group of control bytes
+// at once and only compares the keys of the slots whose control byte matches. The first TABLE_GROUP_WIDTH control
+// bytes are repeated after the last one so a group starting at any slot can be loaded without wrapping.
+
+#ifdef SIMD_WIDTH
+#define TABLE_GROUP_WIDTH SIMD_WIDTH
+#else
+#define TABLE_GROUP_WIDTH 16
+#endif
+
+// Has to be a power of two and at least TABLE_GROUP_WIDTH.
+#define TABLE_INITIAL_CAPACITY 32
+// The table grows when more than 7/8 of the slots are full or deleted.
+#define TABLE_MAX_LOAD_NUMERATOR 7
+#define TABLE_MAX_LOAD_DENOMINATOR 8
+
+// Full slots have the high bit clear.
+#define TABLE_CONTROL_EMPTY 0x80
+#define TABLE_CONTROL_DELETED 0xFE
+
+// The hash functions of the keys can be weak, for example SymbolIds are their own hash. The low bits pick the
+// slot, so they are mixed with the high bits first.
+static inline uint64_t TableMixHash(uint64_t hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static inline uint8_t TableHashControl(uint64_t hash)
+{
+	return (uint8_t)(hash >> 57);
+}
+
+// Bit i of the returned masks corresponds to group[i].
+static inline uint32_t TableGroupMatch(const uint8_t* group, uint8_t control)
+{
+#ifdef SIMD_WIDTH
+	return SimdMatchMask((const char*)group, (char)control);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < TABLE_GROUP_WIDTH; i++)
+	{
+		if (group[i] == control)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+static inline uint32_t TableGroupMatchEmptyOrDeleted(const uint8_t* group)
+{
+#ifdef SIMD_WIDTH
+	return SimdHighBitMask((const char*)group);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < TABLE_GROUP_WIDTH; i++)
+	{
+		if (group[i] & 0x80)
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
 
 #define TABLE_TEMPLATE_DECLARATION(tableTypeName, keyType, valueType) \
-typedef struct tableTypeName##Entry \
+typedef struct \
 { \
 	keyType key; \
 	valueType value; \
-	struct tableTypeName##Entry* next; \
+	/* Stored so growing doesn't need to hash the keys again. */ \
+	uint64_t hash; \
 } tableTypeName##Entry; \
 \
 typedef struct \
 { \
-	tableTypeName##Entry* data; \
+	/* capacity + TABLE_GROUP_WIDTH bytes. */ \
+	uint8_t* controls; \
+	tableTypeName##Entry* entries; \
 	size_t size; \
+	size_t deletedCount; \
 	size_t capacity; \
-} tableTypeName##; \
+} tableTypeName; \
 \
 void tableTypeName##Init(tableTypeName* table); \
 void tableTypeName##Free(tableTypeName* table); \
+/* Replaces the value if the key is already in the table. */ \
 void tableTypeName##Set(tableTypeName* table, keyType* key, valueType value); \
 bool tableTypeName##Get(tableTypeName* table, keyType* key, valueType* result); \
 bool tableTypeName##Remove(tableTypeName* table, const keyType* key);
 
 // size_t hashKeyType(const keyType* key);
 // void copyKeyType(keyType* destination, const keyType* source);
+// bool compareKeyType(const keyType* a, const keyType* b);
 // void freeKeyType(keyType* key);
-#define TABLE_TEMPLATE_DEFINITION(tableTypeName, keyType, valueType, hashKeyType, copyKeyType, compareKeyType, freeKeyType, copyValueType, freeValueType, isKeyNull, setKeyNull) \
-void tableTypeName##Init(tableTypeName* table) \
+#define TABLE_TEMPLATE_DEFINITION(tableTypeName, keyType, valueType, hashKeyType, copyKeyType, compareKeyType, freeKeyType, copyValueType, freeValueType) \
+\
+static void allocate##tableTypeName(tableTypeName* table, size_t capacity) \
 { \
-    table->capacity = TABLE_INITIAL_CAPACITY; \
-    table->data = malloc(table->capacity * sizeof(tableTypeName##Entry)); \
-    if (table->data == NULL) \
+    table->controls = malloc(capacity + TABLE_GROUP_WIDTH); \
+    table->entries = malloc(capacity * sizeof(tableTypeName##Entry)); \
+    if ((table->controls == NULL) || (table->entries == NULL)) \
     { \
         fputs("Failed to allocate table", stderr); \
         exit(1); \
     } \
-    for (size_t i = 0; i < table->capacity; i++) \
-    { \
-        table->data[i].next = NULL; \
-        setKeyNull(&table->data[i].key); \
-    } \
+    memset(table->controls, TABLE_CONTROL_EMPTY, capacity + TABLE_GROUP_WIDTH); \
+    table->capacity = capacity; \
     table->size = 0; \
+    table->deletedCount = 0; \
 } \
 \
-static size_t grow##tableTypeName##Capacity(size_t capacity) \
+void tableTypeName##Init(tableTypeName* table) \
 { \
-    return capacity * 2; \
+    allocate##tableTypeName(table, TABLE_INITIAL_CAPACITY); \
 } \
 \
-static void copy##tableTypeName##Entry(tableTypeName##Entry* dst, tableTypeName##Entry* src) \
+static void set##tableTypeName##Control(tableTypeName* table, size_t index, uint8_t control) \
 { \
-    copyKeyType(&dst->key, &src->key); \
-    copyValueType(&dst->value, &src->value); \
+    table->controls[index] = control; \
+    if (index < TABLE_GROUP_WIDTH) \
+        table->controls[table->capacity + index] = control; \
 } \
 \
-static void free##tableTypeName##Entry(tableTypeName##Entry* entry) \
+/* Returns the index of the entry or SIZE_MAX. */ \
+static size_t find##tableTypeName(const tableTypeName* table, const keyType* key, uint64_t hash) \
 { \
-    if (entry->next == NULL) \
-    { \
-        freeKeyType(&entry->key);\
-        freeValueType(&entry->value); \
-    } \
-    else \
+    size_t mask = table->capacity - 1; \
+    uint8_t control = TableHashControl(hash); \
+    size_t position = hash & mask; \
+    size_t step = 0; \
+    for (;;) \
     { \
-        freeKeyType(&entry->key); \
-        freeValueType(&entry->value); \
-        tableTypeName##Entry* e = entry->next; \
-        while (e->next != NULL) \
+        const uint8_t* group = &table->controls[position]; \
+        uint32_t matches = TableGroupMatch(group, control); \
+        while (matches != 0) \
         { \
-            tableTypeName##Entry* next = e->next; \
-            freeKeyType(&e->key); \
-            freeValueType(&e->value); \
-            free(e); \
-            e = next; \
+            size_t index = (position + SimdCountTrailingZeros(matches)) & mask; \
+            const tableTypeName##Entry* entry = &table->entries[index]; \
+            if ((entry->hash == hash) && compareKeyType(&entry->key, key)) \
+                return index; \
+            matches &= matches - 1; \
         } \
+        /* The key would have been put in the empty slot. */ \
+        if (TableGroupMatch(group, TABLE_CONTROL_EMPTY) != 0) \
+            return SIZE_MAX; \
+        step += TABLE_GROUP_WIDTH; \
+        position = (position + step) & mask; \
     } \
 } \
 \
-static void grow##tableTypeName(tableTypeName* table) \
+static size_t findFreeSlot##tableTypeName(const tableTypeName* table, uint64_t hash) \
 { \
-    size_t newCapacity = grow##tableTypeName##Capacity(table->capacity); \
-    tableTypeName##Entry* newData = malloc(newCapacity * sizeof(tableTypeName##Entry)); \
-    if (newData == NULL) \
+    size_t mask = table->capacity - 1; \
+    size_t position = hash & mask; \
+    size_t step = 0; \
+    for (;;) \
     { \
-        fputs("Failed to reallocate table", stderr); \
-        exit(1);\
+        uint32_t freeSlots = TableGroupMatchEmptyOrDeleted(&table->controls[position]); \
+        if (freeSlots != 0) \
+            return (position + SimdCountTrailingZeros(freeSlots)) & mask; \
+        step += TABLE_GROUP_WIDTH; \
+        position = (position + step) & mask; \
     } \
-    for (size_t i = 0; i < newCapacity; i++) \
-    { \
-        newData[i].next = NULL; \
-        setKeyNull(&newData[i].key); \
-    } \
-\
-    for (size_t i = 0; i < table->capacity; i++) \
-    { \
-        if (isKeyNull(&table->data[i].key) == false) \
-        { \
-            tableTypeName##Entry* oldEntry = &table->data[i]; \
-            size_t hash = hashKeyType(&oldEntry->key) % newCapacity; \
-            while (oldEntry != NULL) \
-            { \
-                tableTypeName##Entry* newEntry = &newData[hash]; \
-                if (isKeyNull(&newEntry->key)) \
-                { \
-                    copy##tableTypeName##Entry(newEntry, oldEntry); \
-                    newEntry->next = NULL; \
-                } \
-                else \
-                { \
-                    while (newEntry->next != NULL) \
-                    { \
-                        newEntry = newEntry->next; \
-                    } \
-                    newEntry->next = malloc(sizeof(tableTypeName##Entry)); \
-                    if (newEntry->next == NULL) \
-                    { \
-                        fputs("Failed to allocate table entry", stderr); \
-                        exit(1); \
-                    } \
-                    copy##tableTypeName##Entry(newEntry->next, oldEntry); \
-                    newEntry->next->next = NULL; \
-                } \
+} \
 \
-                oldEntry = oldEntry->next; \
-            } \
-        } \
-    } \
-    for (size_t i = 0; i < table->capacity; i++) \
+/* The entries are moved so they aren't copied or freed. Also removes the deleted slots. */ \
+static void rehash##tableTypeName(tableTypeName* table, size_t newCapacity) \
+{ \
+    uint8_t* oldControls = table->controls; \
+    tableTypeName##Entry* oldEntries = table->entries; \
+    size_t oldCapacity = table->capacity; \
+    size_t size = table->size; \
+    allocate##tableTypeName(table, newCapacity); \
+    for (size_t i = 0; i < oldCapacity; i++) \
     { \
-        if (isKeyNull(&table->data[i].key) == false) \
-        { \
-            free##tableTypeName##Entry(&table->data[i]); \
-        } \
+        if (oldControls[i] & 0x80) \
+            continue; \
+        size_t index = findFreeSlot##tableTypeName(table, oldEntries[i].hash); \
+        set##tableTypeName##Control(table, index, oldControls[i]); \
+        memcpy(&table->entries[index], &oldEntries[i], sizeof(tableTypeName##Entry)); \
     } \
-    free(table->data); \
-    table->data = newData; \
-    table->capacity = newCapacity; \
+    table->size = size; \
+    free(oldControls); \
+    free(oldEntries); \
 } \
 \
 void tableTypeName##Set(tableTypeName* table, keyType* key, valueType value) \
 { \
-    if (((double)table->size / (double)table->capacity) > 0.75) \
+    uint64_t hash = TableMixHash(hashKeyType(key)); \
+    size_t index = find##tableTypeName(table, key, hash); \
+    if (index != SIZE_MAX) \
     { \
-        grow##tableTypeName(table); \
+        freeValueType(&table->entries[index].value); \
+        copyValueType(&table->entries[index].value, &value); \
+        return; \
     } \
-    size_t index = hashKeyType(key) % table->capacity; \
-    if (isKeyNull(&table->data[index].key)) \
+\
+    if (((table->size + table->deletedCount + 1) * TABLE_MAX_LOAD_DENOMINATOR) \
+        > (table->capacity * TABLE_MAX_LOAD_NUMERATOR)) \
     { \
-        copyKeyType(&table->data[index].key, key); \
-        copyValueType(&table->data[index].value, &value); \
-        table->data[index].next = NULL; \
-    } \
-    else \
-    { \
-        tableTypeName##Entry * entry = &table->data[index]; \
-        while (entry->next != NULL) \
-        { \
-            entry = entry->next; \
-        } \
-        entry->next = malloc(sizeof(tableTypeName##Entry)); \
-        if (entry->next == NULL) \
-        { \
-            fputs("Failed to allocate table entry", stderr); \
-            exit(1); \
-        } \
-        copyKeyType(&entry->next->key, key); \
-        copyValueType(&entry->next->value, &value); \
-        entry->next->next = NULL; \
+        /* If most of the used slots are deleted, removing them makes enough space. */ \
+        size_t newCapacity = (table->size >= table->deletedCount) ? table->capacity * 2 : table->capacity; \
+        rehash##tableTypeName(table, newCapacity); \
     } \
+\
+    index = findFreeSlot##tableTypeName(table, hash); \
+    if (table->controls[index] == TABLE_CONTROL_DELETED) \
+        table->deletedCount--; \
+    set##tableTypeName##Control(table, index, TableHashControl(hash)); \
+    tableTypeName##Entry* entry = &table->entries[index]; \
+    copyKeyType(&entry->key, key); \
+    copyValueType(&entry->value, &value); \
+    entry->hash = hash; \
     table->size++; \
 } \
 \
 bool tableTypeName##Get(tableTypeName* table, keyType* key, valueType* result) \
 { \
-    size_t index = hashKeyType(key) % table->capacity; \
-    tableTypeName##Entry* entry = &table->data[index]; \
-    if (isKeyNull(&entry->key)) \
-    { \
+    size_t index = find##tableTypeName(table, key, TableMixHash(hashKeyType(key))); \
+    if (index == SIZE_MAX) \
         return false; \
-    } \
-    while (entry != NULL) \
-    { \
-        if (compareKeyType(&entry->key, key)) \
-        { \
-            copyValueType(result, &entry->value); \
-            return true; \
-        } \
-        entry = entry->next; \
-    } \
-    return false; \
+    copyValueType(result, &table->entries[index].value); \
+    return true; \
 } \
 \
-bool tableTypeName##Remove(tableTypeName* table, const keyType* key) { \
-    size_t index = hashKeyType(key) % table->capacity; \
-    tableTypeName##Entry* entry = &table->data[index]; \
-    if (isKeyNull(&entry->key)) \
-    { \
+bool tableTypeName##Remove(tableTypeName* table, const keyType* key) \
+{ \
+    size_t index = find##tableTypeName(table, key, TableMixHash(hashKeyType(key))); \
+    if (index == SIZE_MAX) \
         return false; \
-    } \
-    if (compareKeyType(&entry->key, key)) \
-    { \
-        setKeyNull(&entry->key); \
-        table->size--; \
-        return true; \
-    } \
-    tableTypeName##Entry* previous = entry; \
-    entry = entry->next; \
-    while (entry != NULL) \
-    { \
-        if (compareKeyType(&entry->key, key)) \
-        { \
-            previous->next = entry->next; \
-            freeKeyType(&entry->key); \
-            freeValueType(&entry->value); \
-            free(entry); \
-            table->size--; \
-            return true; \
-        } \
-        previous = entry; \
-        entry = entry->next; \
-    } \
-    return false; \
+    freeKeyType(&table->entries[index].key); \
+    freeValueType(&table->entries[index].value); \
+    /* Other keys might have been probed past this slot so it can't become empty. */ \
+    set##tableTypeName##Control(table, index, TABLE_CONTROL_DELETED); \
+    table->deletedCount++; \
+    table->size--; \
+    return true; \
 } \
 \
 void tableTypeName##Free(tableTypeName* table) \
 { \
     for (size_t i = 0; i < table->capacity; i++) \
     { \
-        if (isKeyNull(&table->data[i].key) == false) \
+        if ((table->controls[i] & 0x80) == 0) \
         { \
-            free##tableTypeName##Entry(&table->data[i]); \
+            freeKeyType(&table->entries[i].key); \
+            freeValueType(&table->entries[i].value); \
         } \
     } \
-    free(table->data); \
-}
\ No newline at end of file
+    free(table->controls); \
+    free(table->entries); \
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+typedef void (*ThreadFunction)(void* argument);
+
+typedef struct
+{
+#ifdef _WIN32
+	// HANDLE. windows.h isn't included here because its TOKEN_ macros conflict with the token types.
+	void* handle;
+#else
+	pthread_t handle;
+#endif
+	ThreadFunction function;
+	void* argument;
+} Thread;
+
+// The thread has to stay at the same address until it is joined.
+void ThreadStart(Thread* thread, ThreadFunction function, void* argument);
+void ThreadJoin(Thread* thread);
+size_t ThreadHardwareConcurrency();
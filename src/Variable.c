@@ -4,32 +4,30 @@
 // Probably should move the size information from Registers.h
 #include "Registers.h"
 
-static void copyStringView(StringView* dst, const StringView* src)
+static void copySymbolId(SymbolId* dst, const SymbolId* src)
 {
 	*dst = *src;
 }
 
-static bool compareStringView(const StringView* a, const StringView* b)
+// The ids are dense so they don't need to be hashed.
+static size_t hashSymbolId(const SymbolId* id)
 {
-	return (a->length == b->length) && (memcmp(a->chars, b->chars, a->length) == 0);
+	return *id;
 }
 
-static void copyLocalVariable(LocalVariable* dst, const LocalVariable* src)
+static bool compareSymbolId(const SymbolId* a, const SymbolId* b)
 {
-	*dst = *src;
+	return *a == *b;
 }
 
-static bool isStringViewNull(StringView* view)
+static void copyLocalVariable(LocalVariable* dst, const LocalVariable* src)
 {
-	return view->chars == NULL;
+	*dst = *src;
 }
 
-static void setStringViewNull(StringView* view)
-{
-	view->chars = NULL;
-}
+static int getIntegerConversionRank(const DataType* dataType);
 
-TABLE_TEMPLATE_DEFINITION(LocalVariableTable, StringView, LocalVariable, StringViewHash, copyStringView, compareStringView, NO_OP_FUNCTION, copyLocalVariable, NO_OP_FUNCTION, isStringViewNull, setStringViewNull)
+TABLE_TEMPLATE_DEFINITION(LocalVariableTable, SymbolId, LocalVariable, hashSymbolId, copySymbolId, compareSymbolId, NO_OP_FUNCTION, copyLocalVariable, NO_OP_FUNCTION)
 
 size_t DataTypeSize(const DataType* type)
 {
@@ -67,4 +65,102 @@ bool DataTypeIsInt(const DataType* type)
 		|| (type->type == DATA_TYPE_INT)
 		|| (type->type == DATA_TYPE_LONG)
 		|| (type->type == DATA_TYPE_LONG_LONG);
-}
\ No newline at end of file
+}
+
+static int getIntegerConversionRank(const DataType* dataType)
+{
+	switch (dataType->type)
+	{
+		case DATA_TYPE_CHAR:	   return 1;
+		case DATA_TYPE_SHORT:	   return 2;
+		case DATA_TYPE_INT:		   return 3;
+		case DATA_TYPE_LONG:	   return 4;
+		case DATA_TYPE_LONG_LONG:  return 5;
+
+		default:
+			return -1;
+	}
+}
+
+DataType DataTypeGetBinaryResultType(const DataType* a, const DataType* b)
+{
+	DataType result;
+	result.isUnsigned = false;
+
+	if ((a->type == DATA_TYPE_LONG_DOUBLE) || (b->type == DATA_TYPE_LONG_DOUBLE))
+	{
+		result.type = DATA_TYPE_LONG_DOUBLE;
+		return result;
+	}
+
+	if ((a->type == DATA_TYPE_DOUBLE) || (b->type == DATA_TYPE_DOUBLE))
+	{
+		result.type = DATA_TYPE_DOUBLE;
+		return result;
+	}
+
+	if ((a->type == DATA_TYPE_FLOAT) || (b->type == DATA_TYPE_FLOAT))
+	{
+		result.type = DATA_TYPE_FLOAT;
+		return result;
+	}
+
+	int aConversionRank = getIntegerConversionRank(a);
+	int bConversionRank = getIntegerConversionRank(b);
+	if ((aConversionRank == -1) || (bConversionRank == -1))
+	{
+		result.type = DATA_TYPE_ERROR;
+		return result;
+	}
+
+	if (a->isUnsigned == b->isUnsigned)
+	{
+		result.type = (aConversionRank > bConversionRank) ? a->type : b->type;
+		result.isUnsigned = a->isUnsigned;
+		return result;
+	}
+	else
+	{
+		if ((a->isUnsigned) && (aConversionRank >= bConversionRank))
+		{
+			result.type = a->type;
+			result.isUnsigned = true;
+			return result;
+		}
+		else if ((b->isUnsigned) && (bConversionRank >= aConversionRank))
+		{
+			result.type = b->type;
+			result.isUnsigned = true;
+			return result;
+		}
+		// Simplify this later if the signed type has higher conversion rank
+		else if ((b->isUnsigned))
+		{
+			result.type = a->type;
+			result.isUnsigned = false;
+			return result;
+		}
+		else if ((a->isUnsigned))
+		{
+			result.type = b->type;
+			result.isUnsigned = false;
+			return result;
+		}
+	}
+
+	// Should have returned at integerConversionRank == -1
+	ASSERT_NOT_REACHED();
+
+	result.type = DATA_TYPE_ERROR;
+	return result;
+}
+
+// isUnsigned isn't set for the float literals so it is only compared for ints.
+bool DataTypeEquals(const DataType* a, const DataType* b)
+{
+	if (a->type != b->type)
+		return false;
+	return DataTypeIsFloat(a) || (a->isUnsigned == b->isUnsigned);
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(DataTypeArray, DataType)
@@ -3,6 +3,7 @@
 #include "String.h"
 #include "Table.h"
 #include "StringView.h"
+#include "Symbol.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -38,12 +39,20 @@ typedef struct
 size_t DataTypeSize(const DataType* type);
 bool DataTypeIsFloat(const DataType* type);
 bool DataTypeIsInt(const DataType* type);
+// isUnsigned isn't set for floats so it is only compared for ints.
+bool DataTypeEquals(const DataType* a, const DataType* b);
+// The type the operands of a binary operator are converted to. It is DATA_TYPE_ERROR if one of them isn't a number.
+DataType DataTypeGetBinaryResultType(const DataType* a, const DataType* b);
+
+ARRAY_TEMPLATE_DECLARATION(DataTypeArray, DataType)
 
 typedef struct
 {
 	DataType dataType;
-	// Real position is [rbp-baseOffset]
-	size_t baseOffset;
+	// The IR value that holds the variable.
+	uint32_t value;
+	// The number of scopes the variable is nested in.
+	size_t scopeDepth;
 } LocalVariable;
 
 typedef struct
@@ -52,4 +61,4 @@ typedef struct
 	int labelIndex;
 } GlobalVariable;
 
-TABLE_TEMPLATE_DECLARATION(LocalVariableTable, StringView, LocalVariable)
\ No newline at end of file
+TABLE_TEMPLATE_DECLARATION(LocalVariableTable, SymbolId, LocalVariable)
\ No newline at end of file
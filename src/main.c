@@ -1,5 +1,8 @@
 
 #include "Compiler.h"
+#include "ConstantFolder.h"
+#include "AstCache.h"
+#include "Cli.h"
 
 // Later add function for the parser, compiler and scanner to reset so they can compile multiple files.
 
@@ -39,34 +42,68 @@
 int main(int argCount, char* args[])
 {
 	const char* filename = "src/triangle.txt";
+	CliOptions options = CliParseOptions(argCount, args);
 
-	String source = StringFromFile(filename);
+	String source = StringFromFileMapped(filename);
+	StringView sourceView = StringViewFromString(&source);
 	FileInfo fileInfo;
 	FileInfoInit(&fileInfo);
 	Parser parser;
 	ParserInit(&parser);
+	ConstantFolder folder;
+	ConstantFolderInit(&folder);
 	Compiler compiler;
 	CompilerInit(&compiler);
 
-	StmtArray ast = ParserParse(&parser, filename, StringViewFromString(&source), &fileInfo);
-	if (parser.hadError)
-		return EXIT_FAILURE;
+	// If the source didn't change since the last build, scanning, parsing and folding are skipped.
+	bool isCaching = options.astCacheDirectory != NULL;
+	String cachePath;
+	CachedAst cached;
+	bool isCached = false;
+	if (isCaching)
+	{
+		cachePath = AstCacheGetPath(options.astCacheDirectory, sourceView);
+		isCached = AstCacheLoad(&cached, cachePath.chars, sourceView);
+	}
 
-	String output = CompilerCompile(&compiler, &fileInfo, &ast);
+	const Ast* ast;
+	if (isCached)
+	{
+		fileInfo.filename = filename;
+		fileInfo.source = sourceView;
+		ast = &cached.ast;
+	}
+	else
+	{
+		ParserParse(&parser, filename, sourceView, &fileInfo);
+		if (parser.hadError)
+			return EXIT_FAILURE;
+
+		ConstantFolderFold(&folder, &parser.ast);
+		ast = &parser.ast;
+		if (isCaching && (AstCacheWrite(ast, cachePath.chars) == false))
+			fprintf(stderr, "failed to write the ast cache '%s'\n", cachePath.chars);
+	}
+
+	String output = CompilerCompile(&compiler, &fileInfo, ast);
 	if (compiler.hadError)
 		return EXIT_FAILURE;
 
 	printf("%s", output.chars);
-
-	StringFree(&source);
+	StringFree(&output);
+#ifdef PRINT_PEEPHOLE_STATISTICS
+	PeepholeOptimizerPrintStatistics(&compiler.codeGenerator.peephole, stderr);
+#endif
+
+	if (isCached)
+		AstCacheFree(&cached);
+	if (isCaching)
+		StringFree(&cachePath);
+	StringFreeMapped(&source);
 	ParserFree(&parser);
 	FileInfoFree(&fileInfo);
+	ConstantFolderFree(&folder);
 	CompilerFree(&compiler);
-	for (size_t i = 0; i < ast.size; i++)
-	{
-		StmtFree(ast.data[i]);
-	}
-	StmtArrayFree(&ast);
 
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
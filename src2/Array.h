@@ -4,8 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Could replace the grow capacity function with just one function for all types
-
+// The capacity used on the first append. Arrays don't allocate anything until then.
 #define ARRAY_INITIAL_CAPACITY 4
 
 #define ARRAY_TEMPLATE_DECLARATION(arrayTypeName, itemType) \
@@ -18,22 +17,92 @@ typedef struct \
 void arrayTypeName##Init(arrayTypeName* array); \
 void arrayTypeName##Free(arrayTypeName* array); \
 void arrayTypeName##Append(arrayTypeName* array, itemType item); \
+void arrayTypeName##AppendMany(arrayTypeName* array, const itemType* items, size_t count); \
+/* Makes sure capacity items fit without growing the array. */ \
+void arrayTypeName##Reserve(arrayTypeName* array, size_t capacity); \
+void arrayTypeName##ShrinkToFit(arrayTypeName* array); \
 void arrayTypeName##Clear(arrayTypeName* array);
 
 // void copyItemType(itemType* destination, itemType* source)
 // void freeItemType(itemType* ptr)
+// When the array grows the items are copied to the new buffer one by one and the old ones are freed.
 #define ARRAY_TEMPLATE_DEFINITION(arrayTypeName, itemType, copyItemType, freeItemType) \
 \
-static int grow##arrayTypeName##Capacity(size_t capacity) \
+static void reallocate##arrayTypeName(arrayTypeName* array, size_t capacity) \
+{ \
+	itemType* newData = malloc(capacity * sizeof(itemType)); \
+	if (newData == NULL) \
+	{ \
+		fputs("Failed to reallocate array\n", stderr); \
+		exit(1); \
+	} \
+	for (size_t i = 0; i < array->size; i++) \
+	{ \
+		copyItemType(&newData[i], &array->data[i]); \
+		freeItemType(&array->data[i]); \
+	} \
+	free(array->data); \
+	array->data = newData; \
+	array->capacity = capacity; \
+} \
+\
+static void copy##arrayTypeName##Items(itemType* destination, const itemType* items, size_t count) \
+{ \
+	for (size_t i = 0; i < count; i++) \
+		copyItemType(&destination[i], (itemType*)&items[i]); \
+} \
+\
+ARRAY_TEMPLATE_COMMON_DEFINITION(arrayTypeName, itemType, copyItemType, freeItemType)
+
+// For items that can be copied with memcpy and don't own anything. Growing uses realloc so the items are
+// moved in bulk, and often not at all.
+#define ARRAY_TEMPLATE_TRIVIAL_DEFINITION(arrayTypeName, itemType) \
+\
+static void reallocate##arrayTypeName(arrayTypeName* array, size_t capacity) \
+{ \
+	itemType* newData = realloc(array->data, capacity * sizeof(itemType)); \
+	if (newData == NULL) \
+	{ \
+		fputs("Failed to reallocate array\n", stderr); \
+		exit(1); \
+	} \
+	array->data = newData; \
+	array->capacity = capacity; \
+} \
+\
+static void copy##arrayTypeName##Items(itemType* destination, const itemType* items, size_t count) \
+{ \
+	memcpy(destination, items, count * sizeof(itemType)); \
+} \
+\
+static void copy##arrayTypeName##Item(itemType* destination, itemType* item) \
+{ \
+	*destination = *item; \
+} \
+\
+static void free##arrayTypeName##Item(itemType* item) \
+{ \
+	(void)item; \
+} \
+\
+ARRAY_TEMPLATE_COMMON_DEFINITION(arrayTypeName, itemType, copy##arrayTypeName##Item, free##arrayTypeName##Item)
+
+// Used by both definitions. Requires reallocate##arrayTypeName and copy##arrayTypeName##Items.
+#define ARRAY_TEMPLATE_COMMON_DEFINITION(arrayTypeName, itemType, copyItemType, freeItemType) \
+\
+static void grow##arrayTypeName(arrayTypeName* array, size_t requiredCapacity) \
 { \
-	return capacity * 2; \
+	size_t capacity = (array->capacity == 0) ? ARRAY_INITIAL_CAPACITY : array->capacity * 2; \
+	while (capacity < requiredCapacity) \
+		capacity *= 2; \
+	reallocate##arrayTypeName(array, capacity); \
 } \
 \
 void arrayTypeName##Init(arrayTypeName* array) \
 { \
 	array->size = 0; \
-	array->capacity = ARRAY_INITIAL_CAPACITY;\
-	array->data = malloc(array->capacity * sizeof(itemType)); \
+	array->capacity = 0; \
+	array->data = NULL; \
 } \
 \
 void arrayTypeName##Free(arrayTypeName* array) \
@@ -44,25 +113,41 @@ void arrayTypeName##Free(arrayTypeName* array) \
 void arrayTypeName##Append(arrayTypeName* array, itemType item) \
 { \
 	if ((array->size + 1) > array->capacity) \
+		grow##arrayTypeName(array, array->size + 1); \
+	copyItemType(&array->data[array->size], &item); \
+	array->size++; \
+} \
+\
+void arrayTypeName##AppendMany(arrayTypeName* array, const itemType* items, size_t count) \
+{ \
+	if (count == 0) \
+		return; \
+	if ((array->size + count) > array->capacity) \
+		grow##arrayTypeName(array, array->size + count); \
+	copy##arrayTypeName##Items(&array->data[array->size], items, count); \
+	array->size += count; \
+} \
+\
+void arrayTypeName##Reserve(arrayTypeName* array, size_t capacity) \
+{ \
+	if (capacity > array->capacity) \
+		reallocate##arrayTypeName(array, capacity); \
+} \
+\
+void arrayTypeName##ShrinkToFit(arrayTypeName* array) \
+{ \
+	if (array->size == array->capacity) \
+		return; \
+	if (array->size == 0) \
 	{ \
-		array->capacity = grow##arrayTypeName##Capacity(array->capacity); \
-		itemType* newData = malloc(array->capacity * sizeof(itemType)); \
-		if (newData == NULL) \
-		{ \
-			fputs("Failed to reallocate array\n", stderr); \
-			exit(1); \
-		} \
-		for (size_t i = 0; i < array->size; i++) \
-		{ \
-			copyItemType(&newData[i], &array->data[i]); \
-			freeItemType(&array->data[i]); \
-		} \
 		free(array->data); \
-		array->data = newData; \
+		array->data = NULL; \
+		array->capacity = 0; \
+		return; \
 	} \
-	copyItemType(&array->data[array->size], &item); \
-	array->size++; \
+	reallocate##arrayTypeName(array, array->size); \
 } \
+\
 void arrayTypeName##Clear(arrayTypeName* array) \
 { \
 	for (size_t i = 0; i < array->size; i++) \
@@ -70,4 +155,4 @@ void arrayTypeName##Clear(arrayTypeName* array) \
 		freeItemType(&array->data[i]); \
 	} \
 	array->size = 0; \
-}
\ No newline at end of file
+}
@@ -0,0 +1,42 @@
+#include "Cli.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void printUsageAndExit(const char* program)
+{
+	fprintf(stderr, "usage: %s [--pch <file>] [--create-pch <header>]\n", program);
+	exit(1);
+}
+
+CliOptions CliParseOptions(int argCount, char* args[])
+{
+	CliOptions options;
+	options.pchPath = NULL;
+	options.pchHeaderPath = NULL;
+
+	for (int i = 1; i < argCount; i++)
+	{
+		if ((strcmp(args[i], "--pch") == 0) && ((i + 1) < argCount))
+		{
+			options.pchPath = args[++i];
+		}
+		else if ((strcmp(args[i], "--create-pch") == 0) && ((i + 1) < argCount))
+		{
+			options.pchHeaderPath = args[++i];
+		}
+		else
+		{
+			fprintf(stderr, "unknown argument '%s'\n", args[i]);
+			printUsageAndExit(args[0]);
+		}
+	}
+
+	if ((options.pchHeaderPath != NULL) && (options.pchPath == NULL))
+	{
+		fputs("--create-pch requires --pch\n", stderr);
+		printUsageAndExit(args[0]);
+	}
+	return options;
+}
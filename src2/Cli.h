@@ -0,0 +1,12 @@
+#pragma once
+
+typedef struct
+{
+	// NULL if no precompiled header is used.
+	const char* pchPath;
+	// If set the precompiled header of this header is written to pchPath before compiling.
+	const char* pchHeaderPath;
+} CliOptions;
+
+// Prints the usage and exits if the arguments are invalid.
+CliOptions CliParseOptions(int argCount, char* args[]);
@@ -3,20 +3,27 @@
 #include "Assert.h"
 #include "Generic.h"
 
+// rax and rdx are left for multiplication, division and return values, rbp and rsp are used for the stack.
+static const RegisterGp allocatableRegisters[] = {
+	REGISTER_RBX, REGISTER_RCX, REGISTER_RSI, REGISTER_RDI,
+	REGISTER_R8, REGISTER_R9, REGISTER_R10, REGISTER_R11, REGISTER_R12, REGISTER_R13, REGISTER_R14, REGISTER_R15
+};
+
 Compiler CompilerInit(Compiler* compiler)
 {
 	DataTypeArrayInit(&compiler->dataTypes);
+	RegisterValueArrayInit(&compiler->registerValues);
 }
 
 void CompilerFree(Compiler* compiler)
 {
 	DataTypeArrayFree(&compiler->dataTypes);
+	RegisterValueArrayFree(&compiler->registerValues);
 }
 
-String CompilerCompile(Compiler* compiler, const TokenArray* tokens, const FileInfo* fileInfo)
+String CompilerCompile(Compiler* compiler, const TokenArray* tokens)
 {
 	compiler->tokens = tokens;
-	compiler->fileInfo = fileInfo;
 
 	compiler->currentTokenIndex = 0;
 	compiler->hadError = false;
@@ -24,13 +31,17 @@ String CompilerCompile(Compiler* compiler, const TokenArray* tokens, const FileI
 
 	compiler->textSection = StringCopy("");
 	compiler->dataSection = StringCopy("");
+	compiler->stackFrameSize = 0;
+	compiler->labelCount = 0;
+	resetRegisters(compiler);
 
 	Scope scope;
 	//beginScope(compiler, &scope);
 
 	expr(compiler);
-	printf("%.*s", compiler->tokens->data[compiler->currentTokenIndex].text.length, compiler->tokens->data[compiler->currentTokenIndex].text.chars);
-	ASSERT(compiler->tokens->data[compiler->currentTokenIndex].type == TOKEN_EOF);
+	Token token = peekToken(compiler);
+	printf("%.*s", token.text.length, token.text.chars);
+	ASSERT(token.type == TOKEN_EOF);
 
 	//endScope(compiler);
 
@@ -58,7 +69,7 @@ bool checkDeclarationStart(Compiler* compiler)
 	if (matchToken(compiler, TOKEN_IDENTIFIER))
 	{
 		DataType type;
-		//if (resolveTypedef(compiler, peekPreviousToken(compiler).text, &type))
+		//if (resolveTypedef(compiler, TokenArrayGetSymbol(compiler->tokens, compiler->currentTokenIndex - 1), &type))
 		{
 			return true;
 		}
@@ -85,6 +96,24 @@ bool checkDeclarationStart(Compiler* compiler)
 		|| checkToken(compiler, TOKEN_VOLATILE);
 }
 
+bool isTypeNameStart(TokenType type)
+{
+	return (type == TOKEN_CHAR)
+		|| (type == TOKEN_INT)
+		|| (type == TOKEN_SHORT)
+		|| (type == TOKEN_LONG)
+		|| (type == TOKEN_FLOAT)
+		|| (type == TOKEN_DOUBLE)
+		|| (type == TOKEN_VOID)
+		|| (type == TOKEN_UNSIGNED)
+		|| (type == TOKEN_SIGNED)
+		|| (type == TOKEN_STRUCT)
+		|| (type == TOKEN_ENUM)
+		|| (type == TOKEN_UNION)
+		|| (type == TOKEN_CONST)
+		|| (type == TOKEN_VOLATILE);
+}
+
 Result expr(Compiler* compiler)
 {
 	return commaExpr(compiler);
@@ -93,13 +122,15 @@ Result expr(Compiler* compiler)
 Result primaryExpr(Compiler* compiler)
 {
 	if (matchToken(compiler, TOKEN_IDENTIFIER))
-		return;
+		compilerErrorAt(compiler, peekPreviousToken(compiler), "variables aren't supported yet");
 	if (matchConstant(compiler))
-		return;
+		return constantExpr(compiler, peekPreviousToken(compiler));
 	if (matchToken(compiler, TOKEN_STRING_LITERAL))
-		return; // Later concatenate strings;
+		compilerErrorAt(compiler, peekPreviousToken(compiler), "string literals aren't supported yet"); // Later concatenate strings;
 	if (matchToken(compiler, TOKEN_LEFT_PAREN))
 		return groupingExpr(compiler);
+
+	compilerError(compiler, "expected an expression");
 }
 
 bool matchConstant(Compiler* compiler)
@@ -116,6 +147,31 @@ bool matchConstant(Compiler* compiler)
 		|| matchToken(compiler, TOKEN_LONG_DOUBLE_CONSTANT);
 }
 
+Result constantExpr(Compiler* compiler, Token token)
+{
+	// The scanner gives each constant the first type of its suffix that the value fits in, so the value is already
+	// extended to 64 bits and can be used as any bigger type.
+	Result result;
+	result.storageClass = STORAGE_CLASS_NONE;
+	result.locationType = RESULT_LOCATION_INT_CONSTANT;
+	result.location.unsignedLongLongConstant = token.value.intValue;
+
+	switch (token.type)
+	{
+		case TOKEN_INT_CONSTANT:                result.dataType = integerType(DATA_TYPE_INT, false); break;
+		case TOKEN_UNSIGNED_INT_CONSTANT:       result.dataType = integerType(DATA_TYPE_INT, true); break;
+		case TOKEN_LONG_CONSTANT:               result.dataType = integerType(DATA_TYPE_LONG, false); break;
+		case TOKEN_UNSIGNED_LONG_CONSTANT:      result.dataType = integerType(DATA_TYPE_LONG, true); break;
+		case TOKEN_LONG_LONG_CONSTANT:          result.dataType = integerType(DATA_TYPE_LONG_LONG, false); break;
+		case TOKEN_UNSIGNED_LONG_LONG_CONSTANT: result.dataType = integerType(DATA_TYPE_LONG_LONG, true); break;
+
+		// The scanner doesn't decode the value of char constants yet.
+		default:
+			compilerErrorAt(compiler, token, "only integer constants are supported for now");
+	}
+	return result;
+}
+
 Result groupingExpr(Compiler* compiler)
 {
 	Result result = expr(compiler);
@@ -253,26 +309,48 @@ Result dereferenceExpr(Compiler* compiler)
 
 Result unaryPlusExpr(Compiler* compiler)
 {
-	castExpr(compiler);
-	return;
+	const Result operand = castExpr(compiler);
+	checkIntegerOperand(compiler, &operand);
+	DataType type = promotedType(&operand.dataType);
+	return prepareOperand(compiler, &operand, &type);
 }
 
 Result unaryMinusExpr(Compiler* compiler)
 {
-	castExpr(compiler);
-	return;
+	const Result operand = castExpr(compiler);
+	checkIntegerOperand(compiler, &operand);
+	DataType type = promotedType(&operand.dataType);
+	Result result = moveToRegister(compiler, &operand, &type);
+	StringAppendFormat(&compiler->textSection, "\n\tneg %s", RegisterGpToString(getResultRegister(compiler, &result), DataTypeSize(&type)));
+	return result;
 }
 
 Result bitwiseNotExpr(Compiler* compiler)
 {
-	castExpr(compiler);
-	return;
+	const Result operand = castExpr(compiler);
+	checkIntegerOperand(compiler, &operand);
+	DataType type = promotedType(&operand.dataType);
+	Result result = moveToRegister(compiler, &operand, &type);
+	StringAppendFormat(&compiler->textSection, "\n\tnot %s", RegisterGpToString(getResultRegister(compiler, &result), DataTypeSize(&type)));
+	return result;
 }
 
 Result logicalNotExpr(Compiler* compiler)
 {
-	castExpr(compiler);
-	return;
+	const Result operand = castExpr(compiler);
+	checkIntegerOperand(compiler, &operand);
+	DataType type = promotedType(&operand.dataType);
+	Result result = moveToRegister(compiler, &operand, &type);
+	RegisterGp reg = getResultRegister(compiler, &result);
+	StringAppendFormat(
+		&compiler->textSection,
+		"\n\tcmp %s, 0\n\tsete %s\n\tmovzx %s, %s",
+		RegisterGpToString(reg, DataTypeSize(&type)), RegisterGpToString(reg, SIZE_BYTE),
+		RegisterGpToString(reg, SIZE_DWORD), RegisterGpToString(reg, SIZE_BYTE)
+	);
+	DataType integer = integerType(DATA_TYPE_INT, false);
+	setResultType(compiler, &result, &integer);
+	return result;
 }
 
 Result sizeofExpr(Compiler* compiler)
@@ -291,301 +369,375 @@ Result sizeofExpr(Compiler* compiler)
 
 Result castExpr(Compiler* compiler)
 {
-	if (matchToken(compiler, TOKEN_LEFT_PAREN))
-	{
-		DataType type = typeName(compiler);
-		expectToken(compiler, TOKEN_RIGHT_PAREN, "expected ')'");
-		castExpr(compiler);
-		return;
-	}
-	else
-	{
-		return unaryExpr(compiler);
-	}
-}
+	// Without the type name the parens are a grouping parsed by primaryExpr.
+	if (checkToken(compiler, TOKEN_LEFT_PAREN) && isTypeNameStart(peekNextToken(compiler).type))
+		compilerErrorAt(compiler, peekNextToken(compiler), "casts aren't supported yet"); // typeName isn't done
+
+	return unaryExpr(compiler);
+}
+
+static const BinaryRule binaryRules[] = {
+	[TOKEN_AND_AND] = { PRECEDENCE_LOGICAL_AND, logicalAndExpr },
+	[TOKEN_OR_OR] = { PRECEDENCE_LOGICAL_OR, logicalOrExpr },
+	[TOKEN_OR] = { PRECEDENCE_BITWISE_OR, bitwiseOrExpr },
+	[TOKEN_XOR] = { PRECEDENCE_BITWISE_XOR, bitwiseXorExpr },
+	[TOKEN_AND] = { PRECEDENCE_BITWISE_AND, bitwiseAndExpr },
+	[TOKEN_EQUALS_EQUALS] = { PRECEDENCE_EQUALITY, equalsExpr },
+	[TOKEN_BANG_EQUALS] = { PRECEDENCE_EQUALITY, notEqualsExpr },
+	[TOKEN_LESS] = { PRECEDENCE_RELATIONAL, lessThanExpr },
+	[TOKEN_MORE] = { PRECEDENCE_RELATIONAL, moreThanExpr },
+	[TOKEN_LESS_EQUALS] = { PRECEDENCE_RELATIONAL, lessThanOrEqualExpr },
+	[TOKEN_MORE_EQUALS] = { PRECEDENCE_RELATIONAL, moreThanOrEqualExpr },
+	[TOKEN_SHIFT_LEFT] = { PRECEDENCE_SHIFT, shiftLeftExpr },
+	[TOKEN_SHIFT_RIGHT] = { PRECEDENCE_SHIFT, shiftRightExpr },
+	[TOKEN_PLUS] = { PRECEDENCE_ADDITIVE, additionExpr },
+	[TOKEN_MINUS] = { PRECEDENCE_ADDITIVE, subtractionExpr },
+	[TOKEN_STAR] = { PRECEDENCE_MULTIPLICATIVE, multiplicationExpr },
+	[TOKEN_SLASH] = { PRECEDENCE_MULTIPLICATIVE, divisionExpr },
+	[TOKEN_PERCENT] = { PRECEDENCE_MULTIPLICATIVE, moduloExpr },
+};
+
+const BinaryRule* getBinaryRule(TokenType type)
+{
+	// Tokens that aren't in the table are zero initialized to PRECEDENCE_NONE.
+	static const BinaryRule noRule = { PRECEDENCE_NONE, NULL };
+	if (type >= (sizeof(binaryRules) / sizeof(binaryRules[0])))
+		return &noRule;
+	return &binaryRules[type];
+}
+
+// Binary operators are parsed by precedence climbing. The right operand of an operator is parsed by a single
+// call to binaryExpr instead of going through a function for every precedence level.
+Result binaryExpr(Compiler* compiler, Precedence minPrecedence)
+{
+	Result lhs = castExpr(compiler);
 
-Result multiplicativeExpr(Compiler* compiler)
-{
-	Result result = castExpr(compiler);
-
-	while (isCompilerAtEnd(compiler) == false)
+	for (;;)
 	{
-		if (matchToken(compiler, TOKEN_STAR))
-			result = multiplicationExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_SLASH))
-			result = divisionExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_PERCENT))
-			result = moduloExpr(compiler, &result);
-		else
+		const BinaryRule* rule = getBinaryRule(peekCompilerTokenType(compiler));
+		if (rule->precedence < minPrecedence)
 			break;
+
+		advanceCompiler(compiler);
+		// All the binary operators are left associative.
+		const Result rhs = binaryExpr(compiler, rule->precedence + 1);
+		lhs = rule->function(compiler, &lhs, &rhs);
 	}
 
-	return result;
+	return lhs;
 }
 
-Result multiplicationExpr(Compiler* compiler, const Result* lhs)
+bool isIntegerType(const DataType* dataType)
 {
-	Result rhs = castExpr(compiler);
-	return;
+	return (dataType->type == DATA_TYPE_CHAR)
+		|| (dataType->type == DATA_TYPE_SHORT)
+		|| (dataType->type == DATA_TYPE_INT)
+		|| (dataType->type == DATA_TYPE_LONG)
+		|| (dataType->type == DATA_TYPE_LONG_LONG);
 }
 
-Result divisionExpr(Compiler* compiler, const Result* lhs)
+DataType integerType(DataTypeType type, bool isUnsigned)
 {
-	Result rhs = castExpr(compiler);
-	return;
+	DataType dataType;
+	dataType.type = type;
+	dataType.isUnsigned = isUnsigned;
+	dataType.isConst = false;
+	dataType.isVolatile = false;
+	return dataType;
 }
 
-Result moduloExpr(Compiler* compiler, const Result* lhs)
+DataType promotedType(const DataType* dataType)
 {
-	Result rhs = castExpr(compiler);
-	return;
+	if (DataTypeSize(dataType) < SIZE_DWORD)
+		return integerType(DATA_TYPE_INT, false);
+	return *dataType;
 }
 
-Result additiveExpr(Compiler* compiler)
+DataType binaryResultType(const DataType* lhs, const DataType* rhs)
 {
-	Result result = multiplicativeExpr(compiler);
-
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_PLUS))
-			result = additionExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_MINUS))
-			result = subtractionExpr(compiler, &result);
-		else
-			break;
-	}
+	DataType lhsType = promotedType(lhs);
+	DataType rhsType = promotedType(rhs);
+	size_t lhsSize = DataTypeSize(&lhsType);
+	size_t rhsSize = DataTypeSize(&rhsType);
+	if (lhsSize != rhsSize)
+		return (lhsSize > rhsSize) ? lhsType : rhsType;
 
-	return result;
+	lhsType.isUnsigned = lhsType.isUnsigned || rhsType.isUnsigned;
+	return lhsType;
 }
 
-Result additionExpr(Compiler* compiler, const Result* lhs)
+void checkIntegerOperand(Compiler* compiler, const Result* operand)
 {
-	const Result rhs = multiplicativeExpr(compiler);
-	return;
+	if (isIntegerType(&operand->dataType) == false)
+		compilerError(compiler, "only integer operands are supported for now");
 }
 
-Result subtractionExpr(Compiler* compiler, const Result* lhs)
+Result integerBinaryExpr(Compiler* compiler, const char* instruction, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = multiplicativeExpr(compiler);
-	return;
-}
+	checkIntegerOperand(compiler, lhs);
+	checkIntegerOperand(compiler, rhs);
+	DataType type = binaryResultType(&lhs->dataType, &rhs->dataType);
+	size_t size = DataTypeSize(&type);
 
-Result shiftExpr(Compiler* compiler)
-{
-	Result result = additiveExpr(compiler);
-
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_SHIFT_LEFT))
-			result = shiftLeftExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_SHIFT_RIGHT))
-			result = shiftRightExpr(compiler, &result);
-		else
-			break;
-	}
+	// Moving lhs to a register can spill the operand, so it is resolved after.
+	Result operand = prepareOperand(compiler, rhs, &type);
+	Result result = moveToRegister(compiler, lhs, &type);
+	operand = resolveResult(compiler, &operand);
 
+	StringAppendFormat(&compiler->textSection, "\n\t%s %s, ", instruction, RegisterGpToString(getResultRegister(compiler, &result), size));
+	appendOperand(compiler, &operand, size);
+	freeResult(compiler, &operand);
 	return result;
 }
 
-Result shiftLeftExpr(Compiler* compiler, const Result* lhs)
+Result divisionOrModuloExpr(Compiler* compiler, bool isModulo, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = additiveExpr(compiler);
-	return;
-}
+	checkIntegerOperand(compiler, lhs);
+	checkIntegerOperand(compiler, rhs);
+	DataType type = binaryResultType(&lhs->dataType, &rhs->dataType);
+	size_t size = DataTypeSize(&type);
 
-Result shiftRightExpr(Compiler* compiler, const Result* lhs)
-{
-	const Result rhs = additiveExpr(compiler);
-	return;
+	// div doesn't take an immediate.
+	Result divisor = (rhs->locationType == RESULT_LOCATION_INT_CONSTANT)
+		? moveToRegister(compiler, rhs, &type)
+		: prepareOperand(compiler, rhs, &type);
+	Result result = moveToRegister(compiler, lhs, &type);
+	divisor = resolveResult(compiler, &divisor);
+
+	// The dividend is in rdx:rax, so for signed division the sign of rax is extended into rdx.
+	RegisterGp reg = getResultRegister(compiler, &result);
+	StringAppendFormat(&compiler->textSection, "\n\tmov %s, %s", RegisterGpToString(REGISTER_RAX, size), RegisterGpToString(reg, size));
+	if (type.isUnsigned)
+		StringAppend(&compiler->textSection, "\n\txor edx, edx\n\tdiv ");
+	else
+		StringAppendFormat(&compiler->textSection, "\n\t%s\n\tidiv ", (size == SIZE_QWORD) ? "cqo" : "cdq");
+	appendOperand(compiler, &divisor, size);
+	StringAppendFormat(
+		&compiler->textSection, "\n\tmov %s, %s",
+		RegisterGpToString(reg, size), RegisterGpToString(isModulo ? REGISTER_RDX : REGISTER_RAX, size)
+	);
+	freeResult(compiler, &divisor);
+	return result;
 }
 
-Result relationalExpr(Compiler* compiler)
+Result shiftExpr(Compiler* compiler, bool isLeft, const Result* lhs, const Result* rhs)
 {
-	Result result = shiftExpr(compiler);
+	checkIntegerOperand(compiler, lhs);
+	checkIntegerOperand(compiler, rhs);
+	// Unlike the other operators the type is only decided by lhs.
+	DataType type = promotedType(&lhs->dataType);
+	size_t size = DataTypeSize(&type);
+	const char* instruction = isLeft ? "shl" : (type.isUnsigned ? "shr" : "sar");
 
-	while (isCompilerAtEnd(compiler) == false)
+	Result result = moveToRegister(compiler, lhs, &type);
+	Result count = resolveResult(compiler, rhs);
+	RegisterGp reg = getResultRegister(compiler, &result);
+	if (count.locationType == RESULT_LOCATION_INT_CONSTANT)
 	{
-		if (matchToken(compiler, TOKEN_LESS))
-			result = lessThanExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_MORE))
-			result = moreThanExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_MORE_EQUALS))
-			result = moreThanOrEqualExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_LESS_EQUALS))
-			result = lessThanOrEqualExpr(compiler, &result);
-		else
-			break;
+		// The shift count is masked like the instruction does.
+		StringAppendFormat(
+			&compiler->textSection, "\n\t%s %s, %d",
+			instruction, RegisterGpToString(reg, size), (int)(count.location.unsignedLongLongConstant & ((size * 8) - 1))
+		);
+		return result;
 	}
 
+	// The count has to be in cl. rcx is saved in rax while it is used, and if lhs is in rcx it is shifted in rax.
+	StringAppend(&compiler->textSection, "\n\tmov rax, rcx");
+	appendMoveExtended(compiler, REGISTER_RCX, SIZE_DWORD, &count);
+	RegisterGp shifted = (reg == REGISTER_RCX) ? REGISTER_RAX : reg;
+	StringAppendFormat(&compiler->textSection, "\n\t%s %s, cl\n\tmov rcx, rax", instruction, RegisterGpToString(shifted, size));
+	freeResult(compiler, &count);
 	return result;
 }
 
-Result lessThanExpr(Compiler* compiler, const Result* lhs)
+Result comparisonExpr(Compiler* compiler, const char* signedCondition, const char* unsignedCondition, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = shiftExpr(compiler);
-	return;
+	checkIntegerOperand(compiler, lhs);
+	checkIntegerOperand(compiler, rhs);
+	DataType type = binaryResultType(&lhs->dataType, &rhs->dataType);
+	size_t size = DataTypeSize(&type);
+
+	Result operand = prepareOperand(compiler, rhs, &type);
+	Result result = moveToRegister(compiler, lhs, &type);
+	operand = resolveResult(compiler, &operand);
+
+	RegisterGp reg = getResultRegister(compiler, &result);
+	StringAppendFormat(&compiler->textSection, "\n\tcmp %s, ", RegisterGpToString(reg, size));
+	appendOperand(compiler, &operand, size);
+	StringAppendFormat(
+		&compiler->textSection, "\n\tset%s %s\n\tmovzx %s, %s",
+		type.isUnsigned ? unsignedCondition : signedCondition, RegisterGpToString(reg, SIZE_BYTE),
+		RegisterGpToString(reg, SIZE_DWORD), RegisterGpToString(reg, SIZE_BYTE)
+	);
+	freeResult(compiler, &operand);
+
+	DataType integer = integerType(DATA_TYPE_INT, false);
+	setResultType(compiler, &result, &integer);
+	return result;
 }
 
-Result moreThanExpr(Compiler* compiler, const Result* lhs)
+Result multiplicationExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = shiftExpr(compiler);
-	return;
+	// The lower half of the product is the same for signed and unsigned numbers.
+	return integerBinaryExpr(compiler, "imul", lhs, rhs);
 }
 
-Result lessThanOrEqualExpr(Compiler* compiler, const Result* lhs)
+Result divisionExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = shiftExpr(compiler);
-	return;
+	return divisionOrModuloExpr(compiler, false, lhs, rhs);
 }
 
-Result moreThanOrEqualExpr(Compiler* compiler, const Result* lhs)
+Result moduloExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = shiftExpr(compiler);
-	return;
+	return divisionOrModuloExpr(compiler, true, lhs, rhs);
 }
 
-Result equalityExpr(Compiler* compiler)
+Result additionExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	Result result = relationalExpr(compiler);
-
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_EQUALS_EQUALS))
-			result = equalsExpr(compiler, &result);
-		else if (matchToken(compiler, TOKEN_BANG_EQUALS))
-			result = notEqualsExpr(compiler, &result);
-		else
-			break;
-	}
+	return integerBinaryExpr(compiler, "add", lhs, rhs);
+}
 
-	return result;
+Result subtractionExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return integerBinaryExpr(compiler, "sub", lhs, rhs);
 }
 
-Result equalsExpr(Compiler* compiler, const Result* lhs)
+Result shiftLeftExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = relationalExpr(compiler);
-	return;
+	return shiftExpr(compiler, true, lhs, rhs);
 }
 
-Result notEqualsExpr(Compiler* compiler, const Result* lhs)
+Result shiftRightExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	const Result rhs = relationalExpr(compiler);
-	return;
+	return shiftExpr(compiler, false, lhs, rhs);
 }
 
-Result bitwiseAndExpr(Compiler* compiler)
+Result lessThanExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	Result lhs = equalityExpr(compiler);
+	return comparisonExpr(compiler, "l", "b", lhs, rhs);
+}
 
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_AND))
-		{
-			Result rhs = equalityExpr(compiler);
-			//lhs = RESULT_SUCCESS;
-		}
-		else
-		{
-			break;
-		}
-	}
+Result moreThanExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return comparisonExpr(compiler, "g", "a", lhs, rhs);
+}
 
-	return lhs;
+Result lessThanOrEqualExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return comparisonExpr(compiler, "le", "be", lhs, rhs);
 }
 
-Result bitwiseXorExpr(Compiler* compiler)
+Result moreThanOrEqualExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	Result lhs = bitwiseAndExpr(compiler);
+	return comparisonExpr(compiler, "ge", "ae", lhs, rhs);
+}
 
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_XOR))
-		{
-			Result rhs = bitwiseAndExpr(compiler);
-			//lhs = RESULT_SUCCESS;
-		}
-		else
-		{
-			break;
-		}
-	}
+Result equalsExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return comparisonExpr(compiler, "e", "e", lhs, rhs);
+}
 
-	return lhs;
+Result notEqualsExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return comparisonExpr(compiler, "ne", "ne", lhs, rhs);
 }
 
-Result bitwiseOrExpr(Compiler* compiler)
+Result bitwiseAndExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	Result lhs = bitwiseXorExpr(compiler);
+	return integerBinaryExpr(compiler, "and", lhs, rhs);
+}
 
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_OR))
-		{
-			Result rhs = bitwiseXorExpr(compiler);
-			//lhs = RESULT_SUCCESS;
-		}
-		else
-		{
-			break;
-		}
-	}
+Result bitwiseXorExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return integerBinaryExpr(compiler, "xor", lhs, rhs);
+}
 
-	return lhs;
+Result bitwiseOrExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return integerBinaryExpr(compiler, "or", lhs, rhs);
 }
 
-Result logicalOrExpr(Compiler* compiler)
+Result logicalExpr(Compiler* compiler, const char* instruction, const Result* lhs, const Result* rhs)
 {
-	Result lhs = bitwiseOrExpr(compiler);
+	checkIntegerOperand(compiler, lhs);
+	checkIntegerOperand(compiler, rhs);
+	// There are no jumps in expressions yet so both sides are always evaluated. The operands can't have side effects
+	// until variables are supported.
+	DataType lhsType = promotedType(&lhs->dataType);
+	DataType rhsType = promotedType(&rhs->dataType);
+	Result operand = moveToRegister(compiler, rhs, &rhsType);
+	Result result = moveToRegister(compiler, lhs, &lhsType);
+	operand = resolveResult(compiler, &operand);
 
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_OR_OR))
-		{
-			Result rhs = bitwiseOrExpr(compiler);
-			//lhs = RESULT_SUCCESS;
-		}
-		else
-		{
-			break;
-		}
-	}
+	RegisterGp reg = getResultRegister(compiler, &result);
+	StringAppendFormat(&compiler->textSection, "\n\tcmp %s, 0\n\tsetne %s\n\tcmp ", RegisterGpToString(reg, DataTypeSize(&lhsType)), RegisterGpToString(reg, SIZE_BYTE));
+	appendOperand(compiler, &operand, DataTypeSize(&rhsType));
+	StringAppendFormat(
+		&compiler->textSection, ", 0\n\tsetne al\n\t%s %s, al\n\tmovzx %s, %s",
+		instruction, RegisterGpToString(reg, SIZE_BYTE), RegisterGpToString(reg, SIZE_DWORD), RegisterGpToString(reg, SIZE_BYTE)
+	);
+	freeResult(compiler, &operand);
 
-	return lhs;
+	DataType integer = integerType(DATA_TYPE_INT, false);
+	setResultType(compiler, &result, &integer);
+	return result;
 }
 
-Result logicalAndExpr(Compiler* compiler)
+Result logicalOrExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
 {
-	Result lhs = logicalOrExpr(compiler);
-
-	while (isCompilerAtEnd(compiler) == false)
-	{
-		if (matchToken(compiler, TOKEN_AND_AND))
-		{
-			Result rhs = logicalOrExpr(compiler);
-			//lhs = RESULT_SUCCESS;
-		}
-		else
-		{
-			break;
-		}
-	}
+	return logicalExpr(compiler, "or", lhs, rhs);
+}
 
-	return lhs;
+Result logicalAndExpr(Compiler* compiler, const Result* lhs, const Result* rhs)
+{
+	return logicalExpr(compiler, "and", lhs, rhs);
 }
 
 Result conditionalExpr(Compiler* compiler)
 {
-	Result result = logicalOrExpr(compiler);
+	Result condition = binaryExpr(compiler, PRECEDENCE_LOGICAL_OR);
+	if (matchToken(compiler, TOKEN_QUESTION) == false)
+		return condition;
 
-	if (matchToken(compiler, TOKEN_QUESTION))
-	{
-		// Move this to compilation later
-		Result left = expr(compiler);
-		expectToken(compiler, TOKEN_COLON, "expected ':'");
-		Result right = conditionalExpr(compiler);
-	}
-
-	return result;
+	checkIntegerOperand(compiler, &condition);
+	DataType conditionType = promotedType(&condition.dataType);
+	condition = moveToRegister(compiler, &condition, &conditionType);
+	StringAppendFormat(
+		&compiler->textSection, "\n\tcmp %s, 0",
+		RegisterGpToString(getResultRegister(compiler, &condition), DataTypeSize(&conditionType))
+	);
+	freeResult(compiler, &condition);
+	// The spills are movs, so they don't change the flags.
+	spillRegisters(compiler);
+
+	size_t falseLabel = compiler->labelCount++;
+	size_t endLabel = compiler->labelCount++;
+	StringAppendFormat(&compiler->textSection, "\n\tje .L%zu", falseLabel);
+
+	// Both arms are extended to 64 bits in the same register. The common type is at least as big as the type of
+	// each arm, so the lower bytes of the register are the value converted to it.
+	Result trueResult = expr(compiler);
+	checkIntegerOperand(compiler, &trueResult);
+	DataType trueType = trueResult.dataType;
+	DataType extendedTrueType = integerType(DATA_TYPE_LONG_LONG, trueType.isUnsigned);
+	trueResult = moveToRegister(compiler, &trueResult, &extendedTrueType);
+	RegisterGp reg = getResultRegister(compiler, &trueResult);
+	freeResult(compiler, &trueResult);
+	StringAppendFormat(&compiler->textSection, "\n\tjmp .L%zu\n.L%zu:", endLabel, falseLabel);
+
+	expectToken(compiler, TOKEN_COLON, "expected ':'");
+	Result falseResult = conditionalExpr(compiler);
+	checkIntegerOperand(compiler, &falseResult);
+	DataType falseType = falseResult.dataType;
+	falseResult = resolveResult(compiler, &falseResult);
+	appendMoveExtended(compiler, reg, SIZE_QWORD, &falseResult);
+	freeResult(compiler, &falseResult);
+	StringAppendFormat(&compiler->textSection, "\n.L%zu:", endLabel);
+
+	// Only the arm that was taken put its value in the register, so nothing else can be in one here.
+	DataType type = binaryResultType(&trueType, &falseType);
+	return takeRegister(compiler, reg, &type);
 }
 
 Result assignmentExpr(Compiler* compiler)
@@ -614,6 +766,8 @@ Result assignmentExpr(Compiler* compiler)
 		return bitwiseXorAssignmentExpr(compiler, &lhs);
 	if (matchToken(compiler, TOKEN_OR_EQUALS))
 		return bitwiseOrAssignmentExpr(compiler, &lhs);
+
+	return lhs;
 }
 
 Result simpleAssignmentExpr(Compiler* compiler, const Result* lhs)
@@ -1010,6 +1164,7 @@ void exprStmt(Compiler* compiler)
 
 	expr(compiler);
 	expectToken(compiler, TOKEN_SEMICOLON, "expected ';'");
+	resetRegisters(compiler);
 }
 
 void labeledStmt(Compiler* compiler)
@@ -1017,6 +1172,7 @@ void labeledStmt(Compiler* compiler)
 	Token name = peekToken(compiler);
 	advanceCompiler(compiler);
 	advanceCompiler(compiler);
+	spillRegisters(compiler);
 
 	stmt(compiler);
 }
@@ -1044,8 +1200,9 @@ void returnStatement(Compiler* compiler)
 
 void compilerErrorAtVa(Compiler* compiler, Token token, const char* format, va_list args)
 {
-	const char* filename = compiler->fileInfo->filename;
-	int line = token.line;
+	const TokenSource* source = TokenArrayFindSourceOfChars(compiler->tokens, token.text.chars);
+	const char* filename = source->fileInfo->filename;
+	size_t line = FileInfoGetLineNumber(source->fileInfo, token.text.chars - source->source.chars);
 
 	fprintf(
 		stderr,
@@ -1078,26 +1235,33 @@ void compilerError(Compiler* compiler, const char* format, ...)
 
 void advanceCompiler(Compiler* compiler)
 {
-	printf("%.*s ", compiler->tokens->data[compiler->currentTokenIndex].text.length, compiler->tokens->data[compiler->currentTokenIndex].text.chars);
+	Token token = peekToken(compiler);
+	printf("%.*s ", token.text.length, token.text.chars);
 	if (isCompilerAtEnd(compiler) == false)
 		compiler->currentTokenIndex++;
 }
 
+// Getting the whole token requires scanning it again so only use these if the text is needed.
 Token peekToken(Compiler* compiler)
 {
-	return compiler->tokens->data[compiler->currentTokenIndex];
+	return TokenArrayGet(compiler->tokens, compiler->currentTokenIndex);
+}
+
+TokenType peekCompilerTokenType(Compiler* compiler)
+{
+	return TokenArrayGetType(compiler->tokens, compiler->currentTokenIndex);
 }
 
 Token peekNextToken(Compiler* compiler)
 {
 	if (isCompilerAtEnd(compiler))
-		return compiler->tokens->data[compiler->currentTokenIndex];
-	return compiler->tokens->data[compiler->currentTokenIndex + 1];
+		return TokenArrayGet(compiler->tokens, compiler->currentTokenIndex);
+	return TokenArrayGet(compiler->tokens, compiler->currentTokenIndex + 1);
 }
 
 Token peekPreviousToken(Compiler* compiler)
 {
-	return compiler->tokens->data[compiler->currentTokenIndex - 1];
+	return TokenArrayGet(compiler->tokens, compiler->currentTokenIndex - 1);
 }
 
 bool expectToken(Compiler* compiler, TokenType type, const char* errorMessage)
@@ -1110,17 +1274,19 @@ bool expectToken(Compiler* compiler, TokenType type, const char* errorMessage)
 
 bool isCompilerAtEnd(Compiler* compiler)
 {
-	return compiler->tokens->data[compiler->currentTokenIndex].type == TOKEN_EOF;
+	return TokenArrayGetType(compiler->tokens, compiler->currentTokenIndex) == TOKEN_EOF;
 }
 
 bool checkToken(Compiler* compiler, TokenType type)
 {
-	return peekToken(compiler).type == type;
+	return TokenArrayGetType(compiler->tokens, compiler->currentTokenIndex) == type;
 }
 
 bool checkNextToken(Compiler* compiler, TokenType type)
 {
-	return peekNextToken(compiler).type == type;
+	if (isCompilerAtEnd(compiler))
+		return type == TOKEN_EOF;
+	return TokenArrayGetType(compiler->tokens, compiler->currentTokenIndex + 1) == type;
 }
 
 bool matchToken(Compiler* compiler, TokenType type)
@@ -1146,7 +1312,235 @@ Result allocateVariableOnStack(Compiler* compiler, const DataType* dataType)
 	return result;
 }
 
-Result declareVariable(Compiler* compiler, StringView name, const DataType* dataType)
+Result allocateRegister(Compiler* compiler, const DataType* dataType)
+{
+	size_t registerCount = sizeof(allocatableRegisters) / sizeof(allocatableRegisters[0]);
+	RegisterGp reg = REGISTER_GP_COUNT;
+	for (size_t i = 0; i < registerCount; i++)
+	{
+		if (compiler->registerOwners[allocatableRegisters[i]] == -1)
+		{
+			reg = allocatableRegisters[i];
+			break;
+		}
+	}
+
+	// Values are only spilled once and freed values give their register back, so the owner with the smallest
+	// index is the oldest value.
+	if (reg == REGISTER_GP_COUNT)
+	{
+		int oldest = -1;
+		for (size_t i = 0; i < registerCount; i++)
+		{
+			int owner = compiler->registerOwners[allocatableRegisters[i]];
+			if ((oldest == -1) || (owner < oldest))
+				oldest = owner;
+		}
+
+		reg = compiler->registerValues.data[oldest].reg;
+		spillRegister(compiler, reg);
+	}
+
+	return takeRegister(compiler, reg, dataType);
+}
+
+Result takeRegister(Compiler* compiler, RegisterGp reg, const DataType* dataType)
+{
+	ASSERT(compiler->registerOwners[reg] == -1);
+
+	RegisterValue value;
+	value.reg = reg;
+	value.dataType = *dataType;
+	value.isSpilled = false;
+	value.baseOffset = 0;
+	compiler->registerOwners[reg] = (int)compiler->registerValues.size;
+
+	Result result;
+	result.storageClass = STORAGE_CLASS_NONE;
+	result.dataType = *dataType;
+	result.locationType = RESULT_LOCATION_REGISTER;
+	result.location.registerValueIndex = compiler->registerValues.size;
+	RegisterValueArrayAppend(&compiler->registerValues, value);
+	return result;
+}
+
+Result moveToRegister(Compiler* compiler, const Result* result, const DataType* dataType)
+{
+	Result resolved = resolveResult(compiler, result);
+	size_t size = DataTypeSize(dataType);
+	if (resolved.locationType == RESULT_LOCATION_REGISTER)
+	{
+		RegisterGp reg = getResultRegister(compiler, &resolved);
+		if (DataTypeSize(&resolved.dataType) < size)
+			appendMoveExtended(compiler, reg, size, &resolved);
+		setResultType(compiler, &resolved, dataType);
+		return resolved;
+	}
+
+	Result moved = allocateRegister(compiler, dataType);
+	appendMoveExtended(compiler, getResultRegister(compiler, &moved), size, &resolved);
+	return moved;
+}
+
+Result prepareOperand(Compiler* compiler, const Result* result, const DataType* dataType)
+{
+	Result resolved = resolveResult(compiler, result);
+	size_t size = DataTypeSize(dataType);
+	if (resolved.locationType == RESULT_LOCATION_INT_CONSTANT)
+	{
+		// Only mov takes 64 bit immediates, the other instructions sign extend 32 bit ones.
+		int64_t value = (int64_t)resolved.location.unsignedLongLongConstant;
+		bool fitsImmediate = (size < SIZE_QWORD) || ((value >= INT32_MIN) && (value <= INT32_MAX));
+		if (fitsImmediate)
+		{
+			resolved.dataType = *dataType;
+			return resolved;
+		}
+		return moveToRegister(compiler, &resolved, dataType);
+	}
+
+	if (DataTypeSize(&resolved.dataType) < size)
+		return moveToRegister(compiler, &resolved, dataType);
+
+	setResultType(compiler, &resolved, dataType);
+	return resolved;
+}
+
+RegisterGp getResultRegister(Compiler* compiler, const Result* result)
+{
+	ASSERT(result->locationType == RESULT_LOCATION_REGISTER);
+	const RegisterValue* value = &compiler->registerValues.data[result->location.registerValueIndex];
+	ASSERT(value->isSpilled == false);
+	return value->reg;
+}
+
+void setResultType(Compiler* compiler, Result* result, const DataType* dataType)
+{
+	result->dataType = *dataType;
+	if (result->locationType == RESULT_LOCATION_REGISTER)
+		compiler->registerValues.data[result->location.registerValueIndex].dataType = *dataType;
+}
+
+void appendOperand(Compiler* compiler, const Result* result, size_t size)
+{
+	switch (result->locationType)
+	{
+		case RESULT_LOCATION_INT_CONSTANT:
+		{
+			// Written as a signed number of the size so the assembler doesn't warn about it.
+			uint64_t value = result->location.unsignedLongLongConstant;
+			long long truncated;
+			switch (size)
+			{
+				case SIZE_BYTE:  truncated = (int8_t)value; break;
+				case SIZE_WORD:  truncated = (int16_t)value; break;
+				case SIZE_DWORD: truncated = (int32_t)value; break;
+				default:         truncated = (int64_t)value; break;
+			}
+			StringAppendFormat(&compiler->textSection, "%lld", truncated);
+			break;
+		}
+
+		case RESULT_LOCATION_BASE_OFFSET:
+			StringAppendFormat(&compiler->textSection, "%s [rbp-%zu]", dataSizeToString(size), (size_t)result->location.baseOffset);
+			break;
+
+		case RESULT_LOCATION_REGISTER:
+			StringAppend(&compiler->textSection, RegisterGpToString(getResultRegister(compiler, result), size));
+			break;
+
+		default:
+			ASSERT_NOT_REACHED();
+	}
+}
+
+void appendMoveExtended(Compiler* compiler, RegisterGp reg, size_t size, const Result* result)
+{
+	size_t fromSize = DataTypeSize(&result->dataType);
+	if (result->locationType == RESULT_LOCATION_INT_CONSTANT)
+	{
+		StringAppendFormat(&compiler->textSection, "\n\tmov %s, ", RegisterGpToString(reg, size));
+		appendOperand(compiler, result, size);
+		return;
+	}
+
+	if ((result->locationType == RESULT_LOCATION_REGISTER) && (getResultRegister(compiler, result) == reg) && (fromSize >= size))
+		return;
+
+	// Taking the lower bytes of a bigger value is a plain mov and mov to a 32 bit register zero extends it.
+	if ((fromSize >= size) || (result->dataType.isUnsigned && (fromSize == SIZE_DWORD)))
+	{
+		size_t moveSize = (fromSize >= size) ? size : SIZE_DWORD;
+		StringAppendFormat(&compiler->textSection, "\n\tmov %s, ", RegisterGpToString(reg, moveSize));
+		appendOperand(compiler, result, moveSize);
+		return;
+	}
+
+	StringAppendFormat(
+		&compiler->textSection, "\n\t%s %s, ",
+		result->dataType.isUnsigned ? "movzx" : "movsx", RegisterGpToString(reg, size)
+	);
+	appendOperand(compiler, result, fromSize);
+}
+
+void freeResult(Compiler* compiler, const Result* result)
+{
+	if (result->locationType != RESULT_LOCATION_REGISTER)
+		return;
+
+	const RegisterValue* value = &compiler->registerValues.data[result->location.registerValueIndex];
+	if ((value->isSpilled == false) && (compiler->registerOwners[value->reg] == (int)result->location.registerValueIndex))
+		compiler->registerOwners[value->reg] = -1;
+}
+
+Result resolveResult(Compiler* compiler, const Result* result)
+{
+	if (result->locationType != RESULT_LOCATION_REGISTER)
+		return *result;
+
+	const RegisterValue* value = &compiler->registerValues.data[result->location.registerValueIndex];
+	if (value->isSpilled == false)
+		return *result;
+
+	Result resolved = *result;
+	resolved.locationType = RESULT_LOCATION_BASE_OFFSET;
+	resolved.location.baseOffset = value->baseOffset;
+	return resolved;
+}
+
+void spillRegisters(Compiler* compiler)
+{
+	for (int reg = 0; reg < REGISTER_GP_COUNT; reg++)
+	{
+		if (compiler->registerOwners[reg] != -1)
+			spillRegister(compiler, (RegisterGp)reg);
+	}
+}
+
+void spillRegister(Compiler* compiler, RegisterGp reg)
+{
+	RegisterValue* value = &compiler->registerValues.data[compiler->registerOwners[reg]];
+	Result stackSlot = allocateVariableOnStack(compiler, &value->dataType);
+	value->isSpilled = true;
+	value->baseOffset = stackSlot.location.baseOffset;
+	compiler->registerOwners[reg] = -1;
+
+	size_t size = DataTypeSize(&value->dataType);
+	StringAppendFormat(
+		&compiler->textSection,
+		"\n\tmov %s [rbp-%zu], %s",
+		dataSizeToString(size), (size_t)value->baseOffset, RegisterGpToString(reg, size)
+	);
+}
+
+void resetRegisters(Compiler* compiler)
+{
+	RegisterValueArrayClear(&compiler->registerValues);
+	for (int reg = 0; reg < REGISTER_GP_COUNT; reg++)
+		compiler->registerOwners[reg] = -1;
+}
+
+Result declareVariable(Compiler* compiler, SymbolId name, const DataType* dataType)
 {
 	Result result;
 	if (resolveVariable(compiler, name, &result))
@@ -1162,11 +1556,11 @@ Result declareVariable(Compiler* compiler, StringView name, const DataType* data
 	}
 }
 
-bool resolveVariable(Compiler* compiler, StringView name, Result* result)
+bool resolveVariable(Compiler* compiler, SymbolId name, Result* result)
 {
 	for (size_t i = 0; i < compiler->currentScope->variables.size; i++)
 	{
-		if (StringViewEquals(&compiler->currentScope->variables.data[i].name, &name))
+		if (compiler->currentScope->variables.data[i].name == name)
 		{
 			*result = compiler->currentScope->variables.data[i].location;
 			return true;
@@ -1175,20 +1569,15 @@ bool resolveVariable(Compiler* compiler, StringView name, Result* result)
 	return false;
 }
 
-static void copyVariable(Variable* dst, const Variable* src)
-{
-	*dst = *src;
-}
-
-ARRAY_TEMPLATE_DEFINITION(VariableArray, Variable, copyVariable, NO_OP_FUNCTION)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(VariableArray, Variable)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(RegisterValueArray, RegisterValue)
 
-void declareTypedef(Compiler* compiler, StringView name, const DataType* dataType)
+void declareTypedef(Compiler* compiler, SymbolId name, const DataType* dataType)
 {
 	for (size_t i = 0; i < compiler->typedefTable.size; i++)
 	{
-		if (StringViewEquals(&compiler->typedefTable.data[i].name, &name))
+		if (compiler->typedefTable.data[i].name == name)
 		{
-			compiler->typedefTable.data[i].name = name;
 			compiler->typedefTable.data[i].type = *dataType;
 			return;
 		}
@@ -1200,11 +1589,11 @@ void declareTypedef(Compiler* compiler, StringView name, const DataType* dataTyp
 	TypedefArrayAppend(&compiler->typedefTable, typdef);
 }
 
-bool resolveTypedef(Compiler* compiler, StringView name, DataType* dataType)
+bool resolveTypedef(Compiler* compiler, SymbolId name, DataType* dataType)
 {
 	for (size_t i = 0; i < compiler->typedefTable.size; i++)
 	{
-		if (StringViewEquals(&compiler->typedefTable.data[i].name, &name))
+		if (compiler->typedefTable.data[i].name == name)
 		{
 			*dataType = compiler->typedefTable.data[i].type;
 			return true;
@@ -1215,9 +1604,4 @@ bool resolveTypedef(Compiler* compiler, StringView name, DataType* dataType)
 	return false;
 }
 
-void copyTypedef(Typedef* dst, const Typedef* src)
-{
-	*dst = *src;
-}
-
-ARRAY_TEMPLATE_DEFINITION(TypedefArray, Typedef, copyTypedef, NO_OP_FUNCTION)
\ No newline at end of file
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(TypedefArray, Typedef)
\ No newline at end of file
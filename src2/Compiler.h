@@ -3,13 +3,14 @@
 #include "Token.h"
 #include "FileInfo.h"
 #include "Result.h"
+#include "Registers.h"
 
 #include <stdbool.h>
 #include <stdarg.h>
 
 typedef struct
 {
-	StringView name;
+	SymbolId name;
 	DataType type;
 } Typedef;
 
@@ -31,7 +32,7 @@ ARRAY_TEMPLATE_DECLARATION(TypedefArray, Typedef)
 
 typedef struct
 {
-	StringView name;
+	SymbolId name;
 	Result location;
 } Variable;
 
@@ -43,10 +44,23 @@ typedef struct Scope
 	VariableArray variables;
 } Scope;
 
+// A value an expression put in a register. Results are passed by value, so spilling the register can't change the
+// Result that refers to it. The Result keeps the index of this instead and resolveResult finds the current location.
 typedef struct
 {
+	RegisterGp reg;
+	DataType dataType;
+	bool isSpilled;
+	// Used if isSpilled
+	uintptr_t baseOffset;
+} RegisterValue;
+
+ARRAY_TEMPLATE_DECLARATION(RegisterValueArray, RegisterValue)
+
+typedef struct
+{
+	// The FileInfo of a token is found through its TokenSource.
 	const TokenArray* tokens;
-	const FileInfo* fileInfo;
 
 	size_t currentTokenIndex;
 
@@ -59,6 +73,14 @@ typedef struct
 
 	size_t stackFrameSize;
 
+	// The values put in registers since the last statement boundary.
+	RegisterValueArray registerValues;
+	// The index of the value in each register or -1 if the register is free.
+	int registerOwners[REGISTER_GP_COUNT];
+
+	// Used to make unique labels.
+	size_t labelCount;
+
 	// Used to store data types for more complex types
 	DataTypeArray dataTypes;
 
@@ -68,15 +90,18 @@ typedef struct
 
 Compiler CompilerInit(Compiler* compiler);
 void CompilerFree(Compiler* compiler);
-String CompilerCompile(Compiler* compiler, const TokenArray* tokens, const FileInfo* fileInfo);
+String CompilerCompile(Compiler* compiler, const TokenArray* tokens);
 
 void program(Compiler* compiler);
 bool checkDeclarationStart(Compiler* compiler);
+// Checks if a cast starts with the token after the paren. Typedef names aren't resolved yet.
+bool isTypeNameStart(TokenType type);
 
 Result expr(Compiler* compiler);
 // Maybe put more newline between the different kinds of expression in the c file
 Result primaryExpr(Compiler* compiler);
 bool matchConstant(Compiler* compiler);
+Result constantExpr(Compiler* compiler, Token token);
 Result groupingExpr(Compiler* compiler);
 
 Result postfixExpr(Compiler* compiler);
@@ -100,38 +125,75 @@ Result sizeofExpr(Compiler* compiler);
 
 Result castExpr(Compiler* compiler);
 
-Result multiplicativeExpr(Compiler* compiler);
-Result multiplicationExpr(Compiler* compiler, const Result* lhs);
-Result divisionExpr(Compiler* compiler, const Result* lhs);
-Result moduloExpr(Compiler* compiler, const Result* lhs);
-
-Result additiveExpr(Compiler* compiler);
-Result additionExpr(Compiler* compiler, const Result* lhs);
-Result subtractionExpr(Compiler* compiler, const Result* lhs);
-
-Result shiftExpr(Compiler* compiler);
-Result shiftLeftExpr(Compiler* compiler, const Result* lhs);
-Result shiftRightExpr(Compiler* compiler, const Result* lhs);
-
-Result relationalExpr(Compiler* compiler);
-Result lessThanExpr(Compiler* compiler, const Result* lhs);
-Result moreThanExpr(Compiler* compiler, const Result* lhs);
-Result lessThanOrEqualExpr(Compiler* compiler, const Result* lhs);
-Result moreThanOrEqualExpr(Compiler* compiler, const Result* lhs);
-
-Result equalityExpr(Compiler* compiler);
-Result equalsExpr(Compiler* compiler, const Result* lhs);
-Result notEqualsExpr(Compiler* compiler, const Result* lhs);
-
-Result bitwiseAndExpr(Compiler* compiler);
-
-Result bitwiseXorExpr(Compiler* compiler);
-
-Result bitwiseOrExpr(Compiler* compiler);
-
-Result logicalOrExpr(Compiler* compiler);
+// From lowest to highest.
+typedef enum
+{
+	PRECEDENCE_NONE,
+	PRECEDENCE_LOGICAL_OR,
+	PRECEDENCE_LOGICAL_AND,
+	PRECEDENCE_BITWISE_OR,
+	PRECEDENCE_BITWISE_XOR,
+	PRECEDENCE_BITWISE_AND,
+	PRECEDENCE_EQUALITY,
+	PRECEDENCE_RELATIONAL,
+	PRECEDENCE_SHIFT,
+	PRECEDENCE_ADDITIVE,
+	PRECEDENCE_MULTIPLICATIVE,
+} Precedence;
+
+typedef Result (*BinaryExprFunction)(Compiler* compiler, const Result* lhs, const Result* rhs);
 
-Result logicalAndExpr(Compiler* compiler);
+typedef struct
+{
+	Precedence precedence;
+	BinaryExprFunction function;
+} BinaryRule;
+
+const BinaryRule* getBinaryRule(TokenType type);
+// Parses the binary operators with precedence of at least minPrecedence.
+Result binaryExpr(Compiler* compiler, Precedence minPrecedence);
+
+// Only integer operands generate code for now.
+bool isIntegerType(const DataType* dataType);
+DataType integerType(DataTypeType type, bool isUnsigned);
+// Types smaller than int are promoted to int.
+DataType promotedType(const DataType* dataType);
+// The type both operands of an arithmetic operator are converted to.
+DataType binaryResultType(const DataType* lhs, const DataType* rhs);
+void checkIntegerOperand(Compiler* compiler, const Result* operand);
+
+// The operations take the value of lhs in a register and change it there, so a chain like a + b * c - d only moves
+// each value into a register once.
+Result integerBinaryExpr(Compiler* compiler, const char* instruction, const Result* lhs, const Result* rhs);
+Result divisionOrModuloExpr(Compiler* compiler, bool isModulo, const Result* lhs, const Result* rhs);
+Result shiftExpr(Compiler* compiler, bool isLeft, const Result* lhs, const Result* rhs);
+Result comparisonExpr(Compiler* compiler, const char* signedCondition, const char* unsignedCondition, const Result* lhs, const Result* rhs);
+Result logicalExpr(Compiler* compiler, const char* instruction, const Result* lhs, const Result* rhs);
+
+Result multiplicationExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result divisionExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result moduloExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+
+Result additionExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result subtractionExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+
+Result shiftLeftExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result shiftRightExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+
+Result lessThanExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result moreThanExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result lessThanOrEqualExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result moreThanOrEqualExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+
+Result equalsExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result notEqualsExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+
+Result bitwiseAndExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result bitwiseXorExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result bitwiseOrExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+
+Result logicalOrExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
+Result logicalAndExpr(Compiler* compiler, const Result* lhs, const Result* rhs);
 
 Result conditionalExpr(Compiler* compiler);
 
@@ -182,6 +244,7 @@ void compilerErrorAt(Compiler* compiler, Token token, const char* format, ...);
 void compilerError(Compiler* compiler, const char* format, ...);
 void advanceCompiler(Compiler* compiler);
 Token peekToken(Compiler* compiler);
+TokenType peekCompilerTokenType(Compiler* compiler);
 Token peekNextToken(Compiler* compiler);
 Token peekPreviousToken(Compiler* compiler);
 bool expectToken(Compiler* compiler, TokenType type, const char* errorMessage);
@@ -190,11 +253,41 @@ bool checkToken(Compiler* compiler, TokenType type);
 bool checkNextToken(Compiler* compiler, TokenType type);
 bool matchToken(Compiler* compiler, TokenType type);
 
-void declareTypedef(Compiler* compiler, StringView name, const DataType* dataType);
+void declareTypedef(Compiler* compiler, SymbolId name, const DataType* dataType);
 // Returns if the typedef exists
-bool resolveTypedef(Compiler* compiler, StringView name, DataType* dataType);
+bool resolveTypedef(Compiler* compiler, SymbolId name, DataType* dataType);
 
 Result allocateVariableOnStack(Compiler* compiler, const DataType* dataType);
 
-Result declareVariable(Compiler* compiler, StringView name, const DataType* dataType);
-bool resolveVariable(Compiler* compiler, StringView name, Result* result);
\ No newline at end of file
+// Returns a Result in a free register for an integer or pointer value. Chained operations can keep their
+// intermediate values in registers instead of storing and loading each one. If every register is used, the value
+// that was put in a register first is spilled, because operands are used in the reverse order they are computed.
+Result allocateRegister(Compiler* compiler, const DataType* dataType);
+// Makes the free register hold a new value.
+Result takeRegister(Compiler* compiler, RegisterGp reg, const DataType* dataType);
+// Returns the value converted to the type in a register an instruction can change. A value that already is in a
+// register is converted there, so the Result passed in can't be used after this.
+Result moveToRegister(Compiler* compiler, const Result* result, const DataType* dataType);
+// Returns the value converted to the type in a location an instruction can read it from with the size of the type.
+// Values that have to be extended and 64 bit constants that don't fit in an immediate are moved to a register.
+Result prepareOperand(Compiler* compiler, const Result* result, const DataType* dataType);
+RegisterGp getResultRegister(Compiler* compiler, const Result* result);
+// Changes the type of a value in a register, like the int made by a comparison.
+void setResultType(Compiler* compiler, Result* result, const DataType* dataType);
+// The result has to be resolved.
+void appendOperand(Compiler* compiler, const Result* result, size_t size);
+// Moves the value to the register extended to the size. The result has to be resolved.
+void appendMoveExtended(Compiler* compiler, RegisterGp reg, size_t size, const Result* result);
+// Frees the register of the Result if it is in one. Called when an operation has used its operand.
+void freeResult(Compiler* compiler, const Result* result);
+// Returns the Result with the location its value is in now.
+Result resolveResult(Compiler* compiler, const Result* result);
+// Stores the values in registers on the stack. Has to be called before branches and labels, because the code on
+// the other side doesn't know which values are in which registers.
+void spillRegisters(Compiler* compiler);
+void spillRegister(Compiler* compiler, RegisterGp reg);
+// Frees every register. The intermediate values of a statement are dead after it.
+void resetRegisters(Compiler* compiler);
+
+Result declareVariable(Compiler* compiler, SymbolId name, const DataType* dataType);
+bool resolveVariable(Compiler* compiler, SymbolId name, Result* result);
\ No newline at end of file
@@ -22,9 +22,4 @@ size_t DataTypeSize(const DataType* dataType)
 	}
 }
 
-static void copyDataType(DataType* dst, const DataType* src)
-{
-	*dst = *src;
-}
-
-ARRAY_TEMPLATE_DEFINITION(DataTypeArray, DataType, copyDataType, NO_OP_FUNCTION)
\ No newline at end of file
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(DataTypeArray, DataType)
\ No newline at end of file
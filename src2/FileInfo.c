@@ -1,6 +1,7 @@
 #include "FileInfo.h"
 #include "Assert.h"
 #include "Generic.h"
+#include "Simd.h"
 
 FileInfo FileInfoInit(FileInfo* fileInfo)
 {
@@ -13,15 +14,68 @@ void FileInfoFree(FileInfo* fileInfo)
 	SizetArrayFree(&fileInfo->lineStartOffsets);
 }
 
-StringView FileInfoGetLine(const FileInfo* fileInfo, size_t lineNumber)
+// The line start offsets are only needed for error messages so they are computed on the first use.
+void computeLineStartOffsets(FileInfo* fileInfo)
 {
-	ASSERT(lineNumber < fileInfo->lineStartOffsets.size);
+	SizetArray* lineStartOffsets = &fileInfo->lineStartOffsets;
+	const char* dataStart = fileInfo->source.chars;
+	const char* dataEnd = fileInfo->source.chars + fileInfo->source.length;
+	const char* chr = dataStart;
 
+	SizetArrayAppend(lineStartOffsets, 0);
+
+#ifdef SIMD_WIDTH
+	for (; (dataEnd - chr) >= SIMD_WIDTH; chr += SIMD_WIDTH)
+	{
+		uint32_t newlineMask = SimdMatchMask(chr, '\n');
+		while (newlineMask != 0)
+		{
+			SizetArrayAppend(lineStartOffsets, (chr - dataStart) + SimdCountTrailingZeros(newlineMask) + 1);
+			newlineMask &= newlineMask - 1;
+		}
+	}
+#endif
+
+	for (; chr < dataEnd; chr++)
+	{
+		if (*chr == '\n')
+			SizetArrayAppend(lineStartOffsets, (chr - dataStart) + 1);
+	}
 }
 
-static void copySizet(size_t* dst, const size_t* src)
+StringView FileInfoGetLine(FileInfo* fileInfo, size_t lineNumber)
 {
-	*dst = *src;
+	if (fileInfo->lineStartOffsets.size == 0)
+		computeLineStartOffsets(fileInfo);
+
+	const SizetArray* lineStartOffsets = &fileInfo->lineStartOffsets;
+	ASSERT(lineNumber < lineStartOffsets->size);
+
+	size_t lineEnd = ((lineNumber + 1) == lineStartOffsets->size)
+		? fileInfo->source.length
+		: lineStartOffsets->data[lineNumber + 1];
+	return StringViewInit(fileInfo->source.chars + lineStartOffsets->data[lineNumber], lineEnd - lineStartOffsets->data[lineNumber]);
+}
+
+size_t FileInfoGetLineNumber(FileInfo* fileInfo, size_t offset)
+{
+	if (fileInfo->lineStartOffsets.size == 0)
+		computeLineStartOffsets(fileInfo);
+
+	const SizetArray* lineStartOffsets = &fileInfo->lineStartOffsets;
+
+	// Find the last line that starts at or before the offset.
+	size_t low = 0;
+	size_t high = lineStartOffsets->size;
+	while ((high - low) > 1)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (lineStartOffsets->data[middle] <= offset)
+			low = middle;
+		else
+			high = middle;
+	}
+	return low;
 }
 
-ARRAY_TEMPLATE_DEFINITION(SizetArray, size_t, copySizet, NO_OP_FUNCTION)
\ No newline at end of file
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(SizetArray, size_t)
\ No newline at end of file
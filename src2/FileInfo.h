@@ -10,9 +10,14 @@ typedef struct
 	const char* filename;
 	StringView source;
 	// Line numbers are counted from 0.
+	// Computed when a line is first needed. Empty until then.
 	SizetArray lineStartOffsets;
 } FileInfo;
 
 FileInfo FileInfoInit(FileInfo* fileInfo);
 void FileInfoFree(FileInfo* fileInfo);
-StringView FileInfoGetLine(const FileInfo* fileInfo, size_t lineNumber);
\ No newline at end of file
+StringView FileInfoGetLine(FileInfo* fileInfo, size_t lineNumber);
+// Returns the line containing the character at offset.
+size_t FileInfoGetLineNumber(FileInfo* fileInfo, size_t offset);
+
+void computeLineStartOffsets(FileInfo* fileInfo);
\ No newline at end of file
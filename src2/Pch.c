@@ -0,0 +1,493 @@
+#include "Pch.h"
+#include "Assert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+bool PchWrite(Preprocessor* preprocessor, const char* headerPath, const char* pchPath)
+{
+	ASSERT(preprocessor->files.size == 0);
+
+	TokenArray tokens = PreprocessorPreprocess(preprocessor, headerPath);
+	// The end of file token isn't stored.
+	tokens.size--;
+
+	PchHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = PCH_MAGIC;
+	header.version = PCH_VERSION;
+
+	String buffer = StringCopy("");
+	String strings = StringCopy("");
+	uint64_t headerOffset;
+	// The header is written again at the end when the offsets are known.
+	appendSection(&buffer, &header, sizeof(header), &headerOffset);
+
+	bool isValid = true;
+	for (size_t i = 0; i < tokens.size; i++)
+	{
+		if (TokenArrayGetType(&tokens, i) == TOKEN_ERROR)
+			isValid = false;
+	}
+
+	const SourceFilePtrArray* sourceFiles = &preprocessor->files;
+	PchFile* files = calloc(sourceFiles->size, sizeof(PchFile));
+	time_t now = time(NULL);
+	for (size_t i = 0; (i < sourceFiles->size) && isValid; i++)
+	{
+		const SourceFile* sourceFile = sourceFiles->data[i];
+		PchFile* file = &files[i];
+
+		uint64_t size;
+		int64_t modificationTime;
+		// The file could have changed since it was read.
+		if ((getFileStatus(sourceFile->path.chars, &size, &modificationTime) == false) || (size != sourceFile->source.length))
+		{
+			isValid = false;
+			break;
+		}
+		// A file modified after this in the same second would have the same time, so recent files are always hashed.
+		if (modificationTime >= ((int64_t)now - 1))
+			modificationTime = INT64_MIN;
+
+		file->path = appendString(&strings, StringViewFromString(&sourceFile->path));
+		file->base = sourceFile->base;
+		file->size = (uint32_t)sourceFile->source.length;
+		file->modificationTime = modificationTime;
+		file->hash = hashContents(StringViewFromString(&sourceFile->source));
+		file->guardMacro = sourceFile->guardMacro;
+		file->isPragmaOnce = sourceFile->isPragmaOnce;
+	}
+	header.fileCount = (uint32_t)sourceFiles->size;
+	appendSection(&buffer, files, sourceFiles->size * sizeof(PchFile), &header.files);
+	free(files);
+
+	const StringViewArray* names = &preprocessor->scanner.symbols.names;
+	PchSymbol* symbols = calloc(names->size, sizeof(PchSymbol));
+	// Names are interned in the order of the source so the file is usually the same as the last one.
+	size_t fileIndex = 0;
+	for (size_t i = 0; (i < names->size) && isValid; i++)
+	{
+		StringView name = names->data[i];
+		PchSymbol* symbol = &symbols[i];
+		symbol->length = (uint32_t)name.length;
+
+		bool isInFile = false;
+		for (size_t j = 0; j < sourceFiles->size; j++)
+		{
+			const SourceFile* file = sourceFiles->data[(fileIndex + j) % sourceFiles->size];
+			if ((name.chars >= file->source.chars) && (name.chars < (file->source.chars + file->source.length)))
+			{
+				fileIndex = (fileIndex + j) % sourceFiles->size;
+				symbol->offset = file->base + (uint32_t)(name.chars - file->source.chars);
+				isInFile = true;
+				break;
+			}
+		}
+
+		if (isInFile == false)
+		{
+			PchString string = appendString(&strings, name);
+			symbol->offset = string.offset;
+			symbol->isInStrings = true;
+		}
+	}
+	header.symbolCount = (uint32_t)names->size;
+	appendSection(&buffer, symbols, names->size * sizeof(PchSymbol), &header.symbols);
+	free(symbols);
+
+	PchMacro* macros = calloc(preprocessor->macrosSize + 1, sizeof(PchMacro));
+	for (size_t i = 0; i < preprocessor->macrosSize; i++)
+	{
+		const Macro* macro = &preprocessor->macros[i];
+		if (macro->isDefined == false)
+			continue;
+
+		PchMacro* pchMacro = &macros[header.macroCount];
+		pchMacro->name = (SymbolId)i;
+		pchMacro->isFunctionLike = macro->isFunctionLike;
+		pchMacro->isVariadic = macro->isVariadic;
+		pchMacro->parameterCount = (uint32_t)macro->parameterCount;
+		pchMacro->bodyStart = (uint32_t)macro->bodyStart;
+		pchMacro->bodySize = (uint32_t)macro->bodySize;
+		header.macroCount++;
+	}
+	appendSection(&buffer, macros, header.macroCount * sizeof(PchMacro), &header.macros);
+	free(macros);
+
+	appendTokens(&buffer, &tokens, &header.tokens);
+	appendTokens(&buffer, &preprocessor->macroBodies, &header.macroBodies);
+
+	header.stringsSize = (uint32_t)strings.length;
+	appendSection(&buffer, strings.chars, strings.length, &header.strings);
+	memcpy(buffer.chars + headerOffset, &header, sizeof(header));
+
+	if (isValid)
+	{
+		FILE* file = fopen(pchPath, "wb");
+		if (file == NULL)
+		{
+			isValid = false;
+		}
+		else
+		{
+			isValid = fwrite(buffer.chars, 1, buffer.length, file) == buffer.length;
+			isValid &= fclose(file) == 0;
+			// Don't leave a truncated file.
+			if (isValid == false)
+				remove(pchPath);
+		}
+	}
+
+	StringFree(&buffer);
+	StringFree(&strings);
+	TokenArrayFree(&tokens);
+	return isValid;
+}
+
+bool PchLoad(Preprocessor* preprocessor, const char* pchPath, StringView headerPath, TokenArray* output)
+{
+	if (fileExists(pchPath) == false)
+		return false;
+
+	String data = StringFromFileMapped(pchPath);
+	const PchHeader* header = (const PchHeader*)data.chars;
+
+	if ((isSectionValid(&data, 0, 1, sizeof(PchHeader)) == false)
+		|| (header->magic != PCH_MAGIC)
+		|| (header->version != PCH_VERSION)
+		|| (header->fileCount == 0)
+		|| (isSectionValid(&data, header->strings, header->stringsSize, 1) == false)
+		|| (isSectionValid(&data, header->files, header->fileCount, sizeof(PchFile)) == false)
+		|| (isSectionValid(&data, header->symbols, header->symbolCount, sizeof(PchSymbol)) == false)
+		|| (isSectionValid(&data, header->macros, header->macroCount, sizeof(PchMacro)) == false))
+	{
+		StringFreeMapped(&data);
+		return false;
+	}
+
+	const PchFile* files = (const PchFile*)(data.chars + header->files);
+	const PchSymbol* symbols = (const PchSymbol*)(data.chars + header->symbols);
+	const PchMacro* macros = (const PchMacro*)(data.chars + header->macros);
+	size_t fileCount = header->fileCount;
+
+	String* paths = calloc(fileCount, sizeof(String));
+	String* sources = calloc(fileCount, sizeof(String));
+	uint32_t* newBases = calloc(fileCount, sizeof(uint32_t));
+	SymbolId* symbolMap = calloc((size_t)header->symbolCount + 1, sizeof(SymbolId));
+	size_t loadedCount = 0;
+
+	StringView firstPath = getPchString(&data, header, files[0].path);
+	bool isValid = (firstPath.chars != NULL) && StringViewEquals(&firstPath, &headerPath);
+
+	// The files are checked before anything is changed, so the header can still be processed normally.
+	size_t nextBase = preprocessor->nextBase;
+	for (size_t i = 0; (i < fileCount) && isValid; i++)
+	{
+		StringView path = getPchString(&data, header, files[i].path);
+		isValid = (path.chars != NULL)
+			&& (findFile(preprocessor, path) == SYMBOL_ID_NULL)
+			&& ((i == 0) || (files[i].base > (files[i - 1].base + files[i - 1].size)))
+			&& (((size_t)files[i].base + files[i].size) < UINT32_MAX)
+			&& ((nextBase + files[i].size + 1) <= UINT32_MAX);
+		if (isValid == false)
+			break;
+
+		paths[i] = StringCopy("");
+		StringAppendLen(&paths[i], path.chars, path.length);
+		loadedCount++;
+		isValid = isFileUnchanged(&files[i], paths[i].chars, &sources[i]);
+		if (isValid == false)
+		{
+			StringFree(&paths[i]);
+			loadedCount--;
+			break;
+		}
+
+		newBases[i] = (uint32_t)nextBase;
+		nextBase += files[i].size + 1;
+	}
+
+	for (size_t i = 0; (i < header->symbolCount) && isValid; i++)
+	{
+		const PchSymbol* symbol = &symbols[i];
+		if (symbol->isInStrings)
+		{
+			PchString string = { .offset = symbol->offset, .length = symbol->length };
+			StringView name = getPchString(&data, header, string);
+			isValid = (name.chars != NULL) && (SymbolTableFind(&preprocessor->scanner.symbols, name) != SYMBOL_ID_NULL);
+		}
+		else
+		{
+			size_t file = findPchFile(files, fileCount, symbol->offset);
+			isValid = (file != SIZE_MAX) && (((size_t)symbol->offset + symbol->length) <= ((size_t)files[file].base + files[file].size));
+		}
+	}
+
+	isValid = isValid
+		&& areTokensValid(&data, &header->tokens, files, fileCount, header->symbolCount, false)
+		&& areTokensValid(&data, &header->macroBodies, files, fileCount, header->symbolCount, true);
+
+	for (size_t i = 0; (i < header->macroCount) && isValid; i++)
+	{
+		const PchMacro* macro = &macros[i];
+		isValid = (macro->name < header->symbolCount)
+			&& (macro->parameterCount <= MAX_MACRO_PARAMETERS)
+			&& (((size_t)macro->bodyStart + macro->bodySize) <= header->macroBodies.size);
+
+		const uint8_t* types = (const uint8_t*)(data.chars + header->macroBodies.types);
+		const uint32_t* payloads = (const uint32_t*)(data.chars + header->macroBodies.payloads);
+		for (size_t j = macro->bodyStart; (j < ((size_t)macro->bodyStart + macro->bodySize)) && isValid; j++)
+		{
+			if (types[j] == TOKEN_MACRO_PARAMETER)
+				isValid = macro->isFunctionLike && (payloads[j] < macro->parameterCount);
+		}
+	}
+
+	if (isValid == false)
+	{
+		for (size_t i = 0; i < loadedCount; i++)
+		{
+			StringFree(&paths[i]);
+			StringFreeMapped(&sources[i]);
+		}
+	}
+	else
+	{
+		SourceFile** loadedFiles = malloc(fileCount * sizeof(SourceFile*));
+		for (size_t i = 0; i < fileCount; i++)
+		{
+			// Ownership of the path and source is passed to the file.
+			loadedFiles[i] = addFile(preprocessor, paths[i], sources[i]);
+			ASSERT(loadedFiles[i]->base == newBases[i]);
+			loadedFiles[i]->isPragmaOnce = files[i].isPragmaOnce;
+			// The files were processed as a part of this include.
+			loadedFiles[i]->includedGeneration = preprocessor->generation;
+		}
+
+		for (size_t i = 0; i < header->symbolCount; i++)
+		{
+			const PchSymbol* symbol = &symbols[i];
+			StringView name;
+			if (symbol->isInStrings)
+			{
+				PchString string = { .offset = symbol->offset, .length = symbol->length };
+				name = getPchString(&data, header, string);
+			}
+			else
+			{
+				size_t file = findPchFile(files, fileCount, symbol->offset);
+				name = StringViewInit(loadedFiles[file]->source.chars + (symbol->offset - files[file].base), symbol->length);
+			}
+			symbolMap[i] = SymbolTableIntern(&preprocessor->scanner.symbols, name);
+		}
+
+		for (size_t i = 0; i < fileCount; i++)
+		{
+			SymbolId guardMacro = files[i].guardMacro;
+			loadedFiles[i]->guardMacro = (guardMacro < header->symbolCount) ? symbolMap[guardMacro] : SYMBOL_ID_NULL;
+		}
+		free(loadedFiles);
+
+		loadTokens(&data, &header->tokens, files, fileCount, newBases, symbolMap, output);
+
+		size_t bodiesStart = preprocessor->macroBodies.size;
+		loadTokens(&data, &header->macroBodies, files, fileCount, newBases, symbolMap, &preprocessor->macroBodies);
+		for (size_t i = 0; i < header->macroCount; i++)
+		{
+			const PchMacro* pchMacro = &macros[i];
+			Macro* macro = getMacro(preprocessor, symbolMap[pchMacro->name]);
+			macro->isDefined = true;
+			macro->isFunctionLike = pchMacro->isFunctionLike;
+			macro->isVariadic = pchMacro->isVariadic;
+			macro->isExpanding = false;
+			macro->parameterCount = pchMacro->parameterCount;
+			macro->bodyStart = bodiesStart + pchMacro->bodyStart;
+			macro->bodySize = pchMacro->bodySize;
+		}
+	}
+
+	free(paths);
+	free(sources);
+	free(newBases);
+	free(symbolMap);
+	StringFreeMapped(&data);
+	return isValid;
+}
+
+#ifdef _WIN32
+
+bool getFileStatus(const char* path, uint64_t* size, int64_t* modificationTime)
+{
+	struct _stat64 status;
+	if (_stat64(path, &status) != 0)
+		return false;
+	*size = (uint64_t)status.st_size;
+	*modificationTime = (int64_t)status.st_mtime;
+	return true;
+}
+
+#else
+
+bool getFileStatus(const char* path, uint64_t* size, int64_t* modificationTime)
+{
+	struct stat status;
+	if (stat(path, &status) != 0)
+		return false;
+	*size = (uint64_t)status.st_size;
+	*modificationTime = (int64_t)status.st_mtime;
+	return true;
+}
+
+#endif
+
+// FNV-1a
+uint64_t hashContents(StringView contents)
+{
+	uint64_t hash = 0xCBF29CE484222325;
+	for (size_t i = 0; i < contents.length; i++)
+	{
+		hash ^= (uint8_t)contents.chars[i];
+		hash *= 0x100000001B3;
+	}
+	return hash;
+}
+
+size_t findPchFile(const PchFile* files, size_t fileCount, uint32_t offset)
+{
+	size_t low = 0;
+	size_t high = fileCount;
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (files[middle].base <= offset)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if ((low == 0) || (offset > ((size_t)files[low - 1].base + files[low - 1].size)))
+		return SIZE_MAX;
+	return low - 1;
+}
+
+void appendSection(String* buffer, const void* data, size_t size, uint64_t* offset)
+{
+	static const char padding[8] = { 0 };
+	StringAppendLen(buffer, padding, (8 - (buffer->length % 8)) % 8);
+	*offset = buffer->length;
+	StringAppendLen(buffer, data, size);
+}
+
+void appendTokens(String* buffer, const TokenArray* tokens, PchTokens* section)
+{
+	section->size = (uint32_t)tokens->size;
+	section->valuesSize = (uint32_t)tokens->valuesSize;
+	appendSection(buffer, tokens->types, tokens->size * sizeof(uint8_t), &section->types);
+	appendSection(buffer, tokens->offsets, tokens->size * sizeof(uint32_t), &section->offsets);
+	appendSection(buffer, tokens->payloads, tokens->size * sizeof(uint32_t), &section->payloads);
+	appendSection(buffer, tokens->values, tokens->valuesSize * sizeof(uint64_t), &section->values);
+}
+
+PchString appendString(String* strings, StringView string)
+{
+	PchString result = { .offset = (uint32_t)strings->length, .length = (uint32_t)string.length };
+	StringAppendLen(strings, string.chars, string.length);
+	return result;
+}
+
+// Sections are aligned so the items can be read from the mapped file directly.
+bool isSectionValid(const String* data, uint64_t offset, uint64_t itemCount, size_t itemSize)
+{
+	return ((offset % 8) == 0) && (offset <= data->length) && ((itemCount * itemSize) <= (data->length - offset));
+}
+
+// Returns a view with NULL chars if the string is out of bounds.
+StringView getPchString(const String* data, const PchHeader* header, PchString string)
+{
+	if (((size_t)string.offset + string.length) > header->stringsSize)
+		return StringViewInit(NULL, 0);
+	return StringViewInit(data->chars + header->strings + string.offset, string.length);
+}
+
+// The modification time is checked first so the file only has to be hashed if it was touched.
+bool isFileUnchanged(const PchFile* file, const char* path, String* source)
+{
+	uint64_t size;
+	int64_t modificationTime;
+	if ((getFileStatus(path, &size, &modificationTime) == false) || (size != file->size))
+		return false;
+
+	*source = StringFromFileMapped(path);
+	if ((source->length != file->size)
+		|| ((modificationTime != file->modificationTime) && (hashContents(StringViewFromString(source)) != file->hash)))
+	{
+		StringFreeMapped(source);
+		return false;
+	}
+	return true;
+}
+
+bool areTokensValid(const String* data, const PchTokens* section, const PchFile* files, size_t fileCount, size_t symbolCount, bool isMacroBody)
+{
+	if ((isSectionValid(data, section->types, section->size, sizeof(uint8_t)) == false)
+		|| (isSectionValid(data, section->offsets, section->size, sizeof(uint32_t)) == false)
+		|| (isSectionValid(data, section->payloads, section->size, sizeof(uint32_t)) == false)
+		|| (isSectionValid(data, section->values, section->valuesSize, sizeof(uint64_t)) == false))
+	{
+		return false;
+	}
+
+	const uint8_t* types = (const uint8_t*)(data->chars + section->types);
+	const uint32_t* offsets = (const uint32_t*)(data->chars + section->offsets);
+	const uint32_t* payloads = (const uint32_t*)(data->chars + section->payloads);
+
+	for (size_t i = 0; i < section->size; i++)
+	{
+		TokenType type = types[i];
+		if ((type >= TOKEN_MACRO_END) || ((type == TOKEN_MACRO_PARAMETER) && (isMacroBody == false)))
+			return false;
+		if ((type == TOKEN_IDENTIFIER) && (payloads[i] >= symbolCount))
+			return false;
+		if (TokenTypeIsNumberConstant(type) && (payloads[i] >= section->valuesSize))
+			return false;
+		if (findPchFile(files, fileCount, offsets[i]) == SIZE_MAX)
+			return false;
+	}
+
+	return true;
+}
+
+void loadTokens(
+	const String* data, const PchTokens* section, const PchFile* files, size_t fileCount,
+	const uint32_t* newBases, const SymbolId* symbolMap, TokenArray* output)
+{
+	const uint8_t* types = (const uint8_t*)(data->chars + section->types);
+	const uint32_t* offsets = (const uint32_t*)(data->chars + section->offsets);
+	const uint32_t* payloads = (const uint32_t*)(data->chars + section->payloads);
+	const uint64_t* values = (const uint64_t*)(data->chars + section->values);
+
+	TokenArrayReserve(output, output->size + section->size);
+
+	// Consecutive tokens are usually from the same file.
+	size_t file = 0;
+	for (size_t i = 0; i < section->size; i++)
+	{
+		TokenType type = types[i];
+		uint32_t offset = offsets[i];
+		if ((offset < files[file].base) || (offset > (files[file].base + files[file].size)))
+			file = findPchFile(files, fileCount, offset);
+		offset = offset - files[file].base + newBases[file];
+
+		if (TokenTypeIsNumberConstant(type))
+			TokenArrayAppendValue(output, type, offset, values[payloads[i]]);
+		else if (type == TOKEN_IDENTIFIER)
+			TokenArrayAppend(output, type, offset, symbolMap[payloads[i]]);
+		else
+			TokenArrayAppend(output, type, offset, payloads[i]);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Preprocessor.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A precompiled header is a snapshot of the preprocessor after processing a header: the output tokens, the defined
+// macros, the symbols they use and the files that were included. It is laid out so it can be read directly from
+// the mapped file. Offsets are from the start of the file and every section is aligned to 8 bytes.
+
+// "PCH1"
+#define PCH_MAGIC 0x31484350
+#define PCH_VERSION 1
+
+typedef struct
+{
+	// Offset into the strings.
+	uint32_t offset;
+	uint32_t length;
+} PchString;
+
+typedef struct
+{
+	// Offset in the files like the token offsets, so after loading the name points into the source like the names
+	// interned by the scanner. Names that aren't from a file, like the directive names, are stored in the strings and
+	// have to be interned already.
+	uint32_t offset;
+	uint32_t length;
+	uint32_t isInStrings;
+} PchSymbol;
+
+typedef struct
+{
+	PchString path;
+	// The base of the file when the header was processed.
+	uint32_t base;
+	uint32_t size;
+	int64_t modificationTime;
+	// Only compared if the modification time changed.
+	uint64_t hash;
+	SymbolId guardMacro;
+	uint32_t isPragmaOnce;
+} PchFile;
+
+typedef struct
+{
+	SymbolId name;
+	uint32_t isFunctionLike;
+	uint32_t isVariadic;
+	uint32_t parameterCount;
+	// Range of the macro body tokens.
+	uint32_t bodyStart;
+	uint32_t bodySize;
+} PchMacro;
+
+typedef struct
+{
+	uint32_t size;
+	uint32_t valuesSize;
+	uint64_t types;
+	uint64_t offsets;
+	uint64_t payloads;
+	uint64_t values;
+} PchTokens;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	// The first file is the header.
+	uint32_t fileCount;
+	// SymbolIds in the tokens and macros index the symbols.
+	uint32_t symbolCount;
+	uint32_t macroCount;
+	uint32_t stringsSize;
+	uint64_t files;
+	uint64_t symbols;
+	uint64_t macros;
+	uint64_t strings;
+	PchTokens tokens;
+	PchTokens macroBodies;
+} PchHeader;
+
+// The preprocessor has to be unused, so everything it contains afterwards comes from the header.
+// Returns false if the file couldn't be written.
+bool PchWrite(Preprocessor* preprocessor, const char* headerPath, const char* pchPath);
+// Appends the tokens of the header to the output and loads the macros and files. The symbols of the precompiled
+// header are interned again so the SymbolIds match the preprocessor. Returns false without changing anything
+// if the precompiled header doesn't exist, is for a different header or one of the files changed.
+bool PchLoad(Preprocessor* preprocessor, const char* pchPath, StringView headerPath, TokenArray* output);
+
+bool getFileStatus(const char* path, uint64_t* size, int64_t* modificationTime);
+uint64_t hashContents(StringView contents);
+// Returns the index of the file containing the offset or SIZE_MAX.
+size_t findPchFile(const PchFile* files, size_t fileCount, uint32_t offset);
+
+void appendSection(String* buffer, const void* data, size_t size, uint64_t* offset);
+void appendTokens(String* buffer, const TokenArray* tokens, PchTokens* section);
+PchString appendString(String* strings, StringView string);
+
+bool isSectionValid(const String* data, uint64_t offset, uint64_t itemCount, size_t itemSize);
+StringView getPchString(const String* data, const PchHeader* header, PchString string);
+bool isFileUnchanged(const PchFile* file, const char* path, String* source);
+bool areTokensValid(const String* data, const PchTokens* section, const PchFile* files, size_t fileCount, size_t symbolCount, bool isMacroBody);
+// Converts the tokens from the offset and symbol space of the precompiled header to the one of the preprocessor.
+void loadTokens(
+	const String* data, const PchTokens* section, const PchFile* files, size_t fileCount,
+	const uint32_t* newBases, const SymbolId* symbolMap, TokenArray* output);
@@ -0,0 +1,1167 @@
+#include "Preprocessor.h"
+#include "Pch.h"
+#include "Assert.h"
+#include "Generic.h"
+#include "TerminalColors.h"
+
+#include <stdlib.h>
+
+Preprocessor PreprocessorInit(Preprocessor* preprocessor)
+{
+	ScannerInit(&preprocessor->scanner);
+	SymbolTableInit(&preprocessor->paths);
+	SourceFilePtrArrayInit(&preprocessor->files);
+	preprocessor->nextBase = 0;
+	StringViewArrayInit(&preprocessor->includeDirectories);
+	preprocessor->includeDepth = 0;
+	preprocessor->generation = 0;
+	preprocessor->pchPath = NULL;
+
+	preprocessor->macros = NULL;
+	preprocessor->macrosSize = 0;
+	TokenArrayInit(&preprocessor->macroBodies);
+
+	ConditionalArrayInit(&preprocessor->conditionals);
+
+#define INTERN(name) SymbolTableIntern(&preprocessor->scanner.symbols, StringViewInit(name, sizeof(name) - 1))
+	preprocessor->defineSymbol = INTERN("define");
+	preprocessor->undefSymbol = INTERN("undef");
+	preprocessor->includeSymbol = INTERN("include");
+	preprocessor->ifdefSymbol = INTERN("ifdef");
+	preprocessor->ifndefSymbol = INTERN("ifndef");
+	preprocessor->elifSymbol = INTERN("elif");
+	preprocessor->endifSymbol = INTERN("endif");
+	preprocessor->pragmaSymbol = INTERN("pragma");
+	preprocessor->onceSymbol = INTERN("once");
+	preprocessor->errorSymbol = INTERN("error");
+	preprocessor->lineSymbol = INTERN("line");
+	preprocessor->definedSymbol = INTERN("defined");
+	preprocessor->vaArgsSymbol = INTERN("__VA_ARGS__");
+#undef INTERN
+
+	return *preprocessor;
+}
+
+void PreprocessorFree(Preprocessor* preprocessor)
+{
+	for (size_t i = 0; i < preprocessor->files.size; i++)
+	{
+		SourceFile* file = preprocessor->files.data[i];
+		StringFree(&file->path);
+		StringFree(&file->canonicalPath);
+		StringFreeMapped(&file->source);
+		FileInfoFree(&file->fileInfo);
+		if (file->isScanned)
+			TokenArrayFree(&file->tokens);
+		free(file);
+	}
+	SourceFilePtrArrayFree(&preprocessor->files);
+	SymbolTableFree(&preprocessor->paths);
+	StringViewArrayFree(&preprocessor->includeDirectories);
+	free(preprocessor->macros);
+	TokenArrayFree(&preprocessor->macroBodies);
+	ConditionalArrayFree(&preprocessor->conditionals);
+	ScannerFree(&preprocessor->scanner);
+}
+
+// The directory string isn't copied.
+void PreprocessorAddIncludeDirectory(Preprocessor* preprocessor, const char* directory)
+{
+	StringViewArrayAppend(&preprocessor->includeDirectories, StringViewInit(directory, strlen(directory)));
+}
+
+// The path isn't copied.
+void PreprocessorUsePch(Preprocessor* preprocessor, const char* pchPath)
+{
+	preprocessor->pchPath = pchPath;
+}
+
+TokenArray PreprocessorPreprocess(Preprocessor* preprocessor, const char* filename)
+{
+	preprocessor->generation++;
+	for (size_t i = 0; i < preprocessor->macrosSize; i++)
+		preprocessor->macros[i].isDefined = false;
+	TokenArrayClear(&preprocessor->macroBodies);
+	ConditionalArrayClear(&preprocessor->conditionals);
+
+	TokenArray output;
+	TokenArrayInit(&output);
+
+	SourceFile* file = loadFile(preprocessor, StringCopy(filename));
+	processFile(preprocessor, file, &output);
+	TokenArrayAppend(&output, TOKEN_EOF, file->base + file->source.length, 0);
+
+	for (size_t i = 0; i < preprocessor->files.size; i++)
+	{
+		SourceFile* source = preprocessor->files.data[i];
+		TokenArrayAddSource(&output, StringViewFromString(&source->source), source->base, &source->fileInfo);
+	}
+
+	return output;
+}
+
+SourceFile* loadFile(Preprocessor* preprocessor, String path)
+{
+	SymbolId id = findFile(preprocessor, StringViewFromString(&path));
+	if (id != SYMBOL_ID_NULL)
+	{
+		StringFree(&path);
+		return preprocessor->files.data[id];
+	}
+
+	String source = StringFromFileMapped(path.chars);
+	SourceFile* file = addFile(preprocessor, path, source);
+	scanFile(preprocessor, file);
+	return file;
+}
+
+// Takes ownership of the path and the mapped source. The file isn't scanned.
+SourceFile* addFile(Preprocessor* preprocessor, String path, String source)
+{
+	SourceFile* file = malloc(sizeof(SourceFile));
+	if (file == NULL)
+	{
+		fputs("Failed to allocate source file\n", stderr);
+		exit(1);
+	}
+
+	file->path = path;
+	file->canonicalPath = canonicalPath(StringViewFromString(&path));
+	file->source = source;
+	if (((size_t)preprocessor->nextBase + file->source.length + 1) > UINT32_MAX)
+	{
+		fprintf(stderr, "%s: translation units larger than 4GB are not supported\n", path.chars);
+		exit(1);
+	}
+	file->base = preprocessor->nextBase;
+	// + 1 so the end of file token has a different offset than the start of the next file.
+	preprocessor->nextBase += (uint32_t)file->source.length + 1;
+
+	FileInfoInit(&file->fileInfo);
+	file->fileInfo.source = StringViewFromString(&file->source);
+	file->fileInfo.filename = file->path.chars;
+	file->isScanned = false;
+	file->guardMacro = SYMBOL_ID_NULL;
+	file->isPragmaOnce = false;
+	file->includedGeneration = 0;
+
+	SymbolTableIntern(&preprocessor->paths, StringViewFromString(&file->canonicalPath));
+	SourceFilePtrArrayAppend(&preprocessor->files, file);
+	return file;
+}
+
+SymbolId findFile(Preprocessor* preprocessor, StringView path)
+{
+	String canonical = canonicalPath(path);
+	SymbolId id = SymbolTableFind(&preprocessor->paths, StringViewFromString(&canonical));
+	StringFree(&canonical);
+	return id;
+}
+
+String canonicalPath(StringView path)
+{
+	String copy = StringCopy("");
+	StringAppendLen(&copy, path.chars, path.length);
+
+#ifdef _WIN32
+	char* resolved = _fullpath(NULL, copy.chars, 0);
+#else
+	char* resolved = realpath(copy.chars, NULL);
+#endif
+	if (resolved == NULL)
+		return copy;
+
+	StringFree(&copy);
+	String canonical = StringCopy(resolved);
+	free(resolved);
+	return canonical;
+}
+
+void scanFile(Preprocessor* preprocessor, SourceFile* file)
+{
+	file->tokens = ScannerScan(&preprocessor->scanner, StringViewFromString(&file->source), file->path.chars, &file->fileInfo);
+	file->guardMacro = detectIncludeGuard(preprocessor, &file->tokens);
+	file->isScanned = true;
+}
+
+// Detects files of the form
+// #ifndef GUARD
+// #define GUARD
+// ...
+// #endif
+SymbolId detectIncludeGuard(Preprocessor* preprocessor, const TokenArray* tokens)
+{
+	if ((tokens->size < 7)
+		|| (isDirectiveStart(tokens, 0) == false)
+		|| (TokenArrayGetType(tokens, 1) != TOKEN_IDENTIFIER)
+		|| (tokens->payloads[1] != preprocessor->ifndefSymbol)
+		|| (TokenArrayGetType(tokens, 2) != TOKEN_IDENTIFIER)
+		|| (isDirectiveStart(tokens, 3) == false)
+		|| (TokenArrayGetType(tokens, 4) != TOKEN_IDENTIFIER)
+		|| (tokens->payloads[4] != preprocessor->defineSymbol)
+		|| (TokenArrayGetType(tokens, 5) != TOKEN_IDENTIFIER)
+		|| (tokens->payloads[5] != tokens->payloads[2]))
+	{
+		return SYMBOL_ID_NULL;
+	}
+
+	size_t depth = 0;
+	for (size_t index = 0; TokenArrayGetType(tokens, index) != TOKEN_EOF; index = findNextDirective(tokens, index + 1))
+	{
+		TokenType type = TokenArrayGetType(tokens, index + 1);
+		SymbolId name = (type == TOKEN_IDENTIFIER) ? tokens->payloads[index + 1] : SYMBOL_ID_NULL;
+
+		if ((type == TOKEN_IF) || (name == preprocessor->ifdefSymbol) || (name == preprocessor->ifndefSymbol))
+		{
+			depth++;
+		}
+		else if (name == preprocessor->endifSymbol)
+		{
+			depth--;
+			if (depth == 0)
+			{
+				// The #endif has to be the last line.
+				return (TokenArrayGetType(tokens, findLineEnd(tokens, index)) == TOKEN_EOF)
+					? tokens->payloads[2]
+					: SYMBOL_ID_NULL;
+			}
+		}
+		else if ((depth == 1) && ((type == TOKEN_ELSE) || (name == preprocessor->elifSymbol)))
+		{
+			return SYMBOL_ID_NULL;
+		}
+	}
+
+	return SYMBOL_ID_NULL;
+}
+
+bool fileExists(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	fclose(file);
+	return true;
+}
+
+String resolveIncludePath(Preprocessor* preprocessor, const SourceFile* includer, StringView name, bool isQuoted, uint32_t offset)
+{
+	String path;
+
+	bool isAbsolute = (name.length > 0) && ((name.chars[0] == '/') || (name.chars[0] == '\\')
+		|| ((name.length > 1) && (name.chars[1] == ':')));
+
+	if (isQuoted)
+	{
+		// Quoted includes are first searched relative to the including file.
+		size_t directoryLength = isAbsolute ? 0 : includer->path.length;
+		while ((directoryLength > 0)
+			&& (includer->path.chars[directoryLength - 1] != '/')
+			&& (includer->path.chars[directoryLength - 1] != '\\'))
+		{
+			directoryLength--;
+		}
+
+		path = StringCopy("");
+		StringAppendLen(&path, includer->path.chars, directoryLength);
+		StringAppendLen(&path, name.chars, name.length);
+		if ((findFile(preprocessor, StringViewFromString(&path)) != SYMBOL_ID_NULL) || fileExists(path.chars))
+			return path;
+		StringFree(&path);
+	}
+
+	for (size_t i = 0; (isAbsolute == false) && (i < preprocessor->includeDirectories.size); i++)
+	{
+		StringView directory = preprocessor->includeDirectories.data[i];
+		path = StringCopy("");
+		StringAppendLen(&path, directory.chars, directory.length);
+		if ((directory.length > 0) && (directory.chars[directory.length - 1] != '/') && (directory.chars[directory.length - 1] != '\\'))
+			StringAppend(&path, "/");
+		StringAppendLen(&path, name.chars, name.length);
+		if ((findFile(preprocessor, StringViewFromString(&path)) != SYMBOL_ID_NULL) || fileExists(path.chars))
+			return path;
+		StringFree(&path);
+	}
+
+	preprocessorError(preprocessor, offset, "cannot open include file '%.*s'", (int)name.length, name.chars);
+	// Not reached.
+	return StringCopy("");
+}
+
+void processFile(Preprocessor* preprocessor, SourceFile* file, TokenArray* output)
+{
+	// Files loaded from a precompiled header are only scanned if they are included again.
+	if (file->isScanned == false)
+		scanFile(preprocessor, file);
+
+	preprocessor->includeDepth++;
+	file->includedGeneration = preprocessor->generation;
+
+	const TokenArray* tokens = &file->tokens;
+	size_t conditionalBase = preprocessor->conditionals.size;
+
+	size_t index = 0;
+	while (TokenArrayGetType(tokens, index) != TOKEN_EOF)
+	{
+		if (isDirectiveStart(tokens, index))
+		{
+			index = directive(preprocessor, file, index, conditionalBase, output);
+			continue;
+		}
+
+		// Skipped groups only need to be searched for directives.
+		size_t end = findNextDirective(tokens, index);
+		if (isSkipping(preprocessor) == false)
+		{
+			TokenReader reader;
+			tokenReaderInit(&reader, tokens, index, end, file->base);
+			expandMacros(preprocessor, &reader, output);
+			tokenReaderFree(&reader);
+		}
+		index = end;
+	}
+
+	if (preprocessor->conditionals.size != conditionalBase)
+		preprocessorError(preprocessor, file->base + tokens->offsets[index], "unterminated conditional directive");
+
+	preprocessor->includeDepth--;
+}
+
+bool isDirectiveStart(const TokenArray* tokens, size_t index)
+{
+	return tokens->types[index] == (TOKEN_HASH | TOKEN_FLAG_LINE_START);
+}
+
+// Returns the index of the first token after the line of the token at index.
+size_t findLineEnd(const TokenArray* tokens, size_t index)
+{
+	index++;
+	while ((TokenArrayGetType(tokens, index) != TOKEN_EOF) && (TokenArrayIsAtLineStart(tokens, index) == false))
+		index++;
+	return index;
+}
+
+// Returns the index of the next directive or the end of file token.
+size_t findNextDirective(const TokenArray* tokens, size_t index)
+{
+	while ((tokens->types[index] != (TOKEN_HASH | TOKEN_FLAG_LINE_START)) && (tokens->types[index] != TOKEN_EOF))
+		index++;
+	return index;
+}
+
+bool isSkipping(const Preprocessor* preprocessor)
+{
+	const ConditionalArray* conditionals = &preprocessor->conditionals;
+	return (conditionals->size > 0) && (conditionals->data[conditionals->size - 1].isActive == false);
+}
+
+// Returns the index of the first token after the directive.
+size_t directive(Preprocessor* preprocessor, SourceFile* file, size_t hashIndex, size_t conditionalBase, TokenArray* output)
+{
+	const TokenArray* tokens = &file->tokens;
+	size_t lineEnd = findLineEnd(tokens, hashIndex);
+	size_t nameIndex = hashIndex + 1;
+
+	// A '#' on its own is a null directive.
+	if (nameIndex == lineEnd)
+		return lineEnd;
+
+	TokenType nameType = TokenArrayGetType(tokens, nameIndex);
+	SymbolId name = (nameType == TOKEN_IDENTIFIER) ? tokens->payloads[nameIndex] : SYMBOL_ID_NULL;
+	uint32_t nameOffset = file->base + tokens->offsets[nameIndex];
+	size_t start = nameIndex + 1;
+
+	// Conditionals are tracked in skipped groups too to find the matching #endif.
+	if ((nameType == TOKEN_IF) || (name == preprocessor->ifdefSymbol) || (name == preprocessor->ifndefSymbol))
+	{
+		if (isSkipping(preprocessor))
+		{
+			Conditional conditional = { .isActive = false, .wasTaken = true, .hadElse = false };
+			ConditionalArrayAppend(&preprocessor->conditionals, conditional);
+			return lineEnd;
+		}
+
+		bool isTrue;
+		if (nameType == TOKEN_IF)
+		{
+			isTrue = evaluateCondition(preprocessor, file, start, lineEnd);
+		}
+		else
+		{
+			if ((start == lineEnd) || (TokenArrayGetType(tokens, start) != TOKEN_IDENTIFIER))
+				preprocessorError(preprocessor, nameOffset, "expected macro name");
+			isTrue = (findMacro(preprocessor, tokens->payloads[start]) != NULL) == (name == preprocessor->ifdefSymbol);
+		}
+
+		Conditional conditional = { .isActive = isTrue, .wasTaken = isTrue, .hadElse = false };
+		ConditionalArrayAppend(&preprocessor->conditionals, conditional);
+		return lineEnd;
+	}
+
+	if ((nameType == TOKEN_ELSE) || (name == preprocessor->elifSymbol) || (name == preprocessor->endifSymbol))
+	{
+		if (preprocessor->conditionals.size == conditionalBase)
+			preprocessorError(preprocessor, nameOffset, "conditional directive without #if");
+
+		if (name == preprocessor->endifSymbol)
+		{
+			preprocessor->conditionals.size--;
+			return lineEnd;
+		}
+
+		Conditional* conditional = &preprocessor->conditionals.data[preprocessor->conditionals.size - 1];
+		if (conditional->hadElse)
+			preprocessorError(preprocessor, nameOffset, "conditional directive after #else");
+
+		if (nameType == TOKEN_ELSE)
+		{
+			conditional->hadElse = true;
+			conditional->isActive = conditional->wasTaken == false;
+		}
+		else if (conditional->wasTaken)
+		{
+			conditional->isActive = false;
+		}
+		else
+		{
+			conditional->isActive = evaluateCondition(preprocessor, file, start, lineEnd);
+		}
+		conditional->wasTaken |= conditional->isActive;
+		return lineEnd;
+	}
+
+	if (isSkipping(preprocessor))
+		return lineEnd;
+
+	if (name == preprocessor->defineSymbol)
+	{
+		defineDirective(preprocessor, file, start, lineEnd);
+	}
+	else if (name == preprocessor->undefSymbol)
+	{
+		if ((start == lineEnd) || (TokenArrayGetType(tokens, start) != TOKEN_IDENTIFIER))
+			preprocessorError(preprocessor, nameOffset, "macro name must be an identifier");
+
+		Macro* macro = findMacro(preprocessor, tokens->payloads[start]);
+		if (macro != NULL)
+			macro->isDefined = false;
+	}
+	else if (name == preprocessor->includeSymbol)
+	{
+		includeDirective(preprocessor, file, start, lineEnd, output);
+	}
+	else if (name == preprocessor->pragmaSymbol)
+	{
+		// Other pragmas are ignored.
+		if ((start < lineEnd) && (TokenArrayGetType(tokens, start) == TOKEN_IDENTIFIER) && (tokens->payloads[start] == preprocessor->onceSymbol))
+			file->isPragmaOnce = true;
+	}
+	else if (name == preprocessor->errorSymbol)
+	{
+		const char* message = file->source.chars + tokens->offsets[nameIndex];
+		const char* messageEnd = message;
+		while ((*messageEnd != '\n') && (*messageEnd != '\r') && (*messageEnd != '\0'))
+			messageEnd++;
+		preprocessorError(preprocessor, nameOffset, "#%.*s", (int)(messageEnd - message), message);
+	}
+	else if (name == preprocessor->lineSymbol)
+	{
+		// Line numbers are always taken from the source.
+	}
+	else
+	{
+		preprocessorError(preprocessor, nameOffset, "invalid preprocessing directive");
+	}
+
+	return lineEnd;
+}
+
+void defineDirective(Preprocessor* preprocessor, SourceFile* file, size_t start, size_t end)
+{
+	const TokenArray* tokens = &file->tokens;
+
+	if ((start == end) || (TokenArrayGetType(tokens, start) != TOKEN_IDENTIFIER))
+		preprocessorError(preprocessor, file->base + tokens->offsets[start - 1], "macro name must be an identifier");
+
+	SymbolId name = tokens->payloads[start];
+	uint32_t nameOffset = file->base + tokens->offsets[start];
+	SymbolId parameters[MAX_MACRO_PARAMETERS];
+	size_t parameterCount = 0;
+	bool isFunctionLike = false;
+	bool isVariadic = false;
+	size_t index = start + 1;
+
+	// The macro is function-like only if there is no whitespace between the name and the '('.
+	size_t nameEnd = tokens->offsets[start] + SymbolTableGetName(&preprocessor->scanner.symbols, name).length;
+	if ((index < end) && (TokenArrayGetType(tokens, index) == TOKEN_LEFT_PAREN) && (tokens->offsets[index] == nameEnd))
+	{
+		isFunctionLike = true;
+		index++;
+
+		if ((index < end) && (TokenArrayGetType(tokens, index) == TOKEN_RIGHT_PAREN))
+		{
+			index++;
+		}
+		else
+		{
+			for (;;)
+			{
+				if (index >= end)
+					preprocessorError(preprocessor, nameOffset, "expected ')' in macro parameter list");
+
+				TokenType type = TokenArrayGetType(tokens, index);
+				uint32_t offset = file->base + tokens->offsets[index];
+				SymbolId parameter;
+				if (type == TOKEN_DOT_DOT_DOT)
+				{
+					isVariadic = true;
+					parameter = preprocessor->vaArgsSymbol;
+				}
+				else if (type == TOKEN_IDENTIFIER)
+				{
+					parameter = tokens->payloads[index];
+				}
+				else
+				{
+					preprocessorError(preprocessor, offset, "expected parameter name");
+				}
+
+				if (parameterCount == MAX_MACRO_PARAMETERS)
+					preprocessorError(preprocessor, offset, "too many macro parameters");
+				parameters[parameterCount] = parameter;
+				parameterCount++;
+				index++;
+
+				if ((index < end) && (TokenArrayGetType(tokens, index) == TOKEN_RIGHT_PAREN))
+				{
+					index++;
+					break;
+				}
+				if (isVariadic || (index >= end) || (TokenArrayGetType(tokens, index) != TOKEN_COMMA))
+					preprocessorError(preprocessor, offset, "expected ')' in macro parameter list");
+				index++;
+			}
+		}
+	}
+
+	Macro* macro = getMacro(preprocessor, name);
+	macro->isDefined = true;
+	macro->isFunctionLike = isFunctionLike;
+	macro->isVariadic = isVariadic;
+	macro->isExpanding = false;
+	macro->parameterCount = parameterCount;
+	macro->bodyStart = preprocessor->macroBodies.size;
+
+	for (; index < end; index++)
+	{
+		RawToken token = getRawToken(tokens, index, file->base);
+
+		if ((token.type == TOKEN_HASH_HASH) || (isFunctionLike && (token.type == TOKEN_HASH)))
+			preprocessorError(preprocessor, token.offset, "the '#' and '##' operators are not supported");
+
+		if (isFunctionLike && (token.type == TOKEN_IDENTIFIER))
+		{
+			for (size_t i = 0; i < parameterCount; i++)
+			{
+				if (parameters[i] == token.payload)
+				{
+					token.type = TOKEN_MACRO_PARAMETER;
+					token.payload = (uint32_t)i;
+					break;
+				}
+			}
+		}
+
+		appendRawToken(&preprocessor->macroBodies, token);
+	}
+
+	macro->bodySize = preprocessor->macroBodies.size - macro->bodyStart;
+}
+
+void includeDirective(Preprocessor* preprocessor, SourceFile* file, size_t start, size_t end, TokenArray* output)
+{
+	const TokenArray* tokens = &file->tokens;
+	uint32_t directiveOffset = file->base + tokens->offsets[start - 1];
+
+	StringView name;
+	bool isQuoted;
+	TokenType type = (start < end) ? TokenArrayGetType(tokens, start) : TOKEN_EOF;
+	if (type == TOKEN_STRING_LITERAL)
+	{
+		Token token = TokenArrayGet(tokens, start);
+		// Skip the quotes.
+		name = StringViewInit(token.text.chars + 1, token.text.length - 2);
+		isQuoted = true;
+	}
+	else if (type == TOKEN_LESS)
+	{
+		// The name isn't a token so it is taken from the source between the angle brackets.
+		size_t closing = start + 1;
+		while ((closing < end) && (TokenArrayGetType(tokens, closing) != TOKEN_MORE))
+			closing++;
+		if (closing == end)
+			preprocessorError(preprocessor, directiveOffset, "expected '>'");
+
+		const char* nameStart = file->source.chars + tokens->offsets[start] + 1;
+		name = StringViewInit(nameStart, (file->source.chars + tokens->offsets[closing]) - nameStart);
+		isQuoted = false;
+	}
+	else
+	{
+		preprocessorError(preprocessor, directiveOffset, "expected \"file\" or <file>");
+	}
+
+	String path = resolveIncludePath(preprocessor, file, name, isQuoted, directiveOffset);
+	if (canUsePch(preprocessor, output) && PchLoad(preprocessor, preprocessor->pchPath, StringViewFromString(&path), output))
+	{
+		StringFree(&path);
+		return;
+	}
+	SourceFile* included = loadFile(preprocessor, path);
+
+	// The tokens are cached so files are never read twice, but guarded files don't need to be processed either.
+	if (included->isPragmaOnce && (included->includedGeneration == preprocessor->generation))
+		return;
+	if ((included->guardMacro != SYMBOL_ID_NULL) && (findMacro(preprocessor, included->guardMacro) != NULL))
+		return;
+
+	if (preprocessor->includeDepth >= MAX_INCLUDE_DEPTH)
+		preprocessorError(preprocessor, directiveOffset, "#include nested too deeply");
+
+	processFile(preprocessor, included, output);
+}
+
+// The precompiled header stores the state after processing the header alone, so it can only replace an include
+// that happens before anything else.
+bool canUsePch(const Preprocessor* preprocessor, const TokenArray* output)
+{
+	if ((preprocessor->pchPath == NULL) || (preprocessor->includeDepth != 1) || (output->size != 0))
+		return false;
+
+	for (size_t i = 0; i < preprocessor->macrosSize; i++)
+	{
+		if (preprocessor->macros[i].isDefined)
+			return false;
+	}
+	return true;
+}
+
+bool evaluateCondition(Preprocessor* preprocessor, SourceFile* file, size_t start, size_t end)
+{
+	const TokenArray* tokens = &file->tokens;
+	uint32_t directiveOffset = file->base + tokens->offsets[start - 1];
+
+	if (start == end)
+		preprocessorError(preprocessor, directiveOffset, "expected expression");
+
+	// The operands of defined mustn't be expanded so they are replaced before the macros are expanded.
+	TokenArray condition;
+	TokenArrayInit(&condition);
+	for (size_t i = start; i < end; i++)
+	{
+		RawToken token = getRawToken(tokens, i, file->base);
+
+		if ((token.type == TOKEN_IDENTIFIER) && (token.payload == preprocessor->definedSymbol))
+		{
+			bool hasParen = ((i + 1) < end) && (TokenArrayGetType(tokens, i + 1) == TOKEN_LEFT_PAREN);
+			size_t nameIndex = hasParen ? i + 2 : i + 1;
+			if ((nameIndex >= end) || (TokenArrayGetType(tokens, nameIndex) != TOKEN_IDENTIFIER))
+				preprocessorError(preprocessor, token.offset, "expected macro name after 'defined'");
+			if (hasParen && (((nameIndex + 1) >= end) || (TokenArrayGetType(tokens, nameIndex + 1) != TOKEN_RIGHT_PAREN)))
+				preprocessorError(preprocessor, token.offset, "expected ')' after 'defined'");
+
+			token.type = TOKEN_INT_CONSTANT;
+			token.value = findMacro(preprocessor, tokens->payloads[nameIndex]) != NULL;
+			i = hasParen ? nameIndex + 1 : nameIndex;
+		}
+
+		appendRawToken(&condition, token);
+	}
+
+	TokenArray expanded;
+	TokenArrayInit(&expanded);
+	TokenReader reader;
+	tokenReaderInit(&reader, &condition, 0, condition.size, 0);
+	expandMacros(preprocessor, &reader, &expanded);
+	tokenReaderFree(&reader);
+
+	tokenReaderInit(&reader, &expanded, 0, expanded.size, 0);
+	reader.lastOffset = directiveOffset;
+	ConditionValue value = conditionTernary(preprocessor, &reader, true);
+	if (peekTokenType(&reader) != TOKEN_EOF)
+		preprocessorError(preprocessor, reader.lastOffset, "expected end of expression");
+	tokenReaderFree(&reader);
+
+	TokenArrayFree(&condition);
+	TokenArrayFree(&expanded);
+	return value.value != 0;
+}
+
+ConditionValue conditionTernary(Preprocessor* preprocessor, TokenReader* reader, bool isEvaluated)
+{
+	ConditionValue condition = conditionBinary(preprocessor, reader, 1, isEvaluated);
+	if (peekTokenType(reader) != TOKEN_QUESTION)
+		return condition;
+
+	RawToken token;
+	readToken(preprocessor, reader, &token);
+	bool isTrue = condition.value != 0;
+	ConditionValue trueValue = conditionTernary(preprocessor, reader, isEvaluated && isTrue);
+	if ((readToken(preprocessor, reader, &token) == false) || (token.type != TOKEN_COLON))
+		preprocessorError(preprocessor, reader->lastOffset, "expected ':'");
+	ConditionValue falseValue = conditionTernary(preprocessor, reader, isEvaluated && (isTrue == false));
+
+	// The result has the common type of both arms.
+	ConditionValue result = isTrue ? trueValue : falseValue;
+	result.isUnsigned = trueValue.isUnsigned || falseValue.isUnsigned;
+	return result;
+}
+
+// Returns 0 if the token isn't a binary operator.
+int binaryOperatorPrecedence(TokenType type)
+{
+	switch (type)
+	{
+		case TOKEN_OR_OR: return 1;
+		case TOKEN_AND_AND: return 2;
+		case TOKEN_OR: return 3;
+		case TOKEN_XOR: return 4;
+		case TOKEN_AND: return 5;
+		case TOKEN_EQUALS_EQUALS:
+		case TOKEN_BANG_EQUALS: return 6;
+		case TOKEN_LESS:
+		case TOKEN_LESS_EQUALS:
+		case TOKEN_MORE:
+		case TOKEN_MORE_EQUALS: return 7;
+		case TOKEN_SHIFT_LEFT:
+		case TOKEN_SHIFT_RIGHT: return 8;
+		case TOKEN_PLUS:
+		case TOKEN_MINUS: return 9;
+		case TOKEN_STAR:
+		case TOKEN_SLASH:
+		case TOKEN_PERCENT: return 10;
+		default: return 0;
+	}
+}
+
+ConditionValue signedConditionValue(int64_t value)
+{
+	ConditionValue result = { .value = (uint64_t)value, .isUnsigned = false };
+	return result;
+}
+
+ConditionValue conditionBinary(Preprocessor* preprocessor, TokenReader* reader, int minPrecedence, bool isEvaluated)
+{
+	ConditionValue lhs = conditionUnary(preprocessor, reader, isEvaluated);
+
+	for (;;)
+	{
+		TokenType operator = peekTokenType(reader);
+		int precedence = binaryOperatorPrecedence(operator);
+		if ((precedence == 0) || (precedence < minPrecedence))
+			return lhs;
+
+		RawToken token;
+		readToken(preprocessor, reader, &token);
+
+		// The right side isn't evaluated if the left side decides the result.
+		bool isRhsEvaluated = isEvaluated;
+		if (operator == TOKEN_OR_OR)
+			isRhsEvaluated = isEvaluated && (lhs.value == 0);
+		else if (operator == TOKEN_AND_AND)
+			isRhsEvaluated = isEvaluated && (lhs.value != 0);
+		ConditionValue rhs = conditionBinary(preprocessor, reader, precedence + 1, isRhsEvaluated);
+
+		// The usual arithmetic conversions. Shifts have the type of the left operand.
+		bool isUnsigned = lhs.isUnsigned || rhs.isUnsigned;
+		uint64_t a = lhs.value;
+		uint64_t b = rhs.value;
+
+		switch (operator)
+		{
+			case TOKEN_OR_OR: lhs = signedConditionValue((a != 0) || (b != 0)); break;
+			case TOKEN_AND_AND: lhs = signedConditionValue((a != 0) && (b != 0)); break;
+			case TOKEN_EQUALS_EQUALS: lhs = signedConditionValue(a == b); break;
+			case TOKEN_BANG_EQUALS: lhs = signedConditionValue(a != b); break;
+			case TOKEN_LESS: lhs = signedConditionValue(isUnsigned ? (a < b) : ((int64_t)a < (int64_t)b)); break;
+			case TOKEN_LESS_EQUALS: lhs = signedConditionValue(isUnsigned ? (a <= b) : ((int64_t)a <= (int64_t)b)); break;
+			case TOKEN_MORE: lhs = signedConditionValue(isUnsigned ? (a > b) : ((int64_t)a > (int64_t)b)); break;
+			case TOKEN_MORE_EQUALS: lhs = signedConditionValue(isUnsigned ? (a >= b) : ((int64_t)a >= (int64_t)b)); break;
+
+			case TOKEN_SHIFT_LEFT:
+				lhs.value = a << (b & 63);
+				break;
+			case TOKEN_SHIFT_RIGHT:
+				lhs.value = lhs.isUnsigned ? (a >> (b & 63)) : (uint64_t)((int64_t)a >> (b & 63));
+				break;
+
+			case TOKEN_OR: lhs.value = a | b; lhs.isUnsigned = isUnsigned; break;
+			case TOKEN_XOR: lhs.value = a ^ b; lhs.isUnsigned = isUnsigned; break;
+			case TOKEN_AND: lhs.value = a & b; lhs.isUnsigned = isUnsigned; break;
+			case TOKEN_PLUS: lhs.value = a + b; lhs.isUnsigned = isUnsigned; break;
+			case TOKEN_MINUS: lhs.value = a - b; lhs.isUnsigned = isUnsigned; break;
+			case TOKEN_STAR: lhs.value = a * b; lhs.isUnsigned = isUnsigned; break;
+
+			case TOKEN_SLASH:
+			case TOKEN_PERCENT:
+				lhs.isUnsigned = isUnsigned;
+				if (b == 0)
+				{
+					if (isEvaluated)
+						preprocessorError(preprocessor, token.offset, "division by zero in #if");
+					lhs.value = 0;
+				}
+				else if (isUnsigned)
+				{
+					lhs.value = (operator == TOKEN_SLASH) ? a / b : a % b;
+				}
+				// The quotient doesn't fit and x86 traps on it like on division by zero.
+				else if (((int64_t)a == INT64_MIN) && ((int64_t)b == -1))
+				{
+					if (isEvaluated)
+						preprocessorError(preprocessor, token.offset, "integer overflow in #if");
+					lhs.value = (operator == TOKEN_SLASH) ? a : 0;
+				}
+				else
+				{
+					lhs.value = (uint64_t)((operator == TOKEN_SLASH) ? (int64_t)a / (int64_t)b : (int64_t)a % (int64_t)b);
+				}
+				break;
+
+			default:
+				ASSERT_NOT_REACHED();
+		}
+	}
+}
+
+ConditionValue conditionUnary(Preprocessor* preprocessor, TokenReader* reader, bool isEvaluated)
+{
+	RawToken token;
+	if (readToken(preprocessor, reader, &token) == false)
+		preprocessorError(preprocessor, reader->lastOffset, "expected expression");
+
+	switch (token.type)
+	{
+		case TOKEN_PLUS: return conditionUnary(preprocessor, reader, isEvaluated);
+
+		case TOKEN_MINUS:
+		{
+			ConditionValue value = conditionUnary(preprocessor, reader, isEvaluated);
+			value.value = 0 - value.value;
+			return value;
+		}
+
+		case TOKEN_TILDE:
+		{
+			ConditionValue value = conditionUnary(preprocessor, reader, isEvaluated);
+			value.value = ~value.value;
+			return value;
+		}
+
+		case TOKEN_BANG: return signedConditionValue(conditionUnary(preprocessor, reader, isEvaluated).value == 0);
+
+		case TOKEN_LEFT_PAREN:
+		{
+			ConditionValue value = conditionTernary(preprocessor, reader, isEvaluated);
+			if ((readToken(preprocessor, reader, &token) == false) || (token.type != TOKEN_RIGHT_PAREN))
+				preprocessorError(preprocessor, reader->lastOffset, "expected ')'");
+			return value;
+		}
+
+		case TOKEN_INT_CONSTANT:
+		case TOKEN_LONG_CONSTANT:
+		case TOKEN_LONG_LONG_CONSTANT:
+		{
+			// A constant that doesn't fit in intmax_t is converted to uintmax_t.
+			ConditionValue value = { .value = token.value, .isUnsigned = token.value > INT64_MAX };
+			return value;
+		}
+
+		case TOKEN_UNSIGNED_INT_CONSTANT:
+		case TOKEN_UNSIGNED_LONG_CONSTANT:
+		case TOKEN_UNSIGNED_LONG_LONG_CONSTANT:
+		{
+			ConditionValue value = { .value = token.value, .isUnsigned = true };
+			return value;
+		}
+
+		// Identifiers that are left after expanding macros are replaced with 0. This includes keywords.
+		case TOKEN_IDENTIFIER:
+			return signedConditionValue(0);
+
+		default:
+			if ((token.type >= TOKEN_AUTO) && (token.type <= TOKEN_WHILE))
+				return signedConditionValue(0);
+			preprocessorError(preprocessor, token.offset, "invalid token in #if");
+			return signedConditionValue(0);
+	}
+}
+
+// Returns NULL if the macro isn't defined.
+Macro* findMacro(Preprocessor* preprocessor, SymbolId name)
+{
+	if ((name < preprocessor->macrosSize) && preprocessor->macros[name].isDefined)
+		return &preprocessor->macros[name];
+	return NULL;
+}
+
+Macro* getMacro(Preprocessor* preprocessor, SymbolId name)
+{
+	if (name >= preprocessor->macrosSize)
+	{
+		size_t newSize = (preprocessor->macrosSize == 0) ? 64 : preprocessor->macrosSize;
+		while (newSize <= name)
+			newSize *= 2;
+
+		Macro* newMacros = realloc(preprocessor->macros, newSize * sizeof(Macro));
+		if (newMacros == NULL)
+		{
+			fputs("Failed to reallocate macros\n", stderr);
+			exit(1);
+		}
+		memset(newMacros + preprocessor->macrosSize, 0, (newSize - preprocessor->macrosSize) * sizeof(Macro));
+		preprocessor->macros = newMacros;
+		preprocessor->macrosSize = newSize;
+	}
+
+	return &preprocessor->macros[name];
+}
+
+// The expansion of a macro is pushed back onto the reader and rescanned together with the rest of the tokens, so
+// a function-like macro name at the end of an expansion can take its arguments from after the invocation.
+void expandMacros(Preprocessor* preprocessor, TokenReader* reader, TokenArray* output)
+{
+	RawToken token;
+	while (readToken(preprocessor, reader, &token))
+	{
+		Macro* macro = (token.type == TOKEN_IDENTIFIER) ? findMacro(preprocessor, token.payload) : NULL;
+		if ((macro == NULL) || macro->isExpanding)
+		{
+			appendRawToken(output, token);
+			continue;
+		}
+
+		if (macro->isFunctionLike)
+		{
+			// The name of a function-like macro that isn't followed by '(' isn't an invocation.
+			if (peekTokenType(reader) != TOKEN_LEFT_PAREN)
+			{
+				appendRawToken(output, token);
+				continue;
+			}
+			expandFunctionLikeMacro(preprocessor, reader, token.payload, token.offset);
+			continue;
+		}
+
+		RawToken end = { .type = TOKEN_MACRO_END, .offset = token.offset, .payload = token.payload, .value = 0 };
+		appendRawToken(&reader->pending, end);
+		pushTokens(reader, &preprocessor->macroBodies, macro->bodyStart, macro->bodyStart + macro->bodySize);
+		macro->isExpanding = true;
+	}
+}
+
+void expandFunctionLikeMacro(Preprocessor* preprocessor, TokenReader* reader, SymbolId name, uint32_t nameOffset)
+{
+	Macro* macro = &preprocessor->macros[name];
+	StringView nameText = SymbolTableGetName(&preprocessor->scanner.symbols, name);
+
+	RawToken token;
+	// Skip the '('.
+	readToken(preprocessor, reader, &token);
+
+	TokenArray arguments;
+	TokenArrayInit(&arguments);
+	// Pairs of start and end indices into the arguments.
+	SizetArray argumentBounds;
+	SizetArrayInit(&argumentBounds);
+
+	size_t argumentStart = 0;
+	size_t depth = 0;
+	for (;;)
+	{
+		if (readToken(preprocessor, reader, &token) == false)
+			preprocessorError(preprocessor, nameOffset, "unterminated invocation of macro '%.*s'", (int)nameText.length, nameText.chars);
+
+		if (token.type == TOKEN_LEFT_PAREN)
+		{
+			depth++;
+		}
+		else if (token.type == TOKEN_RIGHT_PAREN)
+		{
+			if (depth == 0)
+				break;
+			depth--;
+		}
+		// The commas in the variadic arguments don't separate arguments.
+		else if ((token.type == TOKEN_COMMA) && (depth == 0)
+			&& ((macro->isVariadic == false) || (((argumentBounds.size / 2) + 1) < macro->parameterCount)))
+		{
+			SizetArrayAppend(&argumentBounds, argumentStart);
+			SizetArrayAppend(&argumentBounds, arguments.size);
+			argumentStart = arguments.size;
+			continue;
+		}
+
+		appendRawToken(&arguments, token);
+	}
+	SizetArrayAppend(&argumentBounds, argumentStart);
+	SizetArrayAppend(&argumentBounds, arguments.size);
+
+	size_t argumentCount = argumentBounds.size / 2;
+	// "()" is a single empty argument.
+	if ((macro->parameterCount == 0) && (argumentCount == 1) && (arguments.size == 0))
+		argumentCount = 0;
+	// The variadic arguments can be left out.
+	if (macro->isVariadic && ((argumentCount + 1) == macro->parameterCount))
+	{
+		SizetArrayAppend(&argumentBounds, arguments.size);
+		SizetArrayAppend(&argumentBounds, arguments.size);
+		argumentCount++;
+	}
+	if (argumentCount != macro->parameterCount)
+	{
+		preprocessorError(
+			preprocessor, nameOffset, "macro '%.*s' takes %zu arguments but %zu were given",
+			(int)nameText.length, nameText.chars, macro->parameterCount, argumentCount
+		);
+	}
+
+	TokenArray substituted;
+	TokenArrayInit(&substituted);
+	for (size_t i = macro->bodyStart; i < (macro->bodyStart + macro->bodySize); i++)
+	{
+		if (TokenArrayGetType(&preprocessor->macroBodies, i) != TOKEN_MACRO_PARAMETER)
+		{
+			appendRawToken(&substituted, getRawToken(&preprocessor->macroBodies, i, 0));
+			continue;
+		}
+
+		// Arguments are fully expanded before they are substituted.
+		size_t parameter = preprocessor->macroBodies.payloads[i];
+		TokenReader argumentReader;
+		tokenReaderInit(&argumentReader, &arguments, argumentBounds.data[parameter * 2], argumentBounds.data[parameter * 2 + 1], 0);
+		expandMacros(preprocessor, &argumentReader, &substituted);
+		tokenReaderFree(&argumentReader);
+	}
+
+	RawToken end = { .type = TOKEN_MACRO_END, .offset = nameOffset, .payload = name, .value = 0 };
+	appendRawToken(&reader->pending, end);
+	pushTokens(reader, &substituted, 0, substituted.size);
+	macro->isExpanding = true;
+
+	TokenArrayFree(&substituted);
+	TokenArrayFree(&arguments);
+	SizetArrayFree(&argumentBounds);
+}
+
+void tokenReaderInit(TokenReader* reader, const TokenArray* tokens, size_t start, size_t end, uint32_t base)
+{
+	reader->tokens = tokens;
+	reader->index = start;
+	reader->end = end;
+	reader->base = base;
+	reader->lastOffset = 0;
+	TokenArrayInit(&reader->pending);
+}
+
+void tokenReaderFree(TokenReader* reader)
+{
+	TokenArrayFree(&reader->pending);
+}
+
+bool readToken(Preprocessor* preprocessor, TokenReader* reader, RawToken* token)
+{
+	while (reader->pending.size > 0)
+	{
+		*token = getRawToken(&reader->pending, reader->pending.size - 1, 0);
+		reader->pending.size--;
+		// Resets the values too.
+		if (reader->pending.size == 0)
+			TokenArrayClear(&reader->pending);
+
+		if (token->type == TOKEN_MACRO_END)
+		{
+			preprocessor->macros[token->payload].isExpanding = false;
+			continue;
+		}
+
+		reader->lastOffset = token->offset;
+		return true;
+	}
+
+	if (reader->index >= reader->end)
+		return false;
+
+	*token = getRawToken(reader->tokens, reader->index, reader->base);
+	reader->index++;
+	reader->lastOffset = token->offset;
+	return true;
+}
+
+TokenType peekTokenType(const TokenReader* reader)
+{
+	for (size_t i = reader->pending.size; i > 0; i--)
+	{
+		TokenType type = TokenArrayGetType(&reader->pending, i - 1);
+		if (type != TOKEN_MACRO_END)
+			return type;
+	}
+
+	if (reader->index >= reader->end)
+		return TOKEN_EOF;
+	return TokenArrayGetType(reader->tokens, reader->index);
+}
+
+void pushTokens(TokenReader* reader, const TokenArray* tokens, size_t start, size_t end)
+{
+	for (size_t i = end; i > start; i--)
+		appendRawToken(&reader->pending, getRawToken(tokens, i - 1, 0));
+}
+
+RawToken getRawToken(const TokenArray* tokens, size_t index, uint32_t base)
+{
+	RawToken token;
+	token.type = TokenArrayGetType(tokens, index);
+	token.offset = base + tokens->offsets[index];
+	token.payload = tokens->payloads[index];
+	token.value = TokenTypeIsNumberConstant(token.type) ? TokenArrayGetValue(tokens, index) : 0;
+	return token;
+}
+
+void appendRawToken(TokenArray* tokens, RawToken token)
+{
+	if (TokenTypeIsNumberConstant(token.type))
+		TokenArrayAppendValue(tokens, token.type, token.offset, token.value);
+	else
+		TokenArrayAppend(tokens, token.type, token.offset, token.payload);
+}
+
+void preprocessorError(Preprocessor* preprocessor, uint32_t offset, const char* format, ...)
+{
+	// The files are sorted by base.
+	SourceFile* file = preprocessor->files.data[0];
+	for (size_t i = 1; (i < preprocessor->files.size) && (preprocessor->files.data[i]->base <= offset); i++)
+		file = preprocessor->files.data[i];
+
+	size_t localOffset = offset - file->base;
+	size_t line = FileInfoGetLineNumber(&file->fileInfo, localOffset);
+	size_t column = localOffset - file->fileInfo.lineStartOffsets.data[line];
+
+	fprintf(
+		stderr,
+		"%s:%zu:%zu: " TERM_COL_RED "error: " TERM_COL_RESET,
+		file->path.chars, line + 1, column
+	);
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+
+	fprintf(stderr, "\n");
+
+	exit(1);
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(SourceFilePtrArray, SourceFile*)
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(ConditionalArray, Conditional)
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "Scanner.h"
+#include "Token.h"
+#include "Symbol.h"
+#include "String.h"
+
+#include <stdarg.h>
+
+// Every file is read and scanned only once. Later includes reuse the tokens.
+typedef struct
+{
+	String path;
+	// The absolute path with symbolic links resolved. The files are cached by it, because the same file can be
+	// included through different paths.
+	String canonicalPath;
+	String source;
+	FileInfo fileInfo;
+	// Files loaded from a precompiled header aren't scanned until they are needed.
+	bool isScanned;
+	TokenArray tokens;
+	// The offsets of the tokens in the output start at base.
+	uint32_t base;
+	// The macro of the include guard surrounding the whole file or SYMBOL_ID_NULL. If the macro is defined
+	// including the file again does nothing so it isn't processed.
+	SymbolId guardMacro;
+	bool isPragmaOnce;
+	// Used to check if a #pragma once file was already included in the current translation unit.
+	size_t includedGeneration;
+} SourceFile;
+
+typedef struct
+{
+	bool isDefined;
+	bool isFunctionLike;
+	bool isVariadic;
+	// Set while the expansion is rescanned so the macro doesn't expand recursively.
+	bool isExpanding;
+	size_t parameterCount;
+	// Range of the macro bodies. Parameters are replaced with TOKEN_MACRO_PARAMETER.
+	size_t bodyStart;
+	size_t bodySize;
+} Macro;
+
+typedef struct
+{
+	bool isActive;
+	// Set if one of the groups was already taken so the remaining #elif and #else groups are skipped.
+	bool wasTaken;
+	bool hadElse;
+} Conditional;
+
+ARRAY_TEMPLATE_DECLARATION(SourceFilePtrArray, SourceFile*)
+ARRAY_TEMPLATE_DECLARATION(ConditionalArray, Conditional)
+
+typedef struct
+{
+	TokenType type;
+	uint32_t offset;
+	uint32_t payload;
+	uint64_t value;
+} RawToken;
+
+// Reads the tokens of a range and the tokens produced by macro expansions, which have to be rescanned before
+// the rest of the range.
+typedef struct
+{
+	const TokenArray* tokens;
+	size_t index;
+	size_t end;
+	uint32_t base;
+	// Offset of the last token read. Used for errors at the end of the range.
+	uint32_t lastOffset;
+	// Stored in reverse so the next token is at the end.
+	TokenArray pending;
+} TokenReader;
+
+// #if expressions are evaluated in intmax_t or uintmax_t, which are 64 bit here.
+typedef struct
+{
+	uint64_t value;
+	bool isUnsigned;
+} ConditionValue;
+
+typedef struct
+{
+	// Owns the symbol table shared by all files, so the SymbolIds in the output are consistent.
+	Scanner scanner;
+
+	// Interned paths of the files. The SymbolId is the index into the files.
+	SymbolTable paths;
+	SourceFilePtrArray files;
+	uint32_t nextBase;
+	StringViewArray includeDirectories;
+	size_t includeDepth;
+	size_t generation;
+	// NULL if no precompiled header is used.
+	const char* pchPath;
+
+	// Indexed by SymbolId.
+	Macro* macros;
+	size_t macrosSize;
+	// The offsets are output offsets.
+	TokenArray macroBodies;
+
+	ConditionalArray conditionals;
+
+	SymbolId defineSymbol;
+	SymbolId undefSymbol;
+	SymbolId includeSymbol;
+	SymbolId ifdefSymbol;
+	SymbolId ifndefSymbol;
+	SymbolId elifSymbol;
+	SymbolId endifSymbol;
+	SymbolId pragmaSymbol;
+	SymbolId onceSymbol;
+	SymbolId errorSymbol;
+	SymbolId lineSymbol;
+	SymbolId definedSymbol;
+	SymbolId vaArgsSymbol;
+} Preprocessor;
+
+#define MAX_INCLUDE_DEPTH 200
+#define MAX_MACRO_PARAMETERS 256
+
+Preprocessor PreprocessorInit(Preprocessor* preprocessor);
+void PreprocessorFree(Preprocessor* preprocessor);
+void PreprocessorAddIncludeDirectory(Preprocessor* preprocessor, const char* directory);
+// If the main file includes the header of the precompiled header before anything else, the state after the header is
+// loaded from the file instead. If the precompiled header is out of date the header is processed normally.
+void PreprocessorUsePch(Preprocessor* preprocessor, const char* pchPath);
+// Returns the tokens of the translation unit with the directives executed and the macros expanded. The sources of
+// all the files are added to the array. Macros are cleared on each call but the files stay cached.
+TokenArray PreprocessorPreprocess(Preprocessor* preprocessor, const char* filename);
+
+SourceFile* loadFile(Preprocessor* preprocessor, String path);
+SourceFile* addFile(Preprocessor* preprocessor, String path, String source);
+// Returns the index of the file or SYMBOL_ID_NULL if it isn't loaded.
+SymbolId findFile(Preprocessor* preprocessor, StringView path);
+// If the file doesn't exist the path is returned unchanged.
+String canonicalPath(StringView path);
+void scanFile(Preprocessor* preprocessor, SourceFile* file);
+SymbolId detectIncludeGuard(Preprocessor* preprocessor, const TokenArray* tokens);
+bool fileExists(const char* path);
+String resolveIncludePath(Preprocessor* preprocessor, const SourceFile* includer, StringView name, bool isQuoted, uint32_t offset);
+void processFile(Preprocessor* preprocessor, SourceFile* file, TokenArray* output);
+
+bool isDirectiveStart(const TokenArray* tokens, size_t index);
+size_t findLineEnd(const TokenArray* tokens, size_t index);
+size_t findNextDirective(const TokenArray* tokens, size_t index);
+bool isSkipping(const Preprocessor* preprocessor);
+size_t directive(Preprocessor* preprocessor, SourceFile* file, size_t hashIndex, size_t conditionalBase, TokenArray* output);
+void defineDirective(Preprocessor* preprocessor, SourceFile* file, size_t start, size_t end);
+void includeDirective(Preprocessor* preprocessor, SourceFile* file, size_t start, size_t end, TokenArray* output);
+bool canUsePch(const Preprocessor* preprocessor, const TokenArray* output);
+bool evaluateCondition(Preprocessor* preprocessor, SourceFile* file, size_t start, size_t end);
+// If isEvaluated is false the expression is only parsed, like the right side of 0 && x. Errors that depend on the
+// values, like division by zero, aren't reported then.
+ConditionValue conditionTernary(Preprocessor* preprocessor, TokenReader* reader, bool isEvaluated);
+int binaryOperatorPrecedence(TokenType type);
+ConditionValue signedConditionValue(int64_t value);
+ConditionValue conditionBinary(Preprocessor* preprocessor, TokenReader* reader, int minPrecedence, bool isEvaluated);
+ConditionValue conditionUnary(Preprocessor* preprocessor, TokenReader* reader, bool isEvaluated);
+
+Macro* findMacro(Preprocessor* preprocessor, SymbolId name);
+Macro* getMacro(Preprocessor* preprocessor, SymbolId name);
+void expandMacros(Preprocessor* preprocessor, TokenReader* reader, TokenArray* output);
+void expandFunctionLikeMacro(Preprocessor* preprocessor, TokenReader* reader, SymbolId name, uint32_t nameOffset);
+
+void tokenReaderInit(TokenReader* reader, const TokenArray* tokens, size_t start, size_t end, uint32_t base);
+void tokenReaderFree(TokenReader* reader);
+bool readToken(Preprocessor* preprocessor, TokenReader* reader, RawToken* token);
+// Returns TOKEN_EOF at the end.
+TokenType peekTokenType(const TokenReader* reader);
+void pushTokens(TokenReader* reader, const TokenArray* tokens, size_t start, size_t end);
+
+RawToken getRawToken(const TokenArray* tokens, size_t index, uint32_t base);
+void appendRawToken(TokenArray* tokens, RawToken token);
+
+void preprocessorError(Preprocessor* preprocessor, uint32_t offset, const char* format, ...);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+// General purpose registers
+typedef enum
+{
+	REGISTER_RAX,
+	REGISTER_RBX,
+	REGISTER_RCX,
+	REGISTER_RDX,
+	REGISTER_RSI,
+	REGISTER_RDI,
+	REGISTER_RBP,
+	REGISTER_RSP,
+	REGISTER_R8,
+	REGISTER_R9,
+	REGISTER_R10,
+	REGISTER_R11,
+	REGISTER_R12,
+	REGISTER_R13,
+	REGISTER_R14,
+	REGISTER_R15,
+	REGISTER_GP_COUNT
+} RegisterGp;
+
+const char* RegisterGpToString(RegisterGp reg, size_t registerSize);
+
+const char* dataSizeToString(size_t size);
@@ -23,6 +23,9 @@ typedef enum
 	RESULT_LOCATION_LABEL_NAME,
 	RESULT_LOCATION_INT_CONSTANT,
 	RESULT_LOCATION_FLOAT_CONSTANT,
+	// The value is in a general purpose register. Use resolveResult to get the location, because the register
+	// might have been spilled since the Result was made.
+	RESULT_LOCATION_REGISTER,
 } ResultLocationType;
 
 typedef uint8_t byte;
@@ -50,6 +53,9 @@ typedef struct
 		// Used if RESUL_LOCATION_TEMP
 		int tempIndex;
 
+		// Used if RESULT_LOCATION_REGISTER. Index into the registerValues of the Compiler.
+		size_t registerValueIndex;
+
 		// Used if RESULT_LOCATION_LABEL_INDEX and RESULT_LOCATION_LABEL_COSTANT
 		size_t labelIndex;
 
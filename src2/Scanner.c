@@ -1,41 +1,272 @@
 #include "Scanner.h"
 #include "Generic.h"
 #include "TerminalColors.h"
+#include "Simd.h"
+#include "Assert.h"
+#include "Thread.h"
+#include "Number.h"
 
 Scanner ScannerInit(Scanner* scanner)
 {
+	SymbolTableInit(&scanner->symbols);
 	return *scanner;
 }
 
 void ScannerFree(Scanner* scanner)
 {
-
+	SymbolTableFree(&scanner->symbols);
 }
 
 TokenArray ScannerScan(Scanner* scanner, StringView source, const char* filename, FileInfo* fileInfoToFillOut)
 {
+	// The scanner uses the terminator as a sentinel instead of checking for the end of the source.
+	ASSERT(source.chars[source.length] == '\0');
+
 	fileInfoToFillOut->source = source;
 	fileInfoToFillOut->filename = filename;
 	SizetArrayClear(&fileInfoToFillOut->lineStartOffsets);
-	SizetArrayAppend(&fileInfoToFillOut->lineStartOffsets, 0);
 	scanner->fileInfo = fileInfoToFillOut;
 
+	scanner->dataStart = source.chars;
 	scanner->currentChar = source.chars;
 	scanner->dataEnd = source.chars + source.length;
+	scanner->isAtLineStart = true;
+	scanner->isSpeculative = false;
+	scanner->hadError = false;
 
-	scanner->line = 0;
-
+	if (source.length > UINT32_MAX)
+	{
+		fprintf(stderr, "%s: files larger than 4GB are not supported\n", filename);
+		exit(1);
+	}
 
 	TokenArray tokens;
 	TokenArrayInit(&tokens);
+	TokenArrayAddSource(&tokens, source, 0, fileInfoToFillOut);
+	// The EOF token always fits.
+	TokenArrayReserve(&tokens, source.length / SCANNER_BYTES_PER_TOKEN_ESTIMATE + 1);
 
-	while (isScannerAtEnd(scanner) == false)
+	size_t chunkCount = source.length / PARALLEL_SCAN_MIN_CHUNK_SIZE;
+	size_t threadCount = ThreadHardwareConcurrency();
+	if (chunkCount > threadCount)
+		chunkCount = threadCount;
+
+	if (chunkCount > 1)
+		scanParallel(scanner, &tokens, chunkCount);
+	else
+		scanSerial(scanner, &tokens);
+
+	TokenArrayAppend(&tokens, TOKEN_EOF, scanner->currentChar - source.chars, 0);
+
+	return tokens;
+}
+
+void appendToken(Scanner* scanner, TokenArray* tokens, Token token)
+{
+	size_t offset = token.text.chars - scanner->dataStart;
+	if (TokenTypeIsNumberConstant(token.type))
+		TokenArrayAppendValue(tokens, token.type, offset, token.value.intValue);
+	else
+		TokenArrayAppend(tokens, token.type, offset, token.payload);
+
+	if (token.isAtLineStart)
+		tokens->types[tokens->size - 1] |= TOKEN_FLAG_LINE_START;
+}
+
+void scanSerial(Scanner* scanner, TokenArray* tokens)
+{
+	for (;;)
 	{
-		TokenArrayAppend(&tokens, nextToken(scanner));
+		Token token = nextToken(scanner);
+		if (token.type == TOKEN_EOF)
+			break;
+		appendToken(scanner, tokens, token);
 	}
-	TokenArrayAppend(&tokens, makeToken(scanner, TOKEN_EOF));
+}
 
-	return tokens;
+void scanParallel(Scanner* scanner, TokenArray* tokens, size_t chunkCount)
+{
+	StringView source = scanner->fileInfo->source;
+	ScannerChunk* chunks = malloc(sizeof(ScannerChunk) * chunkCount);
+	Thread* threads = malloc(sizeof(Thread) * chunkCount);
+	if ((chunks == NULL) || (threads == NULL))
+	{
+		fputs("Failed to allocate scanner chunks\n", stderr);
+		exit(1);
+	}
+
+	// Chunks start after a newline, which is the most likely place for a token to start.
+	size_t start = 0;
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		size_t end = source.length;
+		if (i != (chunkCount - 1))
+		{
+			end = (source.length / chunkCount) * (i + 1);
+			if (end < start)
+				end = start;
+			const char* newline = memchr(source.chars + end, '\n', source.length - end);
+			end = (newline == NULL) ? source.length : (size_t)(newline - source.chars) + 1;
+		}
+
+		ScannerChunk* chunk = &chunks[i];
+		chunk->scanner.fileInfo = NULL;
+		chunk->scanner.tokens = NULL;
+		chunk->scanner.dataStart = source.chars;
+		// Tokens can continue past the end of the chunk.
+		chunk->scanner.dataEnd = source.chars + source.length;
+		chunk->scanner.currentChar = source.chars + start;
+		chunk->scanner.currentTokenStart = chunk->scanner.currentChar;
+		chunk->scanner.isAtLineStart = true;
+		chunk->scanner.isSpeculative = true;
+		chunk->scanner.hadError = false;
+		chunk->start = start;
+		chunk->end = end;
+		TokenArrayInit(&chunk->tokens);
+		TokenArrayReserve(&chunk->tokens, (end - start) / SCANNER_BYTES_PER_TOKEN_ESTIMATE);
+		start = end;
+	}
+
+	for (size_t i = 1; i < chunkCount; i++)
+		ThreadStart(&threads[i], scanChunk, &chunks[i]);
+	scanChunk(&chunks[0]);
+	for (size_t i = 1; i < chunkCount; i++)
+		ThreadJoin(&threads[i]);
+
+	stitchChunks(scanner, tokens, chunks, chunkCount);
+
+	for (size_t i = 0; i < chunkCount; i++)
+		TokenArrayFree(&chunks[i].tokens);
+	free(threads);
+	free(chunks);
+}
+
+void scanChunk(void* chunkPointer)
+{
+	ScannerChunk* chunk = chunkPointer;
+	Scanner* scanner = &chunk->scanner;
+	const char* chunkEnd = scanner->dataStart + chunk->end;
+
+	for (;;)
+	{
+		skipWhitespace(scanner);
+		if (isScannerAtEnd(scanner) || (scanner->currentTokenStart >= chunkEnd))
+			break;
+
+		scanner->hadError = false;
+		Token token = scanToken(scanner);
+		// The error is reported when the token is scanned again by the non speculative scanner.
+		if (scanner->hadError)
+			token.type = TOKEN_ERROR;
+		appendToken(scanner, &chunk->tokens, token);
+	}
+
+	chunk->resumeOffset = scanner->currentChar - scanner->dataStart;
+	chunk->resumeIsAtLineStart = scanner->isAtLineStart;
+}
+
+// Returns the index of the token starting at offset or SIZE_MAX if there isn't one.
+static size_t findTokenAtOffset(const TokenArray* tokens, size_t offset)
+{
+	size_t low = 0;
+	size_t high = tokens->size;
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (tokens->offsets[middle] < offset)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return ((low < tokens->size) && (tokens->offsets[low] == offset)) ? low : SIZE_MAX;
+}
+
+void stitchChunks(Scanner* scanner, TokenArray* tokens, const ScannerChunk* chunks, size_t chunkCount)
+{
+	const char* dataStart = scanner->dataStart;
+	size_t chunkIndex = 0;
+
+	for (;;)
+	{
+		skipWhitespace(scanner);
+		if (isScannerAtEnd(scanner))
+			break;
+
+		size_t offset = scanner->currentChar - dataStart;
+		while (((chunkIndex + 1) < chunkCount) && (offset >= chunks[chunkIndex].end))
+			chunkIndex++;
+		const ScannerChunk* chunk = &chunks[chunkIndex];
+
+		// Scanning only depends on the position so if a chunk has a token starting at the same offset all the
+		// tokens after it are the same as the ones the serial scan would produce.
+		size_t tokenIndex = findTokenAtOffset(&chunk->tokens, offset);
+		if ((tokenIndex == SIZE_MAX) || (TokenArrayGetType(&chunk->tokens, tokenIndex) == TOKEN_ERROR))
+		{
+			appendToken(scanner, tokens, scanToken(scanner));
+			continue;
+		}
+
+		// Whether a token starts a line depends on the whitespace before it, which the chunk might have skipped from
+		// a different position. After the first token the chunk is in sync.
+		bool isAtLineStart = scanner->isAtLineStart;
+
+		for (; tokenIndex < chunk->tokens.size; tokenIndex++)
+		{
+			TokenType type = TokenArrayGetType(&chunk->tokens, tokenIndex);
+			uint32_t tokenOffset = chunk->tokens.offsets[tokenIndex];
+			uint32_t payload = chunk->tokens.payloads[tokenIndex];
+
+			if (type == TOKEN_ERROR)
+			{
+				scanner->currentChar = dataStart + tokenOffset;
+				scanner->isAtLineStart = isAtLineStart;
+				break;
+			}
+
+			// Interning is done here so the symbol ids are the same as in the serial scan.
+			if (type == TOKEN_IDENTIFIER)
+				payload = SymbolTableIntern(&scanner->symbols, StringViewInit(dataStart + tokenOffset, payload));
+
+			if (TokenTypeIsNumberConstant(type))
+				TokenArrayAppendValue(tokens, type, tokenOffset, chunk->tokens.values[payload]);
+			else
+				TokenArrayAppend(tokens, type, tokenOffset, payload);
+
+			if (isAtLineStart)
+				tokens->types[tokens->size - 1] |= TOKEN_FLAG_LINE_START;
+			if ((tokenIndex + 1) < chunk->tokens.size)
+				isAtLineStart = TokenArrayIsAtLineStart(&chunk->tokens, tokenIndex + 1);
+		}
+
+		if (tokenIndex == chunk->tokens.size)
+		{
+			scanner->currentChar = dataStart + chunk->resumeOffset;
+			scanner->isAtLineStart = chunk->resumeIsAtLineStart;
+		}
+	}
+}
+
+size_t ScannerTokenLength(StringView source, size_t offset)
+{
+	Scanner scanner;
+	scanner.fileInfo = NULL;
+	scanner.dataStart = source.chars;
+	scanner.dataEnd = source.chars + source.length;
+	scanner.isAtLineStart = false;
+	// Errors were already reported when the file was scanned.
+	scanner.isSpeculative = true;
+	scanner.currentChar = source.chars + offset;
+	scanner.currentTokenStart = scanner.currentChar;
+
+	// Identifiers and keywords are handled here so the scanner doesn't need a symbol table.
+	if (isAlpha(peekChar(&scanner)))
+	{
+		while (isAlnum(peekChar(&scanner)))
+			advanceScanner(&scanner);
+		return scanner.currentChar - scanner.currentTokenStart;
+	}
+
+	return scanToken(&scanner).text.length;
 }
 
 Token nextToken(Scanner* scanner)
@@ -45,6 +276,11 @@ Token nextToken(Scanner* scanner)
 	if (isScannerAtEnd(scanner))
 		return makeToken(scanner, TOKEN_EOF);
 
+	return scanToken(scanner);
+}
+
+Token scanToken(Scanner* scanner)
+{
 	char chr = peekChar(scanner);
 
 	if (isDigit(chr))
@@ -66,6 +302,8 @@ void skipWhitespace(Scanner* scanner)
 {
 	for (;;)
 	{
+		skipBlanks(scanner);
+
 		switch (peekChar(scanner))
 		{
 			case ' ':
@@ -75,8 +313,27 @@ void skipWhitespace(Scanner* scanner)
 				break;
 
 			case '\n':
+				scanner->isAtLineStart = true;
 				advanceScanner(scanner);
-				advanceScannerLine(scanner);
+				break;
+
+			// Line continuation. Only matters inside of directives, everywhere else a newline is just whitespace.
+			case '\\':
+				if (peekNextChar(scanner) == '\n')
+				{
+					advanceScanner(scanner);
+					advanceScanner(scanner);
+				}
+				else if ((peekNextChar(scanner) == '\r') && (scanner->currentChar[2] == '\n'))
+				{
+					advanceScanner(scanner);
+					advanceScanner(scanner);
+					advanceScanner(scanner);
+				}
+				else
+				{
+					goto end;
+				}
 				break;
 
 			case '/':
@@ -96,6 +353,59 @@ void skipWhitespace(Scanner* scanner)
 	end: scanner->currentTokenStart = scanner->currentChar;
 }
 
+void skipBlanks(Scanner* scanner)
+{
+#ifdef SIMD_WIDTH
+	while ((scanner->dataEnd - scanner->currentChar) >= SIMD_WIDTH)
+	{
+		uint32_t blankMask = SimdBlankMask(scanner->currentChar);
+		// The blanks before the first other char.
+		uint32_t skippedMask = blankMask & (~blankMask - 1);
+		if (SimdMatchMask(scanner->currentChar, '\n') & skippedMask)
+			scanner->isAtLineStart = true;
+
+		if (blankMask != SIMD_FULL_MASK)
+		{
+			scanner->currentChar += SimdCountTrailingZeros(~blankMask);
+			return;
+		}
+		scanner->currentChar += SIMD_WIDTH;
+	}
+#endif
+}
+
+void skipToNewline(Scanner* scanner)
+{
+#ifdef SIMD_WIDTH
+	while ((scanner->dataEnd - scanner->currentChar) >= SIMD_WIDTH)
+	{
+		uint32_t mask = SimdMatchMask(scanner->currentChar, '\n');
+		if (mask != 0)
+		{
+			scanner->currentChar += SimdCountTrailingZeros(mask);
+			return;
+		}
+		scanner->currentChar += SIMD_WIDTH;
+	}
+#endif
+}
+
+void skipToStar(Scanner* scanner)
+{
+#ifdef SIMD_WIDTH
+	while ((scanner->dataEnd - scanner->currentChar) >= SIMD_WIDTH)
+	{
+		uint32_t mask = SimdMatchMask(scanner->currentChar, '*');
+		if (mask != 0)
+		{
+			scanner->currentChar += SimdCountTrailingZeros(mask);
+			return;
+		}
+		scanner->currentChar += SIMD_WIDTH;
+	}
+#endif
+}
+
 void singleLineComment(Scanner* scanner)
 {
 	// Skip "//"
@@ -104,9 +414,10 @@ void singleLineComment(Scanner* scanner)
 
 	while (isScannerAtEnd(scanner) == false)
 	{
+		skipToNewline(scanner);
 		if (matchChar(scanner, '\n'))
 		{
-			advanceScannerLine(scanner);
+			scanner->isAtLineStart = true;
 			break;
 		}
 		advanceScanner(scanner);
@@ -121,19 +432,21 @@ void mutliLineComment(Scanner* scanner)
 
 	while (isScannerAtEnd(scanner) == false)
 	{
-		if (matchChar(scanner, '\n'))
-		{
-			advanceScannerLine(scanner);
-		}
-		else if (matchChar(scanner, '*'))
+		skipToStar(scanner);
+		if (isScannerAtEnd(scanner))
+			break;
+
+		if (matchChar(scanner, '*'))
 		{
 			if (matchChar(scanner, '/'))
 			{
 				break;
 			}
 		}
-
-		advanceScanner(scanner);
+		else
+		{
+			advanceScanner(scanner);
+		}
 	}
 }
 
@@ -148,11 +461,18 @@ Token number(Scanner* scanner)
 
 	bool isFloat = false;
 
+	// The value is decoded here so the compiler doesn't need to parse the text again.
+	const char* digits = scanner->currentTokenStart;
+	int base = 10;
+
 	if (matchChar(scanner, '0'))
 	{
+		base = 8;
 		if (matchChar(scanner, 'x'))
 		{
 			isSignificandHex = true;
+			base = 16;
+			digits = scanner->currentChar;
 			if (isHexDigit(peekChar(scanner)) == false)
 			{
 				scannerError(scanner, "number literal can't end with 'x'");
@@ -164,13 +484,13 @@ Token number(Scanner* scanner)
 		}
 		else
 		{
-			char chr = peekChar(scanner);
-			while (isDigit(chr))
+			while (isDigit(peekChar(scanner)))
 			{
-				if (isOctalDigit(chr) == false)
+				if (isOctalDigit(peekChar(scanner)) == false)
 				{
 					nonOctalDigitInSiginificandStartingWithZero = true;
 				}
+				advanceScanner(scanner);
 			}
 		}
 	}
@@ -180,6 +500,8 @@ Token number(Scanner* scanner)
 			advanceScanner(scanner);
 	}
 
+	const char* digitsEnd = scanner->currentChar;
+
 	if (matchChar(scanner, '.'))
 	{
 		isFloat = true;
@@ -203,7 +525,13 @@ Token number(Scanner* scanner)
 			return errorToken(scanner);
 		}
 
-		return floatSuffix(scanner);
+		const char* text = scanner->currentTokenStart;
+		size_t length = scanner->currentChar - text;
+		Token token = floatSuffix(scanner);
+		token.value.floatValue = (token.type == TOKEN_FLOAT_CONSTANT)
+			? NumberParseFloat(text, length)
+			: NumberParseDouble(text, length);
+		return token;
 	}
 	else
 	{
@@ -213,8 +541,44 @@ Token number(Scanner* scanner)
 			return errorToken(scanner);
 		}
 
-		return intSuffix(scanner);
+		uint64_t value;
+		if (NumberParseInteger(digits, digitsEnd - digits, base, &value) == false)
+		{
+			// Skip the suffix so it isn't scanned as an identifier.
+			while (isAlnum(peekChar(scanner)))
+				advanceScanner(scanner);
+			scannerError(scanner, "integer constant is too large");
+			return errorToken(scanner);
+		}
+
+		Token token = intSuffix(scanner);
+		if (token.type != TOKEN_ERROR)
+			token.type = intConstantType(token.type, value, base == 10);
+		token.value.intValue = value;
+		return token;
+	}
+}
+
+// The type of an integer constant is the first one from the list of its suffix that can represent the value (C11 6.4.4.1).
+// Decimal constants without the u suffix only use the signed types. The integer constant types are ordered by rank
+// with the unsigned type after the signed one, and int and long are both 32 bit.
+TokenType intConstantType(TokenType suffixType, uint64_t value, bool isDecimal)
+{
+	static const uint64_t maxValues[] = { INT32_MAX, UINT32_MAX, INT32_MAX, UINT32_MAX, INT64_MAX, UINT64_MAX };
+
+	bool isSuffixUnsigned = ((suffixType - TOKEN_INT_CONSTANT) % 2) == 1;
+	for (TokenType type = suffixType; type <= TOKEN_UNSIGNED_LONG_LONG_CONSTANT; type++)
+	{
+		bool isUnsigned = ((type - TOKEN_INT_CONSTANT) % 2) == 1;
+		if ((isUnsigned == false) && isSuffixUnsigned)
+			continue;
+		if (isUnsigned && (isSuffixUnsigned == false) && isDecimal)
+			continue;
+		if (value <= maxValues[type - TOKEN_INT_CONSTANT])
+			return type;
 	}
+	// A decimal constant too big for long long has no type. Like GCC it is made unsigned instead of reporting an error.
+	return TOKEN_UNSIGNED_LONG_LONG_CONSTANT;
 }
 
 Token floatSuffix(Scanner* scanner)
@@ -274,117 +638,80 @@ bool matchUnsignedSuffix(Scanner* scanner)
 	return (matchChar(scanner, 'u') || matchChar(scanner, 'U'));
 }
 
+typedef struct
+{
+	const char* text;
+	size_t length;
+	TokenType type;
+} Keyword;
+
+// Perfect hash of the keywords. The multipliers were found by trying small values until every keyword
+// landed in a different slot, so adding a keyword requires checking for collisions again.
+#define KEYWORD_TABLE_SIZE 64
+#define KEYWORD_HASH(first, last, length) \
+	(((((size_t)(unsigned char)(first)) * 14) + ((((size_t)(unsigned char)(last)) + (size_t)(length)) * 5)) & (KEYWORD_TABLE_SIZE - 1))
+
+#define KEYWORD(first, last, keywordString, tokenType) \
+	[KEYWORD_HASH(first, last, sizeof(keywordString) - 1)] = { keywordString, sizeof(keywordString) - 1, tokenType }
+
+// Empty slots have length 0 so they never match.
+static const Keyword keywords[KEYWORD_TABLE_SIZE] = {
+	KEYWORD('a', 'o', "auto", TOKEN_AUTO),
+	KEYWORD('b', 'k', "break", TOKEN_BREAK),
+	KEYWORD('c', 'e', "case", TOKEN_CASE),
+	KEYWORD('c', 'r', "char", TOKEN_CHAR),
+	KEYWORD('c', 't', "const", TOKEN_CONST),
+	KEYWORD('c', 'e', "continue", TOKEN_CONTINUE),
+	KEYWORD('d', 't', "default", TOKEN_DEFAULT),
+	KEYWORD('d', 'o', "do", TOKEN_DO),
+	KEYWORD('d', 'e', "double", TOKEN_DOUBLE),
+	KEYWORD('e', 'e', "else", TOKEN_ELSE),
+	KEYWORD('e', 'm', "enum", TOKEN_ENUM),
+	KEYWORD('e', 'n', "extern", TOKEN_EXTERN),
+	KEYWORD('f', 't', "float", TOKEN_FLOAT),
+	KEYWORD('f', 'r', "for", TOKEN_FOR),
+	KEYWORD('g', 'o', "goto", TOKEN_GOTO),
+	KEYWORD('i', 'f', "if", TOKEN_IF),
+	KEYWORD('i', 't', "int", TOKEN_INT),
+	KEYWORD('l', 'g', "long", TOKEN_LONG),
+	KEYWORD('r', 'r', "register", TOKEN_REGISTER),
+	KEYWORD('r', 'n', "return", TOKEN_RETURN),
+	KEYWORD('s', 't', "short", TOKEN_SHORT),
+	KEYWORD('s', 'd', "signed", TOKEN_SIGNED),
+	KEYWORD('s', 'f', "sizeof", TOKEN_SIZEOF),
+	KEYWORD('s', 'c', "static", TOKEN_STATIC),
+	KEYWORD('s', 't', "struct", TOKEN_STRUCT),
+	KEYWORD('s', 'h', "switch", TOKEN_SWITCH),
+	KEYWORD('t', 'f', "typedef", TOKEN_TYPEDEF),
+	KEYWORD('u', 'n', "union", TOKEN_UNION),
+	KEYWORD('u', 'd', "unsigned", TOKEN_UNSIGNED),
+	KEYWORD('v', 'd', "void", TOKEN_VOID),
+	KEYWORD('v', 'e', "volatile", TOKEN_VOLATILE),
+	KEYWORD('w', 'e', "while", TOKEN_WHILE),
+};
+
+#undef KEYWORD
+
 Token identifierOrKeyword(Scanner* scanner)
 {
-	while ((isScannerAtEnd(scanner) == false) && (isAlnum(peekChar(scanner))))
+	while (isAlnum(peekChar(scanner)))
 	{
 		advanceScanner(scanner);
 	}
 
-	TokenType type = TOKEN_IDENTIFIER;
-
-#define KEYWORD_GROUP(chr) \
-		case chr: 
-
-#define KEYWORD_GROUP_END() \
-		break;
-
-#define KEYWORD(keywordString, tokenType) \
-		{ \
-			ptrdiff_t keywordLength = sizeof(keywordString) - 1; \
-			if (((scanner->currentChar - scanner->currentTokenStart) == keywordLength) \
-			  && (memcmp(scanner->currentTokenStart, keywordString, keywordLength) == 0)) \
-			{ \
-				type = tokenType; \
-				break; \
-			} \
-		}
+	const char* start = scanner->currentTokenStart;
+	size_t length = scanner->currentChar - start;
+	const Keyword* keyword = &keywords[KEYWORD_HASH(start[0], start[length - 1], length)];
+	if ((keyword->length == length) && (memcmp(start, keyword->text, length) == 0))
+	{
+		return makeToken(scanner, keyword->type);
+	}
 
-	switch (*scanner->currentTokenStart)
-	{
-		KEYWORD_GROUP('a')
-			KEYWORD("auto", TOKEN_AUTO)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('b')
-			KEYWORD("break", TOKEN_BREAK)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('c')
-			KEYWORD("case", TOKEN_CASE)
-			KEYWORD("char", TOKEN_CHAR)
-			KEYWORD("const", TOKEN_CONST)
-			KEYWORD("continue", TOKEN_CONTINUE)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('d')
-			KEYWORD("default", TOKEN_DEFAULT)
-			KEYWORD("do", TOKEN_DO)
-			KEYWORD("double", TOKEN_DOUBLE)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('e')
-			KEYWORD("else", TOKEN_ELSE)
-			KEYWORD("enum", TOKEN_ENUM)
-			KEYWORD("extern", TOKEN_EXTERN)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('f')
-			KEYWORD("float", TOKEN_FLOAT)
-			KEYWORD("for", TOKEN_FOR)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('g')
-			KEYWORD("goto", TOKEN_GOTO)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('i')
-			KEYWORD("if", TOKEN_IF)
-			KEYWORD("int", TOKEN_INT)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('l')
-			KEYWORD("long", TOKEN_LONG)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('r')
-			KEYWORD("register", TOKEN_REGISTER)
-			KEYWORD("return", TOKEN_RETURN)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('s')
-			KEYWORD("short", TOKEN_SHORT)
-			KEYWORD("signed", TOKEN_SIGNED)
-			KEYWORD("sizeof", TOKEN_SIZEOF)
-			KEYWORD("static", TOKEN_STATIC)
-			KEYWORD("struct", TOKEN_STRUCT)
-			KEYWORD("switch", TOKEN_SWITCH)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('t')
-			KEYWORD("typedef", TOKEN_TYPEDEF)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('u')
-			KEYWORD("union", TOKEN_UNION)
-			KEYWORD("unsigned", TOKEN_UNSIGNED)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('v')
-			KEYWORD("void", TOKEN_VOID)
-			KEYWORD("volatile", TOKEN_VOLATILE)
-		KEYWORD_GROUP_END();
-
-		KEYWORD_GROUP('w')
-			KEYWORD("while", TOKEN_WHILE)
-		KEYWORD_GROUP_END();
-	}
-
-	return makeToken(scanner, type);
-
-#undef KEYWORD_GROUP
-#undef KEYWORD_GROUP_END
-#undef KEYWORD
+	Token token = makeToken(scanner, TOKEN_IDENTIFIER);
+	token.payload = scanner->isSpeculative
+		? (uint32_t)token.text.length
+		: SymbolTableIntern(&scanner->symbols, token.text);
+	return token;
 }
 
 Token charConstant(Scanner* scanner)
@@ -458,10 +785,13 @@ Token simpleToken(Scanner* scanner)
 		case '~': return MAKE(TOKEN_TILDE);
 		case ';': return MAKE(TOKEN_SEMICOLON);
 
+		case '#': return MATCH('#') ? MAKE(TOKEN_HASH_HASH) : MAKE(TOKEN_HASH);
+
 		case '=': return MATCH('=') ? MAKE(TOKEN_EQUALS_EQUALS)  : MAKE(TOKEN_EQUALS);
 		case '!': return MATCH('=') ? MAKE(TOKEN_BANG_EQUALS)    : MAKE(TOKEN_BANG);
 		case '^': return MATCH('=') ? MAKE(TOKEN_XOR_EQUALS)     : MAKE(TOKEN_XOR);
 		case '*': return MATCH('=') ? MAKE(TOKEN_STAR_EQUALS)    : MAKE(TOKEN_STAR);
+		case '/': return MATCH('=') ? MAKE(TOKEN_SLASH_EQUALS)   : MAKE(TOKEN_SLASH);
 		case '%': return MATCH('=') ? MAKE(TOKEN_PERCENT_EQUALS) : MAKE(TOKEN_PERCENT);
 
 		case '+':
@@ -518,6 +848,8 @@ Token simpleToken(Scanner* scanner)
 		{
 			if ((peekChar(scanner) == '.') && (peekNextChar(scanner) == '.'))
 			{
+				advanceScanner(scanner);
+				advanceScanner(scanner);
 				return MAKE(TOKEN_DOT_DOT_DOT);
 			}
 			return MAKE(TOKEN_DOT);
@@ -552,12 +884,15 @@ Token simpleToken(Scanner* scanner)
 
 void scannerError(Scanner* scanner, const char* message)
 {
-	const size_t* lineStartOffsets = scanner->fileInfo->lineStartOffsets.data;
+	scanner->hadError = true;
+	if (scanner->isSpeculative)
+		return;
+
 	const char* filename = scanner->fileInfo->filename;
 	const char* dataStart = scanner->fileInfo->source.chars;
-	size_t line = scanner->line;
-	const char* lineStart = dataStart + lineStartOffsets[line];
-	size_t lineLength = findEndOfLine(dataStart, scanner->dataEnd) - lineStart;
+	size_t line = FileInfoGetLineNumber(scanner->fileInfo, scanner->currentTokenStart - dataStart);
+	const char* lineStart = dataStart + scanner->fileInfo->lineStartOffsets.data[line];
+	size_t lineLength = findEndOfLine(lineStart, scanner->dataEnd) - lineStart;
 	size_t errorTokenLength = scanner->currentChar - scanner->currentTokenStart;
 	int charInLine = scanner->currentTokenStart - lineStart;
 
@@ -595,11 +930,14 @@ const char* findEndOfLine(const char* data, const char* dataEnd)
 Token makeToken(Scanner* scanner, TokenType type)
 {
 	Token token;
-	token.line = scanner->line;
+	token.payload = 0;
+	token.value.intValue = 0;
+	token.isAtLineStart = scanner->isAtLineStart;
 	token.text.chars = scanner->currentTokenStart;
 	token.text.length = scanner->currentChar - scanner->currentTokenStart;
 	token.type = type;
 	scanner->currentTokenStart = scanner->currentChar;
+	scanner->isAtLineStart = false;
 	return token;
 }
 
@@ -607,9 +945,12 @@ Token errorToken(Scanner* scanner)
 {
 	Token token;
 	token.type = TOKEN_ERROR;
-	token.line = 0;
-	token.text = StringViewInit("", 0);
+	token.payload = 0;
+	token.value.intValue = 0;
+	token.isAtLineStart = scanner->isAtLineStart;
+	token.text = StringViewInit(scanner->currentTokenStart, 0);
 	scanner->currentTokenStart = scanner->currentChar;
+	scanner->isAtLineStart = false;
 	return token;
 }
 
@@ -618,20 +959,16 @@ bool isScannerAtEnd(const Scanner* scanner)
 	return scanner->currentChar >= scanner->dataEnd;
 }
 
+// The source is null terminated so reading at dataEnd returns '\0' and no bounds checks are needed.
 char peekChar(Scanner* scanner)
 {
-	if (isScannerAtEnd(scanner))
-		return '\0';
-	else
-		return *scanner->currentChar;
+	return *scanner->currentChar;
 }
 
+// Only valid if the current char isn't the terminator.
 char peekNextChar(Scanner* scanner)
 {
-	if ((scanner->currentChar + 1) >= scanner->dataEnd)
-		return '\0';
-	else
-		return scanner->currentChar[1];
+	return scanner->currentChar[1];
 }
 
 char peekPreviousChar(Scanner* scanner)
@@ -657,39 +994,50 @@ void advanceScanner(Scanner* scanner)
 	scanner->currentChar++;
 }
 
-void advanceScannerLine(Scanner* scanner)
-{
-	scanner->line++;
-	SizetArrayAppend(&scanner->fileInfo->lineStartOffsets, scanner->currentChar - scanner->fileInfo->source.chars);
-}
+
+// The characters from 0x80 to 0xFF are all 0.
+#define A CHAR_CLASS_ALPHA
+#define H (CHAR_CLASS_ALPHA | CHAR_CLASS_HEX_DIGIT)
+#define D (CHAR_CLASS_DIGIT | CHAR_CLASS_HEX_DIGIT)
+#define O (CHAR_CLASS_DIGIT | CHAR_CLASS_HEX_DIGIT | CHAR_CLASS_OCTAL_DIGIT)
+static const uint8_t charClasses[256] = {
+	/* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 0x20 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* 0x30 */ O, O, O, O, O, O, O, O, D, D, 0, 0, 0, 0, 0, 0,
+	/* 0x40 */ 0, H, H, H, H, H, H, A, A, A, A, A, A, A, A, A,
+	/* 0x50 */ A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, A,
+	/* 0x60 */ 0, H, H, H, H, H, H, A, A, A, A, A, A, A, A, A,
+	/* 0x70 */ A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0,
+};
+#undef A
+#undef H
+#undef D
+#undef O
 
 bool isAlpha(char chr)
 {
-	return ((chr >= 'A') && (chr <= 'Z'))
-		|| ((chr >= 'a') && (chr <= 'z'))
-		||   chr == '_';
+	return (charClasses[(unsigned char)chr] & CHAR_CLASS_ALPHA) != 0;
 }
 
 bool isDigit(char chr)
 {
-	return ((chr >= '0') && (chr <= '9'));
+	return (charClasses[(unsigned char)chr] & CHAR_CLASS_DIGIT) != 0;
 }
 
 bool isAlnum(char chr)
 {
-	return isDigit(chr) || isAlpha(chr);
+	return (charClasses[(unsigned char)chr] & (CHAR_CLASS_ALPHA | CHAR_CLASS_DIGIT)) != 0;
 }
 
 bool isHexDigit(char chr)
 {
-	return isDigit(chr)
-		|| ((chr >= 'A') && (chr <= 'F'))
-		|| ((chr >= 'a') && (chr <= 'f'));
+	return (charClasses[(unsigned char)chr] & CHAR_CLASS_HEX_DIGIT) != 0;
 }
 
 bool isOctalDigit(char chr)
 {
-	return ((chr >= '0') && (chr <= '7'));
+	return (charClasses[(unsigned char)chr] & CHAR_CLASS_OCTAL_DIGIT) != 0;
 }
 
 char toLower(char chr)
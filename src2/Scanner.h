@@ -5,33 +5,86 @@
 #include "Token.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
-typedef struct
+typedef enum
 {
-	size_t line;
+	CHAR_CLASS_ALPHA = 1 << 0,
+	CHAR_CLASS_DIGIT = 1 << 1,
+	CHAR_CLASS_HEX_DIGIT = 1 << 2,
+	CHAR_CLASS_OCTAL_DIGIT = 1 << 3,
+} CharClass;
 
+typedef struct
+{
 	FileInfo* fileInfo;
 
+	SymbolTable symbols;
+
+	const char* dataStart;
 	const char* dataEnd;
 
 	TokenArray* tokens;
 
 	const char* currentTokenStart;
 	const char* currentChar;
+	// Set when a newline is skipped and cleared by the next token.
+	bool isAtLineStart;
+
+	// A speculative scanner may have started in the middle of a comment or literal, so it doesn't report errors
+	// and doesn't intern identifiers. The payload of identifiers is their length instead.
+	bool isSpeculative;
+	bool hadError;
 } Scanner;
 
+// Used to reserve the token array before scanning. C code without many comments averages about 4 bytes per token
+// so most files don't have to grow the array.
+#define SCANNER_BYTES_PER_TOKEN_ESTIMATE 4
+
+// Files smaller than this aren't worth splitting between threads.
+#define PARALLEL_SCAN_MIN_CHUNK_SIZE (1024 * 1024)
+
+typedef struct
+{
+	Scanner scanner;
+	// Tokens starting in [start, end) are scanned by this chunk.
+	size_t start;
+	size_t end;
+	TokenArray tokens;
+	// The offset after the whitespace following the last token.
+	size_t resumeOffset;
+	bool resumeIsAtLineStart;
+} ScannerChunk;
+
 Scanner ScannerInit(Scanner* scanner);
 void ScannerFree(Scanner* scanner);
 TokenArray ScannerScan(Scanner* scanner, StringView source, const char* filename, FileInfo* fileInfoToFillOut);
+// Scans the token starting at offset again. Used to get the length of tokens from a TokenArray.
+size_t ScannerTokenLength(StringView source, size_t offset);
+
+void appendToken(Scanner* scanner, TokenArray* tokens, Token token);
+void scanSerial(Scanner* scanner, TokenArray* tokens);
+void scanParallel(Scanner* scanner, TokenArray* tokens, size_t chunkCount);
+void scanChunk(void* chunk);
+// Appends the tokens of the chunks starting at the current char. Falls back to scanning serially when the
+// current char isn't the start of a token found by any chunk.
+void stitchChunks(Scanner* scanner, TokenArray* tokens, const ScannerChunk* chunks, size_t chunkCount);
 
 Token nextToken(Scanner* scanner);
+// Scans a token starting at the current char without skipping whitespace.
+Token scanToken(Scanner* scanner);
 void skipWhitespace(Scanner* scanner);
-// Comments are removed by the preprocessor, but this might be useful later.
+// Skip SIMD_WIDTH bytes at a time while possible and leave the rest to the scalar code.
+void skipBlanks(Scanner* scanner);
+void skipToNewline(Scanner* scanner);
+void skipToStar(Scanner* scanner);
+// The preprocessor works on the scanned tokens, so comments are skipped here.
 void singleLineComment(Scanner* scanner);
 void mutliLineComment(Scanner* scanner);
 Token number(Scanner* scanner);
 Token floatSuffix(Scanner* scanner);
 Token intSuffix(Scanner* scanner);
+TokenType intConstantType(TokenType suffixType, uint64_t value, bool isDecimal);
 bool matchUnsignedSuffix(Scanner* scanner);
 Token identifierOrKeyword(Scanner* scanner);
 Token charConstant(Scanner* scanner);
@@ -49,7 +102,6 @@ char peekNextChar(Scanner* scanner);
 char peekPreviousChar(Scanner* scanner);
 bool matchChar(Scanner* scanner, char chr);
 void advanceScanner(Scanner* scanner);
-void advanceScannerLine(Scanner* scanner);
 
 bool isAlpha(char chr);
 bool isDigit(char chr);
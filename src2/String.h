@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdarg.h>
 
 typedef struct
 {
@@ -11,6 +12,10 @@ typedef struct
 
 String StringCopy(const char* string);
 String StringFromFile(const char* filename);
+// Maps the file into memory instead of copying it. The returned string is null terminated
+// and read only and has to be freed with StringFreeMapped.
+String StringFromFileMapped(const char* filename);
+void StringFreeMapped(String* string);
 String StringNonOwning(char* str);
 void StringAppendVaFormat(String* string, const char* format, va_list arguments);
 void StringAppendFormat(String* string, const char* format, ...);
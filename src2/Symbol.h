@@ -0,0 +1,30 @@
+#pragma once
+
+#include "StringView.h"
+#include "Table.h"
+#include "Array.h"
+
+#include <stdint.h>
+
+// Identifiers are interned by the scanner so names can be compared and hashed as integers.
+// The ids are dense so they can also be used as indices.
+typedef uint32_t SymbolId;
+
+#define SYMBOL_ID_NULL UINT32_MAX
+
+TABLE_TEMPLATE_DECLARATION(SymbolIdTable, StringView, SymbolId)
+ARRAY_TEMPLATE_DECLARATION(StringViewArray, StringView)
+
+typedef struct
+{
+	SymbolIdTable ids;
+	// Indexed by SymbolId. The names point into the source.
+	StringViewArray names;
+} SymbolTable;
+
+void SymbolTableInit(SymbolTable* table);
+void SymbolTableFree(SymbolTable* table);
+SymbolId SymbolTableIntern(SymbolTable* table, StringView name);
+// Returns SYMBOL_ID_NULL if the name wasn't interned.
+SymbolId SymbolTableFind(SymbolTable* table, StringView name);
+StringView SymbolTableGetName(const SymbolTable* table, SymbolId id);
@@ -0,0 +1,76 @@
+#include "Thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static DWORD WINAPI threadMain(LPVOID parameter)
+{
+	Thread* thread = parameter;
+	thread->function(thread->argument);
+	return 0;
+}
+
+void ThreadStart(Thread* thread, ThreadFunction function, void* argument)
+{
+	thread->function = function;
+	thread->argument = argument;
+	thread->handle = CreateThread(NULL, 0, threadMain, thread, 0, NULL);
+	if (thread->handle == NULL)
+	{
+		fputs("Failed to create thread\n", stderr);
+		exit(1);
+	}
+}
+
+void ThreadJoin(Thread* thread)
+{
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+}
+
+size_t ThreadHardwareConcurrency()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+
+#else
+
+#include <unistd.h>
+
+static void* threadMain(void* parameter)
+{
+	Thread* thread = parameter;
+	thread->function(thread->argument);
+	return NULL;
+}
+
+void ThreadStart(Thread* thread, ThreadFunction function, void* argument)
+{
+	thread->function = function;
+	thread->argument = argument;
+	if (pthread_create(&thread->handle, NULL, threadMain, thread) != 0)
+	{
+		fputs("Failed to create thread\n", stderr);
+		exit(1);
+	}
+}
+
+void ThreadJoin(Thread* thread)
+{
+	pthread_join(thread->handle, NULL);
+}
+
+size_t ThreadHardwareConcurrency()
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count < 1) ? 1 : (size_t)count;
+}
+
+#endif
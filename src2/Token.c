@@ -1,9 +1,180 @@
 #include "Token.h"
+#include "Scanner.h"
+#include "Assert.h"
 #include "Generic.h"
 
-static void copyToken(Token* dst, const Token* src)
+void TokenArrayInit(TokenArray* array)
 {
-	*dst = *src;
+	TokenSourceArrayInit(&array->sources);
+	array->size = 0;
+	array->capacity = 0;
+	array->types = NULL;
+	array->offsets = NULL;
+	array->payloads = NULL;
+	array->valuesSize = 0;
+	array->valuesCapacity = 0;
+	array->values = NULL;
 }
 
-ARRAY_TEMPLATE_DEFINITION(TokenArray, Token, copyToken, NO_OP_FUNCTION)
\ No newline at end of file
+void TokenArrayFree(TokenArray* array)
+{
+	free(array->types);
+	free(array->offsets);
+	free(array->payloads);
+	free(array->values);
+	TokenSourceArrayFree(&array->sources);
+}
+
+void TokenArrayAddSource(TokenArray* array, StringView source, uint32_t base, FileInfo* fileInfo)
+{
+	ASSERT((array->sources.size == 0) || (array->sources.data[array->sources.size - 1].base < base));
+
+	TokenSource tokenSource;
+	tokenSource.source = source;
+	tokenSource.base = base;
+	tokenSource.fileInfo = fileInfo;
+	TokenSourceArrayAppend(&array->sources, tokenSource);
+}
+
+const TokenSource* TokenArrayFindSource(const TokenArray* array, size_t offset)
+{
+	ASSERT(array->sources.size > 0);
+
+	// Find the last source starting at or before the offset.
+	size_t low = 0;
+	size_t high = array->sources.size;
+	while ((high - low) > 1)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (array->sources.data[middle].base <= offset)
+			low = middle;
+		else
+			high = middle;
+	}
+	return &array->sources.data[low];
+}
+
+const TokenSource* TokenArrayFindSourceOfChars(const TokenArray* array, const char* chars)
+{
+	for (size_t i = 0; i < array->sources.size; i++)
+	{
+		const TokenSource* source = &array->sources.data[i];
+		if ((chars >= source->source.chars) && (chars <= (source->source.chars + source->source.length)))
+			return source;
+	}
+	return NULL;
+}
+
+void TokenArrayReserve(TokenArray* array, size_t capacity)
+{
+	if (capacity <= array->capacity)
+		return;
+
+	uint8_t* newTypes = realloc(array->types, capacity * sizeof(uint8_t));
+	uint32_t* newOffsets = realloc(array->offsets, capacity * sizeof(uint32_t));
+	uint32_t* newPayloads = realloc(array->payloads, capacity * sizeof(uint32_t));
+	if ((newTypes == NULL) || (newOffsets == NULL) || (newPayloads == NULL))
+	{
+		fputs("Failed to reallocate array\n", stderr);
+		exit(1);
+	}
+	array->types = newTypes;
+	array->offsets = newOffsets;
+	array->payloads = newPayloads;
+	array->capacity = capacity;
+}
+
+void TokenArrayAppend(TokenArray* array, TokenType type, size_t offset, uint32_t payload)
+{
+	ASSERT(offset <= UINT32_MAX);
+	ASSERT(type < TOKEN_FLAG_LINE_START);
+
+	if ((array->size + 1) > array->capacity)
+		TokenArrayReserve(array, (array->capacity == 0) ? ARRAY_INITIAL_CAPACITY : array->capacity * 2);
+
+	array->types[array->size] = (uint8_t)type;
+	array->offsets[array->size] = (uint32_t)offset;
+	array->payloads[array->size] = payload;
+	array->size++;
+}
+
+void TokenArrayAppendValue(TokenArray* array, TokenType type, size_t offset, uint64_t value)
+{
+	ASSERT(TokenTypeIsNumberConstant(type));
+
+	if ((array->valuesSize + 1) > array->valuesCapacity)
+	{
+		array->valuesCapacity = (array->valuesCapacity == 0) ? ARRAY_INITIAL_CAPACITY : array->valuesCapacity * 2;
+		uint64_t* newValues = realloc(array->values, array->valuesCapacity * sizeof(uint64_t));
+		if (newValues == NULL)
+		{
+			fputs("Failed to reallocate array\n", stderr);
+			exit(1);
+		}
+		array->values = newValues;
+	}
+
+	array->values[array->valuesSize] = value;
+	TokenArrayAppend(array, type, offset, (uint32_t)array->valuesSize);
+	array->valuesSize++;
+}
+
+void TokenArrayClear(TokenArray* array)
+{
+	array->size = 0;
+	array->valuesSize = 0;
+}
+
+TokenType TokenArrayGetType(const TokenArray* array, size_t index)
+{
+	ASSERT(index < array->size);
+	return array->types[index] & ~TOKEN_FLAG_LINE_START;
+}
+
+bool TokenArrayIsAtLineStart(const TokenArray* array, size_t index)
+{
+	ASSERT(index < array->size);
+	return (array->types[index] & TOKEN_FLAG_LINE_START) != 0;
+}
+
+size_t TokenArrayGetOffset(const TokenArray* array, size_t index)
+{
+	ASSERT(index < array->size);
+	return array->offsets[index];
+}
+
+SymbolId TokenArrayGetSymbol(const TokenArray* array, size_t index)
+{
+	ASSERT(TokenArrayGetType(array, index) == TOKEN_IDENTIFIER);
+	return array->payloads[index];
+}
+
+uint64_t TokenArrayGetValue(const TokenArray* array, size_t index)
+{
+	ASSERT(TokenTypeIsNumberConstant(TokenArrayGetType(array, index)));
+	return array->values[array->payloads[index]];
+}
+
+Token TokenArrayGet(const TokenArray* array, size_t index)
+{
+	const TokenSource* source = TokenArrayFindSource(array, array->offsets[index]);
+	size_t offset = array->offsets[index] - source->base;
+
+	Token token;
+	token.type = TokenArrayGetType(array, index);
+	token.isAtLineStart = TokenArrayIsAtLineStart(array, index);
+	token.text.chars = source->source.chars + offset;
+	token.payload = array->payloads[index];
+	token.value.intValue = TokenTypeIsNumberConstant(token.type) ? array->values[token.payload] : 0;
+	token.text.length = ((token.type == TOKEN_ERROR) || (token.type == TOKEN_EOF))
+		? 0
+		: ScannerTokenLength(source->source, offset);
+	return token;
+}
+
+bool TokenTypeIsNumberConstant(TokenType type)
+{
+	return (type >= TOKEN_INT_CONSTANT) && (type <= TOKEN_LONG_DOUBLE_CONSTANT);
+}
+
+ARRAY_TEMPLATE_TRIVIAL_DEFINITION(TokenSourceArray, TokenSource)
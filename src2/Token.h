@@ -2,6 +2,10 @@
 
 #include "StringView.h"
 #include "Array.h"
+#include "Symbol.h"
+#include "FileInfo.h"
+
+#include <stdint.h>
 
 typedef enum
 {
@@ -52,6 +56,8 @@ typedef enum
 	TOKEN_BANG_EQUALS,
 	TOKEN_BANG,
 	TOKEN_SEMICOLON,
+	TOKEN_HASH,
+	TOKEN_HASH_HASH,
 
 	// Keywords
 	TOKEN_AUTO,
@@ -106,6 +112,10 @@ typedef enum
 	TOKEN_STRING_LITERAL,
 
 	// Special tokens
+	// Only used by the preprocessor. The payload is the index of the parameter.
+	TOKEN_MACRO_PARAMETER,
+	// Only used by the preprocessor. Marks the end of the expansion of the macro with the SymbolId in the payload.
+	TOKEN_MACRO_END,
 	TOKEN_ERROR,
 	TOKEN_EOF
 }  TokenType;
@@ -114,7 +124,67 @@ typedef struct
 {
 	TokenType type;
 	StringView text;
-	size_t line;
+	// The SymbolId for identifiers and the index into the values for number constants.
+	uint32_t payload;
+	// The decoded value of number constants. Float constants are stored as the double of the rounded float.
+	union
+	{
+		uint64_t intValue;
+		double floatValue;
+	} value;
+	// True if there is a newline between this and the previous token. Directives are only recognized at the start of a line.
+	bool isAtLineStart;
 } Token;
 
-ARRAY_TEMPLATE_DECLARATION(TokenArray, Token)
\ No newline at end of file
+// Stored in the type byte so the preprocessor can find directives without scanning the source again.
+#define TOKEN_FLAG_LINE_START 0x80
+
+typedef struct
+{
+	StringView source;
+	// The offsets of tokens from this source start at base. Tokens from different files can be stored in one array
+	// and still be identified by a 32 bit offset.
+	uint32_t base;
+	FileInfo* fileInfo;
+} TokenSource;
+
+ARRAY_TEMPLATE_DECLARATION(TokenSourceArray, TokenSource)
+
+// Tokens are stored as a structure of arrays of 9 bytes per token: a type, an offset and a payload. The length of a token isn't stored,
+// it is computed by scanning the token again when the text is needed.
+typedef struct
+{
+	// Sorted by base.
+	TokenSourceArray sources;
+	size_t size;
+	size_t capacity;
+	uint8_t* types;
+	uint32_t* offsets;
+	uint32_t* payloads;
+	// Values of number constants. Most tokens don't have one so they are stored separately.
+	size_t valuesSize;
+	size_t valuesCapacity;
+	uint64_t* values;
+} TokenArray;
+
+void TokenArrayInit(TokenArray* array);
+void TokenArrayFree(TokenArray* array);
+void TokenArrayAddSource(TokenArray* array, StringView source, uint32_t base, FileInfo* fileInfo);
+// Returns the source containing the offset.
+const TokenSource* TokenArrayFindSource(const TokenArray* array, size_t offset);
+// Returns the source containing the chars of a token or NULL.
+const TokenSource* TokenArrayFindSourceOfChars(const TokenArray* array, const char* chars);
+// Makes sure capacity tokens fit without growing the array.
+void TokenArrayReserve(TokenArray* array, size_t capacity);
+void TokenArrayAppend(TokenArray* array, TokenType type, size_t offset, uint32_t payload);
+// Appends a number constant and stores its value.
+void TokenArrayAppendValue(TokenArray* array, TokenType type, size_t offset, uint64_t value);
+void TokenArrayClear(TokenArray* array);
+TokenType TokenArrayGetType(const TokenArray* array, size_t index);
+size_t TokenArrayGetOffset(const TokenArray* array, size_t index);
+bool TokenArrayIsAtLineStart(const TokenArray* array, size_t index);
+SymbolId TokenArrayGetSymbol(const TokenArray* array, size_t index);
+uint64_t TokenArrayGetValue(const TokenArray* array, size_t index);
+Token TokenArrayGet(const TokenArray* array, size_t index);
+
+bool TokenTypeIsNumberConstant(TokenType type);
\ No newline at end of file
@@ -1,31 +1,46 @@
-#include "Scanner.h"
+#include "Preprocessor.h"
 #include "Compiler.h"
+#include "Pch.h"
+#include "Cli.h"
+
+#include <stdio.h>
+#include <stdlib.h>
 
 int main(int argCount, char* args[])
 {
-	
-
 	const char* filename = "src2/test.txt";
+	CliOptions options = CliParseOptions(argCount, args);
+
+	// Writing a precompiled header needs an unused preprocessor.
+	if (options.pchHeaderPath != NULL)
+	{
+		Preprocessor pchPreprocessor = PreprocessorInit(&pchPreprocessor);
+		bool isWritten = PchWrite(&pchPreprocessor, options.pchHeaderPath, options.pchPath);
+		PreprocessorFree(&pchPreprocessor);
+		if (isWritten == false)
+		{
+			fprintf(stderr, "failed to write the precompiled header '%s'\n", options.pchPath);
+			return EXIT_FAILURE;
+		}
+	}
 
-	FileInfo fileInfo = FileInfoInit(&fileInfo);
-	String source = StringFromFile(filename);
-	Scanner scanner = ScannerInit(&scanner);
+	Preprocessor preprocessor = PreprocessorInit(&preprocessor);
+	if (options.pchPath != NULL)
+		PreprocessorUsePch(&preprocessor, options.pchPath);
 	Compiler compiler = CompilerInit(&compiler);
 
-	TokenArray tokens = ScannerScan(&scanner, StringViewFromString(&source), filename, &fileInfo);
+	TokenArray tokens = PreprocessorPreprocess(&preprocessor, filename);
 	//for (size_t i = 0; i < tokens.size; i++)
 	//{
-	//	tokens.data[i].type;
-	//	printf("%.*s", tokens.data[i].text.length, tokens.data[i].text.chars);
+	//	Token token = TokenArrayGet(&tokens, i);
+	//	printf("%.*s", token.text.length, token.text.chars);
 	//}
 	//printf("\n");
-	String output = CompilerCompile(&compiler, &tokens, &fileInfo);
+	String output = CompilerCompile(&compiler, &tokens);
 	//printf("%.*s", output.length, output.chars);
 
-	FileInfoFree(&fileInfo);
-	ScannerFree(&scanner);
-	StringFree(&source);
 	TokenArrayFree(&tokens);
+	PreprocessorFree(&preprocessor);
 	CompilerFree(&compiler);
 	StringFree(&output);
 